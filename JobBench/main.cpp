@@ -0,0 +1,290 @@
+﻿// Замеры и нагрузочная проверка системы заданий без окна и GPU
+#include "JobSystem.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Пустые задания пачками: цена создания, Run и выполнения; с >1 потоком часть уходит ворам
+static void BenchSpawn(JobSystem& jobs) {
+    const int batches = 1000;
+    const int batchSize = 1000;
+
+    jobs.ResetStats();
+    auto start = Clock::now();
+    for (int b = 0; b < batches; b++) {
+        JobCounter counter;
+        for (int i = 0; i < batchSize; i++)
+            jobs.Run(jobs.CreateJob([]() {}, &counter));
+        jobs.Wait(counter);
+    }
+    double ms = MillisecondsSince(start);
+
+    const JobSystemStats stats = jobs.GetStats();
+    const double total = (double)batches * batchSize;
+    printf("  spawn:     %.1f ns/job, %.1f%% stolen, %.2f failed steals/job, %llu sleeps\n",
+        1e6 * ms / total, 100.0 * stats.stolen / total, stats.failedSteals / total,
+        (unsigned long long)stats.sleeps);
+}
+
+// Дерево детей глубины depth: каждое задание рождает двух детей, продолжение - на корень
+static void SpawnTree(JobSystem& jobs, Job& parent, int depth) {
+    if (depth == 0)
+        return;
+    for (int i = 0; i < 2; i++) {
+        jobs.Run(jobs.CreateChildJob(&parent, [&jobs, depth](Job& self) { SpawnTree(jobs, self, depth - 1); }));
+    }
+}
+
+static void BenchTree(JobSystem& jobs) {
+    const int depth = 16;
+    const int repeats = 20;
+
+    jobs.ResetStats();
+    auto start = Clock::now();
+    for (int r = 0; r < repeats; r++) {
+        JobCounter counter;
+        std::atomic<int> continuationRuns{ 0 };
+        Job* root = jobs.CreateJob([&jobs](Job& self) { SpawnTree(jobs, self, depth); });
+        Job* done = jobs.CreateJob([&continuationRuns]() { continuationRuns++; }, &counter);
+        jobs.AddContinuation(root, done);
+        jobs.Run(done);
+        jobs.Run(root);
+        jobs.Wait(counter);
+    }
+    double ms = MillisecondsSince(start);
+
+    const double total = (double)repeats * ((2 << depth) - 1);
+    const JobSystemStats stats = jobs.GetStats();
+    printf("  tree:      %.1f ns/job (%d levels of children + continuation), %.1f%% stolen\n",
+        1e6 * ms / total, depth, 100.0 * stats.stolen / total);
+}
+
+// Задержка fork-join: ParallelFor на ThreadCount кусков почти без работы
+static void BenchForkJoin(JobSystem& jobs) {
+    const int repeats = 20000;
+    const size_t count = jobs.ThreadCount() * 4;
+    std::vector<uint32_t> out(count);
+
+    auto start = Clock::now();
+    for (int r = 0; r < repeats; r++)
+        jobs.ParallelFor(count, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                out[i] += (uint32_t)i;
+        });
+    double ms = MillisecondsSince(start);
+    printf("  fork-join: %.2f us per ParallelFor over %zu items\n", 1000.0 * ms / repeats, count);
+}
+
+// То же через прежний ParallelFor с потоком на индекс - для сравнения (вызов не из потока системы)
+static void BenchThreadForkJoin(unsigned threadCount) {
+    const int repeats = 2000;
+    std::vector<uint32_t> out(threadCount);
+
+    auto start = Clock::now();
+    for (int r = 0; r < repeats; r++)
+        ParallelFor(threadCount, [&](size_t i) { out[i] += (uint32_t)i; });
+    double ms = MillisecondsSince(start);
+    printf("threads (std::thread per index, %u): fork-join %.2f us\n", threadCount, 1000.0 * ms / repeats);
+}
+
+// ===== Нагрузочные проверки: false - нарушение =====
+
+// Каждый индекс ровно один раз, в том числе во вложенных ParallelFor
+static bool StressParallelFor(JobSystem& jobs, std::mt19937& rng) {
+    const size_t outer = 1 + rng() % 64;
+    const size_t inner = 1 + rng() % 2000;
+    std::vector<std::atomic<uint32_t>> visits(outer * inner);
+
+    jobs.ParallelFor(outer, 1 + rng() % 4, [&](size_t begin, size_t end) {
+        for (size_t o = begin; o < end; o++) {
+            ::ParallelForRange(inner, 64, 0, [&](size_t, size_t b, size_t e) {
+                for (size_t i = b; i < e; i++)
+                    visits[o * inner + i].fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+    });
+
+    for (auto& v : visits) {
+        if (v.load() != 1)
+            return false;
+    }
+    return true;
+}
+
+// Случайный DAG: продолжения и дети; задание начинается только после того,
+// как все предшественники отработали вместе со своими детьми
+static bool StressDependencies(JobSystem& jobs, std::mt19937& rng) {
+    const uint32_t nodeCount = 200 + rng() % 800;
+    std::vector<uint32_t> childCount(nodeCount);
+    std::vector<std::atomic<uint32_t>> bodyDone(nodeCount), childrenDone(nodeCount);
+    std::vector<std::vector<uint32_t>> predecessors(nodeCount);
+    std::atomic<uint32_t> started{ 0 };
+    std::atomic<bool> ok{ true };
+
+    JobCounter counter;
+    std::vector<Job*> nodes(nodeCount);
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        childCount[n] = rng() % 4;
+        nodes[n] = jobs.CreateJob([&, n](Job& self) {
+            started++;
+            for (uint32_t p : predecessors[n]) {
+                if (bodyDone[p].load() == 0 || childrenDone[p].load() != childCount[p])
+                    ok = false;
+            }
+            for (uint32_t c = 0; c < childCount[n]; c++)
+                jobs.Run(jobs.CreateChildJob(&self, [&, n]() { childrenDone[n]++; }));
+            bodyDone[n] = 1;
+        }, &counter);
+    }
+
+    // Рёбра только вперёд - цикла нет
+    for (uint32_t n = 1; n < nodeCount; n++) {
+        const uint32_t edges = rng() % 4;
+        for (uint32_t e = 0; e < edges; e++) {
+            const uint32_t p = rng() % n;
+            if (jobs.AddContinuation(nodes[p], nodes[n]))
+                predecessors[n].push_back(p);
+        }
+    }
+
+    // Запуск в случайном порядке: порядок Run не должен влиять на порядок выполнения
+    std::vector<uint32_t> order(nodeCount);
+    for (uint32_t n = 0; n < nodeCount; n++)
+        order[n] = n;
+    std::shuffle(order.begin(), order.end(), rng);
+    for (uint32_t n : order)
+        jobs.Run(nodes[n]);
+    jobs.Wait(counter);
+
+    // Счётчик обнулился - значит, и все дети завершились
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        if (childrenDone[n].load() != childCount[n])
+            ok = false;
+    }
+    return ok.load() && started.load() == nodeCount;
+}
+
+// Больше JOB_DEQUE_CAPACITY заданий без ожидания - часть выполняется на месте
+static bool StressOverflow(JobSystem& jobs) {
+    const uint32_t count = JOB_DEQUE_CAPACITY * 3;
+    std::atomic<uint32_t> runs{ 0 };
+    JobCounter counter;
+    jobs.Run(jobs.CreateJob([&]() {
+        for (uint32_t i = 0; i < count; i++)
+            jobs.Run(jobs.CreateJob([&]() { runs++; }, &counter));
+    }, &counter));
+    jobs.Wait(counter);
+    return runs.load() == count;
+}
+
+// Потоки засыпают между пачками; владелец не помогает, а только смотрит на счётчик -
+// потерянное пробуждение видно как таймаут
+static bool StressWakeup(JobSystem& jobs, std::mt19937& rng) {
+    if (jobs.ThreadCount() == 1)
+        return true;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(rng() % 3));
+    std::atomic<uint32_t> runs{ 0 };
+    JobCounter counter;
+    const uint32_t count = 1 + rng() % 4;
+    for (uint32_t i = 0; i < count; i++)
+        jobs.Run(jobs.CreateJob([&]() { runs++; }, &counter));
+
+    // Задания в деке владельца: рабочие должны проснуться и украсть их
+    auto start = Clock::now();
+    while (!counter.IsDone()) {
+        if (MillisecondsSince(start) > 5000.0)
+            return false;
+        std::this_thread::yield();
+    }
+    return runs.load() == count;
+}
+
+static int RunStress(unsigned threadCount, int iterations) {
+    std::mt19937 rng(12345);
+    JobSystem jobs(threadCount);
+    int failures = 0;
+
+    auto start = Clock::now();
+    for (int it = 0; it < iterations; it++) {
+        const char* failed = nullptr;
+        if (!StressParallelFor(jobs, rng))
+            failed = "parallel-for";
+        else if (!StressDependencies(jobs, rng))
+            failed = "dependencies";
+        else if (it % 16 == 0 && !StressOverflow(jobs))
+            failed = "overflow";
+        else if (it % 8 == 0 && !StressWakeup(jobs, rng))
+            failed = "wakeup";
+
+        if (failed) {
+            printf("  iteration %d: %s FAILED\n", it, failed);
+            failures++;
+        }
+    }
+
+    const JobSystemStats stats = jobs.GetStats();
+    printf("stress %u threads: %d iterations, %d failures (%.0f ms, %llu jobs, %llu stolen, %llu overflowed)\n",
+        jobs.ThreadCount(), iterations, failures, MillisecondsSince(start),
+        (unsigned long long)stats.executed, (unsigned long long)stats.stolen, (unsigned long long)stats.overflowed);
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    bool stress = false;
+    int iterations = 200;
+    unsigned threadCount = 0;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--stress")
+            stress = true;
+        else if (arg == "--iterations" && i + 1 < argc)
+            iterations = atoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc)
+            threadCount = (unsigned)atoi(argv[++i]);
+        else {
+            printf("Usage: JobBench [--stress] [--iterations N] [--threads N]\n");
+            return 1;
+        }
+    }
+
+    // Без --threads - один поток (чистая цена заданий) и все ядра; стресс - ещё и с перебором потоков
+    std::vector<unsigned> threadCounts;
+    if (threadCount != 0)
+        threadCounts.push_back(threadCount);
+    else if (stress)
+        threadCounts = { 1, 2, 4, std::max(8u, std::thread::hardware_concurrency()) };
+    else
+        threadCounts = { 1, std::max(1u, std::thread::hardware_concurrency()) };
+
+    if (stress) {
+        int failures = 0;
+        for (unsigned count : threadCounts)
+            failures += RunStress(count, iterations);
+        return failures ? 2 : 0;
+    }
+
+    BenchThreadForkJoin(threadCounts.back());
+    for (unsigned count : threadCounts) {
+        JobSystem jobs(count);
+        printf("jobs (%u threads):\n", jobs.ThreadCount());
+        BenchSpawn(jobs);
+        BenchTree(jobs);
+        BenchForkJoin(jobs);
+    }
+    return 0;
+}
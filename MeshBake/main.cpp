@@ -0,0 +1,684 @@
+﻿// Офлайн-конвертер: OBJ -> бинарный кэш меша (тот же формат, что пишет BuildObj)
+#include "Parser.h"
+#include "Vertex.h"
+#include "MeshCache.h"
+#include "MeshBounds.h"
+#include "MeshOptimizer.h"
+#include "MeshClusters.h"
+#include "Bvh.h"
+#include "JobSystem.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "MeshStreams.h"
+#include "OcclusionBuffer.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+struct BenchView {
+    XMFLOAT4X4 viewProj;
+    XMFLOAT3 eye;
+};
+
+// Камеры замеров без GPU: 32 по орбите снаружи меша и 32 поворота изнутри (как в атриуме Sponza)
+static std::vector<BenchView> BuildBenchViews(const std::vector<MeshCluster>& clusters) {
+    XMVECTOR lo = XMLoadFloat3(&clusters[0].boundsMin);
+    XMVECTOR hi = XMLoadFloat3(&clusters[0].boundsMax);
+    for (const MeshCluster& cluster : clusters) {
+        lo = XMVectorMin(lo, XMLoadFloat3(&cluster.boundsMin));
+        hi = XMVectorMax(hi, XMLoadFloat3(&cluster.boundsMax));
+    }
+
+    const XMVECTOR center = XMVectorScale(XMVectorAdd(lo, hi), 0.5f);
+    const float radius = XMVectorGetX(XMVector3Length(XMVectorSubtract(hi, lo))) * 0.5f;
+    const XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+    const XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.01f * radius, 4.0f * radius);
+
+    const int viewCount = 64;
+    std::vector<BenchView> views(viewCount);
+    for (int v = 0; v < viewCount; v++) {
+        float angle = XM_2PI * v / (viewCount / 2);
+        XMVECTOR dir = XMVectorSet(cosf(angle), 0.0f, sinf(angle), 0.0f);
+        XMVECTOR eye = (v < viewCount / 2)
+            ? XMVectorAdd(center, XMVectorAdd(XMVectorScale(dir, 1.5f * radius), XMVectorScale(up, 0.3f * radius)))
+            : center;
+        XMVECTOR target = (v < viewCount / 2) ? center : XMVectorAdd(center, dir);
+
+        XMStoreFloat4x4(&views[v].viewProj, XMMatrixLookAtLH(eye, target, up) * proj);
+        XMStoreFloat3(&views[v].eye, eye);
+    }
+    return views;
+}
+
+// Замер отсечения пирамидой: BVH сравнивается с проверкой каждого кластера подряд,
+// затем мешлеты видимых кластеров - сфера и конус
+static void RunCullBenchmark(const std::vector<MeshCluster>& clusters, const MeshletData& meshlets) {
+    if (clusters.empty()) {
+        printf("cull-bench: no clusters\n");
+        return;
+    }
+
+    std::vector<XMFLOAT3> boundsMin(clusters.size());
+    std::vector<XMFLOAT3> boundsMax(clusters.size());
+    for (size_t i = 0; i < clusters.size(); i++) {
+        boundsMin[i] = clusters[i].boundsMin;
+        boundsMax[i] = clusters[i].boundsMax;
+    }
+
+    Bvh bvh;
+    bvh.Build(boundsMin.data(), boundsMax.data(), clusters.size());
+
+    const std::vector<BenchView> views = BuildBenchViews(clusters);
+    std::vector<Frustum> frustums;
+    for (const BenchView& view : views)
+        frustums.push_back(Frustum::FromMatrix(view.viewProj));
+
+    const int repeats = 200;
+    std::vector<uint32_t> visible;
+    visible.reserve(clusters.size());
+
+    uint64_t nodesTested = 0, clustersTested = 0, clustersCulled = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (const Frustum& frustum : frustums) {
+            CullStats stats;
+            visible.clear();
+            bvh.Cull(frustum, visible, &stats);
+            nodesTested += stats.nodesTested;
+            clustersTested += stats.itemsTested;
+            clustersCulled += stats.itemsCulled;
+        }
+    }
+    double bvhMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t linearCulled = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (const Frustum& frustum : frustums) {
+            for (size_t i = 0; i < clusters.size(); i++) {
+                XMVECTOR cMin = XMLoadFloat3(&boundsMin[i]);
+                XMVECTOR cMax = XMLoadFloat3(&boundsMax[i]);
+                if (frustum.Classify(XMVectorScale(XMVectorAdd(cMin, cMax), 0.5f),
+                        XMVectorScale(XMVectorSubtract(cMax, cMin), 0.5f)) < 0)
+                    linearCulled++;
+            }
+        }
+    }
+    double linearMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const uint64_t culls = (uint64_t)repeats * frustums.size();
+    const double clustersTotal = (double)culls * clusters.size();
+    printf("cull-bench: %zu clusters, %zu BVH nodes, %zu views x %d\n",
+        clusters.size(), bvh.Nodes().size(), frustums.size(), repeats);
+    printf("  BVH:    %.3f us/view, %.0f clusters/ms, %.0f culled/ms, "
+        "%.1f nodes + %.1f clusters tested/view, %.1f%% culled\n",
+        1000.0 * bvhMs / culls, clustersTotal / bvhMs, clustersCulled / bvhMs,
+        (double)nodesTested / culls, (double)clustersTested / culls, 100.0 * clustersCulled / clustersTotal);
+    printf("  linear: %.3f us/view, %.0f clusters/ms, %.0f culled/ms, %.1f%% culled\n",
+        1000.0 * linearMs / culls, clustersTotal / linearMs, linearCulled / linearMs,
+        100.0 * linearCulled / clustersTotal);
+
+    if (meshlets.meshlets.empty())
+        return;
+
+    // Мешлеты только внутри видимых кластеров, как в DirectXApp::CullClusters
+    MeshletCullStats meshletStats;
+    std::vector<uint32_t> visibleMeshlets;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (size_t v = 0; v < frustums.size(); v++) {
+            visible.clear();
+            visibleMeshlets.clear();
+            bvh.Cull(frustums[v], visible, nullptr);
+            for (uint32_t cluster : visible) {
+                CullMeshlets(meshlets.bounds.data(), clusters[cluster].firstMeshlet, clusters[cluster].meshletCount,
+                    frustums[v], XMLoadFloat3(&views[v].eye), true, visibleMeshlets, &meshletStats);
+            }
+        }
+    }
+    double meshletMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const double meshletsTotal = (double)culls * meshlets.meshlets.size();
+    const uint32_t meshletsCulled = meshletStats.frustumCulled + meshletStats.backfaceCulled;
+    printf("  meshlets: %.3f us/view (BVH included), %.0f meshlets tested/ms, %.0f culled/ms, "
+        "%.1f%% frustum + %.1f%% backface of %zu\n",
+        1000.0 * meshletMs / culls, meshletStats.tested / meshletMs, meshletsCulled / meshletMs,
+        100.0 * meshletStats.frustumCulled / meshletsTotal, 100.0 * meshletStats.backfaceCulled / meshletsTotal,
+        meshlets.meshlets.size());
+}
+
+// Программное отсечение перекрытых на тех же камерах: растеризация окклюдеров, пирамида hi-Z
+// и проверка кластеров, прошедших пирамиду видимости. dumpPrefix - PGM буфера глубины орбитальной
+// и внутренней камеры (уровень 0 и уровень 3 пирамиды)
+static void RunOcclusionBenchmark(
+    const std::vector<MeshCluster>& clusters,
+    const std::vector<XMFLOAT3>& positions,
+    const std::vector<uint32_t>& indices,
+    size_t baseIndexCount,
+    const std::string& dumpPrefix) {
+    if (clusters.empty()) {
+        printf("occlusion-bench: no clusters\n");
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    OccluderMesh occluders;
+    SelectOccluders(indices.data(), baseIndexCount, &positions[0].x, positions.size(), sizeof(XMFLOAT3),
+        OCCLUDER_TRIANGLE_BUDGET, occluders);
+    double selectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<XMFLOAT3> boundsMin(clusters.size());
+    std::vector<XMFLOAT3> boundsMax(clusters.size());
+    for (size_t i = 0; i < clusters.size(); i++) {
+        boundsMin[i] = clusters[i].boundsMin;
+        boundsMax[i] = clusters[i].boundsMax;
+    }
+    Bvh bvh;
+    bvh.Build(boundsMin.data(), boundsMax.data(), clusters.size());
+
+    const std::vector<BenchView> views = BuildBenchViews(clusters);
+    printf("occlusion-bench: %zu occluder triangles of %zu (selected in %.1f ms), %ux%u buffer, %zu views\n",
+        occluders.TriangleCount(), baseIndexCount / 3, selectMs, OCCLUSION_WIDTH, OCCLUSION_HEIGHT, views.size());
+
+    // Одним потоком и всеми ядрами: растеризация делится на полосы строк
+    const unsigned threadCounts[] = { 1, 0 };
+    for (unsigned threadCount : threadCounts) {
+        OcclusionBuffer buffer;
+        const int repeats = 20;
+        double rasterMs = 0.0, hizMs = 0.0, testMs = 0.0;
+        uint64_t trianglesRasterized = 0, frustumVisible = 0, occluded = 0;
+        uint64_t trianglesVisible = 0, trianglesOccluded = 0;
+        std::vector<uint32_t> visible;
+
+        for (int r = 0; r < repeats; r++) {
+            for (size_t v = 0; v < views.size(); v++) {
+                auto t0 = std::chrono::steady_clock::now();
+                buffer.Render(occluders, &views[v].viewProj, 1, threadCount);
+                auto t1 = std::chrono::steady_clock::now();
+                buffer.BuildHiZ();
+                auto t2 = std::chrono::steady_clock::now();
+
+                visible.clear();
+                bvh.Cull(Frustum::FromMatrix(views[v].viewProj), visible, nullptr);
+                auto t3 = std::chrono::steady_clock::now();
+                for (uint32_t cluster : visible) {
+                    const bool hidden = buffer.IsOccluded(boundsMin[cluster], boundsMax[cluster], views[v].viewProj);
+                    occluded += hidden;
+                    trianglesOccluded += hidden ? clusters[cluster].indexCount / 3 : 0;
+                    trianglesVisible += clusters[cluster].indexCount / 3;
+                }
+                auto t4 = std::chrono::steady_clock::now();
+
+                rasterMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+                hizMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+                testMs += std::chrono::duration<double, std::milli>(t4 - t3).count();
+                frustumVisible += visible.size();
+                trianglesRasterized += buffer.GetStats().trianglesRasterized;
+
+                if (r == 0 && threadCount == 0 && !dumpPrefix.empty() && (v == 0 || v == views.size() / 2)) {
+                    for (uint32_t level : { 0u, 3u }) {
+                        const std::string path = dumpPrefix + "_view" + std::to_string(v) +
+                            "_mip" + std::to_string(level) + ".pgm";
+                        if (!buffer.WriteDepthPgm(path, level))
+                            printf("Failed to write %s\n", path.c_str());
+                    }
+                }
+            }
+        }
+
+        const double runs = (double)repeats * views.size();
+        printf("  %s: raster %.3f ms, hi-Z %.3f ms, test %.3f ms/view; %.0f triangles rasterized/view, "
+            "%.1f%% of %.0f frustum-visible clusters occluded (%.1f%% of their triangles)\n",
+            threadCount == 1 ? "1 thread" : "all threads",
+            rasterMs / runs, hizMs / runs, testMs / runs, trianglesRasterized / runs,
+            frustumVisible ? 100.0 * occluded / frustumVisible : 0.0, frustumVisible / runs,
+            trianglesVisible ? 100.0 * trianglesOccluded / trianglesVisible : 0.0);
+    }
+}
+
+// Потоковый импорт против LoadOBJ: те же вершины углов в том же порядке, побитово.
+// Печатает число кусков и пик памяти на кусок - он не зависит от размера файла
+static bool RunStreamCheck(const std::string& path, const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& indices) {
+    auto start = std::chrono::steady_clock::now();
+
+    size_t corner = 0;
+    size_t chunkCount = 0;
+    size_t peakBytes = 0;
+    bool same = true;
+    const bool loaded = LoadOBJStreamed(path, ObjStreamOptions{}, [&](const ObjMeshChunk& chunk) {
+        chunkCount++;
+        peakBytes = std::max(peakBytes, chunk.vertexCount * sizeof(Vertex) + chunk.indexCount * sizeof(uint32_t));
+
+        for (size_t i = 0; i < chunk.indexCount && same; i++, corner++) {
+            if (corner >= indices.size()) {
+                same = false;
+                break;
+            }
+            const Vertex& streamed = chunk.vertices[chunk.indices[i]];
+            const Vertex& loadedVertex = vertices[indices[corner]];
+            same = memcmp(&streamed.position, &loadedVertex.position, sizeof(XMFLOAT3)) == 0 &&
+                memcmp(&streamed.normal, &loadedVertex.normal, sizeof(XMFLOAT3)) == 0;
+        }
+        return same;
+    });
+    same = same && loaded && corner == indices.size();
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("stream-check: %zu chunks, peak %.1f KB per chunk, %.1f ms: %s\n",
+        chunkCount, peakBytes / 1024.0, ms, same ? "matches LoadOBJ" : "MISMATCH");
+    return same;
+}
+
+// Прежний скалярный проход LoadOBJ: min/max по компонентам, затем перенос и масштаб
+static BoundingBox ScalarNormalize(std::vector<Vertex>& vertices, float targetExtent) {
+    XMFLOAT3 minP = vertices[0].position;
+    XMFLOAT3 maxP = vertices[0].position;
+    for (const Vertex& v : vertices) {
+        minP.x = std::min(minP.x, v.position.x);
+        minP.y = std::min(minP.y, v.position.y);
+        minP.z = std::min(minP.z, v.position.z);
+        maxP.x = std::max(maxP.x, v.position.x);
+        maxP.y = std::max(maxP.y, v.position.y);
+        maxP.z = std::max(maxP.z, v.position.z);
+    }
+
+    const MeshNormalization normalization = ComputeMeshNormalization(minP, maxP, targetExtent);
+    const XMFLOAT3& c = normalization.center;
+    const float scale = normalization.scale;
+    for (Vertex& v : vertices) {
+        v.position.x = (v.position.x - c.x) * scale;
+        v.position.y = (v.position.y - c.y) * scale;
+        v.position.z = (v.position.z - c.z) * scale;
+    }
+
+    XMFLOAT3 newMin = { (minP.x - c.x) * scale, (minP.y - c.y) * scale, (minP.z - c.z) * scale };
+    XMFLOAT3 newMax = { (maxP.x - c.x) * scale, (maxP.y - c.y) * scale, (maxP.z - c.z) * scale };
+    return BoundingBox(
+        XMFLOAT3((newMin.x + newMax.x) * 0.5f, (newMin.y + newMax.y) * 0.5f, (newMin.z + newMax.z) * 0.5f),
+        XMFLOAT3((newMax.x - newMin.x) * 0.5f, (newMax.y - newMin.y) * 0.5f, (newMax.z - newMin.z) * 0.5f));
+}
+
+// Прежний цикл LoadOBJ (getline + sscanf_s) - эталон для --parse-bench. Читает только треугольники
+// v//vn и v/vt/vn с положительными индексами; в счётчиках - что из файла он пропустил или обрезал
+struct LegacyObj {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    size_t faceLines = 0;
+    size_t skippedFaces = 0;    // без нормалей (v, v/vt) или не разобрались
+    size_t polygonFaces = 0;    // больше трёх углов: читались только первые три
+    size_t skippedCorners = 0;  // индекс вне файла: угол пропускался, треугольник ломался
+};
+
+#ifndef _WIN32
+#define sscanf_s sscanf
+#endif
+
+static bool LegacyLoadOBJ(const std::string& path, LegacyObj& out) {
+    std::ifstream file(path);
+    if (!file.is_open())
+        return false;
+
+    constexpr float OBJ_SCALE = 5.0f;
+    std::vector<XMFLOAT3> positions;
+    std::vector<XMFLOAT3> normals;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.rfind("v ", 0) == 0) {
+            XMFLOAT3 p;
+            sscanf_s(line.c_str(), "v %f %f %f", &p.x, &p.y, &p.z);
+            positions.push_back(XMFLOAT3(p.x * OBJ_SCALE, p.y * OBJ_SCALE, p.z * OBJ_SCALE));
+        }
+        else if (line.rfind("vn ", 0) == 0) {
+            XMFLOAT3 n;
+            sscanf_s(line.c_str(), "vn %f %f %f", &n.x, &n.y, &n.z);
+            normals.push_back(n);
+        }
+        else if (line.rfind("f ", 0) == 0) {
+            out.faceLines++;
+            int pi[3]{}, ni[3]{};
+            int matched = sscanf_s(line.c_str(), "f %d//%d %d//%d %d//%d",
+                &pi[0], &ni[0], &pi[1], &ni[1], &pi[2], &ni[2]);
+            if (matched != 6) {
+                matched = sscanf_s(line.c_str(), "f %d/%*d/%d %d/%*d/%d %d/%*d/%d",
+                    &pi[0], &ni[0], &pi[1], &ni[1], &pi[2], &ni[2]);
+            }
+            if (matched != 6) {
+                out.skippedFaces++;
+                continue;
+            }
+
+            size_t corners = 0;
+            for (size_t i = 1; i < line.size(); i++)
+                corners += line[i] != ' ' && line[i] != '\t' && line[i] != '\r' && (line[i - 1] == ' ' || line[i - 1] == '\t');
+            out.polygonFaces += corners > 3;
+
+            for (int i = 0; i < 3; i++) {
+                const int posIndex = pi[i] - 1;
+                const int normIndex = ni[i] - 1;
+                if (posIndex < 0 || posIndex >= (int)positions.size()) {
+                    out.skippedCorners++;
+                    continue;
+                }
+
+                Vertex v{};
+                v.position = positions[posIndex];
+                v.normal = (normIndex >= 0 && normIndex < (int)normals.size()) ? normals[normIndex] : XMFLOAT3(0.0f, 1.0f, 0.0f);
+                v.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+                out.vertices.push_back(v);
+                out.indices.push_back((uint32_t)(out.vertices.size() - 1));
+            }
+        }
+    }
+
+    if (out.vertices.empty())
+        return false;
+    ScalarNormalize(out.vertices, OBJ_SCALE);
+    return true;
+}
+
+// Прежний цикл против LoadOBJ без сварки (своя вершина на угол - как раньше): побитовое совпадение,
+// если файл целиком в том, что прежний цикл умел читать; иначе сравнивать не с чем
+static bool CheckAgainstLegacy(const std::string& path, double newMs) {
+    LegacyObj legacy;
+    auto start = std::chrono::steady_clock::now();
+    const bool loaded = LegacyLoadOBJ(path, legacy);
+    const double legacyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (!loaded || legacy.skippedFaces || legacy.polygonFaces || legacy.skippedCorners) {
+        printf("  legacy getline/sscanf_s: %.1f ms, not comparable: of %zu faces %zu skipped, %zu polygons cut, "
+            "%zu corners dropped\n", legacyMs, legacy.faceLines, legacy.skippedFaces, legacy.polygonFaces,
+            legacy.skippedCorners);
+        return true;
+    }
+
+    ObjLoadOptions options;
+    options.weldVertices = false;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    const bool same = LoadOBJ(path, vertices, indices, options) && indices == legacy.indices &&
+        vertices.size() == legacy.vertices.size() &&
+        memcmp(vertices.data(), legacy.vertices.data(), vertices.size() * sizeof(Vertex)) == 0;
+    printf("  legacy getline/sscanf_s: %.1f ms (stream 1 thread is x%.2f faster), %s\n",
+        legacyMs, legacyMs / newMs, same ? "unwelded output matches" : "MISMATCH");
+    return same;
+}
+
+// Разбор OBJ на 1, 2, 4... потоках до числа ядер, оба способа чтения. Лучшее из нескольких прогонов
+// (файл уже в кэше ОС); результат каждого прогона побитово сравнивается с однопоточным,
+// однопоточный без сварки - с прежним циклом getline/sscanf_s
+static bool RunParseBenchmark(const std::string& path, uint64_t fileSize) {
+    const unsigned cores = (unsigned)ResolveThreadCount(0);
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < cores; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(cores);
+
+    const int repeats = 5;
+    printf("parse-bench: %.1f MB, %u cores, best of %d\n", fileSize / (1024.0 * 1024.0), cores, repeats);
+
+    bool same = true;
+    double streamMs = 0.0;
+    for (ObjReader reader : { ObjReader::Stream, ObjReader::Mapped }) {
+        std::vector<Vertex> baseVertices;
+        std::vector<uint32_t> baseIndices;
+        double baseMs = 0.0;
+
+        for (unsigned threads : threadCounts) {
+            ObjLoadOptions options;
+            options.reader = reader;
+            options.threadCount = threads;
+
+            double bestMs = 0.0;
+            for (int r = 0; r < repeats; r++) {
+                std::vector<Vertex> vertices;
+                std::vector<uint32_t> indices;
+                auto start = std::chrono::steady_clock::now();
+                if (!LoadOBJ(path, vertices, indices, options)) {
+                    printf("parse-bench: failed to parse %s\n", path.c_str());
+                    return false;
+                }
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                bestMs = (r == 0) ? ms : std::min(bestMs, ms);
+
+                if (baseIndices.empty() && !indices.empty()) {
+                    baseVertices = std::move(vertices);
+                    baseIndices = std::move(indices);
+                    continue;
+                }
+                same = same && vertices.size() == baseVertices.size() && indices == baseIndices &&
+                    memcmp(vertices.data(), baseVertices.data(), vertices.size() * sizeof(Vertex)) == 0;
+            }
+            if (threads == 1)
+                baseMs = bestMs;
+            if (threads == 1 && reader == ObjReader::Stream)
+                streamMs = bestMs;
+
+            printf("  %-6s %2u threads: %8.1f ms, %7.1f MB/s, x%.2f\n",
+                reader == ObjReader::Mapped ? "mapped" : "stream", threads, bestMs,
+                fileSize / (1024.0 * 1024.0) / (bestMs / 1000.0), baseMs / bestMs);
+        }
+    }
+
+    same = CheckAgainstLegacy(path, streamMs) && same;
+    printf("parse-bench: %s\n", same ? "all runs match 1 thread" : "MISMATCH");
+    return same;
+}
+
+// Скалярные габариты и нормализация против NormalizeMesh (XMVECTOR) на одном потоке и на всех ядрах.
+// Вершины меша повторяются до ~4M, чтобы проход делился на потоки; копия перед каждым прогоном не замеряется
+static bool RunBoundsBenchmark(const std::vector<Vertex>& source) {
+    if (source.empty()) {
+        printf("bounds-bench: no vertices\n");
+        return true;
+    }
+
+    const size_t targetCount = 4u << 20;
+    std::vector<Vertex> original;
+    original.reserve(targetCount + source.size());
+    while (original.size() < targetCount)
+        original.insert(original.end(), source.begin(), source.end());
+
+    const unsigned cores = (unsigned)ResolveThreadCount(0);
+    const int repeats = 10;
+    const float targetExtent = 10.0f;
+    printf("bounds-bench: %zu vertices (%.1f MB), %u cores, %d runs\n",
+        original.size(), original.size() * sizeof(Vertex) / (1024.0 * 1024.0), cores, repeats);
+
+    std::vector<Vertex> work;
+    BoundingBox scalarBox;
+    double scalarMs = 0.0;
+    for (int r = 0; r < repeats; r++) {
+        work = original;
+        auto start = std::chrono::steady_clock::now();
+        scalarBox = ScalarNormalize(work, targetExtent);
+        scalarMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    const std::vector<Vertex> scalarResult = work;
+    printf("  scalar:          %7.2f ms/run, %6.0f Mvertices/s\n",
+        scalarMs / repeats, original.size() * repeats / (scalarMs * 1000.0));
+
+    bool same = true;
+    for (unsigned threads : { 1u, cores }) {
+        double boundsMs = 0.0;
+        double normalizeMs = 0.0;
+        BoundingBox box;
+        for (int r = 0; r < repeats; r++) {
+            auto start = std::chrono::steady_clock::now();
+            ComputeMeshBounds(original.data(), original.size(), threads);
+            boundsMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            work = original;
+            start = std::chrono::steady_clock::now();
+            box = NormalizeMesh(work.data(), work.size(), targetExtent, threads);
+            normalizeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        same = same && memcmp(&box, &scalarBox, sizeof(BoundingBox)) == 0;
+        for (size_t i = 0; i < work.size() && same; i++)
+            same = memcmp(&work[i].position, &scalarResult[i].position, sizeof(XMFLOAT3)) == 0;
+
+        printf("  SIMD %2u threads: %7.2f ms/run, %6.0f Mvertices/s, x%.2f (bounds only %.2f ms)\n",
+            threads, normalizeMs / repeats, original.size() * repeats / (normalizeMs * 1000.0),
+            scalarMs / normalizeMs, boundsMs / repeats);
+        if (cores == 1)
+            break;
+    }
+
+    printf("bounds-bench: %s\n", same ? "matches scalar" : "MISMATCH");
+    return same;
+}
+
+int main(int argc, char** argv) {
+    bool boundsBench = false;
+    bool cullBench = false;
+    bool lodCheck = false;
+    bool occlusionBench = false;
+    bool parseBench = false;
+    bool streamCheck = false;
+    std::string occlusionDump;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--cull-bench")
+            cullBench = true;
+        else if (std::string(argv[i]) == "--bounds-bench")
+            boundsBench = true;
+        else if (std::string(argv[i]) == "--lod-check")
+            lodCheck = true;
+        else if (std::string(argv[i]) == "--occlusion-bench")
+            occlusionBench = true;
+        else if (std::string(argv[i]) == "--parse-bench")
+            parseBench = true;
+        else if (std::string(argv[i]) == "--stream-check")
+            streamCheck = true;
+        else if (std::string(argv[i]) == "--occlusion-dump" && i + 1 < argc) {
+            occlusionBench = true;
+            occlusionDump = argv[++i];
+        }
+        else
+            args.push_back(argv[i]);
+    }
+
+    if (args.empty()) {
+        printf("Usage: MeshBake [--cull-bench] [--bounds-bench] [--lod-check] [--occlusion-bench] [--occlusion-dump <prefix>] "
+            "[--parse-bench] [--stream-check] <input.obj> [output.meshcache]\n");
+        return 1;
+    }
+
+    const std::string sourcePath = args[0];
+    const std::string cachePath = (args.size() > 1) ? args[1] : MeshCachePath(sourcePath);
+
+    // ParallelFor разбора и замеров идёт заданиями; main - поток 0 системы
+    JobSystem jobs;
+
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t sourceHash = 0;
+    uint64_t sourceSize = 0;
+    if (!HashFile(sourcePath, sourceHash, sourceSize)) {
+        printf("Failed to open %s\n", sourcePath.c_str());
+        return 1;
+    }
+
+    // Как в BuildObj: все CPU-проходы по потоку позиций, в кэш - потоки без цвета
+    MeshStreams streams;
+    if (!LoadOBJ(sourcePath, streams)) {
+        printf("Failed to parse %s\n", sourcePath.c_str());
+        return 1;
+    }
+
+    // До OptimizeMesh: сравнение идёт с порядком вершин и граней файла. Vertex - только для проверок
+    int result = 0;
+    if (streamCheck || boundsBench) {
+        std::vector<Vertex> fileVertices;
+        streams.ToVertices(fileVertices);
+        if (streamCheck && !RunStreamCheck(sourcePath, fileVertices, streams.indices))
+            result = 2;
+        if (boundsBench && !RunBoundsBenchmark(fileVertices))
+            result = 2;
+    }
+
+    std::vector<MeshCluster> clusters;
+    MeshOptimizeReport report = OptimizeMesh(streams, &clusters);
+    const float* positions = &streams.positions[0].x;
+    const size_t vertexCount = streams.VertexCount();
+    std::vector<uint32_t>& indices = streams.indices;
+
+    auto meshletStart = std::chrono::steady_clock::now();
+    MeshletData meshlets;
+    BuildMeshlets(indices.data(), indices.size(), positions, vertexCount, sizeof(XMFLOAT3),
+        clusters.data(), clusters.size(), meshlets);
+    double meshletMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - meshletStart).count();
+
+    auto lodStart = std::chrono::steady_clock::now();
+    const size_t baseIndexCount = indices.size();
+    std::vector<MeshLod> lods;
+    BuildLodChain(indices, baseIndexCount, positions, vertexCount, sizeof(XMFLOAT3),
+        MESH_LOD_RATIOS, sizeof(MESH_LOD_RATIOS) / sizeof(MESH_LOD_RATIOS[0]), lods);
+    double lodMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - lodStart).count();
+
+    if (!WriteMeshCache(cachePath, sourceHash, sourceSize, streams, clusters, meshlets, lods)) {
+        printf("Failed to write %s\n", cachePath.c_str());
+        return 1;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    printf("%s -> %s: %zu vertices, %zu indices, %zu clusters (%.1f ms)\n",
+        sourcePath.c_str(), cachePath.c_str(), vertexCount, indices.size(), clusters.size(), ms);
+    printf("ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+        report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+
+    // Хэш мешлетов - проверка детерминизма между запусками и машинами
+    size_t coneCount = 0;
+    for (const MeshletBounds& b : meshlets.bounds)
+        coneCount += b.coneCutoff < 1.0f;
+    uint64_t meshletHash = HashBytes(meshlets.meshlets.data(), meshlets.meshlets.size() * sizeof(Meshlet));
+    meshletHash = HashBytes(meshlets.bounds.data(), meshlets.bounds.size() * sizeof(MeshletBounds), meshletHash);
+    meshletHash = HashBytes(meshlets.triangles.data(), meshlets.triangles.size(), meshletHash);
+    printf("%zu meshlets (%.1f vertices, %.1f triangles avg, %.1f%% with a usable cone) in %.1f ms, hash %016llx\n",
+        meshlets.meshlets.size(),
+        meshlets.meshlets.empty() ? 0.0 : (double)meshlets.vertices.size() / meshlets.meshlets.size(),
+        meshlets.meshlets.empty() ? 0.0 : (double)baseIndexCount / 3 / meshlets.meshlets.size(),
+        meshlets.meshlets.empty() ? 0.0 : 100.0 * coneCount / meshlets.meshlets.size(),
+        meshletMs, (unsigned long long)meshletHash);
+
+    printf("%zu LODs in %.1f ms:", lods.size(), lodMs);
+    for (const MeshLod& lod : lods)
+        printf(" %u tris (err %.4g)", lod.indexCount / 3, lod.error);
+    printf("\n");
+
+    // Заявленная ошибка LOD - максимум по всем вершинам: перебор по выборке её не превышает
+    if (lodCheck) {
+        const size_t sampleStep = std::max<size_t>(vertexCount / 2000, 1);
+        for (size_t i = 1; i < lods.size(); i++) {
+            float measured = MeasureSimplifyError(indices.data(), baseIndexCount,
+                indices.data() + lods[i].firstIndex, lods[i].indexCount,
+                positions, vertexCount, sizeof(XMFLOAT3), sampleStep);
+            bool ok = measured <= lods[i].error * 1.0001f + 1e-6f;
+            printf("lod-check LOD %zu: measured %.4g (sampled), reported %.4g %s\n",
+                i, measured, lods[i].error, ok ? "ok" : "EXCEEDED");
+            if (!ok)
+                result = 2;
+        }
+    }
+
+    if (cullBench)
+        RunCullBenchmark(clusters, meshlets);
+    if (occlusionBench)
+        RunOcclusionBenchmark(clusters, streams.positions, indices, baseIndexCount, occlusionDump);
+    if (parseBench && !RunParseBenchmark(sourcePath, sourceSize))
+        result = 2;
+    return result;
+}
@@ -0,0 +1,232 @@
+﻿#include "Bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+Frustum Frustum::FromMatrix(const XMFLOAT4X4& m)
+{
+    // Столбцы матрицы: clip = v * M, плоскости Грибба-Хартманна
+    float planes[6][4];
+    for (int k = 0; k < 4; k++)
+    {
+        const float c0 = m.m[k][0], c1 = m.m[k][1], c2 = m.m[k][2], c3 = m.m[k][3];
+        planes[0][k] = c3 + c0;   // левая
+        planes[1][k] = c3 - c0;   // правая
+        planes[2][k] = c3 + c1;   // нижняя
+        planes[3][k] = c3 - c1;   // верхняя
+        planes[4][k] = c2;        // ближняя (z >= 0)
+        planes[5][k] = c3 - c2;   // дальняя
+    }
+
+    // Порядок в SoA: 0..3 и 4, 5, 4, 5
+    static const int slots[8] = { 0, 1, 2, 3, 4, 5, 4, 5 };
+
+    Frustum f;
+    for (int g = 0; g < 2; g++)
+    {
+        float* dst[7] = { &f.a[g].x, &f.b[g].x, &f.c[g].x, &f.d[g].x, &f.absA[g].x, &f.absB[g].x, &f.absC[g].x };
+        for (int i = 0; i < 4; i++)
+        {
+            const float* p = planes[slots[g * 4 + i]];
+            float length = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            float inv = length > 0.0f ? 1.0f / length : 0.0f;
+
+            dst[0][i] = p[0] * inv;
+            dst[1][i] = p[1] * inv;
+            dst[2][i] = p[2] * inv;
+            dst[3][i] = p[3] * inv;
+            dst[4][i] = fabsf(dst[0][i]);
+            dst[5][i] = fabsf(dst[1][i]);
+            dst[6][i] = fabsf(dst[2][i]);
+        }
+    }
+    return f;
+}
+
+int Frustum::Classify(FXMVECTOR center, FXMVECTOR extents) const
+{
+    const XMVECTOR cx = XMVectorSplatX(center);
+    const XMVECTOR cy = XMVectorSplatY(center);
+    const XMVECTOR cz = XMVectorSplatZ(center);
+    const XMVECTOR ex = XMVectorSplatX(extents);
+    const XMVECTOR ey = XMVectorSplatY(extents);
+    const XMVECTOR ez = XMVectorSplatZ(extents);
+    const XMVECTOR zero = XMVectorZero();
+
+    bool inside = true;
+    for (int g = 0; g < 2; g++)
+    {
+        // Расстояние от центра до 4 плоскостей и радиус проекции коробки на их нормали
+        XMVECTOR dist = XMVectorMultiplyAdd(XMLoadFloat4(&a[g]), cx, XMLoadFloat4(&d[g]));
+        dist = XMVectorMultiplyAdd(XMLoadFloat4(&b[g]), cy, dist);
+        dist = XMVectorMultiplyAdd(XMLoadFloat4(&c[g]), cz, dist);
+
+        XMVECTOR radius = XMVectorMultiply(XMLoadFloat4(&absA[g]), ex);
+        radius = XMVectorMultiplyAdd(XMLoadFloat4(&absB[g]), ey, radius);
+        radius = XMVectorMultiplyAdd(XMLoadFloat4(&absC[g]), ez, radius);
+
+        // Хоть одна плоскость целиком отсекает коробку
+        if (!XMVector4GreaterOrEqual(XMVectorAdd(dist, radius), zero))
+            return -1;
+        inside = inside && XMVector4GreaterOrEqual(XMVectorSubtract(dist, radius), zero);
+    }
+    return inside ? 1 : 0;
+}
+
+bool Frustum::IsSphereOutside(FXMVECTOR center, float radius) const
+{
+    const XMVECTOR cx = XMVectorSplatX(center);
+    const XMVECTOR cy = XMVectorSplatY(center);
+    const XMVECTOR cz = XMVectorSplatZ(center);
+    const XMVECTOR negRadius = XMVectorReplicate(-radius);
+
+    for (int g = 0; g < 2; g++)
+    {
+        XMVECTOR dist = XMVectorMultiplyAdd(XMLoadFloat4(&a[g]), cx, XMLoadFloat4(&d[g]));
+        dist = XMVectorMultiplyAdd(XMLoadFloat4(&b[g]), cy, dist);
+        dist = XMVectorMultiplyAdd(XMLoadFloat4(&c[g]), cz, dist);
+        if (!XMVector4GreaterOrEqual(dist, negRadius))
+            return true;
+    }
+    return false;
+}
+
+void Bvh::Clear()
+{
+    mNodes.clear();
+    mItems.clear();
+    mItemCenters.clear();
+    mItemExtents.clear();
+}
+
+void Bvh::Build(const XMFLOAT3* boundsMin, const XMFLOAT3* boundsMax, size_t count, uint32_t maxLeafItems)
+{
+    Clear();
+    if (count == 0)
+        return;
+    maxLeafItems = std::max(maxLeafItems, 1u);
+
+    std::vector<XMFLOAT3> centers(count);
+    std::vector<XMFLOAT3> extents(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        XMVECTOR lo = XMLoadFloat3(&boundsMin[i]);
+        XMVECTOR hi = XMLoadFloat3(&boundsMax[i]);
+        XMStoreFloat3(&centers[i], XMVectorScale(XMVectorAdd(lo, hi), 0.5f));
+        XMStoreFloat3(&extents[i], XMVectorScale(XMVectorSubtract(hi, lo), 0.5f));
+    }
+
+    mItems.resize(count);
+    for (size_t i = 0; i < count; i++)
+        mItems[i] = (uint32_t)i;
+
+    mNodes.reserve(2 * count);
+    mNodes.push_back(BvhNode{ XMFLOAT3(0, 0, 0), 0, XMFLOAT3(0, 0, 0), (uint32_t)count, 0 });
+
+    std::vector<uint32_t> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const uint32_t nodeIndex = stack.back();
+        stack.pop_back();
+
+        const uint32_t first = mNodes[nodeIndex].firstItem;
+        const uint32_t itemCount = mNodes[nodeIndex].itemCount;
+
+        // Габариты узла и центров элементов
+        XMVECTOR lo = XMVectorReplicate(FLT_MAX), hi = XMVectorReplicate(-FLT_MAX);
+        XMVECTOR centerLo = lo, centerHi = hi;
+        for (uint32_t i = first; i < first + itemCount; i++)
+        {
+            const uint32_t item = mItems[i];
+            lo = XMVectorMin(lo, XMLoadFloat3(&boundsMin[item]));
+            hi = XMVectorMax(hi, XMLoadFloat3(&boundsMax[item]));
+            centerLo = XMVectorMin(centerLo, XMLoadFloat3(&centers[item]));
+            centerHi = XMVectorMax(centerHi, XMLoadFloat3(&centers[item]));
+        }
+        XMStoreFloat3(&mNodes[nodeIndex].center, XMVectorScale(XMVectorAdd(lo, hi), 0.5f));
+        XMStoreFloat3(&mNodes[nodeIndex].extents, XMVectorScale(XMVectorSubtract(hi, lo), 0.5f));
+
+        if (itemCount <= maxLeafItems)
+            continue;
+
+        XMFLOAT3 spread;
+        XMStoreFloat3(&spread, XMVectorSubtract(centerHi, centerLo));
+        int axis = 0;
+        if (spread.y > (&spread.x)[axis]) axis = 1;
+        if (spread.z > (&spread.x)[axis]) axis = 2;
+
+        const uint32_t mid = first + itemCount / 2;
+        std::nth_element(mItems.begin() + first, mItems.begin() + mid, mItems.begin() + first + itemCount,
+            [&](uint32_t l, uint32_t r) { return (&centers[l].x)[axis] < (&centers[r].x)[axis]; });
+
+        const uint32_t left = (uint32_t)mNodes.size();
+        mNodes[nodeIndex].leftChild = left;
+        mNodes.push_back(BvhNode{ XMFLOAT3(0, 0, 0), first, XMFLOAT3(0, 0, 0), mid - first, 0 });
+        mNodes.push_back(BvhNode{ XMFLOAT3(0, 0, 0), mid, XMFLOAT3(0, 0, 0), first + itemCount - mid, 0 });
+
+        stack.push_back(left + 1);
+        stack.push_back(left);
+    }
+
+    mItemCenters.resize(count);
+    mItemExtents.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        mItemCenters[i] = centers[mItems[i]];
+        mItemExtents[i] = extents[mItems[i]];
+    }
+}
+
+void Bvh::Cull(const Frustum& frustum, std::vector<uint32_t>& outVisible, CullStats* stats) const
+{
+    CullStats local;
+    const size_t visibleBefore = outVisible.size();
+
+    if (!mNodes.empty())
+    {
+        uint32_t stack[64];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            const BvhNode& node = mNodes[stack[--stackSize]];
+
+            local.nodesTested++;
+            const int result = frustum.Classify(XMLoadFloat3(&node.center), XMLoadFloat3(&node.extents));
+            if (result < 0)
+                continue;
+
+            if (result > 0)
+            {
+                outVisible.insert(outVisible.end(),
+                    mItems.begin() + node.firstItem, mItems.begin() + node.firstItem + node.itemCount);
+                continue;
+            }
+
+            if (node.leftChild != 0)
+            {
+                stack[stackSize++] = node.leftChild + 1;
+                stack[stackSize++] = node.leftChild;
+                continue;
+            }
+
+            // Пересекающий лист: элементы по одному (корень-лист тоже сюда)
+            for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+            {
+                local.itemsTested++;
+                if (frustum.Classify(XMLoadFloat3(&mItemCenters[i]), XMLoadFloat3(&mItemExtents[i])) >= 0)
+                    outVisible.push_back(mItems[i]);
+            }
+        }
+    }
+
+    local.itemsVisible = (uint32_t)(outVisible.size() - visibleBefore);
+    local.itemsCulled = (uint32_t)mItems.size() - local.itemsVisible;
+    if (stats)
+        *stats = local;
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ===== Пирамида видимости =====
+// Шесть плоскостей в SoA-виде: a, b, c, d по четыре плоскости в XMVECTOR (вторая группа
+// дополнена повтором), так что проверка AABB - два прохода по 4 плоскости без ветвлений внутри
+struct Frustum
+{
+    DirectX::XMFLOAT4 a[2], b[2], c[2], d[2];
+    DirectX::XMFLOAT4 absA[2], absB[2], absC[2];   // |нормаль| для радиуса проекции AABB
+
+    // Плоскости из матрицы вида v * M (DirectXMath, z клипа в [0; 1]).
+    // Для world * view * proj пирамида получается в пространстве объекта
+    static Frustum FromMatrix(const DirectX::XMFLOAT4X4& m);
+
+    // -1 - снаружи, 0 - пересекает, 1 - целиком внутри
+    int Classify(DirectX::FXMVECTOR center, DirectX::FXMVECTOR extents) const;
+
+    // Сфера целиком за одной из плоскостей
+    bool IsSphereOutside(DirectX::FXMVECTOR center, float radius) const;
+};
+
+struct BvhNode
+{
+    DirectX::XMFLOAT3 center;
+    uint32_t firstItem;      // элементы поддерева - непрерывный диапазон Bvh::Items()
+    DirectX::XMFLOAT3 extents;
+    uint32_t itemCount;
+    uint32_t leftChild;      // 0 - лист; иначе дети leftChild и leftChild + 1
+};
+
+struct CullStats
+{
+    uint32_t nodesTested = 0;
+    uint32_t itemsTested = 0;     // элементы, проверенные по отдельности в пересекающих листьях
+    uint32_t itemsVisible = 0;
+    uint32_t itemsCulled = 0;
+};
+
+// BVH над AABB (медианное деление по длинной оси центров). Узел целиком внутри пирамиды
+// отдаёт всё поддерево без проверок, снаружи - отбрасывает
+class Bvh
+{
+public:
+    void Build(const DirectX::XMFLOAT3* boundsMin, const DirectX::XMFLOAT3* boundsMax,
+        size_t count, uint32_t maxLeafItems = 2);
+    void Clear();
+
+    // Индексы видимых элементов (в нумерации Build) дописываются в outVisible
+    void Cull(const Frustum& frustum, std::vector<uint32_t>& outVisible, CullStats* stats = nullptr) const;
+
+    size_t ItemCount() const { return mItems.size(); }
+    const std::vector<BvhNode>& Nodes() const { return mNodes; }
+    const std::vector<uint32_t>& Items() const { return mItems; }
+
+private:
+    std::vector<BvhNode> mNodes;
+    std::vector<uint32_t> mItems;                  // порядок элементов по листьям
+    std::vector<DirectX::XMFLOAT3> mItemCenters;   // в порядке mItems
+    std::vector<DirectX::XMFLOAT3> mItemExtents;
+};
@@ -3,6 +3,14 @@
 #include <dxgi1_6.h>
 #include <d3dcompiler.h>
 #include "d3dUtil.h"
+#include "Parser.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshBounds.h"
+#include "MeshStreams.h"
+#include "QuantizedVertex.h"
+#include <algorithm>
+#include <cstdio>
 #include <string>
 #include <DirectXMath.h>
 
@@ -31,71 +39,9 @@ struct CD3DX12_RESOURCE_BARRIER_HELPER {
     }
 };
 
-// Вспомогательные структуры CD3DX12 (как на слайдах)
-struct CD3DX12_DEFAULT {};
-extern const DECLSPEC_SELECTANY CD3DX12_DEFAULT D3D12_DEFAULT;
-
-struct CD3DX12_RASTERIZER_DESC : public D3D12_RASTERIZER_DESC
-{
-    CD3DX12_RASTERIZER_DESC() = default;
-    explicit CD3DX12_RASTERIZER_DESC(const D3D12_RASTERIZER_DESC& o) : D3D12_RASTERIZER_DESC(o) {}
-    explicit CD3DX12_RASTERIZER_DESC(CD3DX12_DEFAULT)
-    {
-        FillMode = D3D12_FILL_MODE_SOLID;
-        CullMode = D3D12_CULL_MODE_BACK;
-        FrontCounterClockwise = FALSE;
-        DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
-        DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
-        SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
-        DepthClipEnable = TRUE;
-        MultisampleEnable = FALSE;
-        AntialiasedLineEnable = FALSE;
-        ForcedSampleCount = 0;
-        ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-    }
-};
-
-struct CD3DX12_BLEND_DESC : public D3D12_BLEND_DESC
-{
-    CD3DX12_BLEND_DESC() = default;
-    explicit CD3DX12_BLEND_DESC(const D3D12_BLEND_DESC& o) : D3D12_BLEND_DESC(o) {}
-    explicit CD3DX12_BLEND_DESC(CD3DX12_DEFAULT)
-    {
-        AlphaToCoverageEnable = FALSE;
-        IndependentBlendEnable = FALSE;
-        const D3D12_RENDER_TARGET_BLEND_DESC defaultRenderTargetBlendDesc =
-        {
-            FALSE,FALSE,
-            D3D12_BLEND_ONE, D3D12_BLEND_ZERO, D3D12_BLEND_OP_ADD,
-            D3D12_BLEND_ONE, D3D12_BLEND_ZERO, D3D12_BLEND_OP_ADD,
-            D3D12_LOGIC_OP_NOOP,
-            D3D12_COLOR_WRITE_ENABLE_ALL,
-        };
-        for (UINT i = 0; i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
-            RenderTarget[i] = defaultRenderTargetBlendDesc;
-    }
-};
-
-struct CD3DX12_DEPTH_STENCIL_DESC : public D3D12_DEPTH_STENCIL_DESC
-{
-    CD3DX12_DEPTH_STENCIL_DESC() = default;
-    explicit CD3DX12_DEPTH_STENCIL_DESC(const D3D12_DEPTH_STENCIL_DESC& o) : D3D12_DEPTH_STENCIL_DESC(o) {}
-    explicit CD3DX12_DEPTH_STENCIL_DESC(CD3DX12_DEFAULT)
-    {
-        DepthEnable = TRUE;
-        DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-        DepthFunc = D3D12_COMPARISON_FUNC_LESS;
-        StencilEnable = FALSE;
-        StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
-        StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
-        const D3D12_DEPTH_STENCILOP_DESC defaultStencilOp =
-        { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
-        FrontFace = defaultStencilOp;
-        BackFace = defaultStencilOp;
-    }
-};
-
-DirectXApp::DirectXApp(Window& window) : window(window)
+DirectXApp::DirectXApp(Window& window, UINT frameResourceCount)
+    : window(window)
+    , mFrameResourceCount(frameResourceCount ? frameResourceCount : 1)
 {
     // Инициализируем матрицы
     XMStoreFloat4x4(&mWorld, XMMatrixIdentity());
@@ -146,451 +92,611 @@ void DirectXApp::OnMouseMove(WPARAM btnState, int x, int y)
 }
 
 // =========== Input Layout ===========
+// Зависит от mMeshColored: BuildObj пересобирает раскладку, когда поток цвета известен
 void DirectXApp::BuildInputLayout()
 {
     mInputLayout =
     {
         { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,
-          D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12,
           D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
     };
+    if (mMeshColored)
+    {
+        mInputLayout.push_back({ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12,
+            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+    }
+
+    mQuantizedInputLayout = GetQuantizedInputLayout(mMeshColored);
 }
 
 // =========== Шейдеры ===========
 void DirectXApp::BuildShaders()
 {
-    mvsByteCode = d3dUtil::CompileShader(
-        L"shaders.hlsl",
+    // Обычно байткод уже лежит в кэше (ShaderBake при сборке); иначе компиляция и запись
+    mvsByteCode = d3dUtil::CompileShaderCached(
+        mShaderCache,
+        "shaders.hlsl",
         nullptr,
-        "VS",
+        mMeshColored ? "VSInstanced" : "VSInstancedNoColor",
         "vs_5_0"
     );
 
-    mpsByteCode = d3dUtil::CompileShader(
-        L"shaders.hlsl",
+    mpsByteCode = d3dUtil::CompileShaderCached(
+        mShaderCache,
+        "shaders.hlsl",
         nullptr,
         "PS",
         "ps_5_0"
     );
 
-    MessageBox(NULL, L"SUCCESS! Shaders compiled", L"Info", MB_OK);
+    mvsQuantizedByteCode = d3dUtil::CompileShaderCached(
+        mShaderCache,
+        "shaders.hlsl",
+        nullptr,
+        mMeshColored ? "VSQuantized" : "VSQuantizedNoColor",
+        "vs_5_0"
+    );
+
+    const ShaderCacheStats& stats = mShaderCache.GetStats();
+    char message[128];
+    snprintf(message, sizeof(message), "Shader cache: %u hits, %u misses, %u rejected\n",
+        stats.hits, stats.misses, stats.rejected);
+    OutputDebugStringA(message);
+
+    MessageBox(NULL, L"SUCCESS! Shaders loaded", L"Info", MB_OK);
 }
 
-// =========== Константный буфер и CBV ===========
+// =========== Константный буфер ===========
 void DirectXApp::BuildConstantBuffer()
 {
-    // 1. Создаем UploadBuffer для констант
-    mObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(
-        device.Get(),
-        1,
-        true
-    );
-
-    // 2. Инициализируем матрицу (орфографическая проекция)
+    // 1. Начальная матрица (орфографическая проекция)
     ObjectConstants objConstants;
     XMMATRIX view = XMMatrixIdentity();
     XMMATRIX proj = XMMatrixOrthographicLH(10.0f, 10.0f, 0.1f, 100.0f);
     XMMATRIX viewProj = view * proj;
     XMStoreFloat4x4(&objConstants.mWorldViewProj, XMMatrixTranspose(viewProj));
 
-    mObjectCB->CopyData(0, objConstants);
-
-    // 3. Создаем CBV (Constant Buffer View) в куче дескрипторов
-    UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
-    D3D12_GPU_VIRTUAL_ADDRESS cbAddress = mObjectCB->Resource()->GetGPUVirtualAddress();
+    // 2. Константы для каждого кадра в полёте; сами данные живут в кольце загрузки
+    mFrameConstants.assign(mFrameResourceCount, 0);
+    for (UINT i = 0; i < mFrameResourceCount; i++)
+        WriteObjectConstants(i, objConstants);
 
-    D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
-    cbvDesc.BufferLocation = cbAddress;
-    cbvDesc.SizeInBytes = objCBByteSize;
+    MessageBox(NULL, L"Constant buffer created", L"Info", MB_OK);
+}
 
-    // Получаем дескриптор из CBV кучи
-    D3D12_CPU_DESCRIPTOR_HANDLE cbvHandle = mCbvHeap->GetCPUDescriptorHandleForHeapStart();
-    device->CreateConstantBufferView(&cbvDesc, cbvHandle);
+// Копирует константы в кольцо и запоминает адрес для корневого CBV кадра.
+// Слот frameIndex к этому моменту уже свободен (FrameRing::BeginFrame)
+void DirectXApp::WriteObjectConstants(UINT frameIndex, const ObjectConstants& constants)
+{
+    UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
+    UploadAllocation alloc = AllocateUpload(objCBByteSize, UploadRing::CONSTANT_BUFFER_ALIGNMENT);
+    if (!alloc)
+        return;
 
-    MessageBox(NULL, L"Constant buffer and CBV created", L"Info", MB_OK);
+    memcpy(alloc.cpu, &constants, sizeof(ObjectConstants));
+    mFrameConstants[frameIndex] = alloc.gpu;
 }
 
 // =========== Root Signature ===========
 void DirectXApp::BuildRootSignature()
 {
-    // 1. Диапазон дескрипторов для CBV (Descriptor Table подход)
-    D3D12_DESCRIPTOR_RANGE cbvRange;
-    cbvRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
-    cbvRange.NumDescriptors = 1;           // 1 CBV
-    cbvRange.BaseShaderRegister = 0;       // register(b0)
-    cbvRange.RegisterSpace = 0;
-    cbvRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-    // 2. Корневой параметр как таблица дескрипторов
-    D3D12_ROOT_PARAMETER slotRootParameter[1];
-    slotRootParameter[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-    slotRootParameter[0].DescriptorTable.NumDescriptorRanges = 1;
-    slotRootParameter[0].DescriptorTable.pDescriptorRanges = &cbvRange;
-    slotRootParameter[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-
-    // 3. Описание корневой сигнатуры
-    D3D12_ROOT_SIGNATURE_DESC rootSigDesc;
-    rootSigDesc.NumParameters = 1;
-    rootSigDesc.pParameters = slotRootParameter;
-    rootSigDesc.NumStaticSamplers = 0;
-    rootSigDesc.pStaticSamplers = nullptr;
-    rootSigDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
-
-    // 4. Сериализация и создание
-    Microsoft::WRL::ComPtr<ID3DBlob> serializedRootSig = nullptr;
-    Microsoft::WRL::ComPtr<ID3DBlob> errorBlob = nullptr;
-
-    HRESULT hr = D3D12SerializeRootSignature(&rootSigDesc, D3D_ROOT_SIGNATURE_VERSION_1,
-        &serializedRootSig, &errorBlob);
-
-    if (errorBlob) {
-        OutputDebugStringA((char*)errorBlob->GetBufferPointer());
+    // Только корневые параметры: на горячем пути нет ни записи дескрипторов, ни SetDescriptorHeaps
+    RootSignatureBuilder builder;
+    builder.AddCbv(0);                                        // b0: ObjectConstants кадра
+    builder.AddSrv(0, 0, RootVisibility::Vertex);             // t0: матрицы экземпляров
+    builder.AddConstants(1, 1, 0, RootVisibility::Vertex);    // b1: начало группы экземпляров
+
+    OutputDebugStringA(builder.Describe().c_str());
+    mRootSignatureKey = builder.Hash();
+
+    std::string errors;
+    HRESULT hr = builder.Build(device.Get(),
+        D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT, mRootSignature, &errors);
+
+    if (!errors.empty()) {
+        OutputDebugStringA(errors.c_str());
     }
 
     if (FAILED(hr)) {
-        MessageBox(NULL, L"Failed to serialize root signature", L"Error", MB_OK);
+        MessageBox(NULL, L"Failed to create root signature", L"Error", MB_OK);
         return;
     }
 
-    hr = device->CreateRootSignature(0,
-        serializedRootSig->GetBufferPointer(),
-        serializedRootSig->GetBufferSize(),
-        IID_PPV_ARGS(&mRootSignature));
-
-    if (SUCCEEDED(hr)) {
-        MessageBox(NULL, L"Root Signature created (Descriptor Table)", L"Info", MB_OK);
-    }
+    MessageBox(NULL, L"Root Signature created (root CBV/SRV + constants)", L"Info", MB_OK);
 }
 
 // =========== PSO (Pipeline State Object) ===========
-void DirectXApp::BuildPSO()
+void DirectXApp::BuildPipelineDescs()
 {
-    // Создаем описание PSO (как на слайде 20.26.54)
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
-    ZeroMemory(&psoDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
-
-    // 1. Шейдеры (как на слайде)
-    psoDesc.VS = {
-        reinterpret_cast<BYTE*>(mvsByteCode->GetBufferPointer()),
-        mvsByteCode->GetBufferSize()
-    };
-    psoDesc.PS = {
-        reinterpret_cast<BYTE*>(mpsByteCode->GetBufferPointer()),
-        mpsByteCode->GetBufferSize()
+    // Общая часть: шейдеры, раскладка вершин, корневая сигнатура, форматы целей
+    PipelineDesc desc;
+    desc.vs = MakeShaderRef(mvsByteCode->GetBufferPointer(), mvsByteCode->GetBufferSize());
+    desc.ps = MakeShaderRef(mpsByteCode->GetBufferPointer(), mpsByteCode->GetBufferSize());
+    desc.rootSignatureKey = mRootSignatureKey;
+
+    auto toPipelineLayout = [](const std::vector<D3D12_INPUT_ELEMENT_DESC>& layout) {
+        std::vector<PipelineInputElement> elements;
+        for (const D3D12_INPUT_ELEMENT_DESC& element : layout) {
+            PipelineInputElement e;
+            e.semantic = element.SemanticName;
+            e.semanticIndex = element.SemanticIndex;
+            e.format = element.Format;
+            e.slot = element.InputSlot;
+            e.offset = element.AlignedByteOffset;
+            e.perInstance = element.InputSlotClass == D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA;
+            e.stepRate = element.InstanceDataStepRate;
+            elements.push_back(e);
+        }
+        return elements;
     };
-
-    // 2. Input Layout
-    psoDesc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
-
-    // 3. Корневая сигнатура
-    psoDesc.pRootSignature = mRootSignature.Get();
-
-    // 4. Растеризатор (используем CD3DX12_RASTERIZER_DESC как на слайде)
-    psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-
-    // 5. Blend State (как на слайде)
-    psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-
-    // 6. Depth/Stencil State (как на слайде)
-    psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
-
-    // 7. Sample Mask
-    psoDesc.SampleMask = UINT_MAX;
-
-    // 8. Примитивы
-    psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-
-    // 9. Render Targets
-    psoDesc.NumRenderTargets = 1;
-    psoDesc.RTVFormats[0] = mBackBufferFormat;
-
-    // 10. Формат Depth/Stencil
-    psoDesc.DSVFormat = mDepthStencilFormat;
-
-    // 11. Multisampling
-    psoDesc.SampleDesc.Count = 1;
-    psoDesc.SampleDesc.Quality = 0;
-
-    // 12. Создание PSO
-    HRESULT hr = device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&mPSO));
-    if (FAILED(hr)) {
+    desc.inputLayout = toPipelineLayout(mInputLayout);
+
+    desc.topologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    desc.renderTargetCount = 1;
+    desc.rtvFormats[0] = mBackBufferFormat;
+    desc.dsvFormat = mDepthStencilFormat;
+    desc.sampleCount = 1;
+
+    // Сплошной режим: состояния по умолчанию
+    mSolidPipeline = desc;
+
+    // Проволочный каркас: без отсечения граней
+    mWireframePipeline = desc;
+    mWireframePipeline.fill = FillMode::Wireframe;
+    mWireframePipeline.cull = CullMode::None;
+
+    // Сжатые вершины: другой VS и раскладка, остальное то же
+    mQuantizedSolidPipeline = mSolidPipeline;
+    mQuantizedSolidPipeline.vs = MakeShaderRef(
+        mvsQuantizedByteCode->GetBufferPointer(), mvsQuantizedByteCode->GetBufferSize());
+    mQuantizedSolidPipeline.inputLayout = toPipelineLayout(mQuantizedInputLayout);
+
+    mQuantizedWireframePipeline = mQuantizedSolidPipeline;
+    mQuantizedWireframePipeline.fill = FillMode::Wireframe;
+    mQuantizedWireframePipeline.cull = CullMode::None;
+
+    // Сплошной нужен на первом же кадре; проволочный создастся при первом переключении
+    if (!mPipelineCache.Get(mSolidPipeline, mRootSignature.Get())) {
         MessageBox(NULL, L"Failed to create PSO", L"Error", MB_OK);
         return;
     }
 
-    MessageBox(NULL, L"PSO created successfully (Solid Mode)", L"Info", MB_OK);
+    const PipelineCacheStats& stats = mPipelineCache.GetStats();
+    char message[160];
+    snprintf(message, sizeof(message), "Pipeline cache: %u created, %u from disk blobs, %u blobs rejected\n",
+        stats.misses, stats.blobHits, stats.blobRejected);
+    OutputDebugStringA(message);
 }
 
-// =========== Wireframe PSO ===========
-void DirectXApp::BuildWireframePSO()
+// =========== Вершинный буфер ===========
+void DirectXApp::BuildVertexBuffer()
 {
-    // Создаем описание PSO для проволочного каркаса
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC wireframePsoDesc;
-    ZeroMemory(&wireframePsoDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
-
-    // 1. Шейдеры (те же самые)
-    wireframePsoDesc.VS = {
-        reinterpret_cast<BYTE*>(mvsByteCode->GetBufferPointer()),
-        mvsByteCode->GetBufferSize()
-    };
-    wireframePsoDesc.PS = {
-        reinterpret_cast<BYTE*>(mpsByteCode->GetBufferPointer()),
-        mpsByteCode->GetBufferSize()
-    };
-
-    // 2. Input Layout
-    wireframePsoDesc.InputLayout = { mInputLayout.data(), (UINT)mInputLayout.size() };
-
-    // 3. Корневая сигнатура
-    wireframePsoDesc.pRootSignature = mRootSignature.Get();
+    const UINT64 vbByteSize = cubeVertexCount * sizeof(Vertex);
 
-    // 4. Растеризатор - НАСТРОЙКА ДЛЯ ПРОВОЛОЧНОГО КАРКАСА
-    wireframePsoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-    wireframePsoDesc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;  // ПРОВОЛОЧНЫЙ КАРКАС
-    wireframePsoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;       // БЕЗ ОБРЕЗКИ
+    // Только ставит копию в пакет; отправка - mUploadScheduler.Submit()
+    mVertexBufferGPU = mUploadScheduler.QueueBuffer(cubeVertices, vbByteSize, mVertexBufferAlloc);
 
-    // 5. Blend State
-    wireframePsoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    if (!mVertexBufferGPU)
+        return;
 
-    // 6. Depth/Stencil State
-    wireframePsoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+    // Vertex Buffer View
+    mVertexBufferView.BufferLocation = mVertexBufferGPU->GetGPUVirtualAddress();
+    mVertexBufferView.SizeInBytes = vbByteSize;
+    mVertexBufferView.StrideInBytes = sizeof(Vertex);
+}
 
-    // 7. Sample Mask
-    wireframePsoDesc.SampleMask = UINT_MAX;
+// =========== Индексный буфер ===========
+void DirectXApp::BuildIndexBuffer()
+{
+    const UINT64 ibByteSize = cubeIndexCount * sizeof(std::uint16_t);
 
-    // 8. Примитивы
-    wireframePsoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    // Только ставит копию в пакет; отправка - mUploadScheduler.Submit()
+    mIndexBufferGPU = mUploadScheduler.QueueBuffer(cubeIndices, ibByteSize, mIndexBufferAlloc);
 
-    // 9. Render Targets
-    wireframePsoDesc.NumRenderTargets = 1;
-    wireframePsoDesc.RTVFormats[0] = mBackBufferFormat;
+    if (!mIndexBufferGPU)
+        return;
 
-    // 10. Формат Depth/Stencil
-    wireframePsoDesc.DSVFormat = mDepthStencilFormat;
+    // Index Buffer View
+    mIndexBufferView.BufferLocation = mIndexBufferGPU->GetGPUVirtualAddress();
+    mIndexBufferView.SizeInBytes = ibByteSize;
+    mIndexBufferView.Format = DXGI_FORMAT_R16_UINT;
 
-    // 11. Multisampling
-    wireframePsoDesc.SampleDesc.Count = 1;
-    wireframePsoDesc.SampleDesc.Quality = 0;
+    MessageBox(NULL, L"Index buffer created", L"Info", MB_OK);
+}
 
-    // 12. Создание PSO
-    HRESULT hr = device->CreateGraphicsPipelineState(&wireframePsoDesc, IID_PPV_ARGS(&mWireframePSO));
-    if (FAILED(hr)) {
-        MessageBox(NULL, L"Failed to create Wireframe PSO", L"Error", MB_OK);
+// =========== Геометрия из OBJ ===========
+void DirectXApp::BuildObj(const std::string& path)
+{
+    uint64_t sourceHash = 0;
+    uint64_t sourceSize = 0;
+    if (!HashFile(path, sourceHash, sourceSize)) {
+        MessageBox(NULL, L"Failed to open OBJ file", L"Error", MB_OK);
         return;
     }
 
-    MessageBox(NULL, L"Wireframe PSO created successfully", L"Info", MB_OK);
-}
+    // 1. Бинарный кэш рядом с OBJ: если хэш исходника совпал, грузим из него.
+    //    Меш - раздельные потоки: CPU-проходы читают только позиции (шаг 12 байт).
+    //    Указатели ниже смотрят либо в отображённый файл, либо в streams - копий при попадании нет
+    const std::string cachePath = MeshCachePath(path);
+    MeshCacheView cache;
+    MeshStreams streams;
+
+    const XMFLOAT3* positions = nullptr;
+    const XMFLOAT3* normals = nullptr;
+    size_t vertexCount = 0;
+    const uint32_t* indexData = nullptr;
+    UINT64 ibByteSize = 0;
+    UINT indexCount = 0;
+
+    if (cache.Open(cachePath, sourceHash, sourceSize)) {
+        const MeshCacheHeader& header = cache.Header();
+        positions = cache.Positions();
+        normals = cache.Normals();
+        vertexCount = header.vertexCount;
+        indexData = cache.Indices();
+        ibByteSize = cache.IndexByteSize();
+        indexCount = header.indexCount;
+
+        XMStoreFloat3(&mMeshCenter, XMVectorScale(
+            XMVectorAdd(XMLoadFloat3(&header.boundsMin), XMLoadFloat3(&header.boundsMax)), 0.5f));
+        mMeshRadius = 0.5f * XMVectorGetX(XMVector3Length(
+            XMVectorSubtract(XMLoadFloat3(&header.boundsMax), XMLoadFloat3(&header.boundsMin))));
+
+        mClusters.assign(cache.Clusters(), cache.Clusters() + header.clusterCount);
+        mLods.assign(cache.Lods(), cache.Lods() + header.lodCount);
+        mMeshlets.meshlets.assign(cache.Meshlets(), cache.Meshlets() + header.meshletCount);
+        mMeshlets.bounds.assign(cache.MeshletBoundsData(), cache.MeshletBoundsData() + header.meshletCount);
+        mMeshlets.vertices.assign(cache.MeshletVertices(), cache.MeshletVertices() + header.meshletVertexCount);
+        mMeshlets.triangles.assign(cache.MeshletTriangles(), cache.MeshletTriangles() + header.meshletTriangleBytes);
+    }
+    else {
+        if (!LoadOBJ(path, streams)) {
+            MessageBox(NULL, L"Failed to load OBJ file", L"Error", MB_OK);
+            return;
+        }
 
-// =========== Вершинный буфер ===========
-void DirectXApp::BuildVertexBuffer()
-{
-    const UINT64 vbByteSize = cubeVertexCount * sizeof(Vertex);
+        // Габариты от порядка вершин не зависят - считаем по плотному потоку позиций
+        BoundingBox bounds = ComputeMeshBounds(streams.positions.data(), streams.VertexCount());
+        mMeshCenter = bounds.Center;
+        mMeshRadius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.Extents)));
+
+        // Кластеры для отсечения, порядок треугольников и вершин под кэш GPU;
+        // в кэш меша пишется уже оптимизированный
+        MeshOptimizeReport report = OptimizeMesh(streams, &mClusters);
+        char message[160];
+        snprintf(message, sizeof(message), "OptimizeMesh: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+            report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+        OutputDebugStringA(message);
+
+        // Мешлеты по готовому порядку индексов, внутри кластеров
+        positions = streams.positions.data();
+        normals = streams.normals.empty() ? nullptr : streams.normals.data();
+        vertexCount = streams.VertexCount();
+        BuildMeshlets(streams.indices.data(), streams.indices.size(), &positions->x, vertexCount,
+            sizeof(XMFLOAT3), mClusters.data(), mClusters.size(), mMeshlets);
+
+        // LOD - упрощённые копии базового меша в том же индексном буфере, следом за ним
+        BuildLodChain(streams.indices, streams.indices.size(), &positions->x, vertexCount, sizeof(XMFLOAT3),
+            MESH_LOD_RATIOS, sizeof(MESH_LOD_RATIOS) / sizeof(MESH_LOD_RATIOS[0]), mLods);
+        for (size_t i = 0; i < mLods.size(); i++) {
+            snprintf(message, sizeof(message), "LOD %zu: %u triangles, error %.4f\n",
+                i, mLods[i].indexCount / 3, mLods[i].error);
+            OutputDebugStringA(message);
+        }
 
-    // 1. Буфер в DEFAULT куче
-    D3D12_HEAP_PROPERTIES defaultHeapProps = {};
-    defaultHeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-
-    D3D12_RESOURCE_DESC bufferDesc = {};
-    bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    bufferDesc.Width = vbByteSize;
-    bufferDesc.Height = 1;
-    bufferDesc.DepthOrArraySize = 1;
-    bufferDesc.MipLevels = 1;
-    bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
-    bufferDesc.SampleDesc.Count = 1;
-    bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-
-    HRESULT hr = device->CreateCommittedResource(
-        &defaultHeapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &bufferDesc,
-        D3D12_RESOURCE_STATE_COMMON,
-        nullptr,
-        IID_PPV_ARGS(&mVertexBufferGPU)
-    );
+        WriteMeshCache(cachePath, sourceHash, sourceSize, streams, mClusters, mMeshlets, mLods);
 
-    if (FAILED(hr)) {
-        MessageBox(NULL, L"Failed to create vertex buffer", L"Error", MB_OK);
-        return;
+        indexData = streams.indices.data();
+        ibByteSize = streams.indices.size() * sizeof(uint32_t);
+        indexCount = (UINT)streams.indices.size();
     }
 
-    // 2. UPLOAD буфер
-    D3D12_HEAP_PROPERTIES uploadHeapProps = {};
-    uploadHeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+    // 2. Буфер вершин под mInputLayout. Меш без цвета (OBJ, кэш) - только позиции, и поток позиций
+    //    уходит в upload-кольцо как есть; с цветом вершины чередуются здесь (нормаль шейдеру не нужна)
+    mMeshColored = !streams.colors.empty();
+    BuildInputLayout();
+
+    uint32_t vertexStride = 0;
+    const std::vector<VertexElement> elements = VertexElementsFromLayout(mInputLayout, vertexStride);
+    std::vector<uint8_t> interleaved;
+    const void* vertexData = positions;
+    if (mMeshColored) {
+        interleaved.resize(vertexCount * vertexStride);
+        streams.Interleave(elements.data(), elements.size(), vertexStride, interleaved.data());
+        vertexData = interleaved.data();
+    }
+    const UINT64 vbByteSize = (UINT64)vertexCount * vertexStride;
 
-    hr = device->CreateCommittedResource(
-        &uploadHeapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &bufferDesc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&mVertexBufferUploader)
-    );
+    // 3. Копии в пакет copy-очереди; данные уже скопированы в промежуточное кольцо,
+    //    так что кэш и векторы можно отпускать. Отправка одна на все меши - в Initialize
+    mVertexBufferGPU = mUploadScheduler.QueueBuffer(vertexData, vbByteSize, mVertexBufferAlloc);
+    mIndexBufferGPU = mUploadScheduler.QueueBuffer(indexData, ibByteSize, mIndexBufferAlloc);
 
-    if (FAILED(hr)) {
-        MessageBox(NULL, L"Failed to create upload buffer", L"Error", MB_OK);
+    if (!mVertexBufferGPU || !mIndexBufferGPU) {
+        MessageBox(NULL, L"Failed to upload OBJ geometry", L"Error", MB_OK);
         return;
     }
 
-    // 3. Копирование данных
-    mDirectCmdListAlloc->Reset();
-    mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr);
-
-    // Барьер: COMMON -> COPY_DEST
-    D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER_HELPER::Transition(
-        mVertexBufferGPU.Get(),
-        D3D12_RESOURCE_STATE_COMMON,
-        D3D12_RESOURCE_STATE_COPY_DEST);
-
-    mCommandList->ResourceBarrier(1, &barrier);
-
-    // Копируем данные
-    BYTE* pData = nullptr;
-    mVertexBufferUploader->Map(0, nullptr, reinterpret_cast<void**>(&pData));
-    memcpy(pData, cubeVertices, vbByteSize);
-    mVertexBufferUploader->Unmap(0, nullptr);
-
-    mCommandList->CopyResource(mVertexBufferGPU.Get(), mVertexBufferUploader.Get());
+    // 4. Views
+    mVertexBufferView.BufferLocation = mVertexBufferGPU->GetGPUVirtualAddress();
+    mVertexBufferView.SizeInBytes = (UINT)vbByteSize;
+    mVertexBufferView.StrideInBytes = vertexStride;
 
-    // Барьер: COPY_DEST -> COMMON
-    barrier = CD3DX12_RESOURCE_BARRIER_HELPER::Transition(
-        mVertexBufferGPU.Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST,
-        D3D12_RESOURCE_STATE_COMMON);
+    mIndexBufferView.BufferLocation = mIndexBufferGPU->GetGPUVirtualAddress();
+    mIndexBufferView.SizeInBytes = (UINT)ibByteSize;
+    mIndexBufferView.Format = DXGI_FORMAT_R32_UINT;
+
+    // 5. Сжатая копия вершин: 12 байт на вершину, с цветом 16; читает те же потоки, что и шаг 2.
+    //    При неудаче рисуем из полного буфера
+    QuantizedMesh quantized;
+    mQuantizedVertexBufferGPU.Reset();
+    if (QuantizeMesh(positions, normals, mMeshColored ? streams.colors.data() : nullptr, vertexCount,
+        mMeshColored, quantized)) {
+        mQuantizedVertexBufferGPU = mUploadScheduler.QueueBuffer(
+            quantized.vertexData.data(), quantized.vertexData.size(), mQuantizedVertexBufferAlloc);
+    }
+    if (mQuantizedVertexBufferGPU) {
+        mQuantizedVertexBufferView.BufferLocation = mQuantizedVertexBufferGPU->GetGPUVirtualAddress();
+        mQuantizedVertexBufferView.SizeInBytes = (UINT)quantized.vertexData.size();
+        mQuantizedVertexBufferView.StrideInBytes = quantized.stride;
+        mQuantizedPositionScale = quantized.positionScale;
+        mQuantizedPositionOffset = quantized.positionOffset;
+
+        char message[128];
+        snprintf(message, sizeof(message), "Vertices: %zu x %u bytes, quantized %u (Vertex %zu)\n",
+            vertexCount, vertexStride, quantized.stride, sizeof(Vertex));
+        OutputDebugStringA(message);
+    }
 
-    mCommandList->ResourceBarrier(1, &barrier);
+    mIndexCount = indexCount;
+    if (mLods.empty())
+        mLods.push_back({ 0, indexCount, 0.0f });
+
+    // Куски меша - единицы работы для потоков записи; с кластерами базовый LOD пересобирает CullClusters
+    mDrawItems.clear();
+    SplitIntoDrawItems(mLods[0].indexCount, DrawItemMaxIndices, mDrawItems);
+    mLodDrawItems.assign(mLods.size(), {});
+    for (size_t i = 1; i < mLods.size(); i++)
+        SplitIntoDrawItems(mLods[i].indexCount, DrawItemMaxIndices, mLodDrawItems[i], mLods[i].firstIndex);
+
+    // Окклюдеры - CPU-копия самых крупных треугольников каждого LOD. Экземпляр с упрощённым LOD
+    // закрывает своей упрощённой формой: треугольники базового могли бы закрыть то, что видно в её дырах
+    mOccluders.clear();
+    if (!mClusters.empty()) {
+        mOccluders.resize(mLods.size());
+        for (size_t i = 0; i < mLods.size(); i++) {
+            SelectOccluders(indexData + mLods[i].firstIndex, mLods[i].indexCount,
+                &positions->x, vertexCount, sizeof(XMFLOAT3),
+                OCCLUDER_TRIANGLE_BUDGET, mOccluders[i]);
+
+            char message[128];
+            snprintf(message, sizeof(message), "Occluders LOD %zu: %zu triangles, %zu vertices\n",
+                i, mOccluders[i].TriangleCount(), mOccluders[i].positions.size());
+            OutputDebugStringA(message);
+        }
+        if (mOccluders[0].indices.empty())
+            mOccluders.clear();
+    }
+    BuildClusterBvh();
 
-    mCommandList->Close();
-    ID3D12CommandList* cmdLists[] = { mCommandList.Get() };
-    mCommandQueue->ExecuteCommandLists(1, cmdLists);
-    FlushCommandQueue();
+    if (mInstances.empty())
+        AddInstance(mWorld);
+}
 
-    // 4. Vertex Buffer View
-    mVertexBufferView.BufferLocation = mVertexBufferGPU->GetGPUVirtualAddress();
-    mVertexBufferView.SizeInBytes = vbByteSize;
-    mVertexBufferView.StrideInBytes = sizeof(Vertex);
+void DirectXApp::BuildClusterBvh()
+{
+    std::vector<XMFLOAT3> boundsMin(mClusters.size());
+    std::vector<XMFLOAT3> boundsMax(mClusters.size());
+    for (size_t i = 0; i < mClusters.size(); i++) {
+        boundsMin[i] = mClusters[i].boundsMin;
+        boundsMax[i] = mClusters[i].boundsMax;
+    }
+    mClusterBvh.Build(boundsMin.data(), boundsMax.data(), mClusters.size());
+    mClusterVisible.assign(mClusters.size(), 0);
+    mMeshletVisible.assign(mMeshlets.meshlets.size(), 0);
+
+    char message[128];
+    snprintf(message, sizeof(message), "Clusters: %zu, BVH nodes: %zu, meshlets: %zu\n",
+        mClusters.size(), mClusterBvh.Nodes().size(), mMeshlets.meshlets.size());
+    OutputDebugStringA(message);
 }
 
-// =========== Индексный буфер ===========
-void DirectXApp::BuildIndexBuffer()
+void DirectXApp::CullClusters(const XMMATRIX& viewProj, FXMVECTOR eyePosition)
 {
-    const UINT64 ibByteSize = cubeIndexCount * sizeof(std::uint16_t);
+    if (mClusters.empty())
+        return;
 
-    // 1. Буфер в DEFAULT куче
-    D3D12_HEAP_PROPERTIES defaultHeapProps = {};
-    defaultHeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-
-    D3D12_RESOURCE_DESC bufferDesc = {};
-    bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    bufferDesc.Width = ibByteSize;
-    bufferDesc.Height = 1;
-    bufferDesc.DepthOrArraySize = 1;
-    bufferDesc.MipLevels = 1;
-    bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
-    bufferDesc.SampleDesc.Count = 1;
-    bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-
-    HRESULT hr = device->CreateCommittedResource(
-        &defaultHeapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &bufferDesc,
-        D3D12_RESOURCE_STATE_COMMON,
-        nullptr,
-        IID_PPV_ARGS(&mIndexBufferGPU)
-    );
+    // Пирамида в пространстве объекта каждого экземпляра; видимые кластеры - объединение.
+    // Мешлеты видимых кластеров дополнительно проверяются сферой и конусом нормалей
+    // (конус - только когда PSO отсекает задние грани)
+    const bool useMeshlets = mMeshletCulling && !mMeshlets.meshlets.empty();
+    std::fill(mClusterVisible.begin(), mClusterVisible.end(), 0);
+    std::fill(mMeshletVisible.begin(), mMeshletVisible.end(), 0);
+    mCullStats = CullStats();
+    mMeshletStats = MeshletCullStats();
+    mClustersOccluded = 0;
+    for (const RenderInstance& instance : mInstances) {
+        // Упрощённые LOD рисуются целиком; кластеры есть только у базового
+        if (instance.lod != 0)
+            continue;
+
+        XMMATRIX world = XMLoadFloat4x4(&instance.world);
+        XMFLOAT4X4 worldViewProj;
+        XMStoreFloat4x4(&worldViewProj, world * viewProj);
+        Frustum frustum = Frustum::FromMatrix(worldViewProj);
+
+        CullStats stats;
+        mVisibleClusters.clear();
+        mClusterBvh.Cull(frustum, mVisibleClusters, &stats);
+
+        // Буфер глубины нужен только здесь - до этого момента он строился параллельно
+        mJobs->Wait(mOcclusionDone);
+        if (mOcclusionCulling && !mOccluders.empty()) {
+            const size_t before = mVisibleClusters.size();
+            mVisibleClusters.erase(std::remove_if(mVisibleClusters.begin(), mVisibleClusters.end(),
+                [&](uint32_t cluster) {
+                    return mOcclusionBuffer.IsOccluded(
+                        mClusters[cluster].boundsMin, mClusters[cluster].boundsMax, worldViewProj);
+                }), mVisibleClusters.end());
+            mClustersOccluded += (uint32_t)(before - mVisibleClusters.size());
+        }
 
-    if (FAILED(hr)) {
-        MessageBox(NULL, L"Failed to create index buffer", L"Error", MB_OK);
-        return;
-    }
+        for (uint32_t cluster : mVisibleClusters)
+            mClusterVisible[cluster] = 1;
 
-    // 2. UPLOAD буфер
-    D3D12_HEAP_PROPERTIES uploadHeapProps = {};
-    uploadHeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+        mCullStats.nodesTested += stats.nodesTested;
+        mCullStats.itemsTested += stats.itemsTested;
 
-    hr = device->CreateCommittedResource(
-        &uploadHeapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &bufferDesc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&mIndexBufferUploader)
-    );
+        if (useMeshlets) {
+            XMVECTOR localEye = XMVector3TransformCoord(eyePosition, XMMatrixInverse(nullptr, world));
+            mVisibleMeshlets.clear();
+            for (uint32_t cluster : mVisibleClusters) {
+                CullMeshlets(mMeshlets.bounds.data(), mClusters[cluster].firstMeshlet, mClusters[cluster].meshletCount,
+                    frustum, localEye, !mWireframeMode, mVisibleMeshlets, &mMeshletStats);
+            }
+            for (uint32_t meshlet : mVisibleMeshlets)
+                mMeshletVisible[meshlet] = 1;
+        }
+    }
 
-    if (FAILED(hr)) {
-        MessageBox(NULL, L"Failed to create index upload buffer", L"Error", MB_OK);
+    // Все экземпляры с упрощённым LOD - буфер так и не понадобился, но задание дождаться нужно
+    mJobs->Wait(mOcclusionDone);
+
+    uint32_t visibleCount = 0;
+    for (uint8_t visible : mClusterVisible)
+        visibleCount += visible;
+    mCullStats.itemsVisible = visibleCount;
+    mCullStats.itemsCulled = (uint32_t)mClusters.size() - visibleCount;
+
+    // Соседние видимые кластеры (мешлеты) лежат в индексном буфере подряд - сливаем их в один диапазон
+    mDrawItems.clear();
+    if (useMeshlets) {
+        size_t i = 0;
+        while (i < mMeshlets.meshlets.size()) {
+            if (!mMeshletVisible[i]) {
+                i++;
+                continue;
+            }
+            const uint32_t start = mMeshlets.meshlets[i].firstIndex;
+            uint32_t count = 0;
+            for (; i < mMeshlets.meshlets.size() && mMeshletVisible[i]; i++)
+                count += mMeshlets.meshlets[i].triangleCount * 3;
+            SplitIntoDrawItems(count, DrawItemMaxIndices, mDrawItems, start);
+        }
         return;
     }
 
-    // 3. Копирование данных
-    mDirectCmdListAlloc->Reset();
-    mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr);
-
-    D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER_HELPER::Transition(
-        mIndexBufferGPU.Get(),
-        D3D12_RESOURCE_STATE_COMMON,
-        D3D12_RESOURCE_STATE_COPY_DEST);
-
-    mCommandList->ResourceBarrier(1, &barrier);
-
-    BYTE* pData = nullptr;
-    mIndexBufferUploader->Map(0, nullptr, reinterpret_cast<void**>(&pData));
-    memcpy(pData, cubeIndices, ibByteSize);
-    mIndexBufferUploader->Unmap(0, nullptr);
-
-    mCommandList->CopyResource(mIndexBufferGPU.Get(), mIndexBufferUploader.Get());
+    size_t i = 0;
+    while (i < mClusters.size()) {
+        if (!mClusterVisible[i]) {
+            i++;
+            continue;
+        }
+        const uint32_t start = mClusters[i].firstIndex;
+        uint32_t count = 0;
+        for (; i < mClusters.size() && mClusterVisible[i]; i++)
+            count += mClusters[i].indexCount;
+        SplitIntoDrawItems(count, DrawItemMaxIndices, mDrawItems, start);
+    }
+}
 
-    barrier = CD3DX12_RESOURCE_BARRIER_HELPER::Transition(
-        mIndexBufferGPU.Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST,
-        D3D12_RESOURCE_STATE_COMMON);
+void DirectXApp::StartOcclusion(const XMMATRIX& viewProj)
+{
+    if (!mOcclusionCulling || mClusters.empty() || mOccluders.empty())
+        return;
 
-    mCommandList->ResourceBarrier(1, &barrier);
+    // Матрицы и окклюдеры выбранного LOD - копией: рабочий поток не читает mInstances
+    mOccluderTransforms.resize(mInstances.size());
+    mOccluderMeshes.resize(mInstances.size());
+    for (size_t i = 0; i < mInstances.size(); i++) {
+        XMStoreFloat4x4(&mOccluderTransforms[i], XMLoadFloat4x4(&mInstances[i].world) * viewProj);
+        mOccluderMeshes[i] = &mOccluders[mInstances[i].lod];
+    }
 
-    mCommandList->Close();
-    ID3D12CommandList* cmdLists[] = { mCommandList.Get() };
-    mCommandQueue->ExecuteCommandLists(1, cmdLists);
-    FlushCommandQueue();
+    mJobs->Run(mJobs->CreateJob([this]() {
+        mOcclusionBuffer.Render(mOccluderMeshes.data(), mOccluderTransforms.data(), mOccluderTransforms.size());
+        mOcclusionBuffer.BuildHiZ();
+    }, &mOcclusionDone));
+}
 
-    // 4. Index Buffer View
-    mIndexBufferView.BufferLocation = mIndexBufferGPU->GetGPUVirtualAddress();
-    mIndexBufferView.SizeInBytes = ibByteSize;
-    mIndexBufferView.Format = DXGI_FORMAT_R16_UINT;
+void DirectXApp::SelectLods(FXMVECTOR eyePosition)
+{
+    // Ошибка LOD в пикселях: error * масштаб * proj._22 * (высота / 2) / расстояние
+    const float pixelsPerUnit = mProj._22 * 0.5f * (float)mClientHeight;
+    mLodInstanceCounts.assign(mLods.size(), 0);
+
+    for (RenderInstance& instance : mInstances) {
+        XMMATRIX world = XMLoadFloat4x4(&instance.world);
+        float scale = XMVectorGetX(XMVectorMax(XMVector3Length(world.r[0]),
+            XMVectorMax(XMVector3Length(world.r[1]), XMVector3Length(world.r[2]))));
+
+        XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&mMeshCenter), world);
+        float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, eyePosition))) - mMeshRadius * scale;
+
+        instance.lod = mLodSelection
+            ? SelectLod(mLods.data(), mLods.size(), pixelsPerUnit * scale, distance, LodMaxPixelError)
+            : 0;
+        mLodInstanceCounts[instance.lod]++;
+    }
+}
 
-    MessageBox(NULL, L"Index buffer created", L"Info", MB_OK);
+void DirectXApp::AddInstance(const XMFLOAT4X4& world, UINT mesh)
+{
+    RenderInstance instance;
+    instance.mesh = mesh;
+    instance.pipeline = 0;
+    instance.world = world;
+    mInstances.push_back(instance);
 }
 
 // =========== Остальные методы ===========
 
 void DirectXApp::Shutdown() {
-    FlushCommandQueue();
+    if (mJobs) {
+        mJobs->Wait(mOcclusionDone);
+    }
+    if (mCommandQueue && mFenceQueue.Fence()) {
+        FlushCommandQueue();
+    }
+    mFrameRing.reset();
 
-    // Освобождаем PSO
-    mPSO.Reset();
-    mWireframePSO.Reset();
+    // Освобождаем PSO (новые блобы сохраняются на диск)
+    mPipelineCache.Shutdown();
     mRootSignature.Reset();
 
     for (int i = 0; i < SwapChainBufferCount; i++) {
         mSwapChainBuffer[i].Reset();
     }
     mDepthStencilBuffer.Reset();
+    mGpuMemory.Free(mDepthStencilAlloc);
     mRtvHeap.Reset();
     mDsvHeap.Reset();
-    mCbvHeap.Reset();
     mSwapChain.Reset();
 
     mVertexBufferGPU.Reset();
-    mVertexBufferUploader.Reset();
     mIndexBufferGPU.Reset();
-    mIndexBufferUploader.Reset();
+    mQuantizedVertexBufferGPU.Reset();
+    mGpuMemory.Free(mVertexBufferAlloc);
+    mGpuMemory.Free(mIndexBufferAlloc);
+    mGpuMemory.Free(mQuantizedVertexBufferAlloc);
+
+    mUploadScheduler.Shutdown();
+    mUploadRing.Reset(nullptr);
+    mUploadMemory.Shutdown();
+    mGpuMemory.Shutdown();
 
     if (mCommandList) {
         mCommandList.Reset();
     }
+    mPresentCommandList.Reset();
+
+    for (auto& recorder : mDrawRecorders)
+        recorder->Shutdown();
+    mDrawRecorders.clear();
+    mParallelRecorder.reset();
 
-    mFence.Reset();
+    mFenceQueue.Shutdown();
+    mFrameCmdListAllocs.clear();
     mDirectCmdListAlloc.Reset();
     mCommandQueue.Reset();
     device.Reset();
@@ -679,6 +785,19 @@ bool DirectXApp::CreateCommandObjects() {
         return false;
     }
 
+    // Аллокаторы кадров: сбрасываются только когда GPU закончил свой кадр
+    mFrameCmdListAllocs.resize(mFrameResourceCount);
+    for (UINT i = 0; i < mFrameResourceCount; i++) {
+        hr = device->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            IID_PPV_ARGS(&mFrameCmdListAllocs[i])
+        );
+        if (FAILED(hr)) {
+            MessageBox(NULL, L"Failed to create frame command allocator", L"Error", MB_OK);
+            return false;
+        }
+    }
+
     hr = device->CreateCommandList(
         0,
         D3D12_COMMAND_LIST_TYPE_DIRECT,
@@ -692,29 +811,69 @@ bool DirectXApp::CreateCommandObjects() {
     }
 
     mCommandList->Close();
+
+    hr = device->CreateCommandList(
+        0,
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        mDirectCmdListAlloc.Get(),
+        nullptr,
+        IID_PPV_ARGS(&mPresentCommandList)
+    );
+    if (FAILED(hr)) {
+        MessageBox(NULL, L"Failed to create present command list", L"Error", MB_OK);
+        return false;
+    }
+    mPresentCommandList->Close();
+
+    // Запись идёт заданиями общей системы; по списку с аллокаторами на каждый поток записи
+    mParallelRecorder = std::make_unique<ParallelRecorder>(*mJobs, MaxRecordThreads);
+
+    mDrawRecorders.clear();
+    for (UINT i = 0; i < mParallelRecorder->ThreadCount(); i++) {
+        auto recorder = std::make_unique<D3D12CommandRecorder>();
+        if (!recorder->Initialize(device.Get(), mFrameResourceCount, DrawConstantsRootParameter)) {
+            MessageBox(NULL, L"Failed to create draw command list", L"Error", MB_OK);
+            return false;
+        }
+        mDrawRecorders.push_back(std::move(recorder));
+    }
     return true;
 }
 
 bool DirectXApp::CreateFence() {
-    HRESULT hr = device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence));
-    if (FAILED(hr)) {
+    if (!mFenceQueue.Initialize(device.Get(), mCommandQueue.Get())) {
         MessageBox(NULL, L"Failed to create fence", L"Error", MB_OK);
         return false;
     }
-    mFenceValue = 0;
+    mFrameRing = std::make_unique<FrameRing>(mFenceQueue, mFrameResourceCount);
     return true;
 }
 
-void DirectXApp::FlushCommandQueue() {
-    mFenceValue++;
-    mCommandQueue->Signal(mFence.Get(), mFenceValue);
-
-    if (mFence->GetCompletedValue() < mFenceValue) {
-        HANDLE eventHandle = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
-        mFence->SetEventOnCompletion(mFenceValue, eventHandle);
-        WaitForSingleObject(eventHandle, INFINITE);
-        CloseHandle(eventHandle);
+bool DirectXApp::CreateUploadRing() {
+    if (!mUploadMemory.Initialize(device.Get(), UploadRingCapacity)) {
+        MessageBox(NULL, L"Failed to create upload ring", L"Error", MB_OK);
+        return false;
     }
+    mUploadRing.Reset(&mUploadMemory);
+    return true;
+}
+
+// Выделение в кольце; если места нет, ждём самый старый fence, под которым что-то занято
+UploadAllocation DirectXApp::AllocateUpload(UINT64 size, UINT64 alignment) {
+    UploadAllocation alloc = mUploadRing.Allocate(size, alignment);
+    while (!alloc && mUploadRing.HasPending()) {
+        mFenceQueue.WaitForValue(mUploadRing.OldestPendingFence());
+        mUploadRing.Retire(mFenceQueue.CompletedValue());
+        alloc = mUploadRing.Allocate(size, alignment);
+    }
+    return alloc;
+}
+
+void DirectXApp::FlushCommandQueue() {
+    uint64_t fence = mFenceQueue.Signal();
+    mUploadRing.Commit(fence);
+    mFenceQueue.WaitForValue(fence);
+    mUploadRing.Retire(fence);
 }
 
 bool DirectXApp::CreateSwapChain() {
@@ -787,18 +946,7 @@ bool DirectXApp::CreateDescriptorHeaps() {
         return false;
     }
 
-    // 3. CBV/SRV/UAV куча
-    D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc;
-    cbvHeapDesc.NumDescriptors = 1;  // Один CBV
-    cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    cbvHeapDesc.NodeMask = 0;
-
-    hr = device->CreateDescriptorHeap(&cbvHeapDesc, IID_PPV_ARGS(&mCbvHeap));
-    if (FAILED(hr)) {
-        MessageBox(NULL, L"Failed to create CBV descriptor heap", L"Error", MB_OK);
-        return false;
-    }
+    // CBV/SRV/UAV куча не нужна: константы и экземпляры идут корневыми параметрами
 
     return true;
 }
@@ -837,16 +985,16 @@ bool DirectXApp::CreateDepthStencilBuffer() {
     optClear.Format = mDepthStencilFormat;
     optClear.DepthStencil.Depth = 1.0f;
 
-    D3D12_HEAP_PROPERTIES heapProps = {};
-    heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+    // Старый буфер (пересоздание при ресайзе): GPU к этому моменту уже его не использует
+    mDepthStencilBuffer.Reset();
+    mGpuMemory.Free(mDepthStencilAlloc);
 
-    HRESULT hr = device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &depthStencilDesc,
+    HRESULT hr = mGpuMemory.CreateRenderTarget(
+        depthStencilDesc,
         D3D12_RESOURCE_STATE_COMMON,
         &optClear,
-        IID_PPV_ARGS(&mDepthStencilBuffer)
+        mDepthStencilBuffer,
+        mDepthStencilAlloc
     );
 
     if (FAILED(hr)) {
@@ -886,12 +1034,23 @@ void DirectXApp::SetViewportAndScissor() {
 bool DirectXApp::Initialize() {
     MessageBox(NULL, L"Starting DirectX 12 initialization...", L"Info", MB_OK);
 
+    // До BuildObj: разбор OBJ уже идёт заданиями
+    mJobs = std::make_unique<JobSystem>();
+
     // Основные этапы инициализации
     if (!CreateDXGIFactory()) return false;
     if (!CreateD3DDevice()) return false;
+    mGpuMemory.Initialize(device.Get());
+    mPipelineCache.Initialize(device.Get(), PipelineCachePath, AdapterFingerprint(adapter.Get()));
     if (!CreateCommandObjects()) return false;
     if (!CreateFence()) return false;
+    if (!CreateUploadRing()) return false;
+    if (!mUploadScheduler.Initialize(device.Get(), &mGpuMemory, GeometryStagingCapacity)) {
+        MessageBox(NULL, L"Failed to create upload scheduler", L"Error", MB_OK);
+        return false;
+    }
     if (!CreateSwapChain()) return false;
+    mResizeTracker.Reset(mClientWidth, mClientHeight);
 
     QueryDescriptorSizes();
 
@@ -902,14 +1061,25 @@ bool DirectXApp::Initialize() {
     CreateViewportAndScissor();
 
     // Геометрия и ресурсы
-  //  BuildInputLayout();
+    BuildInputLayout();
    //BuildVertexBuffer();
    // BuildIndexBuffer();
     BuildObj("sponza.obj");
+
+    // Все копии геометрии одним пакетом; графическая очередь ждёт их на GPU
+    mUploadScheduler.WaitOnGpu(mCommandQueue.Get(), mUploadScheduler.Submit());
+
+    GpuMemoryStats memStats = mGpuMemory.GetStats();
+    char message[200];
+    snprintf(message, sizeof(message),
+        "GPU memory: %u heaps, %.1f / %.1f MB used, %u allocations, fragmentation %.2f\n",
+        memStats.heapCount, memStats.usedBytes / 1048576.0, memStats.reservedBytes / 1048576.0,
+        memStats.allocationCount, memStats.fragmentation);
+    OutputDebugStringA(message);
+
     BuildShaders();
     BuildRootSignature();
-    BuildPSO();
-    BuildWireframePSO();  // Создаем второй PSO для проволочного каркаса
+    BuildPipelineDescs();
     BuildConstantBuffer();
 
     // Инициализация проекционной матрицы
@@ -935,8 +1105,43 @@ D3D12_CPU_DESCRIPTOR_HANDLE DirectXApp::CurrentBackBufferView() const {
     return handle;
 }
 
+// Пересборка под mClientWidth x mClientHeight без полной переинициализации:
+// ждём только кадры в полёте, кучи дескрипторов и swap chain остаются прежними
 void DirectXApp::OnResize() {
-    // TODO: реализовать позже
+    if (!mSwapChain)
+        return;
+
+    // 1. GPU больше не трогает back buffers и depth; copy-очередь не ждём
+    FlushCommandQueue();
+
+    // 2. ResizeBuffers требует, чтобы ссылок на буферы не осталось
+    for (int i = 0; i < SwapChainBufferCount; i++) {
+        mSwapChainBuffer[i].Reset();
+    }
+
+    HRESULT hr = mSwapChain->ResizeBuffers(
+        SwapChainBufferCount,
+        mClientWidth,
+        mClientHeight,
+        mBackBufferFormat,
+        DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH);
+
+    if (FAILED(hr)) {
+        MessageBox(NULL, L"Failed to resize swap chain", L"Error", MB_OK);
+        return;
+    }
+    mCurrBackBuffer = 0;
+
+    // 3. Только то, что зависит от размера: RTV (в той же куче), depth (старый освобождается), viewport.
+    //    Проекция пересчитывается в Update из mClientWidth / mClientHeight
+    if (!CreateRenderTargetViews()) return;
+    if (!CreateDepthStencilBuffer()) return;
+    CreateViewportAndScissor();
+
+    char message[128];
+    snprintf(message, sizeof(message), "Resize: %dx%d (%u events -> %u rebuilds)\n",
+        mClientWidth, mClientHeight, mResizeTracker.EventCount(), mResizeTracker.RebuildCount());
+    OutputDebugStringA(message);
 }
 
 // Обработка клавиатуры
@@ -953,6 +1158,26 @@ void DirectXApp::OnKeyDown(WPARAM wParam)
             SetWindowText(window.GetHandle(), L"DirectX 12 Framework - Solid Mode (Press SPACE to switch)");
         }
     }
+
+    // M - отсечение мешлетов (сфера + конус) поверх отсечения кластеров
+    if (wParam == 'M') {
+        mMeshletCulling = !mMeshletCulling;
+    }
+
+    // L - выбор LOD по расстоянию; выключен - всегда базовый меш
+    if (wParam == 'L') {
+        mLodSelection = !mLodSelection;
+    }
+
+    // O - отсечение перекрытых кластеров по программному буферу глубины
+    if (wParam == 'O') {
+        mOcclusionCulling = !mOcclusionCulling;
+    }
+
+    // Q - сжатые вершины (16 байт) или полные Vertex (40 байт)
+    if (wParam == 'Q') {
+        mQuantizedVertices = !mQuantizedVertices;
+    }
 }
 
 int DirectXApp::Run() {
@@ -966,7 +1191,16 @@ int DirectXApp::Run() {
         }
         else {
             mTimer.Tick();
-            if (!mAppPaused) {
+
+            // Все WM_SIZE с прошлого кадра - одна пересборка
+            uint32_t width = 0, height = 0;
+            if (mResizeTracker.Consume(width, height)) {
+                mClientWidth = (int)width;
+                mClientHeight = (int)height;
+                OnResize();
+            }
+
+            if (!mAppPaused && mResizeTracker.ShouldRender()) {
                 CalculateFrameStats();
                 Update(mTimer);
                 Draw(mTimer);
@@ -994,6 +1228,26 @@ void DirectXApp::CalculateFrameStats() {
         }
         windowText += L" FPS: " + std::to_wstring(fps);
         windowText += L" MSPF: " + std::to_wstring(mspf);
+        if (mQuantizedVertices && mQuantizedVertexBufferGPU) {
+            windowText += L" Quantized";
+        }
+        if (!mClusters.empty()) {
+            windowText += L" Clusters: " + std::to_wstring(mCullStats.itemsVisible) +
+                L"/" + std::to_wstring(mClusters.size());
+        }
+        if (mOcclusionCulling && !mOccluders.empty()) {
+            windowText += L" Occluded: " + std::to_wstring(mClustersOccluded);
+        }
+        if (mLods.size() > 1) {
+            windowText += L" LOD:";
+            for (uint32_t count : mLodInstanceCounts)
+                windowText += L" " + std::to_wstring(count);
+        }
+        if (mMeshletCulling && !mMeshlets.meshlets.empty()) {
+            uint32_t meshletsVisible = mMeshletStats.tested - mMeshletStats.frustumCulled - mMeshletStats.backfaceCulled;
+            windowText += L" Meshlets: " + std::to_wstring(meshletsVisible) +
+                L"/" + std::to_wstring(mMeshlets.meshlets.size());
+        }
         windowText += L" (Press SPACE to switch modes)";
 
         SetWindowText(window.GetHandle(), windowText.c_str());
@@ -1005,6 +1259,11 @@ void DirectXApp::CalculateFrameStats() {
 
 void DirectXApp::Update(const Timer& gt)
 {
+    // 0. Слот кадра: ждём GPU, только если он отстал на mFrameResourceCount кадров
+    UINT frameIndex = mFrameRing->BeginFrame();
+    mUploadRing.Retire(mFenceQueue.CompletedValue());
+    mUploadScheduler.Retire();
+
     // 1. ПРОСТАЯ КАМЕРА (смотрит на куб сбоку)
     XMVECTOR pos = XMVectorSet(5.0f, 5.0f, -10.0f, 1.0f);   // Камера сверху-сбоку
     XMVECTOR target = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);  // Смотрим в центр куба
@@ -1022,21 +1281,34 @@ void DirectXApp::Update(const Timer& gt)
     );
     XMStoreFloat4x4(&mProj, proj);
 
-    // 3. Обновляем константный буфер
+    // 3. LOD каждого экземпляра по экранной ошибке; окклюдеры (того же LOD) растеризуются
+    //    на рабочих потоках, пока идут константы и пирамида видимости
+    SelectLods(pos);
+    StartOcclusion(view * proj);
+
+    // 4. Обновляем константный буфер
     XMMATRIX world = XMLoadFloat4x4(&mWorld);
     XMMATRIX worldViewProj = world * view * proj;
 
     ObjectConstants objConstants;
     XMStoreFloat4x4(&objConstants.mWorldViewProj, XMMatrixTranspose(worldViewProj));
+    XMStoreFloat4x4(&objConstants.mViewProj, XMMatrixTranspose(view * proj));
+    objConstants.mPosScale = XMFLOAT4(mQuantizedPositionScale.x, mQuantizedPositionScale.y, mQuantizedPositionScale.z, 0.0f);
+    objConstants.mPosOffset = XMFLOAT4(mQuantizedPositionOffset.x, mQuantizedPositionOffset.y, mQuantizedPositionOffset.z, 0.0f);
 
-    if (mObjectCB)
-        mObjectCB->CopyData(0, objConstants);
+    WriteObjectConstants(frameIndex, objConstants);
+
+    // 5. Отсечение кластеров (пирамида, hi-Z) и мешлетов у экземпляров с базовым LOD:
+    //    в Draw уходят только видимые диапазоны индексов
+    CullClusters(view * proj, pos);
 }
 
 void DirectXApp::Draw(const Timer& gt) {
-    // 1. Подготовка команд
-    mDirectCmdListAlloc->Reset();
-    mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr);
+    // 1. Подготовка команд (слот уже освобождён в Update)
+    UINT frameIndex = mFrameRing->BeginFrame();
+    ID3D12CommandAllocator* frameAlloc = mFrameCmdListAllocs[frameIndex].Get();
+    frameAlloc->Reset();
+    mCommandList->Reset(frameAlloc, nullptr);
 
     // 2. Барьер: PRESENT -> RENDER_TARGET
     D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER_HELPER::Transition(
@@ -1045,10 +1317,7 @@ void DirectXApp::Draw(const Timer& gt) {
         D3D12_RESOURCE_STATE_RENDER_TARGET);
     mCommandList->ResourceBarrier(1, &barrier);
 
-    // 3. Устанавливаем состояние пайплайна
-    SetViewportAndScissor();
-
-    // 4. Очистка буферов
+    // 3. Очистка буферов
     const float clearColor[] = { 0.69f, 0.77f, 0.87f, 1.0f };
     D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = CurrentBackBufferView();
     D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = mDsvHeap->GetCPUDescriptorHandleForHeapStart();
@@ -1056,51 +1325,91 @@ void DirectXApp::Draw(const Timer& gt) {
     mCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
     mCommandList->ClearDepthStencilView(dsvHandle,
         D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+    mCommandList->Close();
 
-    // 5. Устанавливаем render targets
-    mCommandList->OMSetRenderTargets(1, &rtvHandle, true, &dsvHandle);
-
-    // 6. Устанавливаем корневую сигнатуру и кучу дескрипторов
-    mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
-    ID3D12DescriptorHeap* descriptorHeaps[] = { mCbvHeap.Get() };
-    mCommandList->SetDescriptorHeaps(1, descriptorHeaps);
+    // 4. Экземпляры: группы по (PSO, меш), матрицы одним блоком в кольцо загрузки.
+    //    Меш пока один, так что каждая группа - это все куски меша с instanceCount копий;
+    //    startInstance уходит в шейдер корневой константой (SV_InstanceID его не учитывает)
+    BuildInstanceBatches(mInstances.data(), mInstances.size(), mInstanceOrder, mInstanceBatches);
 
-    // 7. Устанавливаем PSO (как на слайде 20.26.59 - переключение PSO)
-    if (mWireframeMode) {
-        mCommandList->SetPipelineState(mWireframePSO.Get());  // Проволочный каркас
+    mFrameDrawItems.clear();
+    UploadAllocation instanceAlloc;
+    if (!mInstances.empty()) {
+        instanceAlloc = AllocateUpload(
+            mInstances.size() * sizeof(InstanceData), UploadRing::CONSTANT_BUFFER_ALIGNMENT);
     }
-    else {
-        mCommandList->SetPipelineState(mPSO.Get());  // Сплошная заливка
+    if (instanceAlloc) {
+        PackInstanceTransforms(mInstances.data(), mInstanceOrder.data(), mInstances.size(),
+            reinterpret_cast<InstanceData*>(instanceAlloc.cpu));
+
+        for (const InstanceBatch& batch : mInstanceBatches) {
+            const std::vector<DrawItem>& items = batch.lod == 0 ? mDrawItems : mLodDrawItems[batch.lod];
+            for (DrawItem item : items) {
+                item.instanceCount = batch.instanceCount;
+                item.startInstance = batch.firstInstance;
+                mFrameDrawItems.push_back(item);
+            }
+        }
     }
 
-    // 8. Устанавливаем таблицу дескрипторов
-    D3D12_GPU_DESCRIPTOR_HANDLE cbvHandle = mCbvHeap->GetGPUDescriptorHandleForHeapStart();
-    mCommandList->SetGraphicsRootDescriptorTable(0, cbvHandle);
-
-    // 9. Устанавливаем геометрию
-    mCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    mCommandList->IASetVertexBuffers(0, 1, &mVertexBufferView);
-    mCommandList->IASetIndexBuffer(&mIndexBufferView);
+    // 5. Состояние, которое каждый поток выставляет в своём списке
+    //    (как на слайде 20.26.59 - переключение PSO)
+    //    Сжатые вершины - если их буфер есть (у куба его нет)
+    const bool quantized = mQuantizedVertices && mQuantizedVertexBufferGPU;
+    const PipelineDesc& pipeline = quantized
+        ? (mWireframeMode ? mQuantizedWireframePipeline : mQuantizedSolidPipeline)
+        : (mWireframeMode ? mWireframePipeline : mSolidPipeline);
+    ID3D12PipelineState* pso = mPipelineCache.Get(pipeline, mRootSignature.Get());
+    const D3D12_VERTEX_BUFFER_VIEW vertexBufferView = quantized ? mQuantizedVertexBufferView : mVertexBufferView;
+    D3D12_GPU_VIRTUAL_ADDRESS frameConstants = mFrameConstants[frameIndex];
+    D3D12_GPU_VIRTUAL_ADDRESS instanceData = instanceAlloc.gpu;
+
+    const D3D12CommandRecorder::SetupFn setup = [&](ID3D12GraphicsCommandList* list) {
+        list->RSSetViewports(1, &mScreenViewport);
+        list->RSSetScissorRects(1, &mScissorRect);
+        list->OMSetRenderTargets(1, &rtvHandle, true, &dsvHandle);
+
+        list->SetGraphicsRootSignature(mRootSignature.Get());
+        list->SetPipelineState(pso);
+        list->SetGraphicsRootConstantBufferView(ObjectRootParameter, frameConstants);
+        if (instanceData != 0)
+            list->SetGraphicsRootShaderResourceView(InstanceRootParameter, instanceData);
+
+        list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        list->IASetVertexBuffers(0, 1, &vertexBufferView);
+        list->IASetIndexBuffer(&mIndexBufferView);
+    };
 
-    // 10. Рисуем куб
-    mCommandList->DrawIndexedInstanced(cubeIndexCount, 1, 0, 0, 0);
+    // 6. Вызовы делятся между потоками, каждый пишет свой список
+    std::vector<ICommandRecorder*> recorders;
+    for (auto& recorder : mDrawRecorders) {
+        recorder->Prepare(frameIndex, &setup);
+        recorders.push_back(recorder.get());
+    }
+    UINT listCount = mParallelRecorder->Record(
+        mFrameDrawItems.data(), mFrameDrawItems.size(), recorders.data(), (UINT)recorders.size());
 
-    // 11. Барьер: RENDER_TARGET -> PRESENT
+    // 7. Барьер: RENDER_TARGET -> PRESENT (тот же аллокатор кадра, mCommandList уже закрыт)
+    mPresentCommandList->Reset(frameAlloc, nullptr);
     barrier = CD3DX12_RESOURCE_BARRIER_HELPER::Transition(
         CurrentBackBuffer(),
         D3D12_RESOURCE_STATE_RENDER_TARGET,
         D3D12_RESOURCE_STATE_PRESENT);
-    mCommandList->ResourceBarrier(1, &barrier);
-
-    // 12. Завершаем команды
-    mCommandList->Close();
-    ID3D12CommandList* cmdLists[] = { mCommandList.Get() };
-    mCommandQueue->ExecuteCommandLists(1, cmdLists);
-
-    // 13. Презентация
+    mPresentCommandList->ResourceBarrier(1, &barrier);
+    mPresentCommandList->Close();
+
+    // 8. Одна отправка в фиксированном порядке: начало кадра, списки потоков, PRESENT
+    std::vector<ID3D12CommandList*> cmdLists;
+    cmdLists.push_back(mCommandList.Get());
+    for (UINT i = 0; i < listCount; i++)
+        cmdLists.push_back(mDrawRecorders[i]->List());
+    cmdLists.push_back(mPresentCommandList.Get());
+    mCommandQueue->ExecuteCommandLists((UINT)cmdLists.size(), cmdLists.data());
+
+    // 9. Презентация
     mSwapChain->Present(0, 0);
     mCurrBackBuffer = (mCurrBackBuffer + 1) % SwapChainBufferCount;
 
-    // 14. Ожидание
-    FlushCommandQueue();
+    // 10. Fence кадра; CPU сразу идёт готовить следующий
+    mUploadRing.Commit(mFrameRing->EndFrame());
 }
\ No newline at end of file
@@ -10,8 +10,23 @@
 #include "Window.h"
 #include "Timer.h"
 #include "vertex.h"
-#include "UploadBuffer.h"
 #include "ObjectConstants.h"
+#include "FrameRing.h"
+#include "UploadRing.h"
+#include "UploadScheduler.h"
+#include "GpuMemory.h"
+#include "RenderJobs.h"
+#include "InstanceBatcher.h"
+#include "RootSignatureBuilder.h"
+#include "PipelineCache.h"
+#include "ShaderCache.h"
+#include "ResizeTracker.h"
+#include "MeshClusters.h"
+#include "Bvh.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "OcclusionBuffer.h"
+#include "JobSystem.h"
 #include <memory>
 #include "MathHelper.h"
 #include <DirectXMath.h>
@@ -21,7 +36,7 @@ using namespace DirectX;
 
 class DirectXApp {
 public:
-    DirectXApp(Window& window);
+    DirectXApp(Window& window, UINT frameResourceCount = FrameRing::DEFAULT_FRAME_COUNT);
     ~DirectXApp();
 
     bool Initialize();
@@ -33,6 +48,9 @@ public:
     virtual void Update(const Timer& gt);
     virtual void Draw(const Timer& gt);
     void BuildObj(const std::string& path);
+
+    // Ещё одна копия меша; все копии рисуются инстансно
+    void AddInstance(const XMFLOAT4X4& world, UINT mesh = 0);
     virtual void CalculateFrameStats();
 
     // Управление таймером
@@ -46,7 +64,10 @@ public:
     virtual void OnMouseUp(WPARAM btnState, int x, int y);
     virtual void OnMouseMove(WPARAM btnState, int x, int y);
 
-    // Обработка изменения размера
+    // Обработка изменения размера: события окна копятся, OnResize - не чаще раза за кадр
+    void OnSizeEvent(int width, int height, SizeEvent event) { mResizeTracker.OnSize(width, height, event); }
+    void OnEnterSizeMove() { mResizeTracker.OnEnterSizeMove(); }
+    void OnExitSizeMove() { mResizeTracker.OnExitSizeMove(); }
     virtual void OnResize();
 
     // Обработка клавиатуры
@@ -64,8 +85,32 @@ private:
     ComPtr<ID3D12CommandQueue> mCommandQueue;
     ComPtr<ID3D12CommandAllocator> mDirectCmdListAlloc;
     ComPtr<ID3D12GraphicsCommandList> mCommandList;
-    ComPtr<ID3D12Fence> mFence;
-    UINT64 mFenceValue = 0;
+    D3D12FenceQueue mFenceQueue;
+
+    // Кадры в полёте: свой аллокатор, свои константы и свой fence на каждый слот
+    UINT mFrameResourceCount = FrameRing::DEFAULT_FRAME_COUNT;
+    std::unique_ptr<FrameRing> mFrameRing;
+    std::vector<ComPtr<ID3D12CommandAllocator>> mFrameCmdListAllocs;
+
+    // Параллельная запись отрисовки: mCommandList - начало кадра (барьер, очистка),
+    // дальше списки рабочих потоков, mPresentCommandList - барьер в PRESENT
+    static constexpr UINT MaxRecordThreads = 4;
+    static constexpr UINT DrawItemMaxIndices = 3 * 16384;
+    ComPtr<ID3D12GraphicsCommandList> mPresentCommandList;
+    std::unique_ptr<ParallelRecorder> mParallelRecorder;
+    std::vector<std::unique_ptr<D3D12CommandRecorder>> mDrawRecorders;
+    std::vector<DrawItem> mDrawItems;         // видимые куски меша, один экземпляр
+    std::vector<DrawItem> mFrameDrawItems;    // куски * группы экземпляров текущего кадра
+
+    // Корневые параметры: константы кадра (CBV b0) и матрицы экземпляров (SRV t0) -
+    // GPU-адреса в кольце загрузки, без дескрипторов; начало группы - константа b1 на вызов
+    static constexpr UINT ObjectRootParameter = 0;
+    static constexpr UINT InstanceRootParameter = 1;
+    static constexpr UINT DrawConstantsRootParameter = 2;
+    std::vector<D3D12_GPU_VIRTUAL_ADDRESS> mFrameConstants;  // адрес ObjectConstants слота кадра
+    std::vector<RenderInstance> mInstances;
+    std::vector<uint32_t> mInstanceOrder;
+    std::vector<InstanceBatch> mInstanceBatches;
 
     // SwapChain
     ComPtr<IDXGISwapChain> mSwapChain;
@@ -76,8 +121,8 @@ private:
     // Дескрипторы
     ComPtr<ID3D12DescriptorHeap> mRtvHeap;
     ComPtr<ID3D12DescriptorHeap> mDsvHeap;
-    ComPtr<ID3D12DescriptorHeap> mCbvHeap;  // Для CBV дескрипторов
     ComPtr<ID3D12Resource> mDepthStencilBuffer;
+    GpuAllocation mDepthStencilAlloc;
 
     UINT mRtvDescriptorSize = 0;
     UINT mDsvDescriptorSize = 0;
@@ -95,34 +140,68 @@ private:
     D3D12_VIEWPORT mScreenViewport;
     D3D12_RECT mScissorRect;
 
+    // Задания: потоки на все ядра, главный поток - поток 0. ParallelFor из главного потока
+    // и из заданий (разбор OBJ, упаковка матриц, растеризация окклюдеров) идёт через них
+    std::unique_ptr<JobSystem> mJobs;
+
     // Таймер и состояние
     Timer mTimer;
     bool mAppPaused = false;
-    bool mResizing = false;
+    ResizeTracker mResizeTracker;
     int mFrameCount = 0;
     float mTimeElapsed = 0.0f;
     std::wstring mMainWndCaption = L"DirectX 12 Framework";
 
     // =========== Geometry ===========
+    // Есть ли у меша цвет; без него (OBJ) в буферах только позиции, шейдеры - варианты NoColor
+    bool mMeshColored = false;
     std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
     Microsoft::WRL::ComPtr<ID3D12Resource> mVertexBufferGPU;
-    Microsoft::WRL::ComPtr<ID3D12Resource> mVertexBufferUploader;
+    GpuAllocation mVertexBufferAlloc;
     D3D12_VERTEX_BUFFER_VIEW mVertexBufferView;
     Microsoft::WRL::ComPtr<ID3D12Resource> mIndexBufferGPU;
-    Microsoft::WRL::ComPtr<ID3D12Resource> mIndexBufferUploader;
+    GpuAllocation mIndexBufferAlloc;
     D3D12_INDEX_BUFFER_VIEW mIndexBufferView;
 
+    // Сжатые вершины (QuantizedVertex.h): 12 или 16 байт вместо 40, Q переключает.
+    // Позиция декодируется в VSQuantized по габаритам меша из констант кадра
+    std::vector<D3D12_INPUT_ELEMENT_DESC> mQuantizedInputLayout;
+    Microsoft::WRL::ComPtr<ID3D12Resource> mQuantizedVertexBufferGPU;
+    GpuAllocation mQuantizedVertexBufferAlloc;
+    D3D12_VERTEX_BUFFER_VIEW mQuantizedVertexBufferView;
+    XMFLOAT3 mQuantizedPositionScale = { 1.0f, 1.0f, 1.0f };
+    XMFLOAT3 mQuantizedPositionOffset = { 0.0f, 0.0f, 0.0f };
+    bool mQuantizedVertices = true;
+
     // =========== Shaders ===========
+    ShaderCache mShaderCache;  // ShaderCache/<ключ>.cso рядом с shaders.hlsl; заполняет ShaderBake
     Microsoft::WRL::ComPtr<ID3DBlob> mvsByteCode = nullptr;
     Microsoft::WRL::ComPtr<ID3DBlob> mpsByteCode = nullptr;
+    Microsoft::WRL::ComPtr<ID3DBlob> mvsQuantizedByteCode = nullptr;
 
-    // =========== Constant Buffer ===========
-    std::unique_ptr<UploadBuffer<ObjectConstants>> mObjectCB = nullptr;
+    // =========== Upload Ring ===========
+    // Константы кадров и матрицы экземпляров
+    static constexpr UINT64 UploadRingCapacity = 16ull * 1024 * 1024;
+    D3D12UploadMemory mUploadMemory;
+    UploadRing mUploadRing;
+
+    // Размещённые (placed) ресурсы: буферы и depth/stencil
+    GpuMemoryManager mGpuMemory;
+
+    // Геометрия: пакетные копии на copy-очереди
+    static constexpr UINT64 GeometryStagingCapacity = 64ull * 1024 * 1024;
+    UploadScheduler mUploadScheduler;
 
     // =========== Root Signature и PSO ===========
     Microsoft::WRL::ComPtr<ID3D12RootSignature> mRootSignature;
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> mPSO;
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> mWireframePSO;  // Второй PSO для проволочного каркаса
+    uint64_t mRootSignatureKey = 0;
+    // PSO создаются лениво по описанию; блобы драйвера переживают перезапуск
+    static constexpr const char* PipelineCachePath = "pipelines.psocache";
+    D3D12PipelineCache mPipelineCache;
+    PipelineDesc mSolidPipeline;
+    PipelineDesc mWireframePipeline;  // Описание для проволочного каркаса
+    PipelineDesc mQuantizedSolidPipeline;      // То же со сжатыми вершинами
+    PipelineDesc mQuantizedWireframePipeline;
     bool mWireframeMode = false;  // Флаг режима отображения
 
     // Математика для камеры
@@ -134,7 +213,42 @@ private:
     XMFLOAT4X4 mView = MathHelper::Identity4x4();
     XMFLOAT4X4 mProj = MathHelper::Identity4x4();
 
-    UINT mIndexCount;
+    UINT mIndexCount = 0;
+
+    // Отсечение пирамидой видимости: кластеры меша под BVH, проверка на CPU в Update.
+    // Видимый кластер хоть у одного экземпляра рисуется у всех; пустой mClusters - весь меш
+    std::vector<MeshCluster> mClusters;
+    Bvh mClusterBvh;
+    std::vector<uint32_t> mVisibleClusters;
+    std::vector<uint8_t> mClusterVisible;
+    CullStats mCullStats;
+
+    // Мешлеты внутри кластеров: сфера + конус нормалей; M переключает
+    MeshletData mMeshlets;
+    std::vector<uint32_t> mVisibleMeshlets;
+    std::vector<uint8_t> mMeshletVisible;
+    MeshletCullStats mMeshletStats;
+    bool mMeshletCulling = true;
+
+    // Цепочка LOD в общем индексном буфере; LOD экземпляра - по экранной ошибке, L переключает
+    static constexpr float LodMaxPixelError = 1.0f;
+    std::vector<MeshLod> mLods;
+    std::vector<std::vector<DrawItem>> mLodDrawItems;   // [0] не используется - там mDrawItems
+    std::vector<uint32_t> mLodInstanceCounts;
+    XMFLOAT3 mMeshCenter = { 0.0f, 0.0f, 0.0f };
+    float mMeshRadius = 0.0f;
+    bool mLodSelection = true;
+
+    // Программное отсечение перекрытых: окклюдеры растеризуются заданием, пока Update
+    // режет кластеры пирамидой; видимые кластеры проверяются по hi-Z, O переключает.
+    // Окклюдеры - по LOD: экземпляр закрывает других тем, что сам рисует
+    std::vector<OccluderMesh> mOccluders;
+    OcclusionBuffer mOcclusionBuffer;
+    std::vector<const OccluderMesh*> mOccluderMeshes;
+    std::vector<XMFLOAT4X4> mOccluderTransforms;
+    JobCounter mOcclusionDone;
+    uint32_t mClustersOccluded = 0;
+    bool mOcclusionCulling = true;
 
     // Вспомогательные методы инициализации
     bool CreateDXGIFactory();
@@ -142,6 +256,9 @@ private:
     bool CreateD3DDevice();
     bool CreateCommandObjects();
     bool CreateFence();
+    bool CreateUploadRing();
+    UploadAllocation AllocateUpload(UINT64 size, UINT64 alignment);
+    void WriteObjectConstants(UINT frameIndex, const ObjectConstants& constants);
     void FlushCommandQueue();
     bool CreateSwapChain();
     void QueryDescriptorSizes();
@@ -158,8 +275,11 @@ private:
     void BuildShaders();
     void BuildConstantBuffer();
     void BuildRootSignature();
-    void BuildPSO();
-    void BuildWireframePSO();  // Новый метод для создания проволочного PSO
+    void BuildPipelineDescs();
+    void BuildClusterBvh();
+    void SelectLods(FXMVECTOR eyePosition);
+    void StartOcclusion(const XMMATRIX& viewProj);
+    void CullClusters(const XMMATRIX& viewProj, FXMVECTOR eyePosition);
 
     // Методы для доступа к ресурсам
     ID3D12Resource* CurrentBackBuffer() const;
@@ -0,0 +1,90 @@
+﻿#include "FrameRing.h"
+
+#include <algorithm>
+
+FrameRing::FrameRing(IFenceQueue& queue, uint32_t frameCount)
+    : mQueue(queue)
+    , mFrameFences(std::max(frameCount, 1u), 0)
+{
+}
+
+uint32_t FrameRing::BeginFrame()
+{
+    uint64_t fence = mFrameFences[mCurrentIndex];
+    if (fence != 0 && mQueue.CompletedValue() < fence)
+    {
+        mStallCount++;
+        mQueue.WaitForValue(fence);
+    }
+    return mCurrentIndex;
+}
+
+uint64_t FrameRing::EndFrame()
+{
+    uint64_t fence = mQueue.Signal();
+    mFrameFences[mCurrentIndex] = fence;
+    mLastSignaled = fence;
+    mCurrentIndex = (mCurrentIndex + 1) % FrameCount();
+    return fence;
+}
+
+void FrameRing::WaitIdle()
+{
+    if (mLastSignaled != 0 && mQueue.CompletedValue() < mLastSignaled)
+        mQueue.WaitForValue(mLastSignaled);
+}
+
+#ifdef _WIN32
+D3D12FenceQueue::~D3D12FenceQueue()
+{
+    Shutdown();
+}
+
+bool D3D12FenceQueue::Initialize(ID3D12Device* device, ID3D12CommandQueue* queue)
+{
+    Shutdown();
+
+    if (FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence))))
+        return false;
+
+    mEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+    if (!mEvent)
+        return false;
+
+    mQueue = queue;
+    mNextValue = 0;
+    return true;
+}
+
+void D3D12FenceQueue::Shutdown()
+{
+    if (mEvent)
+    {
+        CloseHandle(mEvent);
+        mEvent = nullptr;
+    }
+    mFence.Reset();
+    mQueue = nullptr;
+}
+
+uint64_t D3D12FenceQueue::Signal()
+{
+    mNextValue++;
+    mQueue->Signal(mFence.Get(), mNextValue);
+    return mNextValue;
+}
+
+uint64_t D3D12FenceQueue::CompletedValue() const
+{
+    return mFence->GetCompletedValue();
+}
+
+void D3D12FenceQueue::WaitForValue(uint64_t value)
+{
+    if (mFence->GetCompletedValue() >= value)
+        return;
+
+    mFence->SetEventOnCompletion(value, mEvent);
+    WaitForSingleObject(mEvent, INFINITE);
+}
+#endif
@@ -0,0 +1,84 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+#ifdef _WIN32
+#include <d3d12.h>
+#include <wrl/client.h>
+#endif
+
+// ===== Очередь GPU глазами CPU =====
+// Всё, что нужно кольцу кадров от очереди команд: поставить fence и дождаться его.
+// Реализация на D3D12 ниже, для Linux-тестов достаточно мока со счётчиком.
+class IFenceQueue
+{
+public:
+    virtual ~IFenceQueue() = default;
+
+    // Ставит в очередь сигнал со следующим значением fence и возвращает его
+    virtual uint64_t Signal() = 0;
+
+    // Последнее значение, до которого GPU уже дошёл
+    virtual uint64_t CompletedValue() const = 0;
+
+    // Блокирует CPU, пока CompletedValue() < value
+    virtual void WaitForValue(uint64_t value) = 0;
+};
+
+// ===== Кольцо кадров в полёте =====
+// У каждого слота свой fence: CPU ждёт только когда обгоняет GPU на FrameCount() кадров.
+//   BeginFrame() -> запись команд и констант слота CurrentIndex() -> Execute -> EndFrame()
+class FrameRing
+{
+public:
+    static constexpr uint32_t DEFAULT_FRAME_COUNT = 3;
+
+    explicit FrameRing(IFenceQueue& queue, uint32_t frameCount = DEFAULT_FRAME_COUNT);
+
+    // Ждёт GPU, если слот ещё занят кадром FrameCount() назад. Возвращает индекс слота
+    uint32_t BeginFrame();
+
+    // Сигнал fence после отправки кадра, переход к следующему слоту
+    uint64_t EndFrame();
+
+    // Ждёт завершения всех отправленных кадров
+    void WaitIdle();
+
+    uint32_t FrameCount() const { return (uint32_t)mFrameFences.size(); }
+    uint32_t CurrentIndex() const { return mCurrentIndex; }
+    uint64_t FrameFence(uint32_t index) const { return mFrameFences[index]; }
+
+    // Сколько раз BeginFrame реально блокировался
+    uint64_t StallCount() const { return mStallCount; }
+
+private:
+    IFenceQueue& mQueue;
+    std::vector<uint64_t> mFrameFences;  // 0 - слот свободен
+    uint32_t mCurrentIndex = 0;
+    uint64_t mLastSignaled = 0;
+    uint64_t mStallCount = 0;
+};
+
+#ifdef _WIN32
+class D3D12FenceQueue : public IFenceQueue
+{
+public:
+    D3D12FenceQueue() = default;
+    ~D3D12FenceQueue();
+
+    bool Initialize(ID3D12Device* device, ID3D12CommandQueue* queue);
+    void Shutdown();
+
+    uint64_t Signal() override;
+    uint64_t CompletedValue() const override;
+    void WaitForValue(uint64_t value) override;
+
+    ID3D12Fence* Fence() const { return mFence.Get(); }
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+    ID3D12CommandQueue* mQueue = nullptr;
+    HANDLE mEvent = nullptr;
+    uint64_t mNextValue = 0;
+};
+#endif
@@ -0,0 +1,175 @@
+﻿#include "GpuMemory.h"
+
+#include <algorithm>
+
+using Microsoft::WRL::ComPtr;
+
+GpuMemoryManager::~GpuMemoryManager()
+{
+    Shutdown();
+}
+
+bool GpuMemoryManager::Initialize(ID3D12Device* device, uint64_t blockSize)
+{
+    Shutdown();
+
+    mDevice = device;
+    mBlockSize = blockSize;
+    mPools[POOL_BUFFERS].flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    mPools[POOL_RENDER_TARGETS].flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+    return device != nullptr;
+}
+
+void GpuMemoryManager::Shutdown()
+{
+    for (Pool& pool : mPools)
+        pool.blocks.clear();
+    mDevice = nullptr;
+}
+
+HRESULT GpuMemoryManager::CreateBuffer(
+    uint64_t byteSize,
+    D3D12_RESOURCE_STATES initialState,
+    ComPtr<ID3D12Resource>& outResource,
+    GpuAllocation& outAllocation)
+{
+    D3D12_RESOURCE_DESC bufferDesc = {};
+    bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufferDesc.Width = byteSize;
+    bufferDesc.Height = 1;
+    bufferDesc.DepthOrArraySize = 1;
+    bufferDesc.MipLevels = 1;
+    bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufferDesc.SampleDesc.Count = 1;
+    bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    return Place(POOL_BUFFERS, bufferDesc, initialState, nullptr, outResource, outAllocation);
+}
+
+HRESULT GpuMemoryManager::CreateRenderTarget(
+    const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES initialState,
+    const D3D12_CLEAR_VALUE* clearValue,
+    ComPtr<ID3D12Resource>& outResource,
+    GpuAllocation& outAllocation)
+{
+    return Place(POOL_RENDER_TARGETS, desc, initialState, clearValue, outResource, outAllocation);
+}
+
+HRESULT GpuMemoryManager::Place(
+    PoolKind kind,
+    const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES initialState,
+    const D3D12_CLEAR_VALUE* clearValue,
+    ComPtr<ID3D12Resource>& outResource,
+    GpuAllocation& outAllocation)
+{
+    if (!mDevice)
+        return E_FAIL;
+
+    D3D12_RESOURCE_ALLOCATION_INFO info = mDevice->GetResourceAllocationInfo(0, 1, &desc);
+    if (info.SizeInBytes == UINT64_MAX)
+        return E_INVALIDARG;
+
+    Pool& pool = mPools[kind];
+
+    // 1. Место в уже зарезервированных кучах
+    uint32_t blockIndex = 0;
+    uint64_t offset = TlsfAllocator::INVALID_OFFSET;
+    for (; blockIndex < pool.blocks.size(); blockIndex++)
+    {
+        offset = pool.blocks[blockIndex]->allocator.Allocate(info.SizeInBytes, info.Alignment);
+        if (offset != TlsfAllocator::INVALID_OFFSET)
+            break;
+    }
+
+    // 2. Новая куча; ресурс крупнее блока получает кучу под свой размер
+    if (offset == TlsfAllocator::INVALID_OFFSET)
+    {
+        const uint64_t heapAlignment = (info.Alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+            ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT
+            : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        uint64_t heapSize = (info.SizeInBytes > mBlockSize) ? info.SizeInBytes : mBlockSize;
+        heapSize = (heapSize + heapAlignment - 1) & ~(heapAlignment - 1);
+
+        D3D12_HEAP_DESC heapDesc = {};
+        heapDesc.SizeInBytes = heapSize;
+        heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+        heapDesc.Alignment = heapAlignment;
+        heapDesc.Flags = pool.flags;
+
+        auto block = std::make_unique<HeapBlock>();
+        HRESULT hr = mDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&block->heap));
+        if (FAILED(hr))
+            return hr;
+
+        // Пустая куча под размер ресурса обычно его вмещает, но отказ TLSF (нулевой размер,
+        // переполнение с выравниванием) не должен превратиться в CreatePlacedResource по INVALID_OFFSET
+        block->allocator.Reset(heapSize);
+        offset = block->allocator.Allocate(info.SizeInBytes, info.Alignment);
+        if (offset == TlsfAllocator::INVALID_OFFSET)
+            return E_OUTOFMEMORY;
+
+        blockIndex = (uint32_t)pool.blocks.size();
+        pool.blocks.push_back(std::move(block));
+    }
+
+    HeapBlock& block = *pool.blocks[blockIndex];
+    HRESULT hr = mDevice->CreatePlacedResource(
+        block.heap.Get(),
+        offset,
+        &desc,
+        initialState,
+        clearValue,
+        IID_PPV_ARGS(&outResource)
+    );
+
+    if (FAILED(hr))
+    {
+        block.allocator.Free(offset);
+        return hr;
+    }
+
+    outAllocation.pool = kind;
+    outAllocation.block = blockIndex;
+    outAllocation.offset = offset;
+    outAllocation.size = info.SizeInBytes;
+    return S_OK;
+}
+
+void GpuMemoryManager::Free(GpuAllocation& allocation)
+{
+    if (!allocation.IsValid())
+        return;
+
+    Pool& pool = mPools[allocation.pool];
+    if (allocation.block < pool.blocks.size())
+        pool.blocks[allocation.block]->allocator.Free(allocation.offset);
+
+    allocation = GpuAllocation();
+}
+
+GpuMemoryStats GpuMemoryManager::GetStats() const
+{
+    GpuMemoryStats stats;
+
+    for (const Pool& pool : mPools)
+    {
+        for (const auto& block : pool.blocks)
+        {
+            TlsfAllocator::Stats s = block->allocator.GetStats();
+            stats.reservedBytes += s.capacity;
+            stats.usedBytes += s.usedBytes;
+            stats.allocationCount += s.allocationCount;
+            stats.freeBlockCount += s.freeBlockCount;
+            stats.heapCount++;
+            if (s.largestFreeBlock > stats.largestFreeBlock)
+                stats.largestFreeBlock = s.largestFreeBlock;
+
+            // Кучи не сливаются, так что свободное место считается внутри каждой
+            stats.fragmentation = std::max(stats.fragmentation, s.Fragmentation());
+        }
+    }
+
+    return stats;
+}
@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "TlsfAllocator.h"
+
+// ===== Размещение ресурсов в больших ID3D12Heap =====
+// Вместо неявной кучи на каждый CreateCommittedResource: блоки по blockSize,
+// внутри - TlsfAllocator, ресурсы создаются через CreatePlacedResource.
+// Буферы и RT/DS-текстуры живут в разных кучах (работает и на Resource Heap Tier 1).
+
+struct GpuAllocation
+{
+    uint32_t pool = ~0u;
+    uint32_t block = 0;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+
+    bool IsValid() const { return pool != ~0u; }
+};
+
+struct GpuMemoryStats
+{
+    uint64_t reservedBytes = 0;     // сумма размеров ID3D12Heap
+    uint64_t usedBytes = 0;
+    uint64_t largestFreeBlock = 0;
+    uint32_t heapCount = 0;
+    uint32_t allocationCount = 0;
+    uint32_t freeBlockCount = 0;
+
+    // По худшей куче: доля её свободного места вне её самого большого свободного куска.
+    // Две нетронутые кучи - 0, а не 0.5: кусок из одной в другую всё равно не перейдёт
+    float fragmentation = 0.0f;
+};
+
+class GpuMemoryManager
+{
+public:
+    static constexpr uint64_t DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+    GpuMemoryManager() = default;
+    ~GpuMemoryManager();
+
+    bool Initialize(ID3D12Device* device, uint64_t blockSize = DEFAULT_BLOCK_SIZE);
+    void Shutdown();
+
+    // Буфер в DEFAULT куче
+    HRESULT CreateBuffer(
+        uint64_t byteSize,
+        D3D12_RESOURCE_STATES initialState,
+        Microsoft::WRL::ComPtr<ID3D12Resource>& outResource,
+        GpuAllocation& outAllocation);
+
+    // Текстура с ALLOW_RENDER_TARGET или ALLOW_DEPTH_STENCIL
+    HRESULT CreateRenderTarget(
+        const D3D12_RESOURCE_DESC& desc,
+        D3D12_RESOURCE_STATES initialState,
+        const D3D12_CLEAR_VALUE* clearValue,
+        Microsoft::WRL::ComPtr<ID3D12Resource>& outResource,
+        GpuAllocation& outAllocation);
+
+    // Ресурс к этому моменту должен быть отпущен и не использоваться GPU
+    void Free(GpuAllocation& allocation);
+
+    GpuMemoryStats GetStats() const;
+
+private:
+    enum PoolKind
+    {
+        POOL_BUFFERS,
+        POOL_RENDER_TARGETS,
+        POOL_COUNT
+    };
+
+    struct HeapBlock
+    {
+        Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+        TlsfAllocator allocator;
+    };
+
+    struct Pool
+    {
+        D3D12_HEAP_FLAGS flags = D3D12_HEAP_FLAG_NONE;
+        std::vector<std::unique_ptr<HeapBlock>> blocks;
+    };
+
+    HRESULT Place(
+        PoolKind kind,
+        const D3D12_RESOURCE_DESC& desc,
+        D3D12_RESOURCE_STATES initialState,
+        const D3D12_CLEAR_VALUE* clearValue,
+        Microsoft::WRL::ComPtr<ID3D12Resource>& outResource,
+        GpuAllocation& outAllocation);
+
+    ID3D12Device* mDevice = nullptr;
+    uint64_t mBlockSize = DEFAULT_BLOCK_SIZE;
+    Pool mPools[POOL_COUNT];
+};
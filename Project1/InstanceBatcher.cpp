@@ -0,0 +1,63 @@
+﻿#include "InstanceBatcher.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr size_t MIN_PACK_ITEMS = 4096;
+
+    inline bool BatchLess(const RenderInstance& a, const RenderInstance& b)
+    {
+        if (a.pipeline != b.pipeline) return a.pipeline < b.pipeline;
+        if (a.mesh != b.mesh) return a.mesh < b.mesh;
+        return a.lod < b.lod;
+    }
+}
+
+void BuildInstanceBatches(
+    const RenderInstance* instances,
+    size_t count,
+    std::vector<uint32_t>& outOrder,
+    std::vector<InstanceBatch>& outBatches)
+{
+    outOrder.resize(count);
+    for (size_t i = 0; i < count; i++)
+        outOrder[i] = (uint32_t)i;
+
+    std::stable_sort(outOrder.begin(), outOrder.end(),
+        [instances](uint32_t a, uint32_t b) { return BatchLess(instances[a], instances[b]); });
+
+    outBatches.clear();
+    for (size_t i = 0; i < count; i++)
+    {
+        const RenderInstance& instance = instances[outOrder[i]];
+        if (outBatches.empty() ||
+            outBatches.back().mesh != instance.mesh ||
+            outBatches.back().pipeline != instance.pipeline ||
+            outBatches.back().lod != instance.lod)
+        {
+            outBatches.push_back({ instance.mesh, instance.pipeline, instance.lod, (uint32_t)i, 0 });
+        }
+        outBatches.back().instanceCount++;
+    }
+}
+
+void PackInstanceTransforms(
+    const RenderInstance* instances,
+    const uint32_t* order,
+    size_t count,
+    InstanceData* dst,
+    unsigned threadCount)
+{
+    ParallelForRange(count, MIN_PACK_ITEMS, threadCount, [&](size_t, size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            XMMATRIX world = XMLoadFloat4x4(&instances[order[i]].world);
+            XMStoreFloat4x4(&dst[i].world, XMMatrixTranspose(world));
+        }
+    });
+}
@@ -0,0 +1,48 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+// ===== Экземпляры и группировка в инстансные вызовы =====
+// Экземпляры с одинаковыми (pipeline, mesh, lod) идут одним DrawIndexedInstanced;
+// их мировые матрицы лежат подряд в StructuredBuffer<InstanceData> (gInstances в shaders.hlsl)
+
+struct RenderInstance
+{
+    uint32_t mesh = 0;
+    uint32_t pipeline = 0;
+    uint32_t lod = 0;         // выбирается каждый кадр (SelectLod)
+    DirectX::XMFLOAT4X4 world;
+};
+
+// Как видит шейдер: матрица уже транспонирована
+struct InstanceData
+{
+    DirectX::XMFLOAT4X4 world;
+};
+
+struct InstanceBatch
+{
+    uint32_t mesh;
+    uint32_t pipeline;
+    uint32_t lod;
+    uint32_t firstInstance;   // в упакованном массиве
+    uint32_t instanceCount;
+};
+
+// Порядок экземпляров (стабильный по (pipeline, mesh, lod)) и группы подряд идущих
+void BuildInstanceBatches(
+    const RenderInstance* instances,
+    size_t count,
+    std::vector<uint32_t>& outOrder,
+    std::vector<InstanceBatch>& outBatches
+);
+
+// dst[i] = transpose(instances[order[i]].world). dst может быть upload-памятью (только запись)
+void PackInstanceTransforms(
+    const RenderInstance* instances,
+    const uint32_t* order,
+    size_t count,
+    InstanceData* dst,
+    unsigned threadCount = 0
+);
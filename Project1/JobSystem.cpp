@@ -0,0 +1,357 @@
+﻿#include "JobSystem.h"
+
+#include <cassert>
+
+namespace
+{
+    constexpr uint32_t JOB_POOL_BLOCK = 1024;
+    constexpr uint32_t IDLE_SPINS = 64;   // пустых проходов с yield перед сном
+
+    // Поток и его система; поток-владелец восстанавливает прежнее значение в деструкторе
+    struct ThreadSlot
+    {
+        JobSystem* system = nullptr;
+        uint32_t index = 0;
+    };
+    thread_local ThreadSlot tThreadSlot;
+
+    // Дека Chase-Lev (вариант Lê и др. для модели памяти C11): Push/Pop - только владелец, Steal - любой
+    class WorkStealingDeque
+    {
+    public:
+        bool Push(Job* job)
+        {
+            const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+            const int64_t top = mTop.load(std::memory_order_acquire);
+            if (bottom - top >= (int64_t)JOB_DEQUE_CAPACITY)
+                return false;
+
+            mBuffer[bottom & (JOB_DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+            mBottom.store(bottom + 1, std::memory_order_release);
+            return true;
+        }
+
+        Job* Pop()
+        {
+            const int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+            mBottom.store(bottom, std::memory_order_seq_cst);
+            int64_t top = mTop.load(std::memory_order_seq_cst);
+
+            if (top > bottom)
+            {
+                mBottom.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            Job* job = mBuffer[bottom & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+            if (top == bottom)
+            {
+                // Последний элемент - спорим с ворами за top
+                if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    job = nullptr;
+                mBottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+
+        Job* Steal()
+        {
+            int64_t top = mTop.load(std::memory_order_seq_cst);
+            const int64_t bottom = mBottom.load(std::memory_order_seq_cst);
+            if (top >= bottom)
+                return nullptr;
+
+            Job* job = mBuffer[top & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+            if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+            return job;
+        }
+
+    private:
+        alignas(64) std::atomic<int64_t> mTop{ 0 };
+        alignas(64) std::atomic<int64_t> mBottom{ 0 };
+        alignas(64) std::atomic<Job*> mBuffer[JOB_DEQUE_CAPACITY] = {};
+    };
+
+    // Счётчик одного потока: пишет только он, читать можно из любого
+    void Increment(std::atomic<uint64_t>& value)
+    {
+        value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+struct alignas(64) JobSystem::Worker
+{
+    uint32_t index = 0;
+    uint32_t random = 1;     // xorshift: с какой жертвы начинать кражу
+    WorkStealingDeque deque;
+
+    // Пул заданий: выделяет только этот поток, освобождает тот, кто завершил
+    std::vector<std::unique_ptr<Job[]>> blocks;
+    size_t cursor = 0;
+
+    std::atomic<uint64_t> executed{ 0 };
+    std::atomic<uint64_t> stolen{ 0 };
+    std::atomic<uint64_t> failedSteals{ 0 };
+    std::atomic<uint64_t> overflowed{ 0 };
+    std::atomic<uint64_t> sleeps{ 0 };
+};
+
+JobSystem::JobSystem(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0)
+        threadCount = 1;
+
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        mWorkers.push_back(std::make_unique<Worker>());
+        mWorkers.back()->index = i;
+        mWorkers.back()->random = 0x9e3779b9u * (i + 1);
+    }
+
+    mPreviousSystem = tThreadSlot.system;
+    mPreviousIndex = tThreadSlot.index;
+    tThreadSlot = { this, 0 };
+
+    for (uint32_t i = 1; i < threadCount; i++)
+        mThreads.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    // Запущенное, но не дождавшееся задание всё равно выполняется
+    Worker& owner = *mWorkers[0];
+    while (Job* job = FindJob(owner))
+        Execute(owner, job);
+
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mQuit.store(true);
+    }
+    mWake.notify_all();
+    for (auto& thread : mThreads)
+        thread.join();
+
+    tThreadSlot = { mPreviousSystem, mPreviousIndex };
+}
+
+JobSystem* JobSystem::ForCurrentThread()
+{
+    return tThreadSlot.system;
+}
+
+JobSystem::Worker& JobSystem::CurrentWorker()
+{
+    assert(tThreadSlot.system == this && "JobSystem is used from a foreign thread");
+    return *mWorkers[tThreadSlot.index];
+}
+
+Job* JobSystem::Allocate()
+{
+    Worker& worker = CurrentWorker();
+
+    // Задания завершаются примерно в порядке создания - ищем свободное по кругу от курсора
+    const size_t capacity = worker.blocks.size() * JOB_POOL_BLOCK;
+    for (size_t i = 0; i < capacity; i++)
+    {
+        const size_t slot = worker.cursor;
+        worker.cursor = (worker.cursor + 1) % capacity;
+
+        Job& job = worker.blocks[slot / JOB_POOL_BLOCK][slot % JOB_POOL_BLOCK];
+        if (!job.inUse.load(std::memory_order_acquire))
+        {
+            job.inUse.store(true, std::memory_order_relaxed);
+            return &job;
+        }
+    }
+
+    // Всё занято - новый блок, старые задания не двигаются
+    worker.blocks.push_back(std::make_unique<Job[]>(JOB_POOL_BLOCK));
+    worker.cursor = capacity + 1;
+    Job& job = worker.blocks.back()[0];
+    job.inUse.store(true, std::memory_order_relaxed);
+    return &job;
+}
+
+bool JobSystem::AddContinuation(Job* before, Job* after)
+{
+    if (before->continuationCount >= JOB_MAX_CONTINUATIONS)
+        return false;
+
+    after->dependencies.fetch_add(1, std::memory_order_relaxed);
+    before->continuations[before->continuationCount++] = after;
+    return true;
+}
+
+void JobSystem::Run(Job* job)
+{
+    if (job->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        Push(job);
+}
+
+void JobSystem::Push(Job* job)
+{
+    Worker& worker = CurrentWorker();
+    if (!worker.deque.Push(job))
+    {
+        Increment(worker.overflowed);
+        Execute(worker, job);
+        return;
+    }
+
+    // Спящий либо увидит новое значение сигнала, либо найдёт задание в деке при последней проверке
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mSleepers.load(std::memory_order_relaxed) != 0)
+    {
+        mWakeSignal.fetch_add(1, std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mWake.notify_one();
+    }
+}
+
+Job* JobSystem::FindJob(Worker& worker)
+{
+    if (Job* job = worker.deque.Pop())
+        return job;
+
+    const uint32_t count = (uint32_t)mWorkers.size();
+    if (count == 1)
+        return nullptr;
+
+    worker.random ^= worker.random << 13;
+    worker.random ^= worker.random >> 17;
+    worker.random ^= worker.random << 5;
+
+    const uint32_t first = worker.random % count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        Worker& victim = *mWorkers[(first + i) % count];
+        if (&victim == &worker)
+            continue;
+
+        if (Job* job = victim.deque.Steal())
+        {
+            Increment(worker.stolen);
+            return job;
+        }
+        Increment(worker.failedSteals);
+    }
+    return nullptr;
+}
+
+void JobSystem::Execute(Worker& worker, Job* job)
+{
+    job->invoke(*job);
+    job->destroy(*job);
+    Increment(worker.executed);
+    Finish(job);
+}
+
+void JobSystem::Finish(Job* job)
+{
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    // После inUse = false задание может достаться другому - всё нужное забираем заранее
+    Job* parent = job->parent;
+    JobCounter* counter = job->counter;
+    const uint32_t continuationCount = job->continuationCount;
+    Job* continuations[JOB_MAX_CONTINUATIONS];
+    for (uint32_t i = 0; i < continuationCount; i++)
+        continuations[i] = job->continuations[i];
+    job->inUse.store(false, std::memory_order_release);
+
+    for (uint32_t i = 0; i < continuationCount; i++)
+        Run(continuations[i]);
+    if (parent)
+        Finish(parent);
+    if (counter)
+        counter->mPending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+    Worker& worker = CurrentWorker();
+    while (!counter.IsDone())
+    {
+        if (Job* job = FindJob(worker))
+            Execute(worker, job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::WorkerLoop(uint32_t index)
+{
+    tThreadSlot = { this, index };
+    Worker& worker = *mWorkers[index];
+
+    uint32_t idle = 0;
+    for (;;)
+    {
+        if (Job* job = FindJob(worker))
+        {
+            Execute(worker, job);
+            idle = 0;
+            continue;
+        }
+        if (mQuit.load(std::memory_order_acquire))
+            break;
+        if (++idle < IDLE_SPINS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Засыпаем: объявляемся, запоминаем сигнал и проверяем деки ещё раз
+        mSleepers.fetch_add(1, std::memory_order_seq_cst);
+        const uint64_t signal = mWakeSignal.load(std::memory_order_seq_cst);
+        if (Job* job = FindJob(worker))
+        {
+            mSleepers.fetch_sub(1, std::memory_order_relaxed);
+            Execute(worker, job);
+            idle = 0;
+            continue;
+        }
+
+        Increment(worker.sleeps);
+        {
+            std::unique_lock<std::mutex> lock(mSleepMutex);
+            mWake.wait(lock, [&]()
+                {
+                    return mQuit.load(std::memory_order_relaxed) ||
+                        mWakeSignal.load(std::memory_order_relaxed) != signal;
+                });
+        }
+        mSleepers.fetch_sub(1, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+JobSystemStats JobSystem::GetStats() const
+{
+    JobSystemStats stats;
+    for (const auto& worker : mWorkers)
+    {
+        stats.executed += worker->executed.load(std::memory_order_relaxed);
+        stats.stolen += worker->stolen.load(std::memory_order_relaxed);
+        stats.failedSteals += worker->failedSteals.load(std::memory_order_relaxed);
+        stats.overflowed += worker->overflowed.load(std::memory_order_relaxed);
+        stats.sleeps += worker->sleeps.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void JobSystem::ResetStats()
+{
+    for (auto& worker : mWorkers)
+    {
+        worker->executed.store(0, std::memory_order_relaxed);
+        worker->stolen.store(0, std::memory_order_relaxed);
+        worker->failedSteals.store(0, std::memory_order_relaxed);
+        worker->overflowed.store(0, std::memory_order_relaxed);
+        worker->sleeps.store(0, std::memory_order_relaxed);
+    }
+}
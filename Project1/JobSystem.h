@@ -0,0 +1,191 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ===== Система заданий =====
+// Поток, создавший систему, - поток 0, остальные - рабочие. У каждого потока своя дека
+// Chase-Lev без блокировок: свои задания кладутся и берутся снизу (LIFO, тёплый кэш),
+// простаивающие потоки воруют сверху (FIFO - самые крупные куски разбиения).
+// Задание берётся из пула создавшего потока и возвращается туда сразу по завершении,
+// поэтому ждут не заданий, а счётчиков (JobCounter). Вызывать - только из потоков системы
+
+constexpr uint32_t JOB_DEQUE_CAPACITY = 4096;   // степень двойки; в полную деку не кладём - выполняем сразу
+constexpr uint32_t JOB_MAX_CONTINUATIONS = 8;
+constexpr size_t JOB_STORAGE_BYTES = 64;        // захваты лямбды задания
+
+// Число незавершённых заданий; JobSystem::Wait ждёт нуля
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool IsDone() const { return mPending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<uint32_t> mPending{ 0 };
+};
+
+struct Job
+{
+    void (*invoke)(Job& job) = nullptr;
+    void (*destroy)(Job& job) = nullptr;
+    Job* parent = nullptr;
+    JobCounter* counter = nullptr;
+    std::atomic<int32_t> unfinished{ 0 };     // само задание + незавершённые дети
+    std::atomic<int32_t> dependencies{ 0 };   // Run + незавершённые предшественники
+    uint32_t continuationCount = 0;
+    Job* continuations[JOB_MAX_CONTINUATIONS] = {};
+    std::atomic<bool> inUse{ false };
+    alignas(std::max_align_t) unsigned char storage[JOB_STORAGE_BYTES];
+};
+
+// Счётчики для замеров; складываются по потокам, точны, когда система простаивает
+struct JobSystemStats
+{
+    uint64_t executed = 0;
+    uint64_t stolen = 0;
+    uint64_t failedSteals = 0;   // жертва пуста или кражу перехватили
+    uint64_t overflowed = 0;     // дека была полна - выполнено на месте
+    uint64_t sleeps = 0;
+};
+
+class JobSystem
+{
+public:
+    // threadCount - всего потоков вместе с вызывающим; 0 = по числу ядер
+    explicit JobSystem(unsigned threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    uint32_t ThreadCount() const { return (uint32_t)mWorkers.size(); }
+
+    // Система, которой принадлежит текущий поток, иначе nullptr
+    static JobSystem* ForCurrentThread();
+
+    // fn() или fn(Job& self). Задание не стартует до Run; counter (если есть) ждёт и его
+    template<typename Fn>
+    Job* CreateJob(Fn&& fn, JobCounter* counter = nullptr) { return CreateChildJob(nullptr, std::forward<Fn>(fn), counter); }
+
+    // Родитель завершится только вместе с ребёнком; создавать до конца работы родителя
+    template<typename Fn>
+    Job* CreateChildJob(Job* parent, Fn&& fn, JobCounter* counter = nullptr);
+
+    // after стартует, когда завершатся before (вместе с детьми) и его собственный Run.
+    // Оба ещё не запущены; false - у before кончились места под продолжения
+    bool AddContinuation(Job* before, Job* after);
+
+    void Run(Job* job);
+
+    // Ждёт счётчик, выполняя задания (свои и украденные)
+    void Wait(const JobCounter& counter);
+
+    // fn(begin, end) по кускам не меньше minItems: диапазон делится пополам, правые половины -
+    // задания, самый левый кусок - на вызывающем потоке. Возвращает после всех кусков
+    template<typename Fn>
+    void ParallelFor(size_t count, size_t minItems, Fn&& fn);
+
+    JobSystemStats GetStats() const;
+    void ResetStats();
+
+private:
+    struct Worker;
+
+    Job* Allocate();
+    void Push(Job* job);
+    Job* FindJob(Worker& worker);
+    void Execute(Worker& worker, Job* job);
+    void Finish(Job* job);
+    void WorkerLoop(uint32_t index);
+    Worker& CurrentWorker();
+
+    template<typename Fn>
+    static void SplitRange(JobSystem* system, Fn* fn, size_t begin, size_t end, size_t minItems, JobCounter* counter);
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;   // [0] - поток-владелец
+    std::vector<std::thread> mThreads;
+
+    // Чьим был поток-владелец до нас (система, созданная внутри задания другой системы)
+    JobSystem* mPreviousSystem = nullptr;
+    uint32_t mPreviousIndex = 0;
+
+    // Сон простаивающих: Push будит, только если кто-то спит
+    std::mutex mSleepMutex;
+    std::condition_variable mWake;
+    std::atomic<uint64_t> mWakeSignal{ 0 };
+    std::atomic<uint32_t> mSleepers{ 0 };
+    std::atomic<bool> mQuit{ false };
+};
+
+template<typename Fn>
+Job* JobSystem::CreateChildJob(Job* parent, Fn&& fn, JobCounter* counter)
+{
+    using Callable = std::decay_t<Fn>;
+    static_assert(sizeof(Callable) <= JOB_STORAGE_BYTES, "job captures do not fit JOB_STORAGE_BYTES");
+    static_assert(alignof(Callable) <= alignof(std::max_align_t), "job captures are over-aligned");
+
+    Job* job = Allocate();
+    new (job->storage) Callable(std::forward<Fn>(fn));
+    job->invoke = [](Job& self)
+        {
+            Callable& callable = *std::launder(reinterpret_cast<Callable*>(self.storage));
+            if constexpr (std::is_invocable_v<Callable&, Job&>)
+                callable(self);
+            else
+                callable();
+        };
+    job->destroy = [](Job& self) { std::launder(reinterpret_cast<Callable*>(self.storage))->~Callable(); };
+    job->parent = parent;
+    job->counter = counter;
+    job->unfinished.store(1, std::memory_order_relaxed);
+    job->dependencies.store(1, std::memory_order_relaxed);
+    job->continuationCount = 0;
+
+    if (parent)
+        parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+    if (counter)
+        counter->mPending.fetch_add(1, std::memory_order_relaxed);
+    return job;
+}
+
+template<typename Fn>
+void JobSystem::SplitRange(JobSystem* system, Fn* fn, size_t begin, size_t end, size_t minItems, JobCounter* counter)
+{
+    while (end - begin > minItems)
+    {
+        const size_t mid = begin + (end - begin) / 2;
+        system->Run(system->CreateJob([=]() { SplitRange(system, fn, mid, end, minItems, counter); }, counter));
+        end = mid;
+    }
+    (*fn)(begin, end);
+}
+
+template<typename Fn>
+void JobSystem::ParallelFor(size_t count, size_t minItems, Fn&& fn)
+{
+    if (minItems == 0)
+        minItems = 1;
+    if (count <= minItems || ThreadCount() == 1)
+    {
+        if (count != 0)
+            fn((size_t)0, count);
+        return;
+    }
+
+    JobCounter counter;
+    SplitRange(this, &fn, 0, count, minItems, &counter);
+    Wait(counter);
+}
@@ -0,0 +1,118 @@
+﻿#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    mFile = file;
+    mSize = (size_t)size.QuadPart;
+    mOpen = true;
+
+    // Пустой файл отобразить нельзя - просто нет данных
+    if (mSize == 0)
+        return true;
+
+    mMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mMapping) {
+        Close();
+        return false;
+    }
+
+    mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mData) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if (mData)
+        UnmapViewOfFile(mData);
+    if (mMapping)
+        CloseHandle(mMapping);
+    if (mFile)
+        CloseHandle(mFile);
+
+    mData = nullptr;
+    mMapping = nullptr;
+    mFile = nullptr;
+    mSize = 0;
+    mOpen = false;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    mFile = fd;
+    mSize = (size_t)st.st_size;
+    mOpen = true;
+
+    if (mSize == 0)
+        return true;
+
+    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        Close();
+        return false;
+    }
+
+    // Разбор идёт последовательно по кускам - подсказываем ядру read-ahead
+    madvise(data, mSize, MADV_SEQUENTIAL);
+
+    mData = static_cast<const char*>(data);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (mData)
+        munmap(const_cast<char*>(mData), mSize);
+    if (mFile >= 0)
+        close(mFile);
+
+    mData = nullptr;
+    mFile = -1;
+    mSize = 0;
+    mOpen = false;
+}
+
+#endif
@@ -0,0 +1,31 @@
+﻿#pragma once
+#include <string>
+#include <cstddef>
+
+// Файл, отображённый в память только для чтения (Win32 / POSIX mmap)
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const { return mOpen; }
+    const char* Data() const { return mData; }
+    size_t Size() const { return mSize; }
+
+private:
+#ifdef _WIN32
+    void* mFile = nullptr;     // HANDLE файла
+    void* mMapping = nullptr;  // HANDLE отображения
+#else
+    int mFile = -1;
+#endif
+    const char* mData = nullptr;
+    size_t mSize = 0;
+    bool mOpen = false;
+};
@@ -0,0 +1,166 @@
+﻿#include "MeshBounds.h"
+#include "Vertex.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Меньше вершин на поток - накладные расходы потока дороже самой работы
+    constexpr size_t MIN_VERTICES_PER_THREAD = 64 * 1024;
+
+    // Позиции лежат с произвольным шагом: Vertex (AoS) или плотный массив XMFLOAT3 (SoA)
+    inline XMFLOAT3* PositionAt(XMFLOAT3* first, size_t stride, size_t i)
+    {
+        return reinterpret_cast<XMFLOAT3*>(reinterpret_cast<char*>(first) + i * stride);
+    }
+
+    inline const XMFLOAT3* PositionAt(const XMFLOAT3* first, size_t stride, size_t i)
+    {
+        return reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(first) + i * stride);
+    }
+
+    void ComputeMinMax(const XMFLOAT3* positions, size_t stride, size_t count, unsigned threadCount,
+        XMFLOAT3& outMin, XMFLOAT3& outMax)
+    {
+        const size_t maxParts = ResolveThreadCount(threadCount);
+        std::vector<XMFLOAT3> partMin(maxParts, positions[0]);
+        std::vector<XMFLOAT3> partMax(maxParts, positions[0]);
+
+        ParallelForRange(count, MIN_VERTICES_PER_THREAD, threadCount,
+            [&](size_t part, size_t begin, size_t end)
+            {
+                // Две пары аккумуляторов, чтобы min/max соседних вершин не ждали друг друга
+                XMVECTOR min0 = XMLoadFloat3(PositionAt(positions, stride, begin));
+                XMVECTOR max0 = min0;
+                XMVECTOR min1 = min0;
+                XMVECTOR max1 = min0;
+
+                size_t i = begin;
+                for (; i + 1 < end; i += 2)
+                {
+                    XMVECTOR p0 = XMLoadFloat3(PositionAt(positions, stride, i));
+                    XMVECTOR p1 = XMLoadFloat3(PositionAt(positions, stride, i + 1));
+
+                    min0 = XMVectorMin(min0, p0);
+                    max0 = XMVectorMax(max0, p0);
+                    min1 = XMVectorMin(min1, p1);
+                    max1 = XMVectorMax(max1, p1);
+                }
+                if (i < end)
+                {
+                    XMVECTOR p = XMLoadFloat3(PositionAt(positions, stride, i));
+                    min0 = XMVectorMin(min0, p);
+                    max0 = XMVectorMax(max0, p);
+                }
+
+                XMStoreFloat3(&partMin[part], XMVectorMin(min0, min1));
+                XMStoreFloat3(&partMax[part], XMVectorMax(max0, max1));
+            });
+
+        XMVECTOR vMin = XMLoadFloat3(&partMin[0]);
+        XMVECTOR vMax = XMLoadFloat3(&partMax[0]);
+        for (size_t i = 1; i < maxParts; i++)
+        {
+            vMin = XMVectorMin(vMin, XMLoadFloat3(&partMin[i]));
+            vMax = XMVectorMax(vMax, XMLoadFloat3(&partMax[i]));
+        }
+
+        XMStoreFloat3(&outMin, vMin);
+        XMStoreFloat3(&outMax, vMax);
+    }
+
+    BoundingBox MakeBox(const XMFLOAT3& minP, const XMFLOAT3& maxP)
+    {
+        return BoundingBox(
+            XMFLOAT3((minP.x + maxP.x) * 0.5f, (minP.y + maxP.y) * 0.5f, (minP.z + maxP.z) * 0.5f),
+            XMFLOAT3((maxP.x - minP.x) * 0.5f, (maxP.y - minP.y) * 0.5f, (maxP.z - minP.z) * 0.5f));
+    }
+
+    BoundingBox ComputeBoundsStrided(const XMFLOAT3* positions, size_t stride, size_t count, unsigned threadCount)
+    {
+        if (count == 0)
+            return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+        XMFLOAT3 minP, maxP;
+        ComputeMinMax(positions, stride, count, threadCount, minP, maxP);
+        return MakeBox(minP, maxP);
+    }
+
+    BoundingBox NormalizeStrided(XMFLOAT3* positions, size_t stride, size_t count, float targetExtent, unsigned threadCount)
+    {
+        if (count == 0)
+            return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+        XMFLOAT3 minP, maxP;
+        ComputeMinMax(positions, stride, count, threadCount, minP, maxP);
+
+        float maxExtent = std::max(maxP.x - minP.x, std::max(maxP.y - minP.y, maxP.z - minP.z));
+        if (maxExtent <= 0.0f)
+            return MakeBox(minP, maxP);
+
+        const MeshNormalization normalization = ComputeMeshNormalization(minP, maxP, targetExtent);
+        const XMFLOAT3& center = normalization.center;
+        const float scale = normalization.scale;
+        const XMVECTOR vCenter = XMLoadFloat3(&center);
+        const XMVECTOR vScale = XMVectorReplicate(scale);
+
+        ParallelForRange(count, MIN_VERTICES_PER_THREAD, threadCount,
+            [&](size_t, size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    XMFLOAT3* position = PositionAt(positions, stride, i);
+                    XMVECTOR p = XMLoadFloat3(position);
+                    p = XMVectorMultiply(XMVectorSubtract(p, vCenter), vScale);
+                    XMStoreFloat3(position, p);
+                }
+            });
+
+        // Габариты после переноса/масштаба считаются из исходных, без второго прохода
+        XMFLOAT3 newMin = { (minP.x - center.x) * scale, (minP.y - center.y) * scale, (minP.z - center.z) * scale };
+        XMFLOAT3 newMax = { (maxP.x - center.x) * scale, (maxP.y - center.y) * scale, (maxP.z - center.z) * scale };
+        return MakeBox(newMin, newMax);
+    }
+}
+
+BoundingBox ComputeMeshBounds(const Vertex* vertices, size_t count, unsigned threadCount)
+{
+    return ComputeBoundsStrided(&vertices->position, sizeof(Vertex), count, threadCount);
+}
+
+BoundingBox ComputeMeshBounds(const XMFLOAT3* positions, size_t count, unsigned threadCount)
+{
+    return ComputeBoundsStrided(positions, sizeof(XMFLOAT3), count, threadCount);
+}
+
+BoundingBox NormalizeMesh(Vertex* vertices, size_t count, float targetExtent, unsigned threadCount)
+{
+    return NormalizeStrided(&vertices->position, sizeof(Vertex), count, targetExtent, threadCount);
+}
+
+BoundingBox NormalizeMesh(XMFLOAT3* positions, size_t count, float targetExtent, unsigned threadCount)
+{
+    return NormalizeStrided(positions, sizeof(XMFLOAT3), count, targetExtent, threadCount);
+}
+
+MeshNormalization ComputeMeshNormalization(const XMFLOAT3& minP, const XMFLOAT3& maxP, float targetExtent)
+{
+    MeshNormalization normalization;
+
+    float maxExtent = std::max(maxP.x - minP.x, std::max(maxP.y - minP.y, maxP.z - minP.z));
+    if (maxExtent <= 0.0f)
+        return normalization;
+
+    normalization.center =
+    {
+        (minP.x + maxP.x) * 0.5f,
+        (minP.y + maxP.y) * 0.5f,
+        (minP.z + maxP.z) * 0.5f
+    };
+    normalization.scale = targetExtent / maxExtent;
+    return normalization;
+}
@@ -0,0 +1,60 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstddef>
+
+struct Vertex;
+
+// Габариты позиций меша: SIMD (XMVECTOR min/max), параллельно по диапазонам вершин
+DirectX::BoundingBox ComputeMeshBounds(
+    const Vertex* vertices,
+    size_t count,
+    unsigned threadCount = 0
+);
+
+// То же для плотного массива позиций (SoA)
+DirectX::BoundingBox ComputeMeshBounds(
+    const DirectX::XMFLOAT3* positions,
+    size_t count,
+    unsigned threadCount = 0
+);
+
+// Перенос в начало координат и масштаб так, чтобы наибольшая сторона стала targetExtent.
+// Возвращает габариты уже нормализованного меша
+DirectX::BoundingBox NormalizeMesh(
+    Vertex* vertices,
+    size_t count,
+    float targetExtent,
+    unsigned threadCount = 0
+);
+
+DirectX::BoundingBox NormalizeMesh(
+    DirectX::XMFLOAT3* positions,
+    size_t count,
+    float targetExtent,
+    unsigned threadCount = 0
+);
+
+// Перенос и масштаб, которые применяет NormalizeMesh: p' = (p - center) * scale.
+// Для тех, кто видит позиции по частям (LoadOBJStreamed): габариты отдельно, применение отдельно
+struct MeshNormalization
+{
+    DirectX::XMFLOAT3 center = { 0.0f, 0.0f, 0.0f };
+    float scale = 1.0f;
+
+    DirectX::XMFLOAT3 Apply(const DirectX::XMFLOAT3& position) const
+    {
+        DirectX::XMFLOAT3 result;
+        DirectX::XMStoreFloat3(&result, DirectX::XMVectorMultiply(
+            DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&position), DirectX::XMLoadFloat3(&center)),
+            DirectX::XMVectorReplicate(scale)));
+        return result;
+    }
+};
+
+// Вырожденные габариты (все точки совпадают) - тождественное преобразование, как у NormalizeMesh
+MeshNormalization ComputeMeshNormalization(
+    const DirectX::XMFLOAT3& minP,
+    const DirectX::XMFLOAT3& maxP,
+    float targetExtent
+);
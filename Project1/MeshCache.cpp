@@ -0,0 +1,296 @@
+﻿#include "MeshCache.h"
+#include "MeshStreams.h"
+#include "MeshBounds.h"
+#include "MeshClusters.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+    // [first; first + count) внутри [0; total), без переполнения
+    inline bool InRange(uint64_t first, uint64_t count, uint64_t total)
+    {
+        return first <= total && count <= total - first;
+    }
+}
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const uint64_t m = 0xc6a4a7935bd1e995ull;
+    const int r = 47;
+
+    uint64_t h = seed ^ (size * m);
+
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* blockEnd = p + (size & ~(size_t)7);
+
+    for (; p != blockEnd; p += 8)
+    {
+        uint64_t k;
+        memcpy(&k, p, sizeof(k));
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    switch (size & 7)
+    {
+    case 7: h ^= uint64_t(p[6]) << 48; [[fallthrough]];
+    case 6: h ^= uint64_t(p[5]) << 40; [[fallthrough]];
+    case 5: h ^= uint64_t(p[4]) << 32; [[fallthrough]];
+    case 4: h ^= uint64_t(p[3]) << 24; [[fallthrough]];
+    case 3: h ^= uint64_t(p[2]) << 16; [[fallthrough]];
+    case 2: h ^= uint64_t(p[1]) << 8; [[fallthrough]];
+    case 1: h ^= uint64_t(p[0]);
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return h;
+}
+
+bool HashFile(const std::string& filename, uint64_t& outHash, uint64_t& outSize)
+{
+    MappedFile file;
+    if (!file.Open(filename))
+        return false;
+
+    outSize = file.Size();
+    outHash = HashBytes(file.Data(), file.Size());
+    return true;
+}
+
+std::string MeshCachePath(const std::string& sourcePath)
+{
+    return sourcePath + ".meshcache";
+}
+
+bool WriteMeshCache(
+    const std::string& cachePath,
+    uint64_t sourceHash,
+    uint64_t sourceSize,
+    const MeshStreams& mesh,
+    const std::vector<MeshCluster>& clusters,
+    const MeshletData& meshlets,
+    const std::vector<MeshLod>& lods)
+{
+    const std::vector<XMFLOAT3>& positions = mesh.positions;
+    const std::vector<XMFLOAT3>& normals = mesh.normals;
+    const std::vector<uint32_t>& indices = mesh.indices;
+    if (positions.empty() || (!normals.empty() && normals.size() != positions.size()))
+        return false;
+
+    MeshCacheHeader header{};
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.vertexCount = (uint32_t)positions.size();
+    header.normalCount = (uint32_t)normals.size();
+    header.indexCount = (uint32_t)indices.size();
+    header.clusterCount = (uint32_t)clusters.size();
+    header.meshletCount = (uint32_t)meshlets.meshlets.size();
+    header.meshletVertexCount = (uint32_t)meshlets.vertices.size();
+    header.meshletTriangleBytes = (uint32_t)meshlets.triangles.size();
+    header.lodCount = (uint32_t)lods.size();
+
+    BoundingBox bounds = ComputeMeshBounds(positions.data(), positions.size());
+    XMStoreFloat3(&header.boundsMin, XMVectorSubtract(XMLoadFloat3(&bounds.Center), XMLoadFloat3(&bounds.Extents)));
+    XMStoreFloat3(&header.boundsMax, XMVectorAdd(XMLoadFloat3(&bounds.Center), XMLoadFloat3(&bounds.Extents)));
+
+    // Пишем во временный файл и переименовываем, чтобы не оставить полузаписанный кэш
+    const std::string tmpPath = cachePath + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(positions.data()), positions.size() * sizeof(XMFLOAT3));
+        file.write(reinterpret_cast<const char*>(normals.data()), normals.size() * sizeof(XMFLOAT3));
+        file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(clusters.data()), clusters.size() * sizeof(MeshCluster));
+        file.write(reinterpret_cast<const char*>(lods.data()), lods.size() * sizeof(MeshLod));
+        file.write(reinterpret_cast<const char*>(meshlets.meshlets.data()), meshlets.meshlets.size() * sizeof(Meshlet));
+        file.write(reinterpret_cast<const char*>(meshlets.bounds.data()), meshlets.bounds.size() * sizeof(MeshletBounds));
+        file.write(reinterpret_cast<const char*>(meshlets.vertices.data()), meshlets.vertices.size() * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(meshlets.triangles.data()), meshlets.triangles.size());
+
+        if (!file)
+            return false;
+    }
+
+    std::remove(cachePath.c_str());
+    return std::rename(tmpPath.c_str(), cachePath.c_str()) == 0;
+}
+
+bool MeshCacheView::Open(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize)
+{
+    Close();
+
+    if (!mFile.Open(cachePath) || mFile.Size() < sizeof(MeshCacheHeader))
+    {
+        mFile.Close();
+        return false;
+    }
+
+    const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(mFile.Data());
+
+    const uint64_t expectedSize = sizeof(MeshCacheHeader) +
+        ((uint64_t)header->vertexCount + header->normalCount) * sizeof(XMFLOAT3) +
+        (uint64_t)header->indexCount * sizeof(uint32_t) +
+        (uint64_t)header->clusterCount * sizeof(MeshCluster) +
+        (uint64_t)header->lodCount * sizeof(MeshLod) +
+        (uint64_t)header->meshletCount * (sizeof(Meshlet) + sizeof(MeshletBounds)) +
+        (uint64_t)header->meshletVertexCount * sizeof(uint32_t) +
+        header->meshletTriangleBytes;
+
+    if (header->magic != MESH_CACHE_MAGIC ||
+        header->version != MESH_CACHE_VERSION ||
+        (header->normalCount != 0 && header->normalCount != header->vertexCount) ||
+        header->sourceHash != sourceHash ||
+        header->sourceSize != sourceSize ||
+        expectedSize != mFile.Size())
+    {
+        mFile.Close();
+        return false;
+    }
+
+    mHeader = header;
+    if (!ValidateRanges())
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+// Повреждённый или чужой кэш не должен увести чтение за пределы файла ни на CPU
+// (окклюдеры, отсечение, мешлеты), ни на GPU
+bool MeshCacheView::ValidateRanges() const
+{
+    const MeshCacheHeader& header = *mHeader;
+
+    const uint32_t* indices = Indices();
+    for (uint32_t i = 0; i < header.indexCount; i++)
+    {
+        if (indices[i] >= header.vertexCount)
+            return false;
+    }
+
+    const MeshLod* lods = Lods();
+    for (uint32_t i = 0; i < header.lodCount; i++)
+    {
+        if (!InRange(lods[i].firstIndex, lods[i].indexCount, header.indexCount))
+            return false;
+    }
+
+    const MeshCluster* clusters = Clusters();
+    for (uint32_t i = 0; i < header.clusterCount; i++)
+    {
+        if (!InRange(clusters[i].firstIndex, clusters[i].indexCount, header.indexCount) ||
+            !InRange(clusters[i].firstMeshlet, clusters[i].meshletCount, header.meshletCount))
+            return false;
+    }
+
+    const Meshlet* meshlets = Meshlets();
+    const uint32_t* meshletVertices = MeshletVertices();
+    const uint8_t* meshletTriangles = MeshletTriangles();
+    for (uint32_t i = 0; i < header.meshletCount; i++)
+    {
+        const Meshlet& meshlet = meshlets[i];
+        if (!InRange(meshlet.vertexOffset, meshlet.vertexCount, header.meshletVertexCount) ||
+            !InRange(meshlet.triangleOffset, (uint64_t)meshlet.triangleCount * 3, header.meshletTriangleBytes) ||
+            !InRange(meshlet.firstIndex, (uint64_t)meshlet.triangleCount * 3, header.indexCount))
+            return false;
+
+        for (uint32_t t = 0; t < meshlet.triangleCount * 3; t++)
+        {
+            if (meshletTriangles[meshlet.triangleOffset + t] >= meshlet.vertexCount)
+                return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.meshletVertexCount; i++)
+    {
+        if (meshletVertices[i] >= header.vertexCount)
+            return false;
+    }
+
+    return true;
+}
+
+void MeshCacheView::Close()
+{
+    mHeader = nullptr;
+    mFile.Close();
+}
+
+const XMFLOAT3* MeshCacheView::Positions() const
+{
+    return reinterpret_cast<const XMFLOAT3*>(mFile.Data() + sizeof(MeshCacheHeader));
+}
+
+const XMFLOAT3* MeshCacheView::Normals() const
+{
+    return mHeader->normalCount != 0 ? Positions() + mHeader->vertexCount : nullptr;
+}
+
+const uint32_t* MeshCacheView::Indices() const
+{
+    return reinterpret_cast<const uint32_t*>(Positions() + mHeader->vertexCount + mHeader->normalCount);
+}
+
+const MeshCluster* MeshCacheView::Clusters() const
+{
+    return reinterpret_cast<const MeshCluster*>(Indices() + mHeader->indexCount);
+}
+
+const MeshLod* MeshCacheView::Lods() const
+{
+    return reinterpret_cast<const MeshLod*>(Clusters() + mHeader->clusterCount);
+}
+
+const Meshlet* MeshCacheView::Meshlets() const
+{
+    return reinterpret_cast<const Meshlet*>(Lods() + mHeader->lodCount);
+}
+
+const MeshletBounds* MeshCacheView::MeshletBoundsData() const
+{
+    return reinterpret_cast<const MeshletBounds*>(Meshlets() + mHeader->meshletCount);
+}
+
+const uint32_t* MeshCacheView::MeshletVertices() const
+{
+    return reinterpret_cast<const uint32_t*>(MeshletBoundsData() + mHeader->meshletCount);
+}
+
+const uint8_t* MeshCacheView::MeshletTriangles() const
+{
+    return reinterpret_cast<const uint8_t*>(MeshletVertices() + mHeader->meshletVertexCount);
+}
+
+size_t MeshCacheView::PositionByteSize() const
+{
+    return (size_t)mHeader->vertexCount * sizeof(XMFLOAT3);
+}
+
+size_t MeshCacheView::IndexByteSize() const
+{
+    return (size_t)mHeader->indexCount * sizeof(uint32_t);
+}
@@ -0,0 +1,87 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <DirectXMath.h>
+#include "MappedFile.h"
+
+struct MeshStreams;
+struct MeshCluster;
+struct Meshlet;
+struct MeshletBounds;
+struct MeshletData;
+struct MeshLod;
+
+// ===== Бинарный кэш меша =====
+// [MeshCacheHeader][XMFLOAT3 позиции * vertexCount][XMFLOAT3 нормали * normalCount][uint32_t * indexCount][MeshCluster * clusterCount][MeshLod * lodCount]
+// [Meshlet * meshletCount][MeshletBounds * meshletCount][uint32_t * meshletVertexCount][uint8_t * meshletTriangleBytes]
+struct MeshCacheHeader
+{
+    uint32_t magic;          // MESH_CACHE_MAGIC
+    uint32_t version;        // MESH_CACHE_VERSION
+    uint64_t sourceHash;     // хэш исходного OBJ
+    uint64_t sourceSize;     // размер исходного OBJ в байтах
+    uint32_t normalCount;    // 0 или vertexCount. Цвета не хранятся: у OBJ их нет
+    uint32_t vertexCount;
+    uint32_t indexCount;     // все LOD подряд; диапазоны - в таблице MeshLod
+    uint32_t clusterCount;   // 0 - меш не разбит на кластеры
+    uint32_t meshletCount;
+    uint32_t meshletVertexCount;
+    uint32_t meshletTriangleBytes;
+    uint32_t lodCount;       // 0 - только базовый меш
+    DirectX::XMFLOAT3 boundsMin;
+    DirectX::XMFLOAT3 boundsMax;
+};
+
+constexpr uint32_t MESH_CACHE_MAGIC = 0x4348534D;  // "MSHC"
+constexpr uint32_t MESH_CACHE_VERSION = 7;  // 2: индексы после OptimizeMesh, 3: кластеры, 4: мешлеты, 5: LOD, 6: точная ошибка LOD,
+                                            // 7: потоки позиций и нормалей вместо Vertex
+
+// Быстрый 64-битный хэш содержимого (MurmurHash64A)
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+// Хэш файла целиком (через отображение в память)
+bool HashFile(const std::string& filename, uint64_t& outHash, uint64_t& outSize);
+
+// Путь кэша рядом с исходником: sponza.obj -> sponza.obj.meshcache
+std::string MeshCachePath(const std::string& sourcePath);
+
+bool WriteMeshCache(
+    const std::string& cachePath,
+    uint64_t sourceHash,
+    uint64_t sourceSize,
+    const MeshStreams& mesh,
+    const std::vector<MeshCluster>& clusters,
+    const MeshletData& meshlets,
+    const std::vector<MeshLod>& lods
+);
+
+// Кэш, отображённый в память: потоки вершин и индексы читаются прямо из файла
+class MeshCacheView {
+public:
+    // Открывает кэш и проверяет заголовок, хэш исходника и все диапазоны:
+    // индексы, кластеры, мешлеты и LOD не выходят за свои секции
+    bool Open(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize);
+    void Close();
+
+    bool IsOpen() const { return mHeader != nullptr; }
+    const MeshCacheHeader& Header() const { return *mHeader; }
+
+    const DirectX::XMFLOAT3* Positions() const;
+    const DirectX::XMFLOAT3* Normals() const;   // nullptr - нормалей нет
+    const uint32_t* Indices() const;
+    const MeshCluster* Clusters() const;
+    const MeshLod* Lods() const;
+    const Meshlet* Meshlets() const;
+    const MeshletBounds* MeshletBoundsData() const;
+    const uint32_t* MeshletVertices() const;
+    const uint8_t* MeshletTriangles() const;
+    size_t PositionByteSize() const;
+    size_t IndexByteSize() const;
+
+private:
+    bool ValidateRanges() const;
+
+    MappedFile mFile;
+    const MeshCacheHeader* mHeader = nullptr;
+};
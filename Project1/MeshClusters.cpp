@@ -0,0 +1,172 @@
+﻿#include "MeshClusters.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    const float* PositionAt(const float* positions, size_t stride, uint32_t v)
+    {
+        return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+    }
+
+    struct TriangleRange
+    {
+        size_t begin;
+        size_t end;
+    };
+
+    // Кэш и overdraw внутри кластера: локальная нумерация вершин, чтобы таблицы
+    // оптимизаторов были размером с кластер, а не с весь меш
+    void OptimizeCluster(
+        uint32_t* indices,
+        size_t indexCount,
+        const float* positions,
+        size_t stride,
+        std::vector<uint32_t>& globalToLocal,
+        std::vector<uint32_t>& localToGlobal,
+        std::vector<float>& localPositions)
+    {
+        localToGlobal.clear();
+        localPositions.clear();
+
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            uint32_t v = indices[i];
+            if (globalToLocal[v] == ~0u)
+            {
+                globalToLocal[v] = (uint32_t)localToGlobal.size();
+                localToGlobal.push_back(v);
+
+                const float* p = PositionAt(positions, stride, v);
+                localPositions.insert(localPositions.end(), p, p + 3);
+            }
+            indices[i] = globalToLocal[v];
+        }
+
+        const size_t localCount = localToGlobal.size();
+        OptimizeVertexCache(indices, indexCount, localCount);
+        OptimizeOverdraw(indices, indexCount, localPositions.data(), localCount, 3 * sizeof(float));
+
+        for (size_t i = 0; i < indexCount; i++)
+            indices[i] = localToGlobal[indices[i]];
+        for (uint32_t v : localToGlobal)
+            globalToLocal[v] = ~0u;
+    }
+}
+
+void BuildMeshClusters(
+    uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    uint32_t maxTriangles,
+    std::vector<MeshCluster>& outClusters)
+{
+    outClusters.clear();
+
+    const size_t triCount = indexCount / 3;
+    if (triCount == 0 || vertexCount == 0)
+        return;
+    maxTriangles = std::max(maxTriangles, 1u);
+
+    // 1. Центры треугольников
+    std::vector<XMFLOAT3> centroids(triCount);
+    for (size_t t = 0; t < triCount; t++)
+    {
+        const float* a = PositionAt(positions, stride, indices[t * 3 + 0]);
+        const float* b = PositionAt(positions, stride, indices[t * 3 + 1]);
+        const float* c = PositionAt(positions, stride, indices[t * 3 + 2]);
+        centroids[t] = XMFLOAT3(
+            (a[0] + b[0] + c[0]) * (1.0f / 3.0f),
+            (a[1] + b[1] + c[1]) * (1.0f / 3.0f),
+            (a[2] + b[2] + c[2]) * (1.0f / 3.0f));
+    }
+
+    std::vector<uint32_t> order(triCount);
+    for (size_t t = 0; t < triCount; t++)
+        order[t] = (uint32_t)t;
+
+    // 2. Медианное деление; правая половина кладётся в стек первой,
+    //    так что листья выходят в порядке обхода слева направо
+    std::vector<TriangleRange> leaves;
+    std::vector<TriangleRange> stack;
+    stack.push_back({ 0, triCount });
+
+    while (!stack.empty())
+    {
+        TriangleRange range = stack.back();
+        stack.pop_back();
+
+        const size_t count = range.end - range.begin;
+        if (count <= maxTriangles)
+        {
+            leaves.push_back(range);
+            continue;
+        }
+
+        float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (size_t i = range.begin; i < range.end; i++)
+        {
+            const float* c = &centroids[order[i]].x;
+            for (int k = 0; k < 3; k++)
+            {
+                lo[k] = std::min(lo[k], c[k]);
+                hi[k] = std::max(hi[k], c[k]);
+            }
+        }
+
+        int axis = 0;
+        if (hi[1] - lo[1] > hi[axis] - lo[axis]) axis = 1;
+        if (hi[2] - lo[2] > hi[axis] - lo[axis]) axis = 2;
+
+        const size_t mid = range.begin + count / 2;
+        std::nth_element(order.begin() + range.begin, order.begin() + mid, order.begin() + range.end,
+            [&](uint32_t a, uint32_t b) { return (&centroids[a].x)[axis] < (&centroids[b].x)[axis]; });
+
+        stack.push_back({ mid, range.end });
+        stack.push_back({ range.begin, mid });
+    }
+
+    // 3. Индексы в порядке кластеров
+    std::vector<uint32_t> source(indices, indices + triCount * 3);
+    for (size_t i = 0; i < triCount; i++)
+        memcpy(indices + i * 3, source.data() + order[i] * 3, 3 * sizeof(uint32_t));
+
+    // 4. Оптимизация внутри кластеров и габариты
+    std::vector<uint32_t> globalToLocal(vertexCount, ~0u);
+    std::vector<uint32_t> localToGlobal;
+    std::vector<float> localPositions;
+
+    outClusters.reserve(leaves.size());
+    for (const TriangleRange& leaf : leaves)
+    {
+        MeshCluster cluster;
+        cluster.firstIndex = (uint32_t)(leaf.begin * 3);
+        cluster.indexCount = (uint32_t)((leaf.end - leaf.begin) * 3);
+
+        uint32_t* clusterIndices = indices + cluster.firstIndex;
+        OptimizeCluster(clusterIndices, cluster.indexCount, positions, stride,
+            globalToLocal, localToGlobal, localPositions);
+
+        XMVECTOR vMin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+        for (uint32_t i = 0; i < cluster.indexCount; i++)
+        {
+            const float* p = PositionAt(positions, stride, clusterIndices[i]);
+            XMVECTOR v = XMVectorSet(p[0], p[1], p[2], 0.0f);
+            vMin = XMVectorMin(vMin, v);
+            vMax = XMVectorMax(vMax, v);
+        }
+        XMStoreFloat3(&cluster.boundsMin, vMin);
+        XMStoreFloat3(&cluster.boundsMax, vMax);
+
+        outClusters.push_back(cluster);
+    }
+}
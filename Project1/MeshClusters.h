@@ -0,0 +1,33 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ===== Пространственные кластеры меша =====
+// Кластер - непрерывный диапазон индексного буфера с габаритами; единица отсечения (Bvh.h)
+struct MeshCluster
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    DirectX::XMFLOAT3 boundsMin;
+    DirectX::XMFLOAT3 boundsMax;
+    uint32_t firstMeshlet = 0;   // мешлеты кластера (Meshlets.h), если построены
+    uint32_t meshletCount = 0;
+};
+
+constexpr uint32_t MESH_CLUSTER_TRIANGLES = 512;
+
+// Делит треугольники пополам по медиане центров вдоль длинной оси, пока в части
+// не больше maxTriangles. Индексы переставляются: кластеры идут подряд в порядке обхода дерева,
+// внутри кластера - OptimizeVertexCache и OptimizeOverdraw на локальных вершинах.
+// positions - x,y,z с шагом stride байт
+void BuildMeshClusters(
+    uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    uint32_t maxTriangles,
+    std::vector<MeshCluster>& outClusters
+);
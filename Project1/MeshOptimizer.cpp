@@ -0,0 +1,485 @@
+﻿#include "MeshOptimizer.h"
+#include "MeshStreams.h"
+#include "MeshClusters.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // ===== Forsyth: "Linear-Speed Vertex Cache Optimisation" =====
+    constexpr int FORSYTH_CACHE_SIZE = 32;
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRI_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+    constexpr size_t MAX_VALENCE = 64;
+
+    struct ScoreTables
+    {
+        float cache[FORSYTH_CACHE_SIZE];
+        float valence[MAX_VALENCE];
+
+        ScoreTables()
+        {
+            for (int i = 0; i < FORSYTH_CACHE_SIZE; i++)
+            {
+                if (i < 3)
+                {
+                    cache[i] = LAST_TRI_SCORE;
+                }
+                else
+                {
+                    float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                    cache[i] = std::pow(1.0f - (i - 3) * scaler, CACHE_DECAY_POWER);
+                }
+            }
+
+            valence[0] = 0.0f;
+            for (size_t i = 1; i < MAX_VALENCE; i++)
+                valence[i] = VALENCE_BOOST_SCALE * std::pow((float)i, -VALENCE_BOOST_POWER);
+        }
+    };
+
+    const ScoreTables& GetScoreTables()
+    {
+        static const ScoreTables tables;
+        return tables;
+    }
+
+    inline float VertexScore(int cachePosition, uint32_t liveTriangles)
+    {
+        if (liveTriangles == 0)
+            return -1.0f;
+
+        const ScoreTables& tables = GetScoreTables();
+        float score = (cachePosition >= 0) ? tables.cache[cachePosition] : 0.0f;
+        return score + tables.valence[std::min<size_t>(liveTriangles, MAX_VALENCE - 1)];
+    }
+
+    // Треугольники, в которые входит каждая вершина
+    struct TriangleAdjacency
+    {
+        std::vector<uint32_t> counts;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+
+        void Build(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+        {
+            counts.assign(vertexCount, 0);
+            offsets.assign(vertexCount, 0);
+            triangles.resize(indexCount);
+
+            for (size_t i = 0; i < indexCount; i++)
+                counts[indices[i]]++;
+
+            uint32_t offset = 0;
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                offsets[v] = offset;
+                offset += counts[v];
+            }
+
+            std::vector<uint32_t> fill(offsets);
+            for (size_t i = 0; i < indexCount; i++)
+                triangles[fill[indices[i]]++] = (uint32_t)(i / 3);
+        }
+    };
+
+    // Центр и площадь-взвешенная нормаль группы треугольников
+    struct ClusterGeometry
+    {
+        double cx = 0.0, cy = 0.0, cz = 0.0;
+        double nx = 0.0, ny = 0.0, nz = 0.0;
+        double area = 0.0;
+    };
+
+    inline const float* PositionAt(const float* positions, size_t stride, uint32_t index)
+    {
+        return (const float*)((const uint8_t*)positions + index * stride);
+    }
+
+    void AccumulateTriangle(ClusterGeometry& g, const float* a, const float* b, const float* c)
+    {
+        double e1x = b[0] - a[0], e1y = b[1] - a[1], e1z = b[2] - a[2];
+        double e2x = c[0] - a[0], e2y = c[1] - a[1], e2z = c[2] - a[2];
+
+        double nx = e1y * e2z - e1z * e2y;
+        double ny = e1z * e2x - e1x * e2z;
+        double nz = e1x * e2y - e1y * e2x;
+        double area = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+        g.cx += (a[0] + b[0] + c[0]) * (area / 3.0);
+        g.cy += (a[1] + b[1] + c[1]) * (area / 3.0);
+        g.cz += (a[2] + b[2] + c[2]) * (area / 3.0);
+        g.nx += nx;
+        g.ny += ny;
+        g.nz += nz;
+        g.area += area;
+    }
+
+    // FIFO-кэш с метками времени вместо сдвигов: вершина в кэше,
+    // если вставлена не раньше чем cacheSize промахов назад
+    struct FifoCache
+    {
+        std::vector<size_t> stamps;
+        size_t time;
+        uint32_t size;
+
+        FifoCache(size_t vertexCount, uint32_t cacheSize)
+            : stamps(vertexCount, 0), time(cacheSize + 1), size(cacheSize)
+        {
+        }
+
+        // true при промахе
+        bool Touch(uint32_t v)
+        {
+            if (time - stamps[v] > size)
+            {
+                stamps[v] = time++;
+                return true;
+            }
+            return false;
+        }
+
+        void Reset()
+        {
+            time += size + 1;
+        }
+    };
+}
+
+VertexCacheStats AnalyzeVertexCache(
+    const uint32_t* indices,
+    size_t indexCount,
+    size_t vertexCount,
+    uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indexCount < 3 || vertexCount == 0)
+        return stats;
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> used(vertexCount, 0);
+    size_t uniqueCount = 0;
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t v = indices[i];
+        if (cache.Touch(v))
+            stats.misses++;
+        if (!used[v])
+        {
+            used[v] = 1;
+            uniqueCount++;
+        }
+    }
+
+    stats.acmr = (float)stats.misses / (float)(indexCount / 3);
+    stats.atvr = (float)stats.misses / (float)uniqueCount;
+    return stats;
+}
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    const size_t triCount = indexCount / 3;
+    if (triCount == 0 || vertexCount == 0)
+        return;
+
+    TriangleAdjacency adjacency;
+    adjacency.Build(indices, triCount * 3, vertexCount);
+
+    // counts[v] дальше - число ещё не выданных треугольников вершины,
+    // живые треугольники лежат в начале её диапазона
+    std::vector<uint32_t>& liveCounts = adjacency.counts;
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScores[v] = VertexScore(-1, liveCounts[v]);
+
+    std::vector<float> triScores(triCount);
+    std::vector<uint8_t> emitted(triCount, 0);
+    for (size_t t = 0; t < triCount; t++)
+    {
+        const uint32_t* tri = indices + t * 3;
+        triScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+    }
+
+    std::vector<uint32_t> result(triCount * 3);
+
+    // +3 - место под вершины нового треугольника до вытеснения
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t cacheNew[FORSYTH_CACHE_SIZE + 3];
+    size_t cacheCount = 0;
+
+    size_t best = 0;
+    for (size_t t = 1; t < triCount; t++)
+    {
+        if (triScores[t] > triScores[best])
+            best = t;
+    }
+
+    size_t scanCursor = 0;
+
+    for (size_t out = 0; out < triCount; out++)
+    {
+        // Ни одна вершина кэша не имеет живых треугольников: берём первый невыданный
+        if (best == SIZE_MAX)
+        {
+            while (emitted[scanCursor])
+                scanCursor++;
+            best = scanCursor;
+        }
+
+        const uint32_t* tri = indices + best * 3;
+        result[out * 3 + 0] = tri[0];
+        result[out * 3 + 1] = tri[1];
+        result[out * 3 + 2] = tri[2];
+        emitted[best] = 1;
+
+        // Вершины треугольника - в голову кэша, остальные сдвигаются
+        size_t newCount = 0;
+        for (int k = 0; k < 3; k++)
+            cacheNew[newCount++] = tri[k];
+
+        for (size_t i = 0; i < cacheCount; i++)
+        {
+            uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                cacheNew[newCount++] = v;
+        }
+
+        // Убираем выданный треугольник из списков его вершин
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t v = tri[k];
+            uint32_t* list = adjacency.triangles.data() + adjacency.offsets[v];
+            uint32_t& live = liveCounts[v];
+            for (uint32_t i = 0; i < live; i++)
+            {
+                if (list[i] == best)
+                {
+                    std::swap(list[i], list[live - 1]);
+                    live--;
+                    break;
+                }
+            }
+        }
+
+        // Пересчёт очков вершин кэша (включая вытесненные) и их треугольников
+        best = SIZE_MAX;
+        float bestScore = -1.0f;
+
+        for (size_t i = 0; i < newCount; i++)
+        {
+            uint32_t v = cacheNew[i];
+            int position = (i < FORSYTH_CACHE_SIZE) ? (int)i : -1;
+            cachePositions[v] = position;
+
+            float score = VertexScore(position, liveCounts[v]);
+            float delta = score - vertexScores[v];
+            vertexScores[v] = score;
+
+            const uint32_t* list = adjacency.triangles.data() + adjacency.offsets[v];
+            for (uint32_t j = 0; j < liveCounts[v]; j++)
+            {
+                uint32_t t = list[j];
+                triScores[t] += delta;
+                if (triScores[t] > bestScore)
+                {
+                    bestScore = triScores[t];
+                    best = t;
+                }
+            }
+        }
+
+        cacheCount = std::min<size_t>(newCount, FORSYTH_CACHE_SIZE);
+        std::copy(cacheNew, cacheNew + cacheCount, cache);
+    }
+
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void OptimizeOverdraw(
+    uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    float threshold)
+{
+    const size_t triCount = indexCount / 3;
+    if (triCount == 0 || vertexCount == 0)
+        return;
+
+    constexpr uint32_t CACHE_SIZE = 16;
+
+    // 1. Жёсткие границы: треугольник, у которого промахнулись все три вершины
+    std::vector<size_t> hard;
+    {
+        FifoCache cache(vertexCount, CACHE_SIZE);
+        for (size_t t = 0; t < triCount; t++)
+        {
+            const uint32_t* tri = indices + t * 3;
+            int misses = cache.Touch(tri[0]) + cache.Touch(tri[1]) + cache.Touch(tri[2]);
+            if (t == 0 || misses == 3)
+                hard.push_back(t);
+        }
+        hard.push_back(triCount);
+    }
+
+    // 2. Мягкие границы: режем жёсткий кластер там, где накопленный ACMR
+    //    не превышает ACMR всего кластера больше чем в threshold раз
+    std::vector<size_t> clusters;
+    {
+        FifoCache cache(vertexCount, CACHE_SIZE);
+        for (size_t h = 0; h + 1 < hard.size(); h++)
+        {
+            const size_t start = hard[h];
+            const size_t end = hard[h + 1];
+
+            cache.Reset();
+            size_t clusterMisses = 0;
+            for (size_t t = start; t < end; t++)
+            {
+                const uint32_t* tri = indices + t * 3;
+                clusterMisses += cache.Touch(tri[0]) + cache.Touch(tri[1]) + cache.Touch(tri[2]);
+            }
+
+            const float limit = threshold * (float)clusterMisses / (float)(end - start);
+
+            cache.Reset();
+            clusters.push_back(start);
+            size_t runStart = start;
+            size_t runMisses = 0;
+            for (size_t t = start; t < end; t++)
+            {
+                const uint32_t* tri = indices + t * 3;
+                runMisses += cache.Touch(tri[0]) + cache.Touch(tri[1]) + cache.Touch(tri[2]);
+
+                if (t + 1 < end && (float)runMisses / (float)(t + 1 - runStart) <= limit)
+                {
+                    clusters.push_back(t + 1);
+                    runStart = t + 1;
+                    runMisses = 0;
+                    cache.Reset();
+                }
+            }
+        }
+        clusters.push_back(triCount);
+    }
+
+    // 3. Ключ кластера: насколько он смотрит наружу от центра меша
+    const size_t clusterCount = clusters.size() - 1;
+    std::vector<ClusterGeometry> geometry(clusterCount);
+    ClusterGeometry mesh;
+
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            const uint32_t* tri = indices + t * 3;
+            AccumulateTriangle(geometry[c],
+                PositionAt(positions, stride, tri[0]),
+                PositionAt(positions, stride, tri[1]),
+                PositionAt(positions, stride, tri[2]));
+        }
+
+        mesh.cx += geometry[c].cx;
+        mesh.cy += geometry[c].cy;
+        mesh.cz += geometry[c].cz;
+        mesh.area += geometry[c].area;
+    }
+
+    const double meshInvArea = (mesh.area > 0.0) ? 1.0 / mesh.area : 0.0;
+    const double mx = mesh.cx * meshInvArea;
+    const double my = mesh.cy * meshInvArea;
+    const double mz = mesh.cz * meshInvArea;
+
+    std::vector<float> keys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        const ClusterGeometry& g = geometry[c];
+        double invArea = (g.area > 0.0) ? 1.0 / g.area : 0.0;
+        double nlen = std::sqrt(g.nx * g.nx + g.ny * g.ny + g.nz * g.nz);
+        double invN = (nlen > 0.0) ? 1.0 / nlen : 0.0;
+
+        double dx = g.cx * invArea - mx;
+        double dy = g.cy * invArea - my;
+        double dz = g.cz * invArea - mz;
+        keys[c] = (float)((dx * g.nx + dy * g.ny + dz * g.nz) * invN);
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        order[c] = (uint32_t)c;
+
+    std::stable_sort(order.begin(), order.end(),
+        [&keys](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(triCount * 3);
+    for (uint32_t c : order)
+        result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+
+    std::copy(result.begin(), result.end(), indices);
+}
+
+size_t BuildVertexFetchRemap(
+    uint32_t* indices,
+    size_t indexCount,
+    size_t vertexCount,
+    std::vector<uint32_t>& outRemap)
+{
+    outRemap.assign(vertexCount, ~0u);
+    uint32_t next = 0;
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t& slot = outRemap[indices[i]];
+        if (slot == ~0u)
+            slot = next++;
+        indices[i] = slot;
+    }
+
+    return next;
+}
+
+MeshOptimizeReport OptimizeMesh(
+    MeshStreams& mesh,
+    std::vector<MeshCluster>* outClusters)
+{
+    std::vector<uint32_t>& indices = mesh.indices;
+    const size_t vertexCount = mesh.VertexCount();
+
+    MeshOptimizeReport report;
+    report.vertexCountBefore = vertexCount;
+    report.before = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+    if (vertexCount != 0 && indices.size() >= 3)
+    {
+        if (outClusters)
+        {
+            // Кэш и overdraw - внутри каждого кластера; перестановка вершин не трогает индексы кластеров
+            BuildMeshClusters(indices.data(), indices.size(),
+                &mesh.positions[0].x, vertexCount, sizeof(DirectX::XMFLOAT3), MESH_CLUSTER_TRIANGLES, *outClusters);
+        }
+        else
+        {
+            OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+            OptimizeOverdraw(indices.data(), indices.size(),
+                &mesh.positions[0].x, vertexCount, sizeof(DirectX::XMFLOAT3));
+        }
+
+        // Одна перестановка на все потоки; пустые (значения по умолчанию) так и остаются пустыми
+        std::vector<uint32_t> remap;
+        const size_t used = BuildVertexFetchRemap(indices.data(), indices.size(), vertexCount, remap);
+        RemapStream(mesh.positions, remap, used);
+        RemapStream(mesh.normals, remap, used);
+        RemapStream(mesh.colors, remap, used);
+    }
+
+    report.vertexCountAfter = mesh.VertexCount();
+    report.after = AnalyzeVertexCache(indices.data(), indices.size(), mesh.VertexCount());
+    return report;
+}
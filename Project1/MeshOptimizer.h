@@ -0,0 +1,92 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct MeshCluster;
+struct MeshStreams;
+
+// ===== Оптимизация индексного буфера после импорта =====
+// Порядок: OptimizeVertexCache -> OptimizeOverdraw -> OptimizeVertexFetch.
+// Всё на CPU, выполняется один раз до записи кэша меша и загрузки на GPU.
+
+struct VertexCacheStats
+{
+    size_t misses = 0;
+    float acmr = 0.0f;   // промахи на треугольник (0.5 - идеал, 3 - худший случай)
+    float atvr = 0.0f;   // промахи на уникальную вершину (1 - идеал)
+};
+
+struct MeshOptimizeReport
+{
+    VertexCacheStats before;
+    VertexCacheStats after;
+    size_t vertexCountBefore = 0;
+    size_t vertexCountAfter = 0;
+};
+
+// Модель post-transform кэша: FIFO заданного размера
+VertexCacheStats AnalyzeVertexCache(
+    const uint32_t* indices,
+    size_t indexCount,
+    size_t vertexCount,
+    uint32_t cacheSize = 16
+);
+
+// Перестановка треугольников по Forsyth (линейное время, LRU на 32 вершины)
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// Порядок кластеров "снаружи внутрь" для меньшего overdraw. Кластеры режутся так,
+// чтобы ACMR вырос не больше чем в threshold раз. positions - x,y,z с шагом stride байт
+void OptimizeOverdraw(
+    uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    float threshold = 1.05f
+);
+
+// remap[старый индекс] = новый, в порядке первого использования; ~0u - вершина не используется.
+// Индексы переписываются на месте, возвращает число используемых вершин
+size_t BuildVertexFetchRemap(
+    uint32_t* indices,
+    size_t indexCount,
+    size_t vertexCount,
+    std::vector<uint32_t>& outRemap
+);
+
+// Перестановка по remap из BuildVertexFetchRemap; пустой поток не трогается
+template<typename T>
+void RemapStream(std::vector<T>& stream, const std::vector<uint32_t>& remap, size_t used)
+{
+    if (stream.empty())
+        return;
+
+    std::vector<T> result(used);
+    for (size_t i = 0; i < stream.size(); i++)
+    {
+        if (remap[i] != ~0u)
+            result[remap[i]] = stream[i];
+    }
+
+    stream.swap(result);
+}
+
+// Вершины в порядке обращения к ним, неиспользуемые выбрасываются
+template<typename T>
+size_t OptimizeVertexFetch(std::vector<T>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap;
+    size_t used = BuildVertexFetchRemap(indices.data(), indices.size(), vertices.size(), remap);
+    RemapStream(vertices, remap, used);
+    return used;
+}
+
+// Весь конвейер для меша из LoadOBJ. С outClusters треугольники сначала режутся
+// на пространственные кластеры (MeshClusters.h), кэш и overdraw оптимизируются внутри них.
+// Порядок считается по потоку позиций; остальные потоки только переставляются
+MeshOptimizeReport OptimizeMesh(
+    MeshStreams& mesh,
+    std::vector<MeshCluster>* outClusters = nullptr
+);
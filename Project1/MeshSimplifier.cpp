@@ -0,0 +1,681 @@
+﻿#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+#include <unordered_map>
+
+namespace
+{
+    // Граница держится сильнее поверхности: плоскость вдоль ребра с весом BORDER_WEIGHT * длина^2
+    constexpr double BORDER_WEIGHT = 10.0;
+    // Схлопывание не должно поворачивать нормаль соседнего треугольника больше чем на ~75 градусов
+    constexpr double MIN_NORMAL_DOT = 0.25;
+    // Предел цены прохода - во столько раз дороже кандидата, на котором набралось бы нужное число
+    constexpr double PASS_COST_BOUND = 1.5;
+    // LOD, сокративший треугольники меньше чем на 10% от предыдущего, не нужен
+    constexpr float MIN_LOD_REDUCTION = 0.9f;
+
+    struct Vec3
+    {
+        double x, y, z;
+    };
+
+    inline Vec3 Sub(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    inline double Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    inline Vec3 Cross(const Vec3& a, const Vec3& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+    inline double Length(const Vec3& a) { return std::sqrt(Dot(a, a)); }
+
+    // Сумма квадратов расстояний до плоскостей: p^T A p + 2 b^T p + c, с суммарным весом
+    struct Quadric
+    {
+        double a2, b2, c2, ab, ac, bc, ad, bd, cd, d2, w;
+    };
+
+    void AddPlane(Quadric& q, const Vec3& n, double d, double weight)
+    {
+        q.a2 += weight * n.x * n.x; q.b2 += weight * n.y * n.y; q.c2 += weight * n.z * n.z;
+        q.ab += weight * n.x * n.y; q.ac += weight * n.x * n.z; q.bc += weight * n.y * n.z;
+        q.ad += weight * n.x * d;   q.bd += weight * n.y * d;   q.cd += weight * n.z * d;
+        q.d2 += weight * d * d;
+        q.w += weight;
+    }
+
+    void AddQuadric(Quadric& dst, const Quadric& src)
+    {
+        dst.a2 += src.a2; dst.b2 += src.b2; dst.c2 += src.c2;
+        dst.ab += src.ab; dst.ac += src.ac; dst.bc += src.bc;
+        dst.ad += src.ad; dst.bd += src.bd; dst.cd += src.cd;
+        dst.d2 += src.d2; dst.w += src.w;
+    }
+
+    // Взвешенный средний квадрат расстояния
+    double Evaluate(const Quadric& q, const Vec3& p)
+    {
+        double r = q.a2 * p.x * p.x + q.b2 * p.y * p.y + q.c2 * p.z * p.z +
+            2.0 * (q.ab * p.x * p.y + q.ac * p.x * p.z + q.bc * p.y * p.z) +
+            2.0 * (q.ad * p.x + q.bd * p.y + q.cd * p.z) + q.d2;
+        return q.w > 0.0 ? std::max(r, 0.0) / q.w : 0.0;
+    }
+
+    // Ближайшая точка треугольника (Ericson, "Real-Time Collision Detection", 5.1.5)
+    double DistanceToTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        const Vec3 ab = Sub(b, a), ac = Sub(c, a), ap = Sub(p, a);
+        const double d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+        if (d1 <= 0.0 && d2 <= 0.0)
+            return Length(ap);
+
+        const Vec3 bp = Sub(p, b);
+        const double d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+        if (d3 >= 0.0 && d4 <= d3)
+            return Length(bp);
+
+        const double vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+        {
+            const double v = d1 / (d1 - d3);
+            return Length(Sub(ap, { ab.x * v, ab.y * v, ab.z * v }));
+        }
+
+        const Vec3 cp = Sub(p, c);
+        const double d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+        if (d6 >= 0.0 && d5 <= d6)
+            return Length(cp);
+
+        const double vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+        {
+            const double w = d2 / (d2 - d6);
+            return Length(Sub(ap, { ac.x * w, ac.y * w, ac.z * w }));
+        }
+
+        const double va = d3 * d6 - d5 * d4;
+        if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+        {
+            const double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+            const Vec3 bc = Sub(c, b);
+            return Length(Sub(bp, { bc.x * w, bc.y * w, bc.z * w }));
+        }
+
+        const double denom = 1.0 / (va + vb + vc);
+        const double v = vb * denom, w = vc * denom;
+        return Length(Sub(ap, { ab.x * v + ac.x * w, ab.y * v + ac.y * w, ab.z * v + ac.z * w }));
+    }
+
+    // Треугольники в равномерной сетке: ближайший треугольник к точке без перебора всех.
+    // Треугольник лежит во всех ячейках, которые задевает его AABB
+    class TriangleGrid
+    {
+    public:
+        TriangleGrid(const std::vector<uint32_t>& indices, const std::vector<Vec3>& points, const Vec3& lo, const Vec3& hi)
+            : mIndices(indices), mPoints(points), mOrigin(lo)
+        {
+            const size_t triangleCount = indices.size() / 3;
+            mStamps.assign(triangleCount, 0);
+
+            // Ячейка - пара средних рёбер, но не больше MAX_GRID_DIM ячеек по оси
+            double edgeSum = 0.0;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                for (int k = 0; k < 3; k++)
+                    edgeSum += Length(Sub(points[indices[i + (k + 1) % 3]], points[indices[i + k]]));
+            }
+            const Vec3 extent = Sub(hi, lo);
+            const double maxExtent = std::max({ extent.x, extent.y, extent.z, 1e-12 });
+            mCell = std::max(triangleCount ? 2.0 * edgeSum / indices.size() : maxExtent, maxExtent / MAX_GRID_DIM);
+            mDim[0] = std::max(1, (int)std::ceil(extent.x / mCell));
+            mDim[1] = std::max(1, (int)std::ceil(extent.y / mCell));
+            mDim[2] = std::max(1, (int)std::ceil(extent.z / mCell));
+
+            // Два прохода: сначала число треугольников в ячейке, потом раскладка (CSR)
+            mOffsets.assign((size_t)mDim[0] * mDim[1] * mDim[2] + 1, 0);
+            for (int pass = 0; pass < 2; pass++)
+            {
+                std::vector<uint32_t> fill;
+                if (pass == 1)
+                {
+                    for (size_t c = 1; c < mOffsets.size(); c++)
+                        mOffsets[c] += mOffsets[c - 1];
+                    mTriangles.resize(mOffsets.back());
+                    fill.assign(mOffsets.begin(), mOffsets.end() - 1);
+                }
+
+                for (size_t t = 0; t < triangleCount; t++)
+                {
+                    const Vec3& a = points[indices[t * 3]];
+                    const Vec3& b = points[indices[t * 3 + 1]];
+                    const Vec3& c = points[indices[t * 3 + 2]];
+                    int cellLo[3], cellHi[3];
+                    CellOf({ std::min({ a.x, b.x, c.x }), std::min({ a.y, b.y, c.y }), std::min({ a.z, b.z, c.z }) }, cellLo);
+                    CellOf({ std::max({ a.x, b.x, c.x }), std::max({ a.y, b.y, c.y }), std::max({ a.z, b.z, c.z }) }, cellHi);
+
+                    for (int z = cellLo[2]; z <= cellHi[2]; z++)
+                        for (int y = cellLo[1]; y <= cellHi[1]; y++)
+                            for (int x = cellLo[0]; x <= cellHi[0]; x++)
+                            {
+                                const size_t cell = CellIndex(x, y, z);
+                                if (pass == 0)
+                                    mOffsets[cell + 1]++;
+                                else
+                                    mTriangles[fill[cell]++] = (uint32_t)t;
+                            }
+                }
+            }
+        }
+
+        // Расстояние до ближайшего треугольника, если оно меньше best, иначе best.
+        // Кольца ячеек вокруг точки: за кольцом r всё не ближе r ячеек
+        double Nearest(const Vec3& p, double best)
+        {
+            mQuery++;
+            int center[3];
+            CellOf(p, center);
+            const int maxRing = std::max({ center[0], mDim[0] - 1 - center[0], center[1], mDim[1] - 1 - center[1],
+                center[2], mDim[2] - 1 - center[2] });
+
+            for (int r = 0; r <= maxRing; r++)
+            {
+                if (best <= (r - 1) * mCell)
+                    break;
+
+                for (int z = std::max(center[2] - r, 0); z <= std::min(center[2] + r, mDim[2] - 1); z++)
+                    for (int y = std::max(center[1] - r, 0); y <= std::min(center[1] + r, mDim[1] - 1); y++)
+                        for (int x = std::max(center[0] - r, 0); x <= std::min(center[0] + r, mDim[0] - 1); x++)
+                        {
+                            // Только оболочка кольца: внутренние ячейки уже пройдены
+                            if (std::max({ std::abs(x - center[0]), std::abs(y - center[1]), std::abs(z - center[2]) }) != r)
+                                continue;
+
+                            const size_t cell = CellIndex(x, y, z);
+                            for (uint32_t i = mOffsets[cell]; i < mOffsets[cell + 1]; i++)
+                            {
+                                const uint32_t t = mTriangles[i];
+                                if (mStamps[t] == mQuery)
+                                    continue;
+                                mStamps[t] = mQuery;
+
+                                const uint32_t* tri = &mIndices[t * 3];
+                                best = std::min(best, DistanceToTriangle(p, mPoints[tri[0]], mPoints[tri[1]], mPoints[tri[2]]));
+                            }
+                        }
+            }
+            return best;
+        }
+
+    private:
+        static constexpr double MAX_GRID_DIM = 128.0;
+
+        void CellOf(const Vec3& p, int cell[3]) const
+        {
+            const double coords[3] = { p.x - mOrigin.x, p.y - mOrigin.y, p.z - mOrigin.z };
+            for (int k = 0; k < 3; k++)
+                cell[k] = std::min(std::max((int)(coords[k] / mCell), 0), mDim[k] - 1);
+        }
+
+        size_t CellIndex(int x, int y, int z) const { return ((size_t)z * mDim[1] + y) * mDim[0] + x; }
+
+        const std::vector<uint32_t>& mIndices;
+        const std::vector<Vec3>& mPoints;
+        Vec3 mOrigin;
+        double mCell = 1.0;
+        int mDim[3] = {};
+        std::vector<uint32_t> mOffsets;
+        std::vector<uint32_t> mTriangles;
+        std::vector<uint32_t> mStamps;
+        uint32_t mQuery = 0;
+    };
+
+    enum class VertexKind : uint8_t
+    {
+        Manifold,   // двигается к любому соседу
+        Border,     // только вдоль открытой границы
+        Locked      // не двигается
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    inline uint64_t EdgeKey(uint32_t a, uint32_t b) { return ((uint64_t)a << 32) | b; }
+
+    // Треугольники каждой вершины (CSR)
+    void BuildAdjacency(
+        const std::vector<uint32_t>& indices,
+        size_t vertexCount,
+        std::vector<uint32_t>& offsets,
+        std::vector<uint32_t>& triangles)
+    {
+        offsets.assign(vertexCount + 1, 0);
+        for (uint32_t v : indices)
+            offsets[v + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] += offsets[v];
+
+        triangles.resize(indices.size());
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            triangles[fill[indices[i]]++] = (uint32_t)(i / 3);
+    }
+}
+
+size_t SimplifyMesh(
+    const uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    size_t targetIndexCount,
+    float targetError,
+    std::vector<uint32_t>& outIndices,
+    float* outError)
+{
+    std::vector<uint32_t> current(indices, indices + (indexCount - indexCount % 3));
+
+    std::vector<Vec3> points(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+        points[v] = { p[0], p[1], p[2] };
+    }
+
+    // 1. Совпадающие позиции: канонический представитель группы; вершины группы из нескольких - шов
+    std::vector<uint32_t> canonical(vertexCount);
+    std::vector<VertexKind> kind(vertexCount, VertexKind::Manifold);
+    {
+        std::vector<uint32_t> order(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+            order[v] = (uint32_t)v;
+
+        auto bits = [&](uint32_t v) {
+            const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+            uint32_t key[3];
+            memcpy(key, p, sizeof(key));
+            return std::make_tuple(key[0], key[1], key[2]);
+        };
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            auto ka = bits(a), kb = bits(b);
+            return ka != kb ? ka < kb : a < b;
+        });
+
+        for (size_t i = 0; i < vertexCount;)
+        {
+            size_t j = i + 1;
+            while (j < vertexCount && bits(order[j]) == bits(order[i]))
+                j++;
+            for (size_t k = i; k < j; k++)
+            {
+                canonical[order[k]] = order[i];
+                if (j - i > 1)
+                    kind[order[k]] = VertexKind::Locked;
+            }
+            i = j;
+        }
+    }
+
+    // 2. Рёбра по каноническим вершинам: граница - нет обратного полуребра,
+    //    неманифолд - одно и то же полуребро дважды
+    {
+        std::unordered_map<uint64_t, uint32_t> halfEdges;
+        halfEdges.reserve(current.size());
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+                halfEdges[EdgeKey(canonical[current[i + k]], canonical[current[i + (k + 1) % 3]])]++;
+        }
+
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                const uint32_t a = current[i + k], b = current[i + (k + 1) % 3];
+                const uint32_t ca = canonical[a], cb = canonical[b];
+                if (halfEdges[EdgeKey(ca, cb)] > 1)
+                {
+                    kind[a] = VertexKind::Locked;
+                    kind[b] = VertexKind::Locked;
+                }
+                else if (halfEdges.find(EdgeKey(cb, ca)) == halfEdges.end())
+                {
+                    if (kind[a] == VertexKind::Manifold) kind[a] = VertexKind::Border;
+                    if (kind[b] == VertexKind::Manifold) kind[b] = VertexKind::Border;
+                }
+            }
+        }
+    }
+
+    // 3. Квадрики: плоскости треугольников с весом площади, на границе - плоскость вдоль ребра
+    std::vector<Quadric> quadrics(vertexCount, Quadric{});
+    {
+        std::unordered_map<uint64_t, uint32_t> halfEdges;
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+                halfEdges[EdgeKey(canonical[current[i + k]], canonical[current[i + (k + 1) % 3]])]++;
+        }
+
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            const uint32_t tri[3] = { current[i], current[i + 1], current[i + 2] };
+            const Vec3 n = Cross(Sub(points[tri[1]], points[tri[0]]), Sub(points[tri[2]], points[tri[0]]));
+            const double length = Length(n);
+            if (length <= 0.0)
+                continue;
+
+            const Vec3 unit = { n.x / length, n.y / length, n.z / length };
+            const double area = 0.5 * length;
+            for (int k = 0; k < 3; k++)
+                AddPlane(quadrics[tri[k]], unit, -Dot(unit, points[tri[k]]), area);
+
+            for (int k = 0; k < 3; k++)
+            {
+                const uint32_t a = tri[k], b = tri[(k + 1) % 3];
+                if (halfEdges.count(EdgeKey(canonical[b], canonical[a])))
+                    continue;
+
+                const Vec3 edge = Sub(points[b], points[a]);
+                const Vec3 side = Cross(edge, unit);
+                const double sideLength = Length(side);
+                if (sideLength <= 0.0)
+                    continue;
+
+                const Vec3 sideUnit = { side.x / sideLength, side.y / sideLength, side.z / sideLength };
+                const double weight = BORDER_WEIGHT * Dot(edge, edge);
+                AddPlane(quadrics[a], sideUnit, -Dot(sideUnit, points[a]), weight);
+                AddPlane(quadrics[b], sideUnit, -Dot(sideUnit, points[a]), weight);
+            }
+        }
+    }
+
+    // 4. Проходы: кандидаты по возрастанию цены, в одном проходе вершина и её окрестность
+    //    участвуют не больше одного раза; потом индексы переписываются и вырожденные выбрасываются
+    const size_t target = targetIndexCount - targetIndexCount % 3;
+    const double maxCost = (double)targetError * targetError;
+
+    std::vector<uint32_t> parent(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        parent[v] = (uint32_t)v;
+
+    std::vector<uint32_t> offsets, adjacency;
+    std::vector<Collapse> candidates;
+    std::vector<uint8_t> passLock(vertexCount);
+    std::vector<uint32_t> remap(vertexCount);
+    double passCostBound = PASS_COST_BOUND;
+
+    while (current.size() > target)
+    {
+        BuildAdjacency(current, vertexCount, offsets, adjacency);
+
+        std::unordered_map<uint64_t, uint32_t> halfEdges;
+        halfEdges.reserve(current.size());
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+                halfEdges[EdgeKey(canonical[current[i + k]], canonical[current[i + (k + 1) % 3]])]++;
+        }
+
+        candidates.clear();
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                const uint32_t a = current[i + k], b = current[i + (k + 1) % 3];
+                const bool border = halfEdges.find(EdgeKey(canonical[b], canonical[a])) == halfEdges.end();
+
+                const uint32_t ends[2][2] = { { a, b }, { b, a } };
+                for (const auto& e : ends)
+                {
+                    const uint32_t from = e[0], to = e[1];
+                    if (kind[from] == VertexKind::Locked || (kind[from] == VertexKind::Border && !border))
+                        continue;
+
+                    Quadric q = quadrics[from];
+                    AddQuadric(q, quadrics[to]);
+                    candidates.push_back({ from, to, Evaluate(q, points[to]) });
+                }
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& l, const Collapse& r) {
+            if (l.cost != r.cost) return l.cost < r.cost;
+            return l.from != r.from ? l.from < r.from : l.to < r.to;
+        });
+
+        std::fill(passLock.begin(), passLock.end(), 0);
+        const size_t trianglesToRemove = (current.size() - target) / 3;
+        size_t removed = 0;
+        size_t collapses = 0;
+
+        // Схлопывание убирает ~2 треугольника: проход не берёт кандидатов сильно дороже нужного
+        // по счёту, иначе дешёвые, заблокированные соседями, уступили бы дорогим
+        const size_t goal = std::min(trianglesToRemove / 2, candidates.size() - 1);
+        const double passCost = candidates.empty() ? 0.0 : candidates[goal].cost * passCostBound;
+
+        for (const Collapse& c : candidates)
+        {
+            if (c.cost > maxCost || removed >= trianglesToRemove || (c.cost > passCost && collapses > 0))
+                break;
+            if (passLock[c.from] || passLock[c.to])
+                continue;
+
+            // Переворот или сильный поворот соседних треугольников
+            bool flips = false;
+            size_t removedHere = 0;
+            for (uint32_t t = offsets[c.from]; t < offsets[c.from + 1] && !flips; t++)
+            {
+                const uint32_t* tri = &current[adjacency[t] * 3];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+                {
+                    removedHere++;
+                    continue;
+                }
+
+                Vec3 before[3], after[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    before[k] = points[tri[k]];
+                    after[k] = tri[k] == c.from ? points[c.to] : points[tri[k]];
+                }
+                const Vec3 n0 = Cross(Sub(before[1], before[0]), Sub(before[2], before[0]));
+                const Vec3 n1 = Cross(Sub(after[1], after[0]), Sub(after[2], after[0]));
+                const double l0 = Length(n0), l1 = Length(n1);
+                if (l0 > 0.0 && Dot(n0, n1) <= MIN_NORMAL_DOT * l0 * l1)
+                    flips = true;
+            }
+            // Все треугольники обеих вершин общие - кусок исчез бы целиком
+            if (flips || (removedHere == offsets[c.from + 1] - offsets[c.from] &&
+                removedHere == offsets[c.to + 1] - offsets[c.to]))
+                continue;
+
+            parent[c.from] = c.to;
+            AddQuadric(quadrics[c.to], quadrics[c.from]);
+
+            passLock[c.from] = 1;
+            passLock[c.to] = 1;
+            for (uint32_t t = offsets[c.from]; t < offsets[c.from + 1]; t++)
+            {
+                const uint32_t* tri = &current[adjacency[t] * 3];
+                passLock[tri[0]] = passLock[tri[1]] = passLock[tri[2]] = 1;
+            }
+
+            removed += removedHere;
+            collapses++;
+        }
+
+        if (collapses == 0)
+            break;
+
+        // Дешёвые кандидаты бывают недопустимы (переворот, исчезающий кусок) - тогда предел растёт,
+        // чтобы проходы не вырождались в одно схлопывание
+        passCostBound = removed * 8 < trianglesToRemove ? passCostBound * 2.0 : PASS_COST_BOUND;
+
+        // Переезд за один проход - на один шаг: цель в этом проходе заблокирована
+        size_t write = 0;
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            const uint32_t a = parent[current[i]], b = parent[current[i + 1]], c = parent[current[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            current[write++] = a;
+            current[write++] = b;
+            current[write++] = c;
+        }
+        current.resize(write);
+    }
+
+    // 5. Ошибка: расстояние от каждой исходной вершины до упрощённой поверхности.
+    //    Окрестность вершины, в которую она схлопнулась, даёт начальную оценку,
+    //    сетка треугольников уточняет её до ближайшего треугольника всего меша
+    if (outError)
+    {
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            uint32_t root = (uint32_t)v;
+            while (parent[root] != root)
+                root = parent[root];
+            remap[v] = root;
+        }
+        BuildAdjacency(current, vertexCount, offsets, adjacency);
+
+        std::vector<uint8_t> used(vertexCount, 0);
+        Vec3 lo = { DBL_MAX, DBL_MAX, DBL_MAX }, hi = { -DBL_MAX, -DBL_MAX, -DBL_MAX };
+        for (size_t i = 0; i < indexCount - indexCount % 3; i++)
+        {
+            const Vec3& p = points[indices[i]];
+            used[indices[i]] = 1;
+            lo = { std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z) };
+            hi = { std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z) };
+        }
+
+        TriangleGrid grid(current, points, lo, hi);
+        double maxDistance = 0.0;
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            const uint32_t root = remap[v];
+            if (!used[v] || (root == v && offsets[root] != offsets[root + 1]))
+                continue;
+            if (current.empty())
+            {
+                maxDistance = std::max(maxDistance, Length(Sub(points[v], points[root])));
+                continue;
+            }
+
+            double best = DBL_MAX;
+            for (uint32_t t = offsets[root]; t < offsets[root + 1]; t++)
+            {
+                const uint32_t* tri = &current[adjacency[t] * 3];
+                best = std::min(best, DistanceToTriangle(points[v], points[tri[0]], points[tri[1]], points[tri[2]]));
+            }
+            maxDistance = std::max(maxDistance, grid.Nearest(points[v], best));
+        }
+        *outError = (float)maxDistance;
+    }
+
+    outIndices.swap(current);
+    return outIndices.size();
+}
+
+float MeasureSimplifyError(
+    const uint32_t* sourceIndices,
+    size_t sourceIndexCount,
+    const uint32_t* simplifiedIndices,
+    size_t simplifiedIndexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    size_t sampleStep)
+{
+    auto point = [&](uint32_t v) {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+        return Vec3{ p[0], p[1], p[2] };
+    };
+
+    std::vector<uint8_t> used(vertexCount, 0);
+    for (size_t i = 0; i < sourceIndexCount; i++)
+        used[sourceIndices[i]] = 1;
+
+    sampleStep = std::max<size_t>(sampleStep, 1);
+    double maxDistance = 0.0;
+    size_t sample = 0;
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        if (!used[v] || sample++ % sampleStep != 0)
+            continue;
+
+        const Vec3 p = point((uint32_t)v);
+        double best = DBL_MAX;
+        for (size_t i = 0; i + 2 < simplifiedIndexCount; i += 3)
+        {
+            best = std::min(best, DistanceToTriangle(p,
+                point(simplifiedIndices[i]), point(simplifiedIndices[i + 1]), point(simplifiedIndices[i + 2])));
+        }
+        maxDistance = std::max(maxDistance, best);
+    }
+    return (float)maxDistance;
+}
+
+void BuildLodChain(
+    std::vector<uint32_t>& indices,
+    size_t baseIndexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    const float* ratios,
+    size_t ratioCount,
+    std::vector<MeshLod>& outLods)
+{
+    outLods.clear();
+    outLods.push_back({ 0, (uint32_t)baseIndexCount, 0.0f });
+
+    std::vector<uint32_t> lodIndices;
+    for (size_t i = 0; i < ratioCount; i++)
+    {
+        const size_t target = (size_t)(baseIndexCount / 3 * ratios[i]) * 3;
+        float error = 0.0f;
+        SimplifyMesh(indices.data(), baseIndexCount, positions, vertexCount, stride,
+            target, FLT_MAX, lodIndices, &error);
+
+        const MeshLod& previous = outLods.back();
+        if (lodIndices.empty() || lodIndices.size() > previous.indexCount * MIN_LOD_REDUCTION)
+            break;
+
+        OptimizeVertexCache(lodIndices.data(), lodIndices.size(), vertexCount);
+
+        // Ошибка по цепочке не убывает, иначе SelectLod мог бы перескочить через уровень
+        MeshLod lod;
+        lod.firstIndex = (uint32_t)indices.size();
+        lod.indexCount = (uint32_t)lodIndices.size();
+        lod.error = std::max(error, previous.error);
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        outLods.push_back(lod);
+    }
+}
+
+uint32_t SelectLod(
+    const MeshLod* lods,
+    size_t lodCount,
+    float pixelsPerUnit,
+    float distance,
+    float maxPixelError)
+{
+    if (distance <= 0.0f)
+        return 0;
+
+    uint32_t lod = 0;
+    for (size_t i = 1; i < lodCount; i++)
+    {
+        if (lods[i].error * pixelsPerUnit / distance > maxPixelError)
+            break;
+        lod = (uint32_t)i;
+    }
+    return lod;
+}
@@ -0,0 +1,77 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ===== Упрощение меша и цепочка LOD =====
+// Схлопывание рёбер по квадрикам ошибки (Garland-Heckbert), только half-edge collapse:
+// вершина переезжает в соседнюю, новых вершин нет. Поэтому LOD - лишь другой индексный
+// диапазон в том же буфере, вершинный буфер общий.
+//
+// Вершины на шве (та же позиция у нескольких вершин, например разрыв нормали) и на
+// неманифолдных рёбрах не двигаются; вершины открытой границы скользят только вдоль неё.
+
+// Упрощает до targetIndexCount индексов или пока оценка ошибки не превысит targetError.
+// Возвращает число индексов в outIndices. outError - наибольшее расстояние от вершин
+// исходного меша до упрощённой поверхности (то же, что MeasureSimplifyError с шагом 1),
+// в единицах позиций
+size_t SimplifyMesh(
+    const uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    size_t targetIndexCount,
+    float targetError,
+    std::vector<uint32_t>& outIndices,
+    float* outError = nullptr
+);
+
+// Проверка границы ошибки перебором: максимум расстояния от каждой sampleStep-й используемой
+// вершины исходного меша до ближайшего треугольника упрощённого. O(вершины * треугольники) -
+// для офлайн-проверки (MeshBake --lod-check), не для импорта
+float MeasureSimplifyError(
+    const uint32_t* sourceIndices,
+    size_t sourceIndexCount,
+    const uint32_t* simplifiedIndices,
+    size_t simplifiedIndexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    size_t sampleStep = 1
+);
+
+struct MeshLod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;          // SimplifyMesh::outError; у LOD 0 - ноль
+};
+
+constexpr float MESH_LOD_RATIOS[] = { 0.5f, 0.25f, 0.1f };
+constexpr uint32_t MESH_MAX_LODS = 1 + sizeof(MESH_LOD_RATIOS) / sizeof(MESH_LOD_RATIOS[0]);
+
+// LOD 0 - indices[0; baseIndexCount) как есть; остальные дописываются в indices следом
+// (каждый - из базового меша, с OptimizeVertexCache). LOD, не давший заметного сокращения,
+// не добавляется
+void BuildLodChain(
+    std::vector<uint32_t>& indices,
+    size_t baseIndexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    const float* ratios,
+    size_t ratioCount,
+    std::vector<MeshLod>& outLods
+);
+
+// Самый грубый LOD, чья ошибка на экране не больше maxPixelError.
+// pixelsPerUnit = proj._22 * высота вьюпорта / 2 * масштаб мировой матрицы;
+// distance - от камеры до ближайшей точки ограничивающей сферы объекта
+uint32_t SelectLod(
+    const MeshLod* lods,
+    size_t lodCount,
+    float pixelsPerUnit,
+    float distance,
+    float maxPixelError
+);
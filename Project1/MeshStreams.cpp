@@ -0,0 +1,97 @@
+﻿#include "MeshStreams.h"
+#include "Vertex.h"
+
+#include <cstddef>
+
+using namespace DirectX;
+
+namespace
+{
+    // Один поток атрибута -> поле в каждой вершине dst (или значение по умолчанию)
+    template<typename T>
+    void ScatterStream(const std::vector<T>& stream, const T& fallback,
+        size_t count, uint32_t offset, uint32_t stride, unsigned char* dst)
+    {
+        unsigned char* out = dst + offset;
+
+        if (stream.empty())
+        {
+            for (size_t i = 0; i < count; i++, out += stride)
+                memcpy(out, &fallback, sizeof(T));
+            return;
+        }
+
+        for (size_t i = 0; i < count; i++, out += stride)
+            memcpy(out, &stream[i], sizeof(T));
+    }
+}
+
+void MeshStreams::Interleave(const VertexElement* elements, size_t elementCount, uint32_t stride, void* dst) const
+{
+    const size_t count = VertexCount();
+    unsigned char* bytes = static_cast<unsigned char*>(dst);
+
+    for (size_t e = 0; e < elementCount; e++)
+    {
+        const VertexElement& element = elements[e];
+        switch (element.attribute)
+        {
+        case VertexAttribute::Position:
+            ScatterStream(positions, XMFLOAT3(0.0f, 0.0f, 0.0f), count, element.offset, stride, bytes);
+            break;
+        case VertexAttribute::Normal:
+            ScatterStream(normals, XMFLOAT3(0.0f, 1.0f, 0.0f), count, element.offset, stride, bytes);
+            break;
+        case VertexAttribute::Color:
+            ScatterStream(colors, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), count, element.offset, stride, bytes);
+            break;
+        }
+    }
+}
+
+void MeshStreams::ToVertices(std::vector<Vertex>& outVertices) const
+{
+    static const VertexElement elements[] =
+    {
+        { VertexAttribute::Position, (uint32_t)offsetof(Vertex, position) },
+        { VertexAttribute::Color, (uint32_t)offsetof(Vertex, color) },
+        { VertexAttribute::Normal, (uint32_t)offsetof(Vertex, normal) },
+    };
+
+    outVertices.resize(VertexCount());
+    if (!outVertices.empty())
+        Interleave(elements, 3, sizeof(Vertex), outVertices.data());
+}
+
+MeshStreams MeshStreams::FromVertices(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    MeshStreams mesh = FromVertices(vertices.data(), vertices.size());
+    mesh.indices = indices;
+    return mesh;
+}
+
+MeshStreams MeshStreams::FromVertices(const Vertex* vertices, size_t vertexCount)
+{
+    MeshStreams mesh;
+    mesh.positions.resize(vertexCount);
+    mesh.normals.resize(vertexCount);
+
+    bool allWhite = true;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        mesh.positions[i] = vertices[i].position;
+        mesh.normals[i] = vertices[i].normal;
+
+        const XMFLOAT4& c = vertices[i].color;
+        allWhite = allWhite && c.x == 1.0f && c.y == 1.0f && c.z == 1.0f && c.w == 1.0f;
+    }
+
+    if (!allWhite)
+    {
+        mesh.colors.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++)
+            mesh.colors[i] = vertices[i].color;
+    }
+
+    return mesh;
+}
@@ -0,0 +1,83 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <d3d12.h>
+#endif
+
+struct Vertex;
+
+// Атрибут вершины в чередованном (interleaved) буфере
+enum class VertexAttribute
+{
+    Position,  // XMFLOAT3
+    Normal,    // XMFLOAT3
+    Color      // XMFLOAT4
+};
+
+struct VertexElement
+{
+    VertexAttribute attribute;
+    uint32_t offset;
+};
+
+// Меш с раздельными потоками атрибутов (SoA).
+// CPU-проходы читают только нужный поток, чередование - только при загрузке на GPU
+struct MeshStreams
+{
+    std::vector<DirectX::XMFLOAT3> positions;
+    std::vector<DirectX::XMFLOAT3> normals;  // пусто = (0, 1, 0)
+    std::vector<DirectX::XMFLOAT4> colors;   // пусто = белый
+    std::vector<uint32_t> indices;
+
+    size_t VertexCount() const { return positions.size(); }
+
+    // Пишет VertexCount() * stride байт в dst в раскладке elements
+    void Interleave(const VertexElement* elements, size_t elementCount, uint32_t stride, void* dst) const;
+
+    // Раскладка Vertex из Vertex.h
+    void ToVertices(std::vector<Vertex>& outVertices) const;
+
+    // Из массива Vertex; поток цветов не хранится, если все вершины белые
+    static MeshStreams FromVertices(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+    static MeshStreams FromVertices(const Vertex* vertices, size_t vertexCount);
+};
+
+#ifdef _WIN32
+// Раскладка по семантикам input layout (POSITION / NORMAL / COLOR, слот 0)
+inline std::vector<VertexElement> VertexElementsFromLayout(
+    const std::vector<D3D12_INPUT_ELEMENT_DESC>& layout,
+    uint32_t& outStride)
+{
+    std::vector<VertexElement> elements;
+    uint32_t offset = 0;
+    outStride = 0;
+
+    for (const auto& desc : layout)
+    {
+        if (desc.InputSlot != 0)
+            continue;
+
+        const uint32_t size = (desc.Format == DXGI_FORMAT_R32G32B32A32_FLOAT) ? 16 : 12;
+        if (desc.AlignedByteOffset != D3D12_APPEND_ALIGNED_ELEMENT)
+            offset = desc.AlignedByteOffset;
+
+        const std::string semantic = desc.SemanticName;
+        if (semantic == "POSITION")
+            elements.push_back({ VertexAttribute::Position, offset });
+        else if (semantic == "NORMAL")
+            elements.push_back({ VertexAttribute::Normal, offset });
+        else if (semantic == "COLOR")
+            elements.push_back({ VertexAttribute::Color, offset });
+
+        offset += size;
+        outStride = (offset > outStride) ? offset : outStride;
+    }
+
+    return elements;
+}
+#endif
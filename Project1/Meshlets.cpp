@@ -0,0 +1,246 @@
+﻿#include "Meshlets.h"
+#include "MeshClusters.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    // Конус шире ~84 градусов от оси почти никогда не отсекается - не тратим на него проверку
+    constexpr float MIN_CONE_DOT = 0.1f;
+
+    XMVECTOR LoadPosition(const float* positions, size_t stride, uint32_t v)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+        return XMVectorSet(p[0], p[1], p[2], 0.0f);
+    }
+
+    MeshletBounds ComputeBounds(
+        const uint32_t* indices,
+        uint32_t triangleCount,
+        const float* positions,
+        size_t stride)
+    {
+        MeshletBounds bounds{};
+
+        // Сфера: центр AABB, радиус - до самой дальней вершины
+        XMVECTOR lo = XMVectorReplicate(FLT_MAX), hi = XMVectorReplicate(-FLT_MAX);
+        for (uint32_t i = 0; i < triangleCount * 3; i++)
+        {
+            XMVECTOR p = LoadPosition(positions, stride, indices[i]);
+            lo = XMVectorMin(lo, p);
+            hi = XMVectorMax(hi, p);
+        }
+        const XMVECTOR center = XMVectorScale(XMVectorAdd(lo, hi), 0.5f);
+
+        float radius = 0.0f;
+        for (uint32_t i = 0; i < triangleCount * 3; i++)
+        {
+            XMVECTOR p = LoadPosition(positions, stride, indices[i]);
+            radius = std::max(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(p, center))));
+        }
+        XMStoreFloat3(&bounds.center, center);
+        bounds.radius = radius;
+
+        // Конус: ось - средняя единичная нормаль, раствор - по самой отклонённой нормали
+        std::vector<XMFLOAT3> normals;
+        normals.reserve(triangleCount);
+        XMVECTOR axis = XMVectorZero();
+        for (uint32_t t = 0; t < triangleCount; t++)
+        {
+            XMVECTOR a = LoadPosition(positions, stride, indices[t * 3 + 0]);
+            XMVECTOR b = LoadPosition(positions, stride, indices[t * 3 + 1]);
+            XMVECTOR c = LoadPosition(positions, stride, indices[t * 3 + 2]);
+
+            XMVECTOR n = XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(c, a));
+            float length = XMVectorGetX(XMVector3Length(n));
+            if (length <= 0.0f)
+                continue;  // вырожденный треугольник не влияет на видимость
+
+            n = XMVectorScale(n, 1.0f / length);
+            axis = XMVectorAdd(axis, n);
+
+            XMFLOAT3 stored;
+            XMStoreFloat3(&stored, n);
+            normals.push_back(stored);
+        }
+
+        bounds.coneApex = bounds.center;
+        bounds.coneAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        bounds.coneCutoff = 1.0f;
+
+        const float axisLength = XMVectorGetX(XMVector3Length(axis));
+        if (normals.empty() || axisLength <= 0.0f)
+            return bounds;
+        axis = XMVectorScale(axis, 1.0f / axisLength);
+
+        float minDot = 1.0f;
+        for (const XMFLOAT3& n : normals)
+            minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(XMLoadFloat3(&n), axis)));
+        if (minDot < MIN_CONE_DOT)
+            return bounds;
+
+        // Вершина конуса: сдвиг от центра против оси, чтобы все плоскости треугольников
+        // оказались перед ней (тогда проверка консервативна для любой точки обзора)
+        float maxT = 0.0f;
+        size_t normalIndex = 0;
+        for (uint32_t t = 0; t < triangleCount; t++)
+        {
+            XMVECTOR a = LoadPosition(positions, stride, indices[t * 3 + 0]);
+            XMVECTOR b = LoadPosition(positions, stride, indices[t * 3 + 1]);
+            XMVECTOR c = LoadPosition(positions, stride, indices[t * 3 + 2]);
+            if (XMVectorGetX(XMVector3LengthSq(XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(c, a)))) <= 0.0f)
+                continue;
+
+            XMVECTOR n = XMLoadFloat3(&normals[normalIndex++]);
+            float dc = XMVectorGetX(XMVector3Dot(XMVectorSubtract(center, a), n));
+            float dn = XMVectorGetX(XMVector3Dot(axis, n));
+            maxT = std::max(maxT, dc / dn);
+        }
+
+        XMStoreFloat3(&bounds.coneApex, XMVectorSubtract(center, XMVectorScale(axis, maxT)));
+        XMStoreFloat3(&bounds.coneAxis, axis);
+        bounds.coneCutoff = sqrtf(1.0f - minDot * minDot);
+        return bounds;
+    }
+}
+
+void MeshletData::Clear()
+{
+    meshlets.clear();
+    bounds.clear();
+    vertices.clear();
+    triangles.clear();
+}
+
+void BuildMeshlets(
+    const uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    MeshCluster* clusters,
+    size_t clusterCount,
+    MeshletData& out,
+    uint32_t maxVertices,
+    uint32_t maxTriangles)
+{
+    out.Clear();
+
+    // Локальный индекс в байте: не больше 256 вершин
+    maxVertices = std::min(std::max(maxVertices, 3u), 256u);
+    maxTriangles = std::max(maxTriangles, 1u);
+
+    // Без кластеров - один диапазон на весь буфер
+    MeshCluster whole;
+    whole.firstIndex = 0;
+    whole.indexCount = (uint32_t)(indexCount - indexCount % 3);
+    if (!clusters || clusterCount == 0)
+    {
+        clusters = &whole;
+        clusterCount = 1;
+    }
+
+    std::vector<uint32_t> localIndex(vertexCount, ~0u);
+
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        MeshCluster& cluster = clusters[c];
+        cluster.firstMeshlet = (uint32_t)out.meshlets.size();
+
+        const uint32_t clusterEnd = cluster.firstIndex + cluster.indexCount;
+        uint32_t index = cluster.firstIndex;
+        while (index < clusterEnd)
+        {
+            Meshlet meshlet{};
+            meshlet.vertexOffset = (uint32_t)out.vertices.size();
+            meshlet.triangleOffset = (uint32_t)out.triangles.size();
+            meshlet.firstIndex = index;
+
+            // Треугольники по порядку, пока влезают вершины и треугольники
+            for (; index + 3 <= clusterEnd && meshlet.triangleCount < maxTriangles; index += 3)
+            {
+                uint32_t newVertices = 0;
+                for (int k = 0; k < 3; k++)
+                {
+                    const uint32_t v = indices[index + k];
+                    if (localIndex[v] == ~0u && (k < 1 || v != indices[index]) && (k < 2 || v != indices[index + 1]))
+                        newVertices++;
+                }
+                if (meshlet.vertexCount + newVertices > maxVertices)
+                    break;
+
+                for (int k = 0; k < 3; k++)
+                {
+                    const uint32_t v = indices[index + k];
+                    if (localIndex[v] == ~0u)
+                    {
+                        localIndex[v] = meshlet.vertexCount++;
+                        out.vertices.push_back(v);
+                    }
+                    out.triangles.push_back((uint8_t)localIndex[v]);
+                }
+                meshlet.triangleCount++;
+            }
+
+            for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+                localIndex[out.vertices[meshlet.vertexOffset + i]] = ~0u;
+
+            // Выравнивание начала следующего мешлета под чтение по 4 байта
+            while (out.triangles.size() % 4 != 0)
+                out.triangles.push_back(0);
+
+            out.bounds.push_back(ComputeBounds(indices + meshlet.firstIndex, meshlet.triangleCount, positions, stride));
+            out.meshlets.push_back(meshlet);
+        }
+
+        cluster.meshletCount = (uint32_t)out.meshlets.size() - cluster.firstMeshlet;
+    }
+}
+
+bool IsMeshletBackfacing(const MeshletBounds& bounds, FXMVECTOR cameraPosition)
+{
+    XMVECTOR view = XMVectorSubtract(XMLoadFloat3(&bounds.coneApex), cameraPosition);
+    float distance = XMVectorGetX(XMVector3Length(view));
+    return XMVectorGetX(XMVector3Dot(view, XMLoadFloat3(&bounds.coneAxis))) >= bounds.coneCutoff * distance;
+}
+
+void CullMeshlets(
+    const MeshletBounds* bounds,
+    uint32_t first,
+    uint32_t count,
+    const Frustum& frustum,
+    FXMVECTOR cameraPosition,
+    bool cullBackfaces,
+    std::vector<uint32_t>& outVisible,
+    MeshletCullStats* stats)
+{
+    MeshletCullStats local;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        const MeshletBounds& b = bounds[i];
+        local.tested++;
+
+        if (frustum.IsSphereOutside(XMLoadFloat3(&b.center), b.radius))
+        {
+            local.frustumCulled++;
+            continue;
+        }
+        if (cullBackfaces && b.coneCutoff < 1.0f && IsMeshletBackfacing(b, cameraPosition))
+        {
+            local.backfaceCulled++;
+            continue;
+        }
+        outVisible.push_back(i);
+    }
+
+    if (stats)
+    {
+        stats->tested += local.tested;
+        stats->frustumCulled += local.frustumCulled;
+        stats->backfaceCulled += local.backfaceCulled;
+    }
+}
@@ -0,0 +1,88 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Bvh.h"
+
+struct MeshCluster;
+
+// ===== Мешлеты =====
+// Небольшие группы треугольников фиксированного размера (как для mesh shader):
+// локальный список вершин + тройки байтовых индексов в нём. Те же треугольники лежат
+// непрерывным диапазоном в общем индексном буфере, так что мешлеты рисуются и обычным DrawIndexed
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet
+{
+    uint32_t vertexOffset;    // в MeshletData::vertices
+    uint32_t triangleOffset;  // в MeshletData::triangles, байты; кратно 4
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+    uint32_t firstIndex;      // в общем индексном буфере (indexCount = triangleCount * 3)
+};
+
+// Сфера для отсечения пирамидой и конус нормалей для отсечения задних граней.
+// Мешлет смотрит от камеры, если dot(normalize(coneApex - camera), coneAxis) >= coneCutoff.
+// Лицевая сторона - обход по часовой стрелке (D3D12 по умолчанию)
+struct MeshletBounds
+{
+    DirectX::XMFLOAT3 center;
+    float radius;
+    DirectX::XMFLOAT3 coneApex;
+    float coneCutoff;         // 1 - конус слишком широкий, не отсекается
+    DirectX::XMFLOAT3 coneAxis;
+    float reserved;
+};
+
+struct MeshletData
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds;
+    std::vector<uint32_t> vertices;   // глобальные индексы вершин
+    std::vector<uint8_t> triangles;   // локальные индексы, по 3 на треугольник
+
+    void Clear();
+};
+
+// Жадно режет индексный буфер по порядку на мешлеты (порядок после OptimizeMesh уже локален
+// для кэша, так что перестановка не нужна). Мешлет не пересекает границу кластера;
+// clusters[i].firstMeshlet/meshletCount заполняются. clusters может быть nullptr.
+// Детерминирован: один и тот же вход - один и тот же выход
+void BuildMeshlets(
+    const uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    MeshCluster* clusters,
+    size_t clusterCount,
+    MeshletData& out,
+    uint32_t maxVertices = MESHLET_MAX_VERTICES,
+    uint32_t maxTriangles = MESHLET_MAX_TRIANGLES
+);
+
+struct MeshletCullStats
+{
+    uint32_t tested = 0;
+    uint32_t frustumCulled = 0;
+    uint32_t backfaceCulled = 0;
+};
+
+bool IsMeshletBackfacing(const MeshletBounds& bounds, DirectX::FXMVECTOR cameraPosition);
+
+// Мешлеты [first; first + count): видимые индексы дописываются в outVisible.
+// frustum и cameraPosition - в пространстве объекта; cullBackfaces = false для PSO без отсечения граней.
+// stats накапливаются (вызов обычно на каждый видимый кластер)
+void CullMeshlets(
+    const MeshletBounds* bounds,
+    uint32_t first,
+    uint32_t count,
+    const Frustum& frustum,
+    DirectX::FXMVECTOR cameraPosition,
+    bool cullBackfaces,
+    std::vector<uint32_t>& outVisible,
+    MeshletCullStats* stats = nullptr
+);
@@ -5,8 +5,18 @@ struct ObjectConstants
 {
     DirectX::XMFLOAT4X4 mWorldViewProj;
 
+    // Декодирование сжатой позиции (QuantizedMesh): pos = q * scale + offset
+    DirectX::XMFLOAT4 mPosScale;
+    DirectX::XMFLOAT4 mPosOffset;
+
+    // Для инстансного пути: мировая матрица берётся из gInstances
+    DirectX::XMFLOAT4X4 mViewProj;
+
     ObjectConstants()
+        : mPosScale(1.0f, 1.0f, 1.0f, 0.0f)
+        , mPosOffset(0.0f, 0.0f, 0.0f, 0.0f)
     {
         DirectX::XMStoreFloat4x4(&mWorldViewProj, DirectX::XMMatrixIdentity());
+        DirectX::XMStoreFloat4x4(&mViewProj, DirectX::XMMatrixIdentity());
     }
 };
\ No newline at end of file
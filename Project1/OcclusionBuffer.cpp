@@ -0,0 +1,441 @@
+﻿#include "OcclusionBuffer.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr size_t MIN_VERTICES_PER_THREAD = 8192;
+    constexpr size_t MIN_TRIANGLES_PER_THREAD = 2048;
+    constexpr uint32_t ROWS_PER_BAND = 8;       // полоса строк - единица параллельной растеризации
+    constexpr int HIZ_TEST_TEXELS = 4;          // коробка проверяется на уровне, где она не шире 4 текселей
+    constexpr double MIN_TRIANGLE_AREA = 1e-8;  // в пикселях^2
+
+    XMVECTOR LoadPosition(const float* positions, size_t stride, uint32_t v)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+        return XMVectorSet(p[0], p[1], p[2], 0.0f);
+    }
+
+    XMFLOAT4 Lerp(const XMFLOAT4& a, const XMFLOAT4& b, float t)
+    {
+        return XMFLOAT4(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t);
+    }
+}
+
+void SelectOccluders(
+    const uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    uint32_t triangleBudget,
+    OccluderMesh& out)
+{
+    out.positions.clear();
+    out.indices.clear();
+
+    const uint32_t triangleCount = (uint32_t)(indexCount / 3);
+    std::vector<float> areas(triangleCount);
+    std::vector<uint32_t> order(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        XMVECTOR a = LoadPosition(positions, stride, indices[t * 3 + 0]);
+        XMVECTOR b = LoadPosition(positions, stride, indices[t * 3 + 1]);
+        XMVECTOR c = LoadPosition(positions, stride, indices[t * 3 + 2]);
+        areas[t] = XMVectorGetX(XMVector3LengthSq(XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(c, a))));
+        order[t] = t;
+    }
+
+    // Первые triangleBudget по площади, затем обратно в исходный порядок: соседи делят вершины
+    if (triangleBudget < triangleCount)
+    {
+        std::nth_element(order.begin(), order.begin() + triangleBudget, order.end(),
+            [&](uint32_t a, uint32_t b) { return areas[a] > areas[b] || (areas[a] == areas[b] && a < b); });
+        order.resize(triangleBudget);
+        std::sort(order.begin(), order.end());
+    }
+
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    for (uint32_t t : order)
+    {
+        if (areas[t] <= 0.0f)
+            continue;
+
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            const uint32_t v = indices[t * 3 + k];
+            if (remap[v] == UINT32_MAX)
+            {
+                remap[v] = (uint32_t)out.positions.size();
+                XMFLOAT3 p;
+                XMStoreFloat3(&p, LoadPosition(positions, stride, v));
+                out.positions.push_back(p);
+            }
+            out.indices.push_back(remap[v]);
+        }
+    }
+}
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height)
+    : mWidth((std::max<uint32_t>(width, 4) + 3) & ~3u)
+    , mHeight(std::max<uint32_t>(height, 1))
+{
+    // Уровни пирамиды до 1x1; нечётный край - тексель покрывает остаток
+    uint32_t w = mWidth, h = mHeight;
+    for (;;)
+    {
+        mLevels.push_back({ w, h, std::vector<float>((size_t)w * h, 1.0f) });
+        if (w == 1 && h == 1)
+            break;
+        w = std::max(1u, (w + 1) / 2);
+        h = std::max(1u, (h + 1) / 2);
+    }
+}
+
+void OcclusionBuffer::SetupClippedTriangle(
+    const XMFLOAT4& a,
+    const XMFLOAT4& b,
+    const XMFLOAT4& c,
+    uint32_t width,
+    uint32_t height,
+    TriangleBin& bin)
+{
+    // В пиксели: y вниз, центр пикселя - (x + 0.5, y + 0.5)
+    const XMFLOAT4* v[3] = { &a, &b, &c };
+    double x[3], y[3], z[3];
+    for (int i = 0; i < 3; i++)
+    {
+        const double invW = 1.0 / v[i]->w;
+        x[i] = (v[i]->x * invW * 0.5 + 0.5) * width;
+        y[i] = (0.5 - v[i]->y * invW * 0.5) * height;
+        z[i] = v[i]->z * invW;
+    }
+
+    const double minSx = std::min({ x[0], x[1], x[2] }), maxSx = std::max({ x[0], x[1], x[2] });
+    const double minSy = std::min({ y[0], y[1], y[2] }), maxSy = std::max({ y[0], y[1], y[2] });
+
+    RasterTriangle tri;
+    tri.minX = (int)std::max(0.0, std::ceil(minSx - 0.5));
+    tri.maxX = (int)std::min((double)width - 1.0, std::floor(maxSx - 0.5));
+    tri.minY = (int)std::max(0.0, std::ceil(minSy - 0.5));
+    tri.maxY = (int)std::min((double)height - 1.0, std::floor(maxSy - 0.5));
+
+    const double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY || std::fabs(area) < MIN_TRIANGLE_AREA)
+    {
+        bin.stats.trianglesRejected++;
+        return;
+    }
+
+    // Обе стороны: окклюдер закрывает и изнанкой, знак площади только ориентирует рёбра
+    const double sign = area > 0.0 ? 1.0 : -1.0;
+    const double originX = tri.minX + 0.5, originY = tri.minY + 0.5;
+    for (int e = 0; e < 3; e++)
+    {
+        const int i = e, j = (e + 1) % 3;
+        const double edgeA = (y[i] - y[j]) * sign;
+        const double edgeB = (x[j] - x[i]) * sign;
+        tri.edgeA[e] = (float)edgeA;
+        tri.edgeB[e] = (float)edgeB;
+        tri.edgeC[e] = (float)(edgeA * (originX - x[i]) + edgeB * (originY - y[i]));
+    }
+
+    const double depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    const double depthB = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+    tri.depthA = (float)depthA;
+    tri.depthB = (float)depthB;
+    tri.depthC = (float)(z[0] + depthA * (originX - x[0]) + depthB * (originY - y[0]));
+
+    bin.triangles.push_back(tri);
+    bin.stats.trianglesRasterized++;
+}
+
+void OcclusionBuffer::SetupTriangle(const XMFLOAT4* clip, uint32_t width, uint32_t height, TriangleBin& bin)
+{
+    // Целиком за одной из плоскостей пирамиды (кроме ближней - её режем ниже)
+    const XMFLOAT4& a = clip[0];
+    const XMFLOAT4& b = clip[1];
+    const XMFLOAT4& c = clip[2];
+    if ((a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w) ||
+        (a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w) ||
+        (a.z > a.w && b.z > b.w && c.z > c.w) || (a.z < 0.0f && b.z < 0.0f && c.z < 0.0f))
+    {
+        bin.stats.trianglesRejected++;
+        return;
+    }
+
+    if (a.z >= 0.0f && b.z >= 0.0f && c.z >= 0.0f)
+    {
+        SetupClippedTriangle(a, b, c, width, height, bin);
+        return;
+    }
+
+    // Отсечение ближней плоскостью z = 0: многоугольник из 3-4 вершин, веером
+    XMFLOAT4 polygon[4];
+    int count = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        const XMFLOAT4& p = clip[i];
+        const XMFLOAT4& q = clip[(i + 1) % 3];
+        if (p.z >= 0.0f)
+            polygon[count++] = p;
+        if ((p.z >= 0.0f) != (q.z >= 0.0f))
+            polygon[count++] = Lerp(p, q, p.z / (p.z - q.z));
+    }
+
+    bin.stats.trianglesClipped++;
+    for (int i = 1; i + 1 < count; i++)
+        SetupClippedTriangle(polygon[0], polygon[i], polygon[i + 1], width, height, bin);
+}
+
+void OcclusionBuffer::RasterizeRows(uint32_t rowBegin, uint32_t rowEnd)
+{
+    DepthLevel& target = mLevels[0];
+    const XMVECTOR laneOffsets = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+    const XMVECTOR zero = XMVectorZero();
+
+    for (const TriangleBin& bin : mBins)
+    {
+        for (const RasterTriangle& tri : bin.triangles)
+        {
+            const int y0 = std::max(tri.minY, (int)rowBegin);
+            const int y1 = std::min(tri.maxY, (int)rowEnd - 1);
+            if (y0 > y1)
+                continue;
+
+            // Четвёрки пикселей выровнены по 4, ширина буфера кратна 4
+            const int xStart = tri.minX & ~3;
+            const XMVECTOR dx = XMVectorAdd(XMVectorReplicate((float)(xStart - tri.minX)), laneOffsets);
+
+            const XMVECTOR a0 = XMVectorReplicate(tri.edgeA[0]);
+            const XMVECTOR a1 = XMVectorReplicate(tri.edgeA[1]);
+            const XMVECTOR a2 = XMVectorReplicate(tri.edgeA[2]);
+            const XMVECTOR az = XMVectorReplicate(tri.depthA);
+            const XMVECTOR step0 = XMVectorScale(a0, 4.0f);
+            const XMVECTOR step1 = XMVectorScale(a1, 4.0f);
+            const XMVECTOR step2 = XMVectorScale(a2, 4.0f);
+            const XMVECTOR stepZ = XMVectorScale(az, 4.0f);
+
+            for (int y = y0; y <= y1; y++)
+            {
+                const float dy = (float)(y - tri.minY);
+                XMVECTOR e0 = XMVectorMultiplyAdd(a0, dx, XMVectorReplicate(tri.edgeB[0] * dy + tri.edgeC[0]));
+                XMVECTOR e1 = XMVectorMultiplyAdd(a1, dx, XMVectorReplicate(tri.edgeB[1] * dy + tri.edgeC[1]));
+                XMVECTOR e2 = XMVectorMultiplyAdd(a2, dx, XMVectorReplicate(tri.edgeB[2] * dy + tri.edgeC[2]));
+                XMVECTOR z = XMVectorMultiplyAdd(az, dx, XMVectorReplicate(tri.depthB * dy + tri.depthC));
+
+                float* row = target.depth.data() + (size_t)y * target.width;
+                for (int x = xStart; x <= tri.maxX; x += 4)
+                {
+                    XMVECTOR inside = XMVectorAndInt(
+                        XMVectorAndInt(XMVectorGreaterOrEqual(e0, zero), XMVectorGreaterOrEqual(e1, zero)),
+                        XMVectorGreaterOrEqual(e2, zero));
+
+                    XMFLOAT4* pixels = reinterpret_cast<XMFLOAT4*>(row + x);
+                    XMVECTOR depth = XMLoadFloat4(pixels);
+                    XMStoreFloat4(pixels, XMVectorSelect(depth, XMVectorMin(depth, z), inside));
+
+                    e0 = XMVectorAdd(e0, step0);
+                    e1 = XMVectorAdd(e1, step1);
+                    e2 = XMVectorAdd(e2, step2);
+                    z = XMVectorAdd(z, stepZ);
+                }
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::BuildHiZ()
+{
+    for (size_t level = 1; level < mLevels.size(); level++)
+    {
+        const DepthLevel& src = mLevels[level - 1];
+        DepthLevel& dst = mLevels[level];
+        for (uint32_t y = 0; y < dst.height; y++)
+        {
+            const float* row0 = src.depth.data() + (size_t)std::min(y * 2, src.height - 1) * src.width;
+            const float* row1 = src.depth.data() + (size_t)std::min(y * 2 + 1, src.height - 1) * src.width;
+            float* out = dst.depth.data() + (size_t)y * dst.width;
+            for (uint32_t x = 0; x < dst.width; x++)
+            {
+                const uint32_t x0 = std::min(x * 2, src.width - 1);
+                const uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+                out[x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::Render(
+    const OccluderMesh& mesh,
+    const XMFLOAT4X4* worldViewProj,
+    size_t instanceCount,
+    unsigned threadCount)
+{
+    mInstanceMeshes.assign(instanceCount, &mesh);
+    Render(mInstanceMeshes.data(), worldViewProj, instanceCount, threadCount);
+}
+
+void OcclusionBuffer::Render(
+    const OccluderMesh* const* meshes,
+    const XMFLOAT4X4* worldViewProj,
+    size_t instanceCount,
+    unsigned threadCount)
+{
+    std::fill(mLevels[0].depth.begin(), mLevels[0].depth.end(), 1.0f);
+
+    mBins.resize(ResolveThreadCount(threadCount));
+    for (TriangleBin& bin : mBins)
+    {
+        bin.triangles.clear();
+        bin.stats = OcclusionStats();
+    }
+
+    for (size_t instance = 0; instance < instanceCount; instance++)
+    {
+        const OccluderMesh& mesh = *meshes[instance];
+        const size_t vertexCount = mesh.positions.size();
+        const size_t triangleCount = mesh.TriangleCount();
+        mClip.resize(std::max(mClip.size(), vertexCount));
+
+        const XMMATRIX m = XMLoadFloat4x4(&worldViewProj[instance]);
+
+        ParallelForRange(vertexCount, MIN_VERTICES_PER_THREAD, threadCount, [&](size_t, size_t begin, size_t end)
+            {
+                for (size_t v = begin; v < end; v++)
+                    XMStoreFloat4(&mClip[v], XMVector3Transform(XMLoadFloat3(&mesh.positions[v]), m));
+            });
+
+        ParallelForRange(triangleCount, MIN_TRIANGLES_PER_THREAD, threadCount, [&](size_t part, size_t begin, size_t end)
+            {
+                TriangleBin& bin = mBins[part];
+                for (size_t t = begin; t < end; t++)
+                {
+                    const XMFLOAT4 clip[3] = {
+                        mClip[mesh.indices[t * 3 + 0]],
+                        mClip[mesh.indices[t * 3 + 1]],
+                        mClip[mesh.indices[t * 3 + 2]],
+                    };
+                    SetupTriangle(clip, mWidth, mHeight, bin);
+                }
+            });
+    }
+
+    // Полосы строк не пересекаются - пишем в буфер без синхронизации
+    const size_t bandCount = (mHeight + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+    ParallelForRange(bandCount, 1, threadCount, [&](size_t, size_t begin, size_t end)
+        {
+            RasterizeRows((uint32_t)begin * ROWS_PER_BAND, std::min((uint32_t)end * ROWS_PER_BAND, mHeight));
+        });
+
+    mStats = OcclusionStats();
+    for (const TriangleBin& bin : mBins)
+    {
+        mStats.trianglesRasterized += bin.stats.trianglesRasterized;
+        mStats.trianglesClipped += bin.stats.trianglesClipped;
+        mStats.trianglesRejected += bin.stats.trianglesRejected;
+    }
+}
+
+bool OcclusionBuffer::IsOccluded(
+    const XMFLOAT3& boundsMin,
+    const XMFLOAT3& boundsMax,
+    const XMFLOAT4X4& worldViewProj) const
+{
+    const XMMATRIX m = XMLoadFloat4x4(&worldViewProj);
+
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const XMVECTOR p = XMVectorSet(
+            (corner & 1) ? boundsMax.x : boundsMin.x,
+            (corner & 2) ? boundsMax.y : boundsMin.y,
+            (corner & 4) ? boundsMax.z : boundsMin.z,
+            1.0f);
+        XMFLOAT4 clip;
+        XMStoreFloat4(&clip, XMVector3Transform(p, m));
+
+        // Угол перед ближней плоскостью - коробка касается камеры, считаем видимой
+        if (clip.z < 0.0f || clip.w <= 0.0f)
+            return false;
+
+        const float invW = 1.0f / clip.w;
+        const float sx = (clip.x * invW * 0.5f + 0.5f) * mWidth;
+        const float sy = (0.5f - clip.y * invW * 0.5f) * mHeight;
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+        minZ = std::min(minZ, clip.z * invW);
+    }
+
+    // Вне экрана - дело отсечения пирамидой видимости
+    if (maxX < 0.0f || maxY < 0.0f || minX >= (float)mWidth || minY >= (float)mHeight)
+        return false;
+
+    const int x0 = (int)std::max(0.0f, minX);
+    const int y0 = (int)std::max(0.0f, minY);
+    const int x1 = (int)std::min((float)mWidth - 1.0f, maxX);
+    const int y1 = (int)std::min((float)mHeight - 1.0f, maxY);
+
+    uint32_t level = 0;
+    while (level + 1 < mLevels.size() &&
+        ((x1 >> level) - (x0 >> level) >= HIZ_TEST_TEXELS || (y1 >> level) - (y0 >> level) >= HIZ_TEST_TEXELS))
+        level++;
+
+    const DepthLevel& hiz = mLevels[level];
+    for (int y = y0 >> level; y <= y1 >> level; y++)
+    {
+        const float* row = hiz.depth.data() + (size_t)y * hiz.width;
+        for (int x = x0 >> level; x <= x1 >> level; x++)
+        {
+            if (row[x] >= minZ)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool OcclusionBuffer::WriteDepthPgm(const std::string& path, uint32_t level) const
+{
+    if (level >= mLevels.size())
+        return false;
+
+    const DepthLevel& src = mLevels[level];
+
+    // Занятый диапазон без очищенного фона, иначе почти всё сливается у 1.0
+    float lo = 1.0f, hi = 0.0f;
+    for (float d : src.depth)
+    {
+        if (d < 1.0f)
+        {
+            lo = std::min(lo, d);
+            hi = std::max(hi, d);
+        }
+    }
+    const float scale = hi > lo ? 1.0f / (hi - lo) : 0.0f;
+
+    std::vector<unsigned char> pixels(src.depth.size());
+    for (size_t i = 0; i < src.depth.size(); i++)
+    {
+        const float d = src.depth[i];
+        pixels[i] = d < 1.0f ? (unsigned char)(255.0f - 223.0f * (d - lo) * scale) : 0;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    char header[64];
+    const int headerSize = snprintf(header, sizeof(header), "P5\n%u %u\n255\n", src.width, src.height);
+    file.write(header, headerSize);
+    file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+    return (bool)file;
+}
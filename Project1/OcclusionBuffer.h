@@ -0,0 +1,131 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ===== Программное отсечение перекрытых (hi-Z на CPU) =====
+// Окклюдеры (самые крупные треугольники меша) растеризуются в маленький буфер глубины, по нему строится
+// пирамида максимумов; коробка закрыта, если её ближайшая глубина дальше максимума под ней.
+// Глубина - z/w как у D3D (0 - ближняя плоскость), растеризация по 4 пикселя в XMVECTOR.
+
+constexpr uint32_t OCCLUSION_WIDTH = 256;
+constexpr uint32_t OCCLUSION_HEIGHT = 128;
+constexpr uint32_t OCCLUDER_TRIANGLE_BUDGET = 16384;
+
+// CPU-копия геометрии окклюдеров
+struct OccluderMesh
+{
+    std::vector<DirectX::XMFLOAT3> positions;
+    std::vector<uint32_t> indices;
+
+    size_t TriangleCount() const { return indices.size() / 3; }
+};
+
+// Не больше triangleBudget самых крупных треугольников (стены, пол), в исходном порядке.
+// Целыми кластерами нельзя: кластер - пространственный кусок, стена в нём вперемешку с мелочью.
+// positions - x,y,z с шагом stride байт
+void SelectOccluders(
+    const uint32_t* indices,
+    size_t indexCount,
+    const float* positions,
+    size_t vertexCount,
+    size_t stride,
+    uint32_t triangleBudget,
+    OccluderMesh& out
+);
+
+struct OcclusionStats
+{
+    uint32_t trianglesRasterized = 0;
+    uint32_t trianglesClipped = 0;     // разрезаны ближней плоскостью
+    uint32_t trianglesRejected = 0;    // вне экрана, за камерой или вырожденные
+};
+
+class OcclusionBuffer
+{
+public:
+    // width кратна 4
+    explicit OcclusionBuffer(uint32_t width = OCCLUSION_WIDTH, uint32_t height = OCCLUSION_HEIGHT);
+
+    // Буфер глубины по окклюдерам всех экземпляров (worldViewProj в порядке DirectXMath, v * M).
+    // Вершины, сборка треугольников и полосы строк - параллельно; 0 = по числу ядер
+    void Render(
+        const OccluderMesh& mesh,
+        const DirectX::XMFLOAT4X4* worldViewProj,
+        size_t instanceCount,
+        unsigned threadCount = 0
+    );
+
+    // То же, но у каждого экземпляра свои окклюдеры (например, от LOD, которым он рисуется)
+    void Render(
+        const OccluderMesh* const* meshes,
+        const DirectX::XMFLOAT4X4* worldViewProj,
+        size_t instanceCount,
+        unsigned threadCount = 0
+    );
+
+    // Пирамида максимумов по буферу глубины - после Render
+    void BuildHiZ();
+
+    // true - коробка (в пространстве объекта) закрыта окклюдерами целиком.
+    // Безопасно вызывать из нескольких потоков после BuildHiZ
+    bool IsOccluded(
+        const DirectX::XMFLOAT3& boundsMin,
+        const DirectX::XMFLOAT3& boundsMax,
+        const DirectX::XMFLOAT4X4& worldViewProj
+    ) const;
+
+    // Уровень пирамиды в PGM (P5): ближнее - светлее, растянуто по занятому диапазону глубин
+    bool WriteDepthPgm(const std::string& path, uint32_t level = 0) const;
+
+    uint32_t Width() const { return mWidth; }
+    uint32_t Height() const { return mHeight; }
+    uint32_t LevelCount() const { return (uint32_t)mLevels.size(); }
+    const float* Level(uint32_t level) const { return mLevels[level].depth.data(); }
+
+    const OcclusionStats& GetStats() const { return mStats; }
+
+private:
+    // Рёбра и глубина - от центра пикселя (minX, minY), чтобы не терять точность на больших координатах
+    struct RasterTriangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3];  // E = A dx + B dy + C >= 0 внутри
+        float depthA, depthB, depthC;        // z = A dx + B dy + C
+        int minX, maxX, minY, maxY;
+    };
+
+    // Треугольники, собранные одним потоком
+    struct TriangleBin
+    {
+        std::vector<RasterTriangle> triangles;
+        OcclusionStats stats;
+    };
+
+    struct DepthLevel
+    {
+        uint32_t width;
+        uint32_t height;
+        std::vector<float> depth;
+    };
+
+    static void SetupTriangle(const DirectX::XMFLOAT4* clip, uint32_t width, uint32_t height, TriangleBin& bin);
+    static void SetupClippedTriangle(
+        const DirectX::XMFLOAT4& a,
+        const DirectX::XMFLOAT4& b,
+        const DirectX::XMFLOAT4& c,
+        uint32_t width,
+        uint32_t height,
+        TriangleBin& bin
+    );
+    void RasterizeRows(uint32_t rowBegin, uint32_t rowEnd);
+
+    uint32_t mWidth;
+    uint32_t mHeight;
+    std::vector<DepthLevel> mLevels;          // [0] - сам буфер глубины
+    std::vector<TriangleBin> mBins;
+    std::vector<DirectX::XMFLOAT4> mClip;     // вершины окклюдеров в пространстве отсечения
+    std::vector<const OccluderMesh*> mInstanceMeshes;
+    OcclusionStats mStats;
+};
@@ -0,0 +1,59 @@
+﻿#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+
+// Число потоков: 0 = по числу ядер
+inline size_t ResolveThreadCount(unsigned threadCount)
+{
+    if (threadCount != 0)
+        return threadCount;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// fn(i) для i в [0; count), по потоку на индекс, i = 0 - на вызывающем потоке.
+// Из потока JobSystem (и из её заданий) - заданиями в её потоках, без создания новых
+template<typename Fn>
+void ParallelFor(size_t count, Fn&& fn)
+{
+    if (count <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            fn(i);
+        return;
+    }
+
+    if (JobSystem* jobs = JobSystem::ForCurrentThread())
+    {
+        jobs->ParallelFor(count, 1, [&fn](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                    fn(i);
+            });
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(count - 1);
+    for (size_t i = 1; i < count; i++)
+        workers.emplace_back([&fn, i]() { fn(i); });
+
+    fn(0);
+
+    for (auto& t : workers)
+        t.join();
+}
+
+// Делит [0; count) на равные диапазоны не меньше minItems: fn(part, begin, end)
+template<typename Fn>
+void ParallelForRange(size_t count, size_t minItems, unsigned threadCount, Fn&& fn)
+{
+    size_t parts = std::min(ResolveThreadCount(threadCount), count / std::max<size_t>(minItems, 1) + 1);
+    parts = std::max<size_t>(1, std::min(parts, count));
+
+    ParallelFor(parts, [&](size_t part)
+        {
+            fn(part, count * part / parts, count * (part + 1) / parts);
+        });
+}
@@ -1,157 +1,903 @@
-#include "Parser.h"
+﻿#include "Parser.h"
 #include "Vertex.h"
+#include "MappedFile.h"
+#include "ParallelFor.h"
+#include "MeshBounds.h"
+#include "MeshStreams.h"
 
 #include <fstream>
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <charconv>
+#include <cfloat>
+#include <climits>
+#include <cmath>
 
 using namespace DirectX;
 
-bool LoadOBJ(
-    const std::string& filename,
-    std::vector<Vertex>& outVertices,
-    std::vector<uint32_t>& outIndices)
+namespace
 {
-    std::ifstream file(filename);
-    if (!file.is_open())
-        return false;
-
     constexpr float OBJ_SCALE = 5.0f;
 
-    std::vector<XMFLOAT3> positions;
-    std::vector<XMFLOAT3> normals;
+    // Минимальный размер куска файла на поток (меньше не дробим)
+    constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    // Средняя длина строки OBJ - для оценки ёмкости массивов по размеру файла
+    constexpr size_t AVG_LINE_BYTES = 32;
 
-    positions.reserve(500000);
-    normals.reserve(500000);
-    outVertices.reserve(500000);
-    outIndices.reserve(1000000);
+    // Минимум вершин на поток при заполнении выходных массивов
+    constexpr size_t MIN_FILL_ITEMS = 64 * 1024;
+
+    // ===== Ручной сканер чисел (аналог %d / %f из sscanf) =====
+    inline bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
 
-    std::string line;
+    inline void SkipSpaces(const char*& p, const char* end)
+    {
+        while (p < end && IsSpace(*p))
+            ++p;
+    }
 
-    while (std::getline(file, line))
+    inline bool ScanInt(const char*& p, const char* end, int& out)
     {
-        // ===== vertex position =====
-        if (line.rfind("v ", 0) == 0)
+        SkipSpaces(p, end);
+
+        const char* s = p;
+        bool negative = false;
+        if (s < end && (*s == '-' || *s == '+'))
         {
-            XMFLOAT3 p;
-            sscanf_s(line.c_str(), "v %f %f %f", &p.x, &p.y, &p.z);
+            negative = (*s == '-');
+            ++s;
+        }
 
-            p.x *= OBJ_SCALE;
-            p.y *= OBJ_SCALE;
-            p.z *= OBJ_SCALE;
+        if (s >= end || *s < '0' || *s > '9')
+            return false;
 
-            positions.push_back(p);
+        // Как strtol: за пределами int - INT_MIN / INT_MAX (такой индекс дальше отбрасывается как вне границ).
+        // Накопление в int64 и насыщение чуть выше предела: длинная строка цифр не переполняет и его
+        const int64_t limit = negative ? -(int64_t)INT_MIN : INT_MAX;
+        int64_t value = 0;
+        while (s < end && *s >= '0' && *s <= '9')
+        {
+            value = std::min(value * 10 + (*s - '0'), limit + 1);
+            ++s;
         }
-        // ===== vertex normal =====
-        else if (line.rfind("vn ", 0) == 0)
+
+        value = std::min(value, limit);
+        out = (int)(negative ? -value : value);
+        p = s;
+        return true;
+    }
+
+    inline bool ScanFloat(const char*& p, const char* end, float& out)
+    {
+        SkipSpaces(p, end);
+
+        const char* s = p;
+        if (s < end && *s == '+')
+            ++s;
+
+        // from_chars округляет так же, как strtof, поэтому результат побитово совпадает с sscanf
+        std::from_chars_result r = std::from_chars(s, end, out);
+        if (r.ec == std::errc::invalid_argument)
+            return false;
+
+        // Вне диапазона float from_chars не трогает out; strtof (и sscanf) дают ±HUGE_VALF при
+        // переполнении и ±0 при потере значимости. Что из двух - по тому же числу в double,
+        // а если не влезает и в double - по знаку порядка
+        if (r.ec == std::errc::result_out_of_range)
         {
-            XMFLOAT3 n;
-            sscanf_s(line.c_str(), "vn %f %f %f", &n.x, &n.y, &n.z);
-            normals.push_back(n);
+            const bool negative = (*s == '-');
+            double wide = 0.0;
+            bool overflow;
+            if (std::from_chars(s, r.ptr, wide).ec == std::errc())
+            {
+                overflow = std::fabs(wide) > 1.0;
+            }
+            else
+            {
+                const char* exponent = std::find_if(s, r.ptr, [](char c) { return c == 'e' || c == 'E'; });
+                overflow = exponent + 1 >= r.ptr || exponent[1] != '-';
+            }
+
+            out = overflow ? HUGE_VALF : 0.0f;
+            if (negative)
+                out = -out;
         }
-        // ===== face =====
-        else if (line.rfind("f ", 0) == 0)
+
+        p = r.ptr;
+        return true;
+    }
+
+    inline bool Expect(const char*& p, const char* end, char c)
+    {
+        if (p >= end || *p != c)
+            return false;
+        ++p;
+        return true;
+    }
+
+    inline bool StartsWith(const char* p, const char* end, const char* prefix)
+    {
+        for (; *prefix; ++prefix, ++p)
         {
-            int pi[3]{}, ni[3]{};
+            if (p >= end || *p != *prefix)
+                return false;
+        }
+        return true;
+    }
+
+    // ===== Разобранный кусок файла =====
+    struct ObjCorner
+    {
+        int pi;  // индекс позиции как в файле (1..N или отрицательный)
+        int ni;  // индекс нормали как в файле (0 - нет нормали)
+    };
+
+    // Треугольник после веерной триангуляции грани
+    struct ObjFace
+    {
+        ObjCorner corners[3];
+        // Сколько v/vn было в куске к моменту этой грани (для проверки границ
+        // и разрешения относительных индексов)
+        uint32_t posCount;
+        uint32_t normCount;
+    };
+
+    struct ObjChunk
+    {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        std::vector<XMFLOAT3> positions;
+        std::vector<XMFLOAT3> normals;
+        std::vector<ObjFace> faces;
+
+        // Заполняются последовательным проходом
+        size_t posBase = 0;
+        size_t normBase = 0;
+        size_t cornerBase = 0;
+        size_t cornerCount = 0;
+    };
+
+    // Один угол грани: v, v/vt, v//vn или v/vt/vn
+    bool ScanCorner(const char*& p, const char* end, ObjCorner& corner)
+    {
+        corner.ni = 0;
+        if (!ScanInt(p, end, corner.pi))
+            return false;
+
+        if (!Expect(p, end, '/'))
+            return true;
+
+        int vt = 0;
+        if (p < end && *p != '/' && !ScanInt(p, end, vt))
+            return false;
+
+        if (!Expect(p, end, '/'))
+            return true;
+
+        return ScanInt(p, end, corner.ni);
+    }
+
+    // Грань из любого числа углов, веер (0, i, i+1) отдаётся в emit по треугольнику
+    template<typename Emit>
+    void ParseFace(const char* p, const char* end, Emit&& emit)
+    {
+        ObjCorner first{}, prev{}, corner{};
+        int count = 0;
+
+        while (ScanCorner(p, end, corner))
+        {
+            if (count == 0)
+                first = corner;
+            else if (count >= 2)
+                emit(first, prev, corner);
+
+            prev = corner;
+            count++;
+        }
+    }
+
+    // Индекс из файла -> индекс в общем массиве, -1 если вне границ
+    inline int ResolveIndex(int index, size_t base, uint32_t count)
+    {
+        const int64_t limit = (int64_t)base + count;
+        const int64_t resolved = (index > 0) ? (int64_t)index - 1 : limit + index;
+
+        if (index == 0 || resolved < 0 || resolved >= limit)
+            return -1;
+        return (int)resolved;
+    }
+
+    inline bool IsFaceValid(const ObjFace& face, const ObjChunk& chunk)
+    {
+        for (const ObjCorner& corner : face.corners)
+        {
+            if (ResolveIndex(corner.pi, chunk.posBase, face.posCount) < 0)
+                return false;
+        }
+        return true;
+    }
+
+    // Строка "v x y z" (уже с OBJ_SCALE)
+    inline XMFLOAT3 ReadPosition(const char* p, const char* lineEnd)
+    {
+        XMFLOAT3 pos{};
+        const char* s = p + 1;
+        ScanFloat(s, lineEnd, pos.x) && ScanFloat(s, lineEnd, pos.y) && ScanFloat(s, lineEnd, pos.z);
+
+        pos.x *= OBJ_SCALE;
+        pos.y *= OBJ_SCALE;
+        pos.z *= OBJ_SCALE;
+        return pos;
+    }
+
+    // Строка "vn x y z"
+    inline XMFLOAT3 ReadNormal(const char* p, const char* lineEnd)
+    {
+        XMFLOAT3 n{};
+        const char* s = p + 2;
+        ScanFloat(s, lineEnd, n.x) && ScanFloat(s, lineEnd, n.y) && ScanFloat(s, lineEnd, n.z);
+        return n;
+    }
+
+    void ParseChunk(ObjChunk& chunk)
+    {
+        const char* p = chunk.begin;
+        const char* end = chunk.end;
+
+        // Ёмкость по размеру куска вместо фиксированных reserve
+        const size_t lineEstimate = (size_t)(end - p) / AVG_LINE_BYTES;
+        chunk.positions.reserve(lineEstimate / 3);
+        chunk.normals.reserve(lineEstimate / 3);
+        chunk.faces.reserve(lineEstimate / 2);
 
-            // : v//n  v/vt/n
-            int matched = sscanf_s(
-                line.c_str(),
-                "f %d//%d %d//%d %d//%d",
-                &pi[0], &ni[0],
-                &pi[1], &ni[1],
-                &pi[2], &ni[2]
-            );
+        while (p < end)
+        {
+            const char* lineEnd = std::find(p, end, '\n');
 
-            if (matched != 6)
+            // ===== vertex position =====
+            if (StartsWith(p, lineEnd, "v "))
+            {
+                chunk.positions.push_back(ReadPosition(p, lineEnd));
+            }
+            // ===== vertex normal =====
+            else if (StartsWith(p, lineEnd, "vn "))
             {
-                matched = sscanf_s(
-                    line.c_str(),
-                    "f %d/%*d/%d %d/%*d/%d %d/%*d/%d",
-                    &pi[0], &ni[0],
-                    &pi[1], &ni[1],
-                    &pi[2], &ni[2]
-                );
+                chunk.normals.push_back(ReadNormal(p, lineEnd));
             }
+            // ===== face =====
+            else if (StartsWith(p, lineEnd, "f "))
+            {
+                const uint32_t posCount = (uint32_t)chunk.positions.size();
+                const uint32_t normCount = (uint32_t)chunk.normals.size();
 
-            if (matched != 6)
-                continue;
+                ParseFace(p + 1, lineEnd, [&](const ObjCorner& a, const ObjCorner& b, const ObjCorner& c)
+                    {
+                        chunk.faces.push_back(ObjFace{ { a, b, c }, posCount, normCount });
+                    });
+            }
 
-            for (int i = 0; i < 3; i++)
+            p = (lineEnd < end) ? lineEnd + 1 : end;
+        }
+    }
+
+    // ===== Сварка вершин =====
+    constexpr uint32_t NO_NORMAL = 0xFFFFFFFFu;
+
+    inline uint64_t MakeCornerKey(int posIndex, int normIndex)
+    {
+        return ((uint64_t)(uint32_t)posIndex << 32) | (uint32_t)(normIndex < 0 ? NO_NORMAL : (uint32_t)normIndex);
+    }
+
+    // Открытая адресация: ключ угла -> индекс вершины
+    class CornerTable
+    {
+    public:
+        explicit CornerTable(size_t expected)
+        {
+            size_t capacity = 16;
+            while (capacity < expected * 2)
+                capacity <<= 1;
+
+            mMask = capacity - 1;
+            mKeys.assign(capacity, EMPTY_KEY);
+            mValues.resize(capacity);
+        }
+
+        void Clear()
+        {
+            std::fill(mKeys.begin(), mKeys.end(), EMPTY_KEY);
+        }
+
+        // Возвращает существующий индекс или вставляет value
+        uint32_t FindOrInsert(uint64_t key, uint32_t value)
+        {
+            size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mMask;
+            while (true)
             {
-                int posIndex = pi[i] - 1;
-                int normIndex = ni[i] - 1;
+                if (mKeys[slot] == key)
+                    return mValues[slot];
 
-                if (posIndex < 0 || posIndex >= (int)positions.size())
-                    continue;
+                if (mKeys[slot] == EMPTY_KEY)
+                {
+                    mKeys[slot] = key;
+                    mValues[slot] = value;
+                    return value;
+                }
 
-                Vertex v{};
-                v.position = positions[posIndex];
+                slot = (slot + 1) & mMask;
+            }
+        }
+
+    private:
+        static constexpr uint64_t EMPTY_KEY = ~0ull;
+
+        std::vector<uint64_t> mKeys;
+        std::vector<uint32_t> mValues;
+        size_t mMask = 0;
+    };
+
+    bool ReadWholeFile(const std::string& filename, std::vector<char>& data)
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            return false;
+
+        std::streamsize size = file.tellg();
+        if (size < 0)
+            return false;
+
+        data.resize((size_t)size);
+        file.seekg(0, std::ios::beg);
+        return size == 0 || (bool)file.read(data.data(), size);
+    }
+
+    // Делим [begin; end) на куски, выровненные по концу строки
+    std::vector<ObjChunk> SplitChunks(const char* begin, const char* end, size_t chunkCount)
+    {
+        std::vector<ObjChunk> chunks;
+        chunks.reserve(chunkCount);
+
+        const size_t total = (size_t)(end - begin);
+        const char* p = begin;
+
+        for (size_t i = 0; i < chunkCount && p < end; i++)
+        {
+            const char* target = begin + total * (i + 1) / chunkCount;
+            const char* chunkEnd = (i + 1 == chunkCount) ? end : std::find(std::max(p, target), end, '\n');
+            if (chunkEnd < end)
+                ++chunkEnd;
+
+            ObjChunk chunk;
+            chunk.begin = p;
+            chunk.end = chunkEnd;
+            chunks.push_back(std::move(chunk));
+
+            p = chunkEnd;
+        }
+
+        return chunks;
+    }
+
+    // Результат разбора: уникальные вершины как ключи (позиция, нормаль) и индексы с нуля
+    struct ParsedObj
+    {
+        std::vector<XMFLOAT3> positions;
+        std::vector<XMFLOAT3> normals;
+        std::vector<uint64_t> vertexKeys;
+        std::vector<uint32_t> indices;
+    };
+
+    bool ParseObj(const std::string& filename, const ObjLoadOptions& options, ParsedObj& parsed)
+    {
+        std::vector<char> data;
+        MappedFile mapped;
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        if (options.reader == ObjReader::Mapped)
+        {
+            if (!mapped.Open(filename))
+                return false;
+            begin = mapped.Data();
+            end = begin + mapped.Size();
+        }
+        else
+        {
+            if (!ReadWholeFile(filename, data))
+                return false;
+            begin = data.data();
+            end = begin + data.size();
+        }
+
+        // ===== 1. Параллельный разбор кусков =====
+        size_t threadCount = ResolveThreadCount(options.threadCount);
+
+        size_t chunkCount = std::min(threadCount, (size_t)(end - begin) / MIN_CHUNK_BYTES + 1);
+
+        std::vector<ObjChunk> chunks = SplitChunks(begin, end, chunkCount);
+        ParallelFor(chunks.size(), [&](size_t i) { ParseChunk(chunks[i]); });
+
+        // ===== 2. Последовательно: базы индексов каждого куска =====
+        size_t posTotal = 0;
+        size_t normTotal = 0;
+        for (auto& chunk : chunks)
+        {
+            chunk.posBase = posTotal;
+            chunk.normBase = normTotal;
+            posTotal += chunk.positions.size();
+            normTotal += chunk.normals.size();
+        }
+
+        std::vector<XMFLOAT3>& positions = parsed.positions;
+        std::vector<XMFLOAT3>& normals = parsed.normals;
+        positions.resize(posTotal);
+        normals.resize(normTotal);
 
-                if (!normals.empty() &&
-                    normIndex >= 0 &&
-                    normIndex < (int)normals.size())
+        // ===== 3. Сборка общих массивов и подсчёт вершин =====
+        ParallelFor(chunks.size(), [&](size_t c)
+            {
+                ObjChunk& chunk = chunks[c];
+                std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.posBase);
+                std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normBase);
+
+                // Треугольник с позицией вне границ отбрасывается целиком
+                size_t count = 0;
+                for (const ObjFace& face : chunk.faces)
                 {
-                    v.normal = normals[normIndex];
+                    if (IsFaceValid(face, chunk))
+                        count += 3;
                 }
-                else
+                chunk.cornerCount = count;
+            });
+
+        size_t cornerTotal = 0;
+        for (auto& chunk : chunks)
+        {
+            chunk.cornerBase = cornerTotal;
+            cornerTotal += chunk.cornerCount;
+        }
+
+        // ===== 4. Параллельно: ключ (позиция, нормаль) для каждого угла =====
+        std::vector<uint64_t> corners(cornerTotal);
+
+        ParallelFor(chunks.size(), [&](size_t c)
+            {
+                const ObjChunk& chunk = chunks[c];
+                size_t out = chunk.cornerBase;
+
+                for (const ObjFace& face : chunk.faces)
                 {
-                    v.normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+                    if (!IsFaceValid(face, chunk))
+                        continue;
+
+                    for (const ObjCorner& corner : face.corners)
+                    {
+                        int posIndex = ResolveIndex(corner.pi, chunk.posBase, face.posCount);
+                        int normIndex = ResolveIndex(corner.ni, chunk.normBase, face.normCount);
+
+                        corners[out++] = MakeCornerKey(posIndex, normIndex);
+                    }
                 }
+            });
 
-                v.color = XMFLOAT4(1, 1, 1, 1);
+        // ===== 5. Сварка и индексы =====
+        if (options.weldVertices)
+        {
+            // Одинаковая пара (v, vn) -> одна вершина, порядок первого появления
+            CornerTable table(cornerTotal);
+            parsed.vertexKeys.reserve(std::min(cornerTotal, posTotal * 2));
+            parsed.indices.resize(cornerTotal);
 
-                outVertices.push_back(v);
-                outIndices.push_back((uint32_t)(outVertices.size() - 1));
+            for (size_t i = 0; i < cornerTotal; i++)
+            {
+                uint32_t newIndex = (uint32_t)parsed.vertexKeys.size();
+                uint32_t index = table.FindOrInsert(corners[i], newIndex);
+                if (index == newIndex)
+                    parsed.vertexKeys.push_back(corners[i]);
+
+                parsed.indices[i] = index;
             }
         }
+        else
+        {
+            parsed.vertexKeys = std::move(corners);
+            parsed.indices.resize(cornerTotal);
+            for (size_t i = 0; i < cornerTotal; i++)
+                parsed.indices[i] = (uint32_t)i;
+        }
+
+        return true;
     }
 
-    if (outVertices.empty())
-        return false;
+    inline XMFLOAT3 KeyNormal(const ParsedObj& parsed, uint64_t key)
+    {
+        const uint32_t normIndex = (uint32_t)key;
+        return (normIndex != NO_NORMAL) ? parsed.normals[normIndex] : XMFLOAT3(0.0f, 1.0f, 0.0f);
+    }
 
-    // =====   [-1;1] =====
-    XMFLOAT3 minP = outVertices[0].position;
-    XMFLOAT3 maxP = outVertices[0].position;
+    inline const XMFLOAT3& KeyPosition(const ParsedObj& parsed, uint64_t key)
+    {
+        return parsed.positions[(uint32_t)(key >> 32)];
+    }
+
+    // ===== Потоковый импорт =====
+    // Смещение каждой blockLines-й строки v и vn: значения дочитываются из файла по нему
+    struct ObjLineIndex
+    {
+        std::vector<const char*> positionBlocks;
+        std::vector<const char*> normalBlocks;
+        size_t blockLines = 1;
+    };
 
-    for (const auto& v : outVertices)
+    void BuildLineIndex(const char* begin, const char* end, size_t blockLines, ObjLineIndex& index)
     {
-        minP.x = std::min(minP.x, v.position.x);
-        minP.y = std::min(minP.y, v.position.y);
-        minP.z = std::min(minP.z, v.position.z);
+        index.blockLines = blockLines;
+        size_t posCount = 0;
+        size_t normCount = 0;
+
+        for (const char* p = begin; p < end; )
+        {
+            const char* lineEnd = std::find(p, end, '\n');
 
-        maxP.x = std::max(maxP.x, v.position.x);
-        maxP.y = std::max(maxP.y, v.position.y);
-        maxP.z = std::max(maxP.z, v.position.z);
+            if (StartsWith(p, lineEnd, "v "))
+            {
+                if (posCount++ % blockLines == 0)
+                    index.positionBlocks.push_back(p);
+            }
+            else if (StartsWith(p, lineEnd, "vn "))
+            {
+                if (normCount++ % blockLines == 0)
+                    index.normalBlocks.push_back(p);
+            }
+
+            p = (lineEnd < end) ? lineEnd + 1 : end;
+        }
     }
 
-    XMFLOAT3 center =
+    // line - номер строки v (или vn) в файле, target - номер вершины куска
+    struct ObjLineRequest
     {
-        (minP.x + maxP.x) * 0.5f,
-        (minP.y + maxP.y) * 0.5f,
-        (minP.z + maxP.z) * 0.5f
+        uint32_t line;
+        uint32_t target;
     };
 
-    float maxExtent = std::max(
-        maxP.x - minP.x,
-        std::max(
-            maxP.y - minP.y,
-            maxP.z - minP.z
-        )
-    );
+    // Где остановился прошлый проход по строкам одного префикса: номер строки и её начало.
+    // Следующий сброс куска обычно просит строки дальше в том же блоке - оттуда и продолжаем
+    struct ObjLineCursor
+    {
+        size_t line = 0;
+        const char* p = nullptr;
+    };
 
-    if (maxExtent > 0.0f)
+    // Значения строк с префиксом prefix для всех запросов: сортировка по номеру строки,
+    // затем последовательный проход внутри каждого затронутого блока индекса - с его начала
+    // или с курсора, если тот в этом блоке и не дальше первого запроса
+    template<typename Store>
+    void FetchLines(
+        const std::vector<const char*>& blocks,
+        size_t blockLines,
+        const char* end,
+        const char* prefix,
+        XMFLOAT3 (*read)(const char*, const char*),
+        std::vector<ObjLineRequest>& requests,
+        ObjLineCursor& cursor,
+        Store&& store)
     {
-        float scale = OBJ_SCALE / maxExtent;
+        std::sort(requests.begin(), requests.end(),
+            [](const ObjLineRequest& a, const ObjLineRequest& b) { return a.line < b.line; });
 
-        for (auto& v : outVertices)
+        size_t r = 0;
+        while (r < requests.size())
         {
-            v.position.x = (v.position.x - center.x) * scale;
-            v.position.y = (v.position.y - center.y) * scale;
-            v.position.z = (v.position.z - center.z) * scale;
+            const size_t block = requests[r].line / blockLines;
+            const char* p = blocks[block];
+            size_t line = block * blockLines;
+            if (cursor.p && cursor.line / blockLines == block && cursor.line <= requests[r].line)
+            {
+                p = cursor.p;
+                line = cursor.line;
+            }
+
+            while (p < end && r < requests.size() && requests[r].line / blockLines == block)
+            {
+                const char* lineEnd = std::find(p, end, '\n');
+                if (StartsWith(p, lineEnd, prefix))
+                {
+                    if (requests[r].line == line)
+                    {
+                        const XMFLOAT3 value = read(p, lineEnd);
+                        for (; r < requests.size() && requests[r].line == line; r++)
+                            store(requests[r].target, value);
+                    }
+                    line++;
+                }
+                p = (lineEnd < end) ? lineEnd + 1 : end;
+            }
+            cursor = { line, p };
+
+            // Номера проверены по счётчикам строк, так что конец файла - только после последнего
+            if (p >= end)
+                break;
         }
     }
 
+    // Треугольники граней в порядке файла: ключи (позиция, нормаль) углов, как в ParseObj.
+    // Треугольник с позицией вне границ пропускается; emit возвращает false, чтобы остановиться
+    template<typename Emit>
+    void ForEachTriangle(const char* begin, const char* end, Emit&& emit)
+    {
+        uint32_t posCount = 0;
+        uint32_t normCount = 0;
+        bool keepGoing = true;
+
+        for (const char* p = begin; p < end && keepGoing; )
+        {
+            const char* lineEnd = std::find(p, end, '\n');
+
+            if (StartsWith(p, lineEnd, "v "))
+                posCount++;
+            else if (StartsWith(p, lineEnd, "vn "))
+                normCount++;
+            else if (StartsWith(p, lineEnd, "f "))
+            {
+                ParseFace(p + 1, lineEnd, [&](const ObjCorner& a, const ObjCorner& b, const ObjCorner& c)
+                    {
+                        const ObjCorner* corners[3] = { &a, &b, &c };
+                        uint64_t keys[3];
+
+                        for (int i = 0; i < 3; i++)
+                        {
+                            int posIndex = ResolveIndex(corners[i]->pi, 0, posCount);
+                            if (posIndex < 0)
+                                return;
+                            keys[i] = MakeCornerKey(posIndex, ResolveIndex(corners[i]->ni, 0, normCount));
+                        }
+
+                        if (keepGoing)
+                            keepGoing = emit(keys);
+                    });
+            }
+
+            p = (lineEnd < end) ? lineEnd + 1 : end;
+        }
+    }
+}
+
+bool LoadOBJ(
+    const std::string& filename,
+    std::vector<Vertex>& outVertices,
+    std::vector<uint32_t>& outIndices)
+{
+    return LoadOBJ(filename, outVertices, outIndices, ObjLoadOptions{});
+}
+
+bool LoadOBJ(
+    const std::string& filename,
+    std::vector<Vertex>& outVertices,
+    std::vector<uint32_t>& outIndices,
+    const ObjLoadOptions& options)
+{
+    ParsedObj parsed;
+    if (!ParseObj(filename, options, parsed))
+        return false;
+
+    // ===== Запись вершин и индексов =====
+    const size_t firstVertex = outVertices.size();
+    const size_t firstIndex = outIndices.size();
+    outVertices.resize(firstVertex + parsed.vertexKeys.size());
+    outIndices.resize(firstIndex + parsed.indices.size());
+
+    ParallelForRange(parsed.vertexKeys.size(), MIN_FILL_ITEMS, options.threadCount,
+        [&](size_t, size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                Vertex v{};
+                v.position = KeyPosition(parsed, parsed.vertexKeys[i]);
+                v.normal = KeyNormal(parsed, parsed.vertexKeys[i]);
+                v.color = XMFLOAT4(1, 1, 1, 1);
+                outVertices[firstVertex + i] = v;
+            }
+        });
+
+    for (size_t i = 0; i < parsed.indices.size(); i++)
+        outIndices[firstIndex + i] = (uint32_t)firstVertex + parsed.indices[i];
+
+    if (outVertices.empty())
+        return false;
+
+    // ===== НОРМАЛИЗАЦИЯ В [-1;1] =====
+    NormalizeMesh(outVertices.data(), outVertices.size(), OBJ_SCALE, options.threadCount);
+
+    return true;
+}
+
+bool LoadOBJ(
+    const std::string& filename,
+    MeshStreams& outMesh,
+    const ObjLoadOptions& options)
+{
+    ParsedObj parsed;
+    if (!ParseObj(filename, options, parsed))
+        return false;
+
+    // Цвет в OBJ не задаётся - поток цветов остаётся пустым
+    const size_t vertexCount = parsed.vertexKeys.size();
+    outMesh.positions.resize(vertexCount);
+    outMesh.normals.resize(vertexCount);
+    outMesh.colors.clear();
+    outMesh.indices = std::move(parsed.indices);
+
+    ParallelForRange(vertexCount, MIN_FILL_ITEMS, options.threadCount,
+        [&](size_t, size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                outMesh.positions[i] = KeyPosition(parsed, parsed.vertexKeys[i]);
+                outMesh.normals[i] = KeyNormal(parsed, parsed.vertexKeys[i]);
+            }
+        });
+
+    if (vertexCount == 0)
+        return false;
+
+    NormalizeMesh(outMesh.positions.data(), vertexCount, OBJ_SCALE, options.threadCount);
+    return true;
+}
+
+bool LoadOBJStreamed(
+    const std::string& filename,
+    const ObjStreamOptions& options,
+    const ObjChunkCallback& onChunk)
+{
+    MappedFile file;
+    if (!file.Open(filename))
+        return false;
+
+    const char* begin = file.Data();
+    const char* end = begin + file.Size();
+
+    const size_t maxVertices = std::max<size_t>(options.maxChunkVertices, 3);
+    const size_t maxIndices = std::max<size_t>(options.maxChunkIndices, 3);
+
+    // ===== 1. Индекс строк v/vn вместо самих позиций и нормалей =====
+    ObjLineIndex lineIndex;
+    BuildLineIndex(begin, end, std::max<size_t>(options.indexBlockLines, 1), lineIndex);
+
+    // ===== 2. Габариты позиций, на которые ссылаются грани (как у NormalizeMesh в LoadOBJ) =====
+    //    Лишний проход по граням - цена памяти: позиции не держатся, габариты нужны до первого куска.
+    //    Позиция в запросах один раз до сброса: min/max от повторов не меняется
+    std::vector<ObjLineRequest> requests;
+    requests.reserve(maxVertices);
+    ObjLineCursor positionCursor, normalCursor;
+    CornerTable table(maxVertices);
+
+    XMFLOAT3 minP = { FLT_MAX, FLT_MAX, FLT_MAX };
+    XMFLOAT3 maxP = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    bool anyTriangle = false;
+
+    auto flushBounds = [&]()
+        {
+            FetchLines(lineIndex.positionBlocks, lineIndex.blockLines, end, "v ", ReadPosition, requests,
+                positionCursor, [&](uint32_t, const XMFLOAT3& pos)
+                {
+                    minP.x = std::min(minP.x, pos.x);
+                    minP.y = std::min(minP.y, pos.y);
+                    minP.z = std::min(minP.z, pos.z);
+
+                    maxP.x = std::max(maxP.x, pos.x);
+                    maxP.y = std::max(maxP.y, pos.y);
+                    maxP.z = std::max(maxP.z, pos.z);
+                });
+            requests.clear();
+            table.Clear();
+        };
+
+    ForEachTriangle(begin, end, [&](const uint64_t* keys)
+        {
+            if (requests.size() + 3 > maxVertices)
+                flushBounds();
+
+            for (int i = 0; i < 3; i++)
+            {
+                const uint32_t line = (uint32_t)(keys[i] >> 32);
+                if (table.FindOrInsert(line, (uint32_t)requests.size()) == requests.size())
+                    requests.push_back({ line, 0 });
+            }
+
+            anyTriangle = true;
+            return true;
+        });
+    flushBounds();
+
+    if (!anyTriangle)
+        return false;
+
+    const MeshNormalization normalization = ComputeMeshNormalization(minP, maxP, OBJ_SCALE);
+    table.Clear();
+
+    // ===== 3. Грани -> куски фиксированного размера =====
+    std::vector<uint64_t> vertexKeys;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    vertexKeys.reserve(maxVertices);
+    vertices.reserve(maxVertices);
+    indices.reserve(maxIndices);
+
+    ObjMeshChunk chunk{};
+    bool keepGoing = true;
+
+    auto flush = [&]()
+        {
+            if (indices.empty())
+                return;
+
+            // Позиции и нормали вершин куска дочитываются из файла
+            vertices.resize(vertexKeys.size());
+
+            requests.clear();
+            for (size_t i = 0; i < vertexKeys.size(); i++)
+                requests.push_back({ (uint32_t)(vertexKeys[i] >> 32), (uint32_t)i });
+            FetchLines(lineIndex.positionBlocks, lineIndex.blockLines, end, "v ", ReadPosition, requests,
+                positionCursor, [&](uint32_t target, const XMFLOAT3& pos)
+                {
+                    vertices[target].position = normalization.Apply(pos);
+                });
+
+            requests.clear();
+            for (size_t i = 0; i < vertexKeys.size(); i++)
+            {
+                const uint32_t normIndex = (uint32_t)vertexKeys[i];
+                if (normIndex != NO_NORMAL)
+                    requests.push_back({ normIndex, (uint32_t)i });
+                else
+                    vertices[i].normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+                vertices[i].color = XMFLOAT4(1, 1, 1, 1);
+            }
+            FetchLines(lineIndex.normalBlocks, lineIndex.blockLines, end, "vn ", ReadNormal, requests,
+                normalCursor, [&](uint32_t target, const XMFLOAT3& normal) { vertices[target].normal = normal; });
+            requests.clear();
+
+            chunk.vertices = vertices.data();
+            chunk.vertexCount = vertices.size();
+            chunk.indices = indices.data();
+            chunk.indexCount = indices.size();
+
+            keepGoing = onChunk(chunk);
+            chunk.chunkIndex++;
+
+            vertexKeys.clear();
+            vertices.clear();
+            indices.clear();
+            table.Clear();
+        };
+
+    ForEachTriangle(begin, end, [&](const uint64_t* keys)
+        {
+            if (vertexKeys.size() + 3 > maxVertices || indices.size() + 3 > maxIndices)
+                flush();
+            if (!keepGoing)
+                return false;
+
+            for (int i = 0; i < 3; i++)
+            {
+                uint32_t newIndex = (uint32_t)vertexKeys.size();
+                uint32_t index = table.FindOrInsert(keys[i], newIndex);
+                if (index == newIndex)
+                    vertexKeys.push_back(keys[i]);
+                indices.push_back(index);
+            }
+            return true;
+        });
+
+    if (keepGoing)
+        flush();
+
     return true;
-}
\ No newline at end of file
+}
@@ -1,12 +1,80 @@
-#pragma once
+﻿#pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <functional>
 #include <DirectXMath.h>
 
 struct Vertex;
+struct MeshStreams;
+
+// Способ чтения файла
+enum class ObjReader
+{
+    Stream,  // std::ifstream в буфер
+    Mapped   // отображение файла в память, разбор прямо из него
+};
+
+// Параметры импорта OBJ
+struct ObjLoadOptions
+{
+    ObjReader reader = ObjReader::Mapped;
+
+    // Число потоков разбора (0 = по числу ядер)
+    unsigned threadCount = 0;
+
+    // Сваривать одинаковые углы (v, vn) в одну вершину с общими индексами.
+    // false - как раньше: своя вершина на каждый угол, индексы 0,1,2,3...
+    bool weldVertices = true;
+};
 
 bool LoadOBJ(
     const std::string& filename,
     std::vector<Vertex>& outVertices,
     std::vector<uint32_t>& outIndices
+);
+
+bool LoadOBJ(
+    const std::string& filename,
+    std::vector<Vertex>& outVertices,
+    std::vector<uint32_t>& outIndices,
+    const ObjLoadOptions& options
+);
+
+// То же, но в раздельные потоки атрибутов (без мёртвого канала цвета)
+bool LoadOBJ(
+    const std::string& filename,
+    MeshStreams& outMesh,
+    const ObjLoadOptions& options = ObjLoadOptions{}
+);
+
+// ===== Потоковый импорт =====
+// Кусок меша со своими локальными индексами; данные валидны только внутри колбэка
+struct ObjMeshChunk
+{
+    const Vertex* vertices;
+    size_t vertexCount;
+    const uint32_t* indices;
+    size_t indexCount;
+    size_t chunkIndex;
+};
+
+// Память на кусок ограничена этими числами. Позиции и нормали файла в памяти не держатся:
+// от них остаётся только смещение каждой indexBlockLines-й строки v/vn, а значения
+// для куска дочитываются из файла по этому индексу (8 байт на indexBlockLines строк).
+// Вершины нормализуются так же, как в LoadOBJ, - по габаритам позиций, на которые ссылаются грани
+struct ObjStreamOptions
+{
+    size_t maxChunkVertices = 64 * 1024;
+    size_t maxChunkIndices = 3 * 64 * 1024;
+    size_t indexBlockLines = 1024;
+};
+
+// Возврат false из колбэка прекращает импорт
+using ObjChunkCallback = std::function<bool(const ObjMeshChunk&)>;
+
+bool LoadOBJStreamed(
+    const std::string& filename,
+    const ObjStreamOptions& options,
+    const ObjChunkCallback& onChunk
 );
\ No newline at end of file
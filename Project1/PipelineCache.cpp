@@ -0,0 +1,376 @@
+﻿#include "PipelineCache.h"
+#include "MeshCache.h"
+#include "MappedFile.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    // Поля описания по одному в байтовый поток: у структур есть выравнивание и указатели
+    class KeyWriter
+    {
+    public:
+        void Put(uint64_t value) { Append(&value, sizeof(value)); }
+        void Put(uint32_t value) { Append(&value, sizeof(value)); }
+
+        void PutSemantic(const std::string& semantic)
+        {
+            Put((uint32_t)semantic.size());
+            for (char c : semantic)
+                mBytes.push_back((uint8_t)std::toupper((unsigned char)c));
+        }
+
+        uint64_t Hash() const { return HashBytes(mBytes.data(), mBytes.size()); }
+
+    private:
+        void Append(const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            mBytes.insert(mBytes.end(), bytes, bytes + size);
+        }
+
+        std::vector<uint8_t> mBytes;
+    };
+}
+
+ShaderRef MakeShaderRef(const void* data, size_t size)
+{
+    ShaderRef ref;
+    ref.data = data;
+    ref.size = size;
+    ref.hash = data ? HashBytes(data, size) : 0;
+    return ref;
+}
+
+uint64_t HashPipelineDesc(const PipelineDesc& desc)
+{
+    KeyWriter key;
+    key.Put(desc.vs.hash);
+    key.Put((uint64_t)desc.vs.size);
+    key.Put(desc.ps.hash);
+    key.Put((uint64_t)desc.ps.size);
+    key.Put(desc.rootSignatureKey);
+
+    key.Put((uint32_t)desc.inputLayout.size());
+    for (const PipelineInputElement& e : desc.inputLayout)
+    {
+        key.PutSemantic(e.semantic);
+        key.Put(e.semanticIndex);
+        key.Put(e.format);
+        key.Put(e.slot);
+        key.Put(e.offset);
+        key.Put((uint32_t)e.perInstance);
+        key.Put(e.perInstance ? e.stepRate : 0u);
+    }
+
+    key.Put((uint32_t)desc.fill);
+    key.Put((uint32_t)desc.cull);
+    key.Put((uint32_t)desc.frontCounterClockwise);
+    key.Put((uint32_t)desc.depthBias);
+    key.Put((uint32_t)desc.blend);
+    key.Put((uint32_t)desc.depth);
+
+    key.Put(desc.topologyType);
+    uint32_t rtCount = desc.renderTargetCount < PipelineDesc::MAX_RENDER_TARGETS
+        ? desc.renderTargetCount : PipelineDesc::MAX_RENDER_TARGETS;
+    key.Put(rtCount);
+    for (uint32_t i = 0; i < rtCount; i++)
+        key.Put(desc.rtvFormats[i]);
+    key.Put(desc.dsvFormat);
+    key.Put(desc.sampleCount);
+
+    return key.Hash();
+}
+
+PipelineLookup PipelineCache::Find(uint64_t key)
+{
+    mStats.lookups++;
+
+    PipelineLookup result;
+    auto it = mIndices.find(key);
+    if (it != mIndices.end())
+    {
+        mStats.hits++;
+        result.index = it->second;
+        return result;
+    }
+
+    mStats.misses++;
+    result.index = (uint32_t)mIndices.size();
+    result.isNew = true;
+    mIndices.emplace(key, result.index);
+
+    auto blob = mBlobs.find(key);
+    if (blob != mBlobs.end())
+    {
+        mStats.blobHits++;
+        result.blob = &blob->second;
+    }
+    return result;
+}
+
+void PipelineCache::StoreBlob(uint64_t key, const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    std::vector<uint8_t>& blob = mBlobs[key];
+    if (blob.size() == size && memcmp(blob.data(), bytes, size) == 0)
+        return;
+
+    blob.assign(bytes, bytes + size);
+    mDirty = true;
+}
+
+void PipelineCache::RejectBlob(uint64_t key)
+{
+    if (mBlobs.erase(key))
+    {
+        mStats.blobRejected++;
+        mDirty = true;
+    }
+}
+
+bool PipelineCache::Load(const std::string& path, uint64_t deviceFingerprint)
+{
+    Clear();
+
+    MappedFile file;
+    if (!file.Open(path) || file.Size() < sizeof(PipelineCacheHeader))
+        return false;
+
+    PipelineCacheHeader header;
+    memcpy(&header, file.Data(), sizeof(header));
+    if (header.magic != PIPELINE_CACHE_MAGIC ||
+        header.version != PIPELINE_CACHE_VERSION ||
+        header.deviceFingerprint != deviceFingerprint)
+        return false;
+
+    // Обрезанный или испорченный файл: берём только целые записи до места ошибки
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.entryCount; i++)
+    {
+        uint64_t entry[2];  // key, size
+        if (file.Size() - offset < sizeof(entry))
+            break;
+        memcpy(entry, file.Data() + offset, sizeof(entry));
+        offset += sizeof(entry);
+
+        if (entry[1] > file.Size() - offset)
+            break;
+
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(file.Data() + offset);
+        mBlobs[entry[0]].assign(bytes, bytes + entry[1]);
+        offset += (size_t)entry[1];
+    }
+
+    mDirty = mBlobs.size() != header.entryCount;
+    return true;
+}
+
+bool PipelineCache::Save(const std::string& path, uint64_t deviceFingerprint)
+{
+    PipelineCacheHeader header{};
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.version = PIPELINE_CACHE_VERSION;
+    header.deviceFingerprint = deviceFingerprint;
+    header.entryCount = (uint32_t)mBlobs.size();
+
+    // Как WriteMeshCache: временный файл и переименование
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& blob : mBlobs)
+        {
+            const uint64_t entry[2] = { blob.first, (uint64_t)blob.second.size() };
+            file.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+            file.write(reinterpret_cast<const char*>(blob.second.data()), blob.second.size());
+        }
+
+        if (!file)
+            return false;
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        return false;
+
+    mDirty = false;
+    return true;
+}
+
+void PipelineCache::Clear()
+{
+    mIndices.clear();
+    mBlobs.clear();
+    mStats = PipelineCacheStats();
+    mDirty = false;
+}
+
+#ifdef _WIN32
+uint64_t AdapterFingerprint(IDXGIAdapter* adapter)
+{
+    DXGI_ADAPTER_DESC desc = {};
+    adapter->GetDesc(&desc);
+
+    LARGE_INTEGER umdVersion = {};
+    adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umdVersion);
+
+    const uint64_t words[] = {
+        desc.VendorId, desc.DeviceId, desc.SubSysId, desc.Revision, (uint64_t)umdVersion.QuadPart
+    };
+    return HashBytes(words, sizeof(words));
+}
+
+namespace
+{
+    D3D12_RASTERIZER_DESC ToD3D12Rasterizer(const PipelineDesc& desc)
+    {
+        D3D12_RASTERIZER_DESC r = {};
+        r.FillMode = desc.fill == FillMode::Wireframe ? D3D12_FILL_MODE_WIREFRAME : D3D12_FILL_MODE_SOLID;
+        r.CullMode = desc.cull == CullMode::None ? D3D12_CULL_MODE_NONE
+            : desc.cull == CullMode::Front ? D3D12_CULL_MODE_FRONT : D3D12_CULL_MODE_BACK;
+        r.FrontCounterClockwise = desc.frontCounterClockwise;
+        r.DepthBias = desc.depthBias;
+        r.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
+        r.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
+        r.DepthClipEnable = TRUE;
+        r.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+        return r;
+    }
+
+    D3D12_BLEND_DESC ToD3D12Blend(const PipelineDesc& desc)
+    {
+        D3D12_RENDER_TARGET_BLEND_DESC rt = {};
+        rt.BlendEnable = desc.blend != BlendMode::Opaque;
+        rt.SrcBlend = desc.blend == BlendMode::Alpha ? D3D12_BLEND_SRC_ALPHA : D3D12_BLEND_ONE;
+        rt.DestBlend = desc.blend == BlendMode::Alpha ? D3D12_BLEND_INV_SRC_ALPHA
+            : desc.blend == BlendMode::Additive ? D3D12_BLEND_ONE : D3D12_BLEND_ZERO;
+        rt.BlendOp = D3D12_BLEND_OP_ADD;
+        rt.SrcBlendAlpha = D3D12_BLEND_ONE;
+        rt.DestBlendAlpha = D3D12_BLEND_ZERO;
+        rt.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+        rt.LogicOp = D3D12_LOGIC_OP_NOOP;
+        rt.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+
+        D3D12_BLEND_DESC b = {};
+        for (UINT i = 0; i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+            b.RenderTarget[i] = rt;
+        return b;
+    }
+
+    D3D12_DEPTH_STENCIL_DESC ToD3D12DepthStencil(const PipelineDesc& desc)
+    {
+        D3D12_DEPTH_STENCIL_DESC d = {};
+        d.DepthEnable = desc.depth != DepthMode::Disabled;
+        d.DepthWriteMask = desc.depth == DepthMode::ReadWrite
+            ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+        d.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+        d.StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
+        d.StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
+        const D3D12_DEPTH_STENCILOP_DESC keep =
+        { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+        d.FrontFace = keep;
+        d.BackFace = keep;
+        return d;
+    }
+}
+
+bool D3D12PipelineCache::Initialize(ID3D12Device* device, const std::string& path, uint64_t deviceFingerprint)
+{
+    mDevice = device;
+    mPath = path;
+    mFingerprint = deviceFingerprint;
+    mPipelines.clear();
+
+    // Нет файла - первый запуск, это не ошибка
+    mCache.Load(mPath, mFingerprint);
+    return true;
+}
+
+void D3D12PipelineCache::Shutdown()
+{
+    if (mDevice && mCache.IsDirty())
+        Save();
+
+    mPipelines.clear();
+    mCache.Clear();
+    mDevice = nullptr;
+}
+
+bool D3D12PipelineCache::Save()
+{
+    return mCache.Save(mPath, mFingerprint);
+}
+
+ID3D12PipelineState* D3D12PipelineCache::Get(const PipelineDesc& desc, ID3D12RootSignature* rootSignature)
+{
+    const uint64_t key = HashPipelineDesc(desc);
+    PipelineLookup lookup = mCache.Find(key);
+    if (!lookup.isNew)
+        return mPipelines[lookup.index].Get();
+
+    mPipelines.resize(lookup.index + 1);
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>& pso = mPipelines[lookup.index];
+
+    HRESULT hr = Create(desc, rootSignature, lookup.blob, pso);
+    if (FAILED(hr) && lookup.blob)
+    {
+        // D3D12_ERROR_DRIVER_VERSION_MISMATCH и т.п.: блоб устарел, компилируем заново
+        mCache.RejectBlob(key);
+        hr = Create(desc, rootSignature, nullptr, pso);
+    }
+    if (FAILED(hr))
+        return nullptr;
+
+    Microsoft::WRL::ComPtr<ID3DBlob> blob;
+    if (SUCCEEDED(pso->GetCachedBlob(&blob)))
+        mCache.StoreBlob(key, blob->GetBufferPointer(), blob->GetBufferSize());
+
+    return pso.Get();
+}
+
+HRESULT D3D12PipelineCache::Create(const PipelineDesc& desc, ID3D12RootSignature* rootSignature,
+    const std::vector<uint8_t>* blob, Microsoft::WRL::ComPtr<ID3D12PipelineState>& out)
+{
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout(desc.inputLayout.size());
+    for (size_t i = 0; i < inputLayout.size(); i++)
+    {
+        const PipelineInputElement& e = desc.inputLayout[i];
+        inputLayout[i].SemanticName = e.semantic.c_str();
+        inputLayout[i].SemanticIndex = e.semanticIndex;
+        inputLayout[i].Format = (DXGI_FORMAT)e.format;
+        inputLayout[i].InputSlot = e.slot;
+        inputLayout[i].AlignedByteOffset = e.offset;
+        inputLayout[i].InputSlotClass = e.perInstance
+            ? D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA : D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+        inputLayout[i].InstanceDataStepRate = e.perInstance ? e.stepRate : 0;
+    }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.VS = { desc.vs.data, desc.vs.size };
+    psoDesc.PS = { desc.ps.data, desc.ps.size };
+    psoDesc.InputLayout = { inputLayout.data(), (UINT)inputLayout.size() };
+    psoDesc.pRootSignature = rootSignature;
+    psoDesc.RasterizerState = ToD3D12Rasterizer(desc);
+    psoDesc.BlendState = ToD3D12Blend(desc);
+    psoDesc.DepthStencilState = ToD3D12DepthStencil(desc);
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.PrimitiveTopologyType = (D3D12_PRIMITIVE_TOPOLOGY_TYPE)desc.topologyType;
+    psoDesc.NumRenderTargets = desc.renderTargetCount;
+    for (UINT i = 0; i < desc.renderTargetCount && i < PipelineDesc::MAX_RENDER_TARGETS; i++)
+        psoDesc.RTVFormats[i] = (DXGI_FORMAT)desc.rtvFormats[i];
+    psoDesc.DSVFormat = (DXGI_FORMAT)desc.dsvFormat;
+    psoDesc.SampleDesc.Count = desc.sampleCount;
+
+    if (blob)
+        psoDesc.CachedPSO = { blob->data(), blob->size() };
+
+    return mDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&out));
+}
+#endif
@@ -0,0 +1,158 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <d3d12.h>
+#include <dxgi.h>
+#include <wrl/client.h>
+#endif
+
+// ===== Нормализованное описание PSO =====
+// Только то, что влияет на результат: байткод по содержимому, состояния перечислениями,
+// форматы числами DXGI_FORMAT. Одинаковые описания дают один ключ независимо от адресов
+
+enum class FillMode : uint8_t { Solid, Wireframe };
+enum class CullMode : uint8_t { None, Front, Back };
+enum class BlendMode : uint8_t { Opaque, Alpha, Additive };
+enum class DepthMode : uint8_t { ReadWrite, ReadOnly, Disabled };
+
+// Байткод шейдера и его хэш (считается один раз, а не на каждый поиск)
+struct ShaderRef
+{
+    const void* data = nullptr;
+    size_t size = 0;
+    uint64_t hash = 0;
+};
+
+ShaderRef MakeShaderRef(const void* data, size_t size);
+
+struct PipelineInputElement
+{
+    std::string semantic;
+    uint32_t semanticIndex = 0;
+    uint32_t format = 0;          // DXGI_FORMAT
+    uint32_t slot = 0;
+    uint32_t offset = 0;
+    bool perInstance = false;
+    uint32_t stepRate = 0;
+};
+
+struct PipelineDesc
+{
+    static constexpr uint32_t MAX_RENDER_TARGETS = 8;
+
+    ShaderRef vs;
+    ShaderRef ps;
+    uint64_t rootSignatureKey = 0;   // RootSignatureBuilder::Hash()
+    std::vector<PipelineInputElement> inputLayout;
+
+    FillMode fill = FillMode::Solid;
+    CullMode cull = CullMode::Back;
+    bool frontCounterClockwise = false;
+    int32_t depthBias = 0;
+    BlendMode blend = BlendMode::Opaque;
+    DepthMode depth = DepthMode::ReadWrite;
+
+    uint32_t topologyType = 3;       // D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE
+    uint32_t renderTargetCount = 1;
+    uint32_t rtvFormats[MAX_RENDER_TARGETS] = {};
+    uint32_t dsvFormat = 0;
+    uint32_t sampleCount = 1;
+};
+
+// Ключ кэша. Нормализация: семантики без учёта регистра (как в HLSL),
+// форматы за пределами renderTargetCount не учитываются
+uint64_t HashPipelineDesc(const PipelineDesc& desc);
+
+// ===== Поиск и хранение блобов =====
+// Без D3D12: ключ -> индекс объекта (создаётся один раз) и блоб драйвера для диска.
+// Файл: [PipelineCacheHeader][key, size, bytes] * count
+struct PipelineCacheStats
+{
+    uint32_t lookups = 0;
+    uint32_t hits = 0;          // объект уже был создан
+    uint32_t misses = 0;        // новый ключ - объект надо создать
+    uint32_t blobHits = 0;      // новый ключ, но блоб есть с прошлого запуска
+    uint32_t blobRejected = 0;  // драйвер не принял блоб (другой драйвер/адаптер)
+};
+
+struct PipelineLookup
+{
+    uint32_t index = 0;
+    bool isNew = false;                          // вызывающий создаёт объект под index
+    const std::vector<uint8_t>* blob = nullptr;  // только при isNew
+};
+
+struct PipelineCacheHeader
+{
+    uint32_t magic;             // PIPELINE_CACHE_MAGIC
+    uint32_t version;           // PIPELINE_CACHE_VERSION
+    uint64_t deviceFingerprint; // адаптер и версия драйвера: блобы от другого не годятся
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x434F5350;  // "PSOC"
+constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+
+class PipelineCache
+{
+public:
+    PipelineLookup Find(uint64_t key);
+    PipelineLookup Find(const PipelineDesc& desc) { return Find(HashPipelineDesc(desc)); }
+
+    // Блоб созданного объекта; пишется на диск при Save
+    void StoreBlob(uint64_t key, const void* data, size_t size);
+    // Блоб не подошёл драйверу: выбрасываем, объект создаётся с нуля
+    void RejectBlob(uint64_t key);
+
+    // Файла нет или он от другого устройства - кэш просто пуст
+    bool Load(const std::string& path, uint64_t deviceFingerprint);
+    bool Save(const std::string& path, uint64_t deviceFingerprint);
+
+    bool IsDirty() const { return mDirty; }
+    size_t PipelineCount() const { return mIndices.size(); }
+    size_t BlobCount() const { return mBlobs.size(); }
+    const PipelineCacheStats& GetStats() const { return mStats; }
+
+    void Clear();
+
+private:
+    std::unordered_map<uint64_t, uint32_t> mIndices;
+    std::unordered_map<uint64_t, std::vector<uint8_t>> mBlobs;
+    PipelineCacheStats mStats;
+    bool mDirty = false;
+};
+
+#ifdef _WIN32
+// Адаптер + версия UMD-драйвера
+uint64_t AdapterFingerprint(IDXGIAdapter* adapter);
+
+// Ленивое создание PSO: первый Get с описанием создаёт объект (с блобом с диска, если есть),
+// дальше - поиск по ключу. Shutdown сохраняет новые блобы
+class D3D12PipelineCache
+{
+public:
+    bool Initialize(ID3D12Device* device, const std::string& path, uint64_t deviceFingerprint);
+    void Shutdown();
+    bool Save();
+
+    // nullptr, если создать не удалось (повторно не пытается)
+    ID3D12PipelineState* Get(const PipelineDesc& desc, ID3D12RootSignature* rootSignature);
+
+    const PipelineCacheStats& GetStats() const { return mCache.GetStats(); }
+
+private:
+    HRESULT Create(const PipelineDesc& desc, ID3D12RootSignature* rootSignature,
+        const std::vector<uint8_t>* blob, Microsoft::WRL::ComPtr<ID3D12PipelineState>& out);
+
+    ID3D12Device* mDevice = nullptr;
+    std::string mPath;
+    uint64_t mFingerprint = 0;
+    PipelineCache mCache;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12PipelineState>> mPipelines;
+};
+#endif
@@ -0,0 +1,177 @@
+﻿#include "QuantizedVertex.h"
+#include "MeshStreams.h"
+#include "MeshBounds.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    inline uint16_t ToUnorm16(float v)
+    {
+        v = std::min(std::max(v, 0.0f), 1.0f);
+        return (uint16_t)std::lround(v * 65535.0f);
+    }
+
+    inline int16_t ToSnorm16(float v)
+    {
+        v = std::min(std::max(v, -1.0f), 1.0f);
+        return (int16_t)std::lround(v * 32767.0f);
+    }
+
+    // Как DXGI: -32768 и -32767 оба дают -1
+    inline float FromSnorm16(int16_t v)
+    {
+        return std::max((float)v / 32767.0f, -1.0f);
+    }
+
+    inline uint8_t ToUnorm8(float v)
+    {
+        v = std::min(std::max(v, 0.0f), 1.0f);
+        return (uint8_t)std::lround(v * 255.0f);
+    }
+
+    inline float SignNotZero(float v)
+    {
+        return (v >= 0.0f) ? 1.0f : -1.0f;
+    }
+}
+
+uint32_t EncodeOctahedral(const XMFLOAT3& normal)
+{
+    float l1 = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (l1 <= 0.0f)
+        return EncodeOctahedral(XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+    float x = normal.x / l1;
+    float y = normal.y / l1;
+
+    // Нижняя полусфера отражается на углы квадрата
+    if (normal.z < 0.0f)
+    {
+        float ox = (1.0f - std::fabs(y)) * SignNotZero(x);
+        float oy = (1.0f - std::fabs(x)) * SignNotZero(y);
+        x = ox;
+        y = oy;
+    }
+
+    return (uint32_t)(uint16_t)ToSnorm16(x) | ((uint32_t)(uint16_t)ToSnorm16(y) << 16);
+}
+
+XMFLOAT3 DecodeOctahedral(uint32_t packed)
+{
+    float x = FromSnorm16((int16_t)(packed & 0xFFFF));
+    float y = FromSnorm16((int16_t)(packed >> 16));
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+    float t = std::max(-z, 0.0f);
+    x += (x >= 0.0f) ? -t : t;
+    y += (y >= 0.0f) ? -t : t;
+
+    float len = std::sqrt(x * x + y * y + z * z);
+    return XMFLOAT3(x / len, y / len, z / len);
+}
+
+bool QuantizeMesh(const MeshStreams& mesh, bool withColor, QuantizedMesh& outMesh)
+{
+    if (!QuantizeMesh(mesh.positions.data(), mesh.normals.empty() ? nullptr : mesh.normals.data(),
+        mesh.colors.empty() ? nullptr : mesh.colors.data(), mesh.VertexCount(), withColor, outMesh))
+        return false;
+
+    outMesh.indices = mesh.indices;
+    return true;
+}
+
+bool QuantizeMesh(
+    const XMFLOAT3* positions,
+    const XMFLOAT3* normals,
+    const XMFLOAT4* colors,
+    size_t count,
+    bool withColor,
+    QuantizedMesh& outMesh)
+{
+    if (count == 0)
+        return false;
+
+    BoundingBox bounds = ComputeMeshBounds(positions, count);
+    XMFLOAT3 minP =
+    {
+        bounds.Center.x - bounds.Extents.x,
+        bounds.Center.y - bounds.Extents.y,
+        bounds.Center.z - bounds.Extents.z
+    };
+    XMFLOAT3 size = { bounds.Extents.x * 2.0f, bounds.Extents.y * 2.0f, bounds.Extents.z * 2.0f };
+
+    outMesh.hasColor = withColor;
+    outMesh.stride = withColor ? 16 : 12;
+    outMesh.positionScale = size;
+    outMesh.positionOffset = minP;
+    outMesh.indices.clear();
+    outMesh.vertexData.assign(count * outMesh.stride, 0);
+
+    const float invX = (size.x > 0.0f) ? 1.0f / size.x : 0.0f;
+    const float invY = (size.y > 0.0f) ? 1.0f / size.y : 0.0f;
+    const float invZ = (size.z > 0.0f) ? 1.0f / size.z : 0.0f;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t* dst = outMesh.vertexData.data() + i * outMesh.stride;
+
+        const XMFLOAT3& p = positions[i];
+        uint16_t qp[4] =
+        {
+            ToUnorm16((p.x - minP.x) * invX),
+            ToUnorm16((p.y - minP.y) * invY),
+            ToUnorm16((p.z - minP.z) * invZ),
+            0
+        };
+        memcpy(dst + QUANTIZED_POSITION_OFFSET, qp, sizeof(qp));
+
+        const XMFLOAT3 n = normals ? normals[i] : XMFLOAT3(0.0f, 1.0f, 0.0f);
+        uint32_t qn = EncodeOctahedral(n);
+        memcpy(dst + QUANTIZED_NORMAL_OFFSET, &qn, sizeof(qn));
+
+        if (withColor)
+        {
+            const XMFLOAT4 c = colors ? colors[i] : XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+            uint8_t qc[4] = { ToUnorm8(c.x), ToUnorm8(c.y), ToUnorm8(c.z), ToUnorm8(c.w) };
+            memcpy(dst + QUANTIZED_COLOR_OFFSET, qc, sizeof(qc));
+        }
+    }
+
+    return true;
+}
+
+void DecodeQuantizedVertex(
+    const QuantizedMesh& mesh,
+    size_t index,
+    XMFLOAT3& outPosition,
+    XMFLOAT3& outNormal,
+    XMFLOAT4& outColor)
+{
+    const uint8_t* src = mesh.vertexData.data() + index * mesh.stride;
+
+    uint16_t qp[4];
+    memcpy(qp, src + QUANTIZED_POSITION_OFFSET, sizeof(qp));
+    outPosition.x = (qp[0] / 65535.0f) * mesh.positionScale.x + mesh.positionOffset.x;
+    outPosition.y = (qp[1] / 65535.0f) * mesh.positionScale.y + mesh.positionOffset.y;
+    outPosition.z = (qp[2] / 65535.0f) * mesh.positionScale.z + mesh.positionOffset.z;
+
+    uint32_t qn;
+    memcpy(&qn, src + QUANTIZED_NORMAL_OFFSET, sizeof(qn));
+    outNormal = DecodeOctahedral(qn);
+
+    if (mesh.hasColor)
+    {
+        uint8_t qc[4];
+        memcpy(qc, src + QUANTIZED_COLOR_OFFSET, sizeof(qc));
+        outColor = XMFLOAT4(qc[0] / 255.0f, qc[1] / 255.0f, qc[2] / 255.0f, qc[3] / 255.0f);
+    }
+    else
+    {
+        outColor = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    }
+}
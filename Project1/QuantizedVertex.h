@@ -0,0 +1,83 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <d3d12.h>
+#endif
+
+struct MeshStreams;
+
+// ===== Сжатые вершины для загрузки на GPU =====
+// Позиция:  4 x uint16 UNORM относительно габаритов меша (w не используется) - 8 байт
+// Нормаль:  2 x int16 SNORM, октаэдрическое кодирование                   - 4 байта
+// Цвет:     4 x uint8 UNORM, необязательный                               - 4 байта
+// Итого 12 или 16 байт вместо 40 у Vertex.
+//
+// Погрешность: позиция - около половины шага (габарит / 65535 / 2) по оси,
+// нормаль - до 1e-3 рад, цвет - 1/510.
+constexpr uint32_t QUANTIZED_POSITION_OFFSET = 0;
+constexpr uint32_t QUANTIZED_NORMAL_OFFSET = 8;
+constexpr uint32_t QUANTIZED_COLOR_OFFSET = 12;
+
+struct QuantizedMesh
+{
+    std::vector<uint8_t> vertexData;
+    std::vector<uint32_t> indices;
+    uint32_t stride = 0;
+    bool hasColor = false;
+
+    // Декодирование позиции: pos = q * positionScale + positionOffset
+    DirectX::XMFLOAT3 positionScale = { 1.0f, 1.0f, 1.0f };
+    DirectX::XMFLOAT3 positionOffset = { 0.0f, 0.0f, 0.0f };
+
+    size_t VertexCount() const { return stride ? vertexData.size() / stride : 0; }
+};
+
+bool QuantizeMesh(const MeshStreams& mesh, bool withColor, QuantizedMesh& outMesh);
+
+// Те же вершины из потоков вне MeshStreams (отображённый кэш меша), без копии в векторы;
+// normals и colors могут быть nullptr (= (0, 1, 0) и белый), outMesh.indices остаётся пустым
+bool QuantizeMesh(
+    const DirectX::XMFLOAT3* positions,
+    const DirectX::XMFLOAT3* normals,
+    const DirectX::XMFLOAT4* colors,
+    size_t vertexCount,
+    bool withColor,
+    QuantizedMesh& outMesh
+);
+
+// Обратное преобразование на CPU (позиция - та же математика, что в DecodeQuantizedPosition в shaders.hlsl)
+void DecodeQuantizedVertex(
+    const QuantizedMesh& mesh,
+    size_t index,
+    DirectX::XMFLOAT3& outPosition,
+    DirectX::XMFLOAT3& outNormal,
+    DirectX::XMFLOAT4& outColor
+);
+
+// Единичная нормаль <-> 2 x int16 SNORM (x в младших 16 битах)
+uint32_t EncodeOctahedral(const DirectX::XMFLOAT3& normal);
+DirectX::XMFLOAT3 DecodeOctahedral(uint32_t packed);
+
+#ifdef _WIN32
+inline std::vector<D3D12_INPUT_ELEMENT_DESC> GetQuantizedInputLayout(bool withColor)
+{
+    std::vector<D3D12_INPUT_ELEMENT_DESC> layout =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, QUANTIZED_POSITION_OFFSET,
+          D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, QUANTIZED_NORMAL_OFFSET,
+          D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+    };
+
+    if (withColor)
+    {
+        layout.push_back({ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, QUANTIZED_COLOR_OFFSET,
+            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+    }
+
+    return layout;
+}
+#endif
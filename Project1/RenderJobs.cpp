@@ -0,0 +1,187 @@
+﻿#include "RenderJobs.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Условная цена самого вызова в "индексах": смена корневых параметров, проверка состояния
+    constexpr uint64_t DRAW_CALL_COST = 256;
+}
+
+uint64_t DrawItemCost(const DrawItem& item)
+{
+    return (uint64_t)item.indexCount * item.instanceCount + DRAW_CALL_COST;
+}
+
+void SplitIntoDrawItems(uint32_t indexCount, uint32_t maxIndices, std::vector<DrawItem>& outItems,
+    uint32_t startIndex)
+{
+    maxIndices = std::max(maxIndices - maxIndices % 3, 3u);
+
+    for (uint32_t start = 0; start < indexCount; start += maxIndices)
+    {
+        DrawItem item;
+        item.startIndex = startIndex + start;
+        item.indexCount = std::min(maxIndices, indexCount - start);
+        outItems.push_back(item);
+    }
+}
+
+void PartitionDrawItems(
+    const DrawItem* items,
+    size_t count,
+    uint32_t maxParts,
+    size_t minItems,
+    std::vector<DrawRange>& outRanges)
+{
+    outRanges.clear();
+    if (count == 0)
+        return;
+
+    minItems = std::max<size_t>(minItems, 1);
+    size_t parts = std::min<size_t>(std::max(maxParts, 1u), std::max<size_t>(count / minItems, 1));
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++)
+        total += DrawItemCost(items[i]);
+
+    // Граница части p - первый элемент, на котором накопленная цена достигла total * p / parts
+    size_t begin = 0;
+    uint64_t accumulated = 0;
+    for (size_t p = 1; p <= parts && begin < count; p++)
+    {
+        const uint64_t target = total * p / parts;
+        const size_t remainingParts = parts - p;
+
+        size_t end = begin;
+        while (end < count && (accumulated < target || end - begin < minItems))
+        {
+            // Оставшимся частям тоже нужно по minItems
+            if (end - begin >= minItems && count - end <= remainingParts * minItems)
+                break;
+            accumulated += DrawItemCost(items[end]);
+            end++;
+        }
+
+        if (p == parts)
+        {
+            while (end < count)
+                accumulated += DrawItemCost(items[end++]);
+        }
+
+        outRanges.push_back({ begin, end });
+        begin = end;
+    }
+}
+
+ParallelRecorder::ParallelRecorder(JobSystem& jobs, uint32_t threadCount)
+    : mJobs(jobs)
+{
+    mThreadCount = threadCount == 0 ? jobs.ThreadCount() : std::min(threadCount, jobs.ThreadCount());
+}
+
+void ParallelRecorder::RunRange(ICommandRecorder* recorder, const DrawItem* items, DrawRange range)
+{
+    recorder->Begin();
+    for (size_t i = range.begin; i < range.end; i++)
+        recorder->RecordDraw(items[i]);
+    recorder->End();
+}
+
+uint32_t ParallelRecorder::Record(
+    const DrawItem* items,
+    size_t count,
+    ICommandRecorder* const* recorders,
+    uint32_t recorderCount,
+    size_t minItemsPerList)
+{
+    PartitionDrawItems(items, count,
+        std::min(recorderCount, mThreadCount), minItemsPerList, mRanges);
+
+    // Пустой кадр: один пустой список, чтобы вызывающему не нужно было отдельной ветки
+    if (mRanges.empty())
+    {
+        if (recorderCount == 0)
+            return 0;
+        recorders[0]->Begin();
+        recorders[0]->End();
+        return 1;
+    }
+
+    // Задание получает копию своего диапазона: mRanges после возврата уже не читается
+    JobCounter done;
+    for (size_t i = 1; i < mRanges.size(); i++)
+    {
+        ICommandRecorder* recorder = recorders[i];
+        const DrawRange range = mRanges[i];
+        mJobs.Run(mJobs.CreateJob([recorder, items, range]() { RunRange(recorder, items, range); }, &done));
+    }
+
+    RunRange(recorders[0], items, mRanges[0]);
+    mJobs.Wait(done);
+
+    return (uint32_t)mRanges.size();
+}
+
+#ifdef _WIN32
+bool D3D12CommandRecorder::Initialize(ID3D12Device* device, uint32_t frameCount, uint32_t drawConstantsRootParameter)
+{
+    mDrawConstantsRootParameter = drawConstantsRootParameter;
+
+    mAllocators.resize(frameCount);
+    for (uint32_t i = 0; i < frameCount; i++)
+    {
+        if (FAILED(device->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&mAllocators[i]))))
+            return false;
+    }
+
+    if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+        mAllocators[0].Get(), nullptr, IID_PPV_ARGS(&mList))))
+        return false;
+
+    mList->Close();
+    return true;
+}
+
+void D3D12CommandRecorder::Shutdown()
+{
+    mList.Reset();
+    mAllocators.clear();
+}
+
+void D3D12CommandRecorder::Prepare(uint32_t frameIndex, const SetupFn* setup)
+{
+    mFrameIndex = frameIndex;
+    mSetup = setup;
+}
+
+void D3D12CommandRecorder::Begin()
+{
+    ID3D12CommandAllocator* allocator = mAllocators[mFrameIndex].Get();
+    allocator->Reset();
+    mList->Reset(allocator, nullptr);
+
+    if (mSetup)
+        (*mSetup)(mList.Get());
+    mBoundStartInstance = ~0u;
+}
+
+void D3D12CommandRecorder::RecordDraw(const DrawItem& item)
+{
+    if (mDrawConstantsRootParameter != ~0u && item.startInstance != mBoundStartInstance)
+    {
+        mList->SetGraphicsRoot32BitConstant(mDrawConstantsRootParameter, item.startInstance, 0);
+        mBoundStartInstance = item.startInstance;
+    }
+
+    mList->DrawIndexedInstanced(item.indexCount, item.instanceCount,
+        item.startIndex, item.baseVertex, item.startInstance);
+}
+
+void D3D12CommandRecorder::End()
+{
+    mList->Close();
+}
+#endif
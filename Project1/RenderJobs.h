@@ -0,0 +1,120 @@
+﻿#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "JobSystem.h"
+
+#ifdef _WIN32
+#include <d3d12.h>
+#include <wrl/client.h>
+#endif
+
+// ===== Элемент отрисовки =====
+// Один DrawIndexedInstanced; состояние (PSO, корневая сигнатура, VB/IB) задаёт запись списка
+struct DrawItem
+{
+    uint32_t indexCount = 0;
+    uint32_t startIndex = 0;
+    int32_t baseVertex = 0;
+    uint32_t instanceCount = 1;
+    uint32_t startInstance = 0;  // дублируется корневой константой: SV_InstanceID с нуля
+};
+
+// Диапазон индексов [startIndex; startIndex + indexCount) -> куски не больше maxIndices (кратно 3)
+void SplitIntoDrawItems(uint32_t indexCount, uint32_t maxIndices, std::vector<DrawItem>& outItems,
+    uint32_t startIndex = 0);
+
+// ===== Запись одного списка команд =====
+// D3D12 реализация ниже; для тестов и замеров без GPU хватает заглушки
+class ICommandRecorder
+{
+public:
+    virtual ~ICommandRecorder() = default;
+
+    virtual void Begin() = 0;
+    virtual void RecordDraw(const DrawItem& item) = 0;
+    virtual void End() = 0;
+};
+
+struct DrawRange
+{
+    size_t begin;
+    size_t end;
+};
+
+// Условная цена вызова для разбиения: индексы * экземпляры + постоянная цена самого вызова
+uint64_t DrawItemCost(const DrawItem& item);
+
+// Делит items на не больше чем maxParts непрерывных диапазонов примерно равной DrawItemCost.
+// Диапазон не короче minItems элементов
+void PartitionDrawItems(
+    const DrawItem* items,
+    size_t count,
+    uint32_t maxParts,
+    size_t minItems,
+    std::vector<DrawRange>& outRanges
+);
+
+// ===== Параллельная запись =====
+// Диапазоны 1..n - задания JobSystem, диапазон 0 - вызывающий поток (поток этой системы).
+// Диапазон i пишет recorders[i]; порядок отправки списков определяется индексом диапазона,
+// а не временем завершения
+class ParallelRecorder
+{
+public:
+    // Списков не больше threadCount и потоков системы; 0 = по числу потоков системы
+    explicit ParallelRecorder(JobSystem& jobs, uint32_t threadCount = 0);
+
+    ParallelRecorder(const ParallelRecorder&) = delete;
+    ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+    uint32_t ThreadCount() const { return mThreadCount; }
+
+    // Возвращает число записанных списков: recorders[0 .. n) в порядке отправки
+    uint32_t Record(
+        const DrawItem* items,
+        size_t count,
+        ICommandRecorder* const* recorders,
+        uint32_t recorderCount,
+        size_t minItemsPerList = 16
+    );
+
+private:
+    static void RunRange(ICommandRecorder* recorder, const DrawItem* items, DrawRange range);
+
+    JobSystem& mJobs;
+    uint32_t mThreadCount;
+    std::vector<DrawRange> mRanges;
+};
+
+#ifdef _WIN32
+// Свой список и по аллокатору на каждый кадр в полёте.
+// setup вызывается после Reset: render targets, viewport, PSO, корневые параметры, VB/IB
+class D3D12CommandRecorder : public ICommandRecorder
+{
+public:
+    using SetupFn = std::function<void(ID3D12GraphicsCommandList*)>;
+
+    // drawConstantsRootParameter - корневая константа под DrawItem::startInstance (~0u - не используется).
+    // На вызов не больше одной корневой команды, и только если значение сменилось
+    bool Initialize(ID3D12Device* device, uint32_t frameCount, uint32_t drawConstantsRootParameter = ~0u);
+    void Shutdown();
+
+    // Перед Begin: слот кадра (его аллокаторы уже свободны) и состояние для списка
+    void Prepare(uint32_t frameIndex, const SetupFn* setup);
+
+    void Begin() override;
+    void RecordDraw(const DrawItem& item) override;
+    void End() override;
+
+    ID3D12GraphicsCommandList* List() const { return mList.Get(); }
+
+private:
+    std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> mAllocators;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mList;
+    uint32_t mFrameIndex = 0;
+    const SetupFn* mSetup = nullptr;
+    uint32_t mDrawConstantsRootParameter = ~0u;
+    uint32_t mBoundStartInstance = ~0u;
+};
+#endif
@@ -0,0 +1,55 @@
+﻿#include "ResizeTracker.h"
+
+void ResizeTracker::Reset(uint32_t width, uint32_t height)
+{
+    mWidth = width;
+    mHeight = height;
+    mPending = false;
+    mMinimized = false;
+    mSizing = false;
+}
+
+void ResizeTracker::OnSize(uint32_t width, uint32_t height, SizeEvent event)
+{
+    mEventCount++;
+
+    if (event == SizeEvent::Minimized || width == 0 || height == 0)
+    {
+        // Буферы не трогаем: после восстановления размер обычно тот же
+        mMinimized = true;
+        return;
+    }
+
+    mMinimized = false;
+    mPendingWidth = width;
+    mPendingHeight = height;
+    mPending = true;
+}
+
+void ResizeTracker::OnEnterSizeMove()
+{
+    mSizing = true;
+}
+
+void ResizeTracker::OnExitSizeMove()
+{
+    mSizing = false;
+}
+
+bool ResizeTracker::Consume(uint32_t& outWidth, uint32_t& outHeight)
+{
+    if (!mPending || mSizing || mMinimized)
+        return false;
+
+    mPending = false;
+    if (mPendingWidth == mWidth && mPendingHeight == mHeight)
+        return false;
+
+    mWidth = mPendingWidth;
+    mHeight = mPendingHeight;
+    mRebuildCount++;
+
+    outWidth = mWidth;
+    outHeight = mHeight;
+    return true;
+}
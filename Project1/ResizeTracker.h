@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <cstdint>
+
+// ===== Склейка событий изменения размера =====
+// Без окна: WM_SIZE / WM_ENTERSIZEMOVE / WM_EXITSIZEMOVE -> не больше одной пересборки за кадр.
+//   - пока тянут рамку, размер только запоминается; пересборка - после отпускания
+//   - свёрнутое окно не рисуется и не пересобирается (размер 0 x 0)
+//   - размер, равный текущему (восстановление после сворачивания), пересборки не требует
+enum class SizeEvent : uint8_t
+{
+    Restored,   // SIZE_RESTORED
+    Minimized,  // SIZE_MINIMIZED
+    Maximized   // SIZE_MAXIMIZED
+};
+
+class ResizeTracker
+{
+public:
+    ResizeTracker() = default;
+
+    // Размер, под который сейчас созданы буферы
+    void Reset(uint32_t width, uint32_t height);
+
+    void OnSize(uint32_t width, uint32_t height, SizeEvent event);
+    void OnEnterSizeMove();
+    void OnExitSizeMove();
+
+    // Раз в кадр, до Update: true - пересоздать буферы под outWidth x outHeight
+    bool Consume(uint32_t& outWidth, uint32_t& outHeight);
+
+    bool IsMinimized() const { return mMinimized; }
+    bool IsSizing() const { return mSizing; }
+    bool ShouldRender() const { return !mMinimized; }
+
+    uint32_t Width() const { return mWidth; }
+    uint32_t Height() const { return mHeight; }
+
+    // Сколько событий пришло и во сколько пересборок они склеились
+    uint32_t EventCount() const { return mEventCount; }
+    uint32_t RebuildCount() const { return mRebuildCount; }
+
+private:
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    uint32_t mPendingWidth = 0;
+    uint32_t mPendingHeight = 0;
+    bool mPending = false;
+    bool mMinimized = false;
+    bool mSizing = false;
+    uint32_t mEventCount = 0;
+    uint32_t mRebuildCount = 0;
+};
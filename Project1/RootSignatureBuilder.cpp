@@ -0,0 +1,230 @@
+﻿#include "RootSignatureBuilder.h"
+#include "MeshCache.h"
+
+#include <cstdio>
+
+uint32_t RootSignatureBuilder::AddConstants(uint32_t num32BitValues, uint32_t shaderRegister,
+    uint32_t space, RootVisibility visibility)
+{
+    RootParameter parameter;
+    parameter.type = RootParameterType::Constants;
+    parameter.visibility = visibility;
+    parameter.shaderRegister = shaderRegister;
+    parameter.space = space;
+    parameter.num32BitValues = num32BitValues;
+    mParameters.push_back(parameter);
+    return (uint32_t)mParameters.size() - 1;
+}
+
+uint32_t RootSignatureBuilder::AddCbv(uint32_t shaderRegister, uint32_t space, RootVisibility visibility)
+{
+    return AddDescriptor(RootParameterType::Cbv, shaderRegister, space, visibility);
+}
+
+uint32_t RootSignatureBuilder::AddSrv(uint32_t shaderRegister, uint32_t space, RootVisibility visibility)
+{
+    return AddDescriptor(RootParameterType::Srv, shaderRegister, space, visibility);
+}
+
+uint32_t RootSignatureBuilder::AddUav(uint32_t shaderRegister, uint32_t space, RootVisibility visibility)
+{
+    return AddDescriptor(RootParameterType::Uav, shaderRegister, space, visibility);
+}
+
+uint32_t RootSignatureBuilder::AddTable(const std::vector<DescriptorRange>& ranges, RootVisibility visibility)
+{
+    RootParameter parameter;
+    parameter.type = RootParameterType::Table;
+    parameter.visibility = visibility;
+    parameter.ranges = ranges;
+    mParameters.push_back(parameter);
+    return (uint32_t)mParameters.size() - 1;
+}
+
+uint32_t RootSignatureBuilder::AddDescriptor(RootParameterType type, uint32_t shaderRegister,
+    uint32_t space, RootVisibility visibility)
+{
+    RootParameter parameter;
+    parameter.type = type;
+    parameter.visibility = visibility;
+    parameter.shaderRegister = shaderRegister;
+    parameter.space = space;
+    mParameters.push_back(parameter);
+    return (uint32_t)mParameters.size() - 1;
+}
+
+uint32_t RootSignatureBuilder::DwordCost(const RootParameter& parameter)
+{
+    switch (parameter.type)
+    {
+    case RootParameterType::Constants: return parameter.num32BitValues;
+    case RootParameterType::Table:     return 1;
+    default:                           return 2;
+    }
+}
+
+uint32_t RootSignatureBuilder::DwordCost() const
+{
+    uint32_t total = 0;
+    for (const RootParameter& parameter : mParameters)
+        total += DwordCost(parameter);
+    return total;
+}
+
+std::string RootSignatureBuilder::Describe() const
+{
+    static const char* typeNames[] = { "Constants", "CBV", "SRV", "UAV", "Table" };
+    static const char* visibilityNames[] = { "ALL", "VS", "PS" };
+
+    std::string text;
+    char line[128];
+    for (size_t i = 0; i < mParameters.size(); i++)
+    {
+        const RootParameter& p = mParameters[i];
+        char registerClass = p.type == RootParameterType::Srv ? 't'
+            : p.type == RootParameterType::Uav ? 'u' : 'b';
+
+        if (p.type == RootParameterType::Table)
+            snprintf(line, sizeof(line), "[%zu] Table (%zu ranges) %s - %u DWORD\n",
+                i, p.ranges.size(), visibilityNames[(int)p.visibility], DwordCost(p));
+        else
+            snprintf(line, sizeof(line), "[%zu] %s %c%u space%u %s - %u DWORD\n",
+                i, typeNames[(int)p.type], registerClass, p.shaderRegister, p.space,
+                visibilityNames[(int)p.visibility], DwordCost(p));
+        text += line;
+    }
+
+    snprintf(line, sizeof(line), "Root signature: %u / %u DWORD\n", DwordCost(), MAX_DWORDS);
+    text += line;
+    return text;
+}
+
+uint64_t RootSignatureBuilder::Hash() const
+{
+    // Поля по одному: в RootParameter есть выравнивание и вектор
+    std::vector<uint32_t> words;
+    for (const RootParameter& p : mParameters)
+    {
+        words.push_back((uint32_t)p.type);
+        words.push_back((uint32_t)p.visibility);
+        words.push_back(p.shaderRegister);
+        words.push_back(p.space);
+        words.push_back(p.num32BitValues);
+        words.push_back((uint32_t)p.ranges.size());
+        for (const DescriptorRange& r : p.ranges)
+        {
+            words.push_back((uint32_t)r.type);
+            words.push_back(r.count);
+            words.push_back(r.baseRegister);
+            words.push_back(r.space);
+        }
+    }
+    return HashBytes(words.data(), words.size() * sizeof(uint32_t));
+}
+
+#ifdef _WIN32
+namespace
+{
+    D3D12_SHADER_VISIBILITY ToD3D12(RootVisibility visibility)
+    {
+        switch (visibility)
+        {
+        case RootVisibility::Vertex: return D3D12_SHADER_VISIBILITY_VERTEX;
+        case RootVisibility::Pixel:  return D3D12_SHADER_VISIBILITY_PIXEL;
+        default:                     return D3D12_SHADER_VISIBILITY_ALL;
+        }
+    }
+
+    D3D12_DESCRIPTOR_RANGE_TYPE ToD3D12(DescriptorRangeType type)
+    {
+        switch (type)
+        {
+        case DescriptorRangeType::Uav:     return D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+        case DescriptorRangeType::Cbv:     return D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
+        case DescriptorRangeType::Sampler: return D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER;
+        default:                           return D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        }
+    }
+}
+
+HRESULT RootSignatureBuilder::Build(
+    ID3D12Device* device,
+    D3D12_ROOT_SIGNATURE_FLAGS flags,
+    Microsoft::WRL::ComPtr<ID3D12RootSignature>& outSignature,
+    std::string* errors) const
+{
+    if (!FitsBudget())
+    {
+        if (errors)
+            *errors = Describe();
+        return E_INVALIDARG;
+    }
+
+    // Диапазоны всех таблиц подряд; указатели на них берутся после заполнения
+    std::vector<D3D12_DESCRIPTOR_RANGE> ranges;
+    for (const RootParameter& p : mParameters)
+    {
+        for (const DescriptorRange& r : p.ranges)
+        {
+            D3D12_DESCRIPTOR_RANGE range;
+            range.RangeType = ToD3D12(r.type);
+            range.NumDescriptors = r.count;
+            range.BaseShaderRegister = r.baseRegister;
+            range.RegisterSpace = r.space;
+            range.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+            ranges.push_back(range);
+        }
+    }
+
+    std::vector<D3D12_ROOT_PARAMETER> parameters(mParameters.size());
+    size_t rangeOffset = 0;
+    for (size_t i = 0; i < mParameters.size(); i++)
+    {
+        const RootParameter& p = mParameters[i];
+        D3D12_ROOT_PARAMETER& out = parameters[i];
+        out.ShaderVisibility = ToD3D12(p.visibility);
+
+        switch (p.type)
+        {
+        case RootParameterType::Constants:
+            out.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+            out.Constants.ShaderRegister = p.shaderRegister;
+            out.Constants.RegisterSpace = p.space;
+            out.Constants.Num32BitValues = p.num32BitValues;
+            break;
+        case RootParameterType::Table:
+            out.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+            out.DescriptorTable.NumDescriptorRanges = (UINT)p.ranges.size();
+            out.DescriptorTable.pDescriptorRanges = ranges.data() + rangeOffset;
+            rangeOffset += p.ranges.size();
+            break;
+        default:
+            out.ParameterType = p.type == RootParameterType::Cbv ? D3D12_ROOT_PARAMETER_TYPE_CBV
+                : p.type == RootParameterType::Srv ? D3D12_ROOT_PARAMETER_TYPE_SRV
+                : D3D12_ROOT_PARAMETER_TYPE_UAV;
+            out.Descriptor.ShaderRegister = p.shaderRegister;
+            out.Descriptor.RegisterSpace = p.space;
+            break;
+        }
+    }
+
+    D3D12_ROOT_SIGNATURE_DESC desc;
+    desc.NumParameters = (UINT)parameters.size();
+    desc.pParameters = parameters.data();
+    desc.NumStaticSamplers = 0;
+    desc.pStaticSamplers = nullptr;
+    desc.Flags = flags;
+
+    Microsoft::WRL::ComPtr<ID3DBlob> serialized;
+    Microsoft::WRL::ComPtr<ID3DBlob> errorBlob;
+    HRESULT hr = D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &serialized, &errorBlob);
+
+    if (errorBlob && errors)
+        errors->assign((const char*)errorBlob->GetBufferPointer(), errorBlob->GetBufferSize());
+    if (FAILED(hr))
+        return hr;
+
+    return device->CreateRootSignature(0, serialized->GetBufferPointer(),
+        serialized->GetBufferSize(), IID_PPV_ARGS(&outSignature));
+}
+#endif
@@ -0,0 +1,98 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <d3d12.h>
+#include <wrl/client.h>
+#endif
+
+// ===== Корневая сигнатура по параметрам =====
+// Описание без D3D12 типов: стоимость в DWORD считается и на Linux, сборка - под _WIN32.
+// Цена параметра (лимит 64 DWORD на всю сигнатуру):
+//   корневые константы - по 1 DWORD на 32-битное значение
+//   корневой CBV/SRV/UAV - 2 DWORD (GPU-адрес), таблица дескрипторов - 1 DWORD
+
+enum class RootParameterType : uint8_t
+{
+    Constants,
+    Cbv,
+    Srv,
+    Uav,
+    Table
+};
+
+enum class RootVisibility : uint8_t
+{
+    All,
+    Vertex,
+    Pixel
+};
+
+enum class DescriptorRangeType : uint8_t
+{
+    Srv,
+    Uav,
+    Cbv,
+    Sampler
+};
+
+struct DescriptorRange
+{
+    DescriptorRangeType type = DescriptorRangeType::Srv;
+    uint32_t count = 1;
+    uint32_t baseRegister = 0;
+    uint32_t space = 0;
+};
+
+struct RootParameter
+{
+    RootParameterType type = RootParameterType::Cbv;
+    RootVisibility visibility = RootVisibility::All;
+    uint32_t shaderRegister = 0;
+    uint32_t space = 0;
+    uint32_t num32BitValues = 0;         // только для Constants
+    std::vector<DescriptorRange> ranges; // только для Table
+};
+
+class RootSignatureBuilder
+{
+public:
+    static constexpr uint32_t MAX_DWORDS = 64;
+
+    // Возвращают индекс параметра для SetGraphicsRoot*
+    uint32_t AddConstants(uint32_t num32BitValues, uint32_t shaderRegister,
+        uint32_t space = 0, RootVisibility visibility = RootVisibility::All);
+    uint32_t AddCbv(uint32_t shaderRegister, uint32_t space = 0, RootVisibility visibility = RootVisibility::All);
+    uint32_t AddSrv(uint32_t shaderRegister, uint32_t space = 0, RootVisibility visibility = RootVisibility::All);
+    uint32_t AddUav(uint32_t shaderRegister, uint32_t space = 0, RootVisibility visibility = RootVisibility::All);
+    uint32_t AddTable(const std::vector<DescriptorRange>& ranges, RootVisibility visibility = RootVisibility::All);
+
+    const std::vector<RootParameter>& Parameters() const { return mParameters; }
+
+    static uint32_t DwordCost(const RootParameter& parameter);
+    uint32_t DwordCost() const;
+    bool FitsBudget() const { return DwordCost() <= MAX_DWORDS; }
+
+    // Строка на параметр: "[1] SRV t0 VS - 2 DWORD", в конце итог
+    std::string Describe() const;
+
+    // Хэш раскладки параметров (часть ключа PSO в PipelineCache)
+    uint64_t Hash() const;
+
+#ifdef _WIN32
+    // Сериализация и создание; при ошибке текст компилятора сигнатуры в errors
+    HRESULT Build(
+        ID3D12Device* device,
+        D3D12_ROOT_SIGNATURE_FLAGS flags,
+        Microsoft::WRL::ComPtr<ID3D12RootSignature>& outSignature,
+        std::string* errors = nullptr
+    ) const;
+#endif
+
+private:
+    uint32_t AddDescriptor(RootParameterType type, uint32_t shaderRegister, uint32_t space, RootVisibility visibility);
+
+    std::vector<RootParameter> mParameters;
+};
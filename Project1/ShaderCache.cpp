@@ -0,0 +1,201 @@
+﻿#include "ShaderCache.h"
+#include "MeshCache.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    void AppendString(std::vector<uint8_t>& bytes, const std::string& s)
+    {
+        const uint32_t size = (uint32_t)s.size();
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&size);
+        bytes.insert(bytes.end(), p, p + sizeof(size));
+        bytes.insert(bytes.end(), s.begin(), s.end());
+    }
+
+    template<typename T>
+    void AppendValue(std::vector<uint8_t>& bytes, T value)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), p, p + sizeof(value));
+    }
+
+    // 16 шестнадцатеричных цифр и .cso
+    bool ParseCacheFileName(const std::string& name, uint64_t& outKey)
+    {
+        if (name.size() != 20 || name.compare(16, 4, ".cso") != 0)
+            return false;
+
+        uint64_t key = 0;
+        for (size_t i = 0; i < 16; i++)
+        {
+            char c = name[i];
+            uint64_t digit;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+            else return false;
+            key = (key << 4) | digit;
+        }
+        outKey = key;
+        return true;
+    }
+}
+
+uint64_t HashShaderKey(const ShaderKey& key)
+{
+    std::vector<ShaderDefine> defines = key.defines;
+    std::sort(defines.begin(), defines.end(),
+        [](const ShaderDefine& a, const ShaderDefine& b) { return a.name < b.name; });
+
+    std::vector<uint8_t> bytes;
+    AppendValue(bytes, key.sourceHash);
+    AppendValue(bytes, (uint32_t)defines.size());
+    for (const ShaderDefine& d : defines)
+    {
+        AppendString(bytes, d.name);
+        AppendString(bytes, d.value);
+    }
+    AppendString(bytes, key.entryPoint);
+    AppendString(bytes, key.target);
+    AppendValue(bytes, key.flags);
+
+    return HashBytes(bytes.data(), bytes.size());
+}
+
+ShaderCache::ShaderCache(std::string directory)
+    : mDirectory(std::move(directory))
+{
+}
+
+std::string ShaderCache::PathFor(uint64_t key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.cso", (unsigned long long)key);
+    return mDirectory + "/" + name;
+}
+
+bool ShaderCache::HashSource(const std::string& path, uint64_t& outHash)
+{
+    auto it = mSourceHashes.find(path);
+    if (it != mSourceHashes.end())
+    {
+        outHash = it->second;
+        return true;
+    }
+
+    uint64_t size = 0;
+    if (!HashFile(path, outHash, size))
+        return false;
+
+    mSourceHashes.emplace(path, outHash);
+    return true;
+}
+
+bool ShaderCache::MakeKey(const std::string& sourcePath, const std::vector<ShaderDefine>& defines,
+    const std::string& entryPoint, const std::string& target, uint32_t flags, uint64_t& outKey)
+{
+    ShaderKey key;
+    if (!HashSource(sourcePath, key.sourceHash))
+        return false;
+
+    key.defines = defines;
+    key.entryPoint = entryPoint;
+    key.target = target;
+    key.flags = flags;
+    outKey = HashShaderKey(key);
+    return true;
+}
+
+bool ShaderCache::Load(uint64_t key, std::vector<uint8_t>& outByteCode)
+{
+    // Одно отображение файла и одна копия байткода
+    MappedFile file;
+    if (!file.Open(PathFor(key)))
+    {
+        mStats.misses++;
+        return false;
+    }
+
+    ShaderCacheHeader header;
+    if (file.Size() < sizeof(header))
+    {
+        mStats.rejected++;
+        return false;
+    }
+    memcpy(&header, file.Data(), sizeof(header));
+
+    if (header.magic != SHADER_CACHE_MAGIC ||
+        header.version != SHADER_CACHE_VERSION ||
+        header.key != key ||
+        header.byteCodeSize == 0 ||
+        header.byteCodeSize != file.Size() - sizeof(header))
+    {
+        mStats.rejected++;
+        return false;
+    }
+
+    const uint8_t* byteCode = reinterpret_cast<const uint8_t*>(file.Data() + sizeof(header));
+    outByteCode.assign(byteCode, byteCode + header.byteCodeSize);
+    mStats.hits++;
+    return true;
+}
+
+bool ShaderCache::Store(uint64_t key, const void* byteCode, size_t size)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(mDirectory, ec);
+
+    ShaderCacheHeader header{};
+    header.magic = SHADER_CACHE_MAGIC;
+    header.version = SHADER_CACHE_VERSION;
+    header.key = key;
+    header.byteCodeSize = size;
+
+    // Как WriteMeshCache: временный файл и переименование
+    const std::string path = PathFor(key);
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(static_cast<const char*>(byteCode), size);
+
+        if (!file)
+            return false;
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        return false;
+
+    mStats.stores++;
+    return true;
+}
+
+size_t ShaderCache::RemoveStale(const std::vector<uint64_t>& liveKeys)
+{
+    std::error_code ec;
+    std::filesystem::directory_iterator it(mDirectory, ec);
+    if (ec)
+        return 0;
+
+    size_t removed = 0;
+    for (const auto& entry : it)
+    {
+        uint64_t key;
+        if (!entry.is_regular_file() || !ParseCacheFileName(entry.path().filename().string(), key))
+            continue;
+
+        if (std::find(liveKeys.begin(), liveKeys.end(), key) == liveKeys.end() &&
+            std::filesystem::remove(entry.path(), ec))
+            removed++;
+    }
+    return removed;
+}
@@ -0,0 +1,93 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ===== Кэш байткода шейдеров =====
+// Адресация по содержимому: имя файла - хэш ключа (исходник, defines, точка входа, профиль, флаги).
+// Изменили исходник или флаги - ключ другой, старый файл просто не находится.
+// Файл: [ShaderCacheHeader][байткод]
+
+struct ShaderDefine
+{
+    std::string name;
+    std::string value;
+};
+
+struct ShaderKey
+{
+    uint64_t sourceHash = 0;            // содержимое .hlsl; #include не отслеживаются
+    std::vector<ShaderDefine> defines;
+    std::string entryPoint;
+    std::string target;                 // vs_5_0, ps_5_0, ...
+    uint32_t flags = 0;                 // D3DCOMPILE_*
+};
+
+// Defines сортируются по имени: порядок в массиве на результат не влияет
+uint64_t HashShaderKey(const ShaderKey& key);
+
+struct ShaderCacheHeader
+{
+    uint32_t magic;        // SHADER_CACHE_MAGIC
+    uint32_t version;      // SHADER_CACHE_VERSION
+    uint64_t key;          // HashShaderKey - защита от подменённого/переименованного файла
+    uint64_t byteCodeSize;
+};
+
+constexpr uint32_t SHADER_CACHE_MAGIC = 0x43444853;  // "SHDC"
+constexpr uint32_t SHADER_CACHE_VERSION = 1;
+
+struct ShaderCacheStats
+{
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t rejected = 0;  // файл есть, но заголовок или размер не сходятся
+    uint32_t stores = 0;
+};
+
+class ShaderCache
+{
+public:
+    explicit ShaderCache(std::string directory = "ShaderCache");
+
+    const std::string& Directory() const { return mDirectory; }
+    std::string PathFor(uint64_t key) const;
+
+    // Хэш исходника; повторные вызовы для того же пути не читают файл
+    bool HashSource(const std::string& path, uint64_t& outHash);
+
+    // HashShaderKey для файла; false - исходник не прочитать
+    bool MakeKey(const std::string& sourcePath, const std::vector<ShaderDefine>& defines,
+        const std::string& entryPoint, const std::string& target, uint32_t flags, uint64_t& outKey);
+
+    bool Load(uint64_t key, std::vector<uint8_t>& outByteCode);
+    bool Store(uint64_t key, const void* byteCode, size_t size);
+
+    // Удаляет файлы кэша, ключей которых нет в liveKeys. Возвращает число удалённых
+    size_t RemoveStale(const std::vector<uint64_t>& liveKeys);
+
+    const ShaderCacheStats& GetStats() const { return mStats; }
+
+private:
+    std::string mDirectory;
+    std::unordered_map<std::string, uint64_t> mSourceHashes;
+    ShaderCacheStats mStats;
+};
+
+// Все шейдеры приложения: BuildShaders берёт их из кэша, ShaderBake компилирует заранее
+struct ShaderPermutation
+{
+    const char* file;
+    const char* entryPoint;
+    const char* target;
+};
+
+inline constexpr ShaderPermutation SHADER_PERMUTATIONS[] = {
+    { "shaders.hlsl", "VS",                 "vs_5_0" },
+    { "shaders.hlsl", "VSInstanced",        "vs_5_0" },
+    { "shaders.hlsl", "VSInstancedNoColor", "vs_5_0" },
+    { "shaders.hlsl", "VSQuantized",        "vs_5_0" },
+    { "shaders.hlsl", "VSQuantizedNoColor", "vs_5_0" },
+    { "shaders.hlsl", "PS",                 "ps_5_0" },
+};
@@ -0,0 +1,286 @@
+﻿#include "TlsfAllocator.h"
+
+#include <bit>
+
+TlsfAllocator::TlsfAllocator(uint64_t capacity)
+{
+    Reset(capacity);
+}
+
+void TlsfAllocator::Reset(uint64_t capacity)
+{
+    mBlocks.clear();
+    mUnusedBlocks.clear();
+    mAllocated.clear();
+    mFlBitmap = 0;
+    for (uint32_t fl = 0; fl < FL_COUNT; fl++)
+    {
+        mSlBitmap[fl] = 0;
+        for (uint32_t sl = 0; sl < SL_COUNT; sl++)
+            mHeads[fl][sl] = NIL;
+    }
+
+    mCapacity = capacity;
+    mUsedBytes = 0;
+
+    if (capacity == 0)
+        return;
+
+    uint32_t index = NewBlock();
+    Block& block = mBlocks[index];
+    block.offset = 0;
+    block.size = capacity;
+    InsertFree(index);
+}
+
+// Маленькие размеры (< SL_COUNT) - линейно в первом классе
+void TlsfAllocator::Mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+    if (size < SL_COUNT)
+    {
+        fl = 0;
+        sl = (uint32_t)size;
+        return;
+    }
+
+    uint32_t msb = (uint32_t)std::bit_width(size) - 1;
+    fl = msb - SL_LOG2 + 1;
+    sl = (uint32_t)(size >> (msb - SL_LOG2)) - SL_COUNT;
+}
+
+// Класс, в котором любой блок не меньше size
+bool TlsfAllocator::FindFree(uint64_t size, uint32_t& fl, uint32_t& sl) const
+{
+    if (size >= SL_COUNT)
+    {
+        uint32_t msb = (uint32_t)std::bit_width(size) - 1;
+        uint64_t round = (1ull << (msb - SL_LOG2)) - 1;
+        if (size + round < size)
+            return false;
+        size += round;
+    }
+    Mapping(size, fl, sl);
+    if (fl >= FL_COUNT)
+        return false;
+
+    uint32_t slMap = mSlBitmap[fl] & (~0u << sl);
+    if (slMap == 0)
+    {
+        uint64_t flMap = (fl + 1 < 64) ? mFlBitmap & (~0ull << (fl + 1)) : 0;
+        if (flMap == 0)
+            return false;
+
+        fl = (uint32_t)std::countr_zero(flMap);
+        slMap = mSlBitmap[fl];
+    }
+
+    sl = (uint32_t)std::countr_zero(slMap);
+    return true;
+}
+
+// Запасной путь, когда классов выше нет: блоки в собственном классе размера могут быть меньше
+// запроса, поэтому список просматривается. Без этого последний кусок кучи нельзя занять целиком
+uint32_t TlsfAllocator::FindInClass(uint64_t size, uint64_t mask) const
+{
+    uint32_t fl, sl;
+    Mapping(size, fl, sl);
+    if (fl >= FL_COUNT)
+        return NIL;
+
+    for (uint32_t i = mHeads[fl][sl]; i != NIL; i = mBlocks[i].nextFree)
+    {
+        const Block& block = mBlocks[i];
+        const uint64_t padding = ((block.offset + mask) & ~mask) - block.offset;
+        if (block.size >= padding && block.size - padding >= size)
+            return i;
+    }
+    return NIL;
+}
+
+uint32_t TlsfAllocator::NewBlock()
+{
+    uint32_t index;
+    if (!mUnusedBlocks.empty())
+    {
+        index = mUnusedBlocks.back();
+        mUnusedBlocks.pop_back();
+    }
+    else
+    {
+        index = (uint32_t)mBlocks.size();
+        mBlocks.emplace_back();
+    }
+
+    mBlocks[index] = { 0, 0, NIL, NIL, NIL, NIL, false };
+    return index;
+}
+
+void TlsfAllocator::ReleaseBlock(uint32_t index)
+{
+    mUnusedBlocks.push_back(index);
+}
+
+void TlsfAllocator::InsertFree(uint32_t index)
+{
+    Block& block = mBlocks[index];
+    uint32_t fl, sl;
+    Mapping(block.size, fl, sl);
+
+    block.free = true;
+    block.prevFree = NIL;
+    block.nextFree = mHeads[fl][sl];
+    if (block.nextFree != NIL)
+        mBlocks[block.nextFree].prevFree = index;
+    mHeads[fl][sl] = index;
+
+    mFlBitmap |= 1ull << fl;
+    mSlBitmap[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t index)
+{
+    Block& block = mBlocks[index];
+    uint32_t fl, sl;
+    Mapping(block.size, fl, sl);
+
+    if (block.prevFree != NIL)
+        mBlocks[block.prevFree].nextFree = block.nextFree;
+    else
+        mHeads[fl][sl] = block.nextFree;
+
+    if (block.nextFree != NIL)
+        mBlocks[block.nextFree].prevFree = block.prevFree;
+
+    if (mHeads[fl][sl] == NIL)
+    {
+        mSlBitmap[fl] &= ~(1u << sl);
+        if (mSlBitmap[fl] == 0)
+            mFlBitmap &= ~(1ull << fl);
+    }
+
+    block.free = false;
+    block.prevFree = NIL;
+    block.nextFree = NIL;
+}
+
+uint32_t TlsfAllocator::Split(uint32_t index, uint64_t size)
+{
+    uint32_t rest = NewBlock();
+    Block& block = mBlocks[index];
+    Block& right = mBlocks[rest];
+
+    right.offset = block.offset + size;
+    right.size = block.size - size;
+    right.prevPhys = index;
+    right.nextPhys = block.nextPhys;
+    if (block.nextPhys != NIL)
+        mBlocks[block.nextPhys].prevPhys = rest;
+
+    block.size = size;
+    block.nextPhys = rest;
+    return rest;
+}
+
+uint32_t TlsfAllocator::Merge(uint32_t left, uint32_t right)
+{
+    Block& l = mBlocks[left];
+    Block& r = mBlocks[right];
+
+    l.size += r.size;
+    l.nextPhys = r.nextPhys;
+    if (r.nextPhys != NIL)
+        mBlocks[r.nextPhys].prevPhys = left;
+
+    ReleaseBlock(right);
+    return left;
+}
+
+uint64_t TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    if (size == 0 || size > mCapacity)
+        return INVALID_OFFSET;
+
+    // С запасом под выравнивание: начало любого найденного блока можно сдвинуть
+    const uint64_t mask = alignment - 1;
+    const uint64_t search = size + mask;
+
+    if (search < size)
+        return INVALID_OFFSET;
+
+    uint32_t fl, sl;
+    uint32_t index = FindFree(search, fl, sl) ? mHeads[fl][sl] : FindInClass(size, mask);
+    if (index == NIL)
+        return INVALID_OFFSET;
+    RemoveFree(index);
+
+    // Отступ до выравнивания - отдельный свободный блок слева
+    uint64_t aligned = (mBlocks[index].offset + mask) & ~mask;
+    uint64_t padding = aligned - mBlocks[index].offset;
+    if (padding != 0)
+    {
+        uint32_t right = Split(index, padding);
+        InsertFree(index);
+        index = right;
+    }
+
+    if (mBlocks[index].size > size)
+    {
+        uint32_t rest = Split(index, size);
+        InsertFree(rest);
+    }
+
+    mAllocated[aligned] = index;
+    mUsedBytes += size;
+    return aligned;
+}
+
+void TlsfAllocator::Free(uint64_t offset)
+{
+    auto it = mAllocated.find(offset);
+    if (it == mAllocated.end())
+        return;
+
+    uint32_t index = it->second;
+    mAllocated.erase(it);
+    mUsedBytes -= mBlocks[index].size;
+
+    uint32_t prev = mBlocks[index].prevPhys;
+    if (prev != NIL && mBlocks[prev].free)
+    {
+        RemoveFree(prev);
+        index = Merge(prev, index);
+    }
+
+    uint32_t next = mBlocks[index].nextPhys;
+    if (next != NIL && mBlocks[next].free)
+    {
+        RemoveFree(next);
+        index = Merge(index, next);
+    }
+
+    InsertFree(index);
+}
+
+TlsfAllocator::Stats TlsfAllocator::GetStats() const
+{
+    Stats stats;
+    stats.capacity = mCapacity;
+    stats.usedBytes = mUsedBytes;
+    stats.freeBytes = mCapacity - mUsedBytes;
+    stats.allocationCount = (uint32_t)mAllocated.size();
+
+    for (uint32_t fl = 0; fl < FL_COUNT; fl++)
+    {
+        for (uint32_t sl = 0; sl < SL_COUNT; sl++)
+        {
+            for (uint32_t i = mHeads[fl][sl]; i != NIL; i = mBlocks[i].nextFree)
+            {
+                stats.freeBlockCount++;
+                if (mBlocks[i].size > stats.largestFreeBlock)
+                    stats.largestFreeBlock = mBlocks[i].size;
+            }
+        }
+    }
+
+    return stats;
+}
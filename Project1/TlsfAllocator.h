@@ -0,0 +1,84 @@
+﻿#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// ===== TLSF (Two-Level Segregated Fit) по смещениям =====
+// Сама память не хранится: аллокатор раздаёт смещения в диапазоне [0; capacity).
+// Allocate/Free за O(1): первый уровень - степень двойки размера,
+// второй - SL_COUNT линейных подклассов внутри неё. Соседние свободные блоки сливаются.
+class TlsfAllocator
+{
+public:
+    static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+    struct Stats
+    {
+        uint64_t capacity = 0;
+        uint64_t usedBytes = 0;
+        uint64_t freeBytes = 0;
+        uint64_t largestFreeBlock = 0;
+        uint32_t allocationCount = 0;
+        uint32_t freeBlockCount = 0;
+
+        // 0 - всё свободное место одним куском, ближе к 1 - раздроблено
+        float Fragmentation() const
+        {
+            return freeBytes ? 1.0f - (float)largestFreeBlock / (float)freeBytes : 0.0f;
+        }
+    };
+
+    explicit TlsfAllocator(uint64_t capacity = 0);
+
+    void Reset(uint64_t capacity);
+
+    // alignment - степень двойки. INVALID_OFFSET, если подходящего блока нет
+    uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+    void Free(uint64_t offset);
+
+    uint64_t Capacity() const { return mCapacity; }
+    uint64_t UsedBytes() const { return mUsedBytes; }
+    uint32_t AllocationCount() const { return (uint32_t)mAllocated.size(); }
+    bool IsEmpty() const { return mAllocated.empty(); }
+
+    Stats GetStats() const;
+
+private:
+    static constexpr uint32_t SL_LOG2 = 4;
+    static constexpr uint32_t SL_COUNT = 1u << SL_LOG2;
+    static constexpr uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+    static constexpr uint32_t NIL = ~0u;
+
+    struct Block
+    {
+        uint64_t offset;
+        uint64_t size;
+        uint32_t prevPhys;
+        uint32_t nextPhys;
+        uint32_t prevFree;
+        uint32_t nextFree;
+        bool free;
+    };
+
+    static void Mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+    bool FindFree(uint64_t size, uint32_t& fl, uint32_t& sl) const;
+    uint32_t FindInClass(uint64_t size, uint64_t mask) const;
+
+    uint32_t NewBlock();
+    void ReleaseBlock(uint32_t index);
+    void InsertFree(uint32_t index);
+    void RemoveFree(uint32_t index);
+    uint32_t Split(uint32_t index, uint64_t size);   // возвращает правый остаток
+    uint32_t Merge(uint32_t left, uint32_t right);   // right поглощается left
+
+    std::vector<Block> mBlocks;
+    std::vector<uint32_t> mUnusedBlocks;
+    std::unordered_map<uint64_t, uint32_t> mAllocated;   // смещение -> блок
+
+    uint64_t mFlBitmap = 0;
+    uint32_t mSlBitmap[FL_COUNT] = {};
+    uint32_t mHeads[FL_COUNT][SL_COUNT];
+
+    uint64_t mCapacity = 0;
+    uint64_t mUsedBytes = 0;
+};
@@ -0,0 +1,143 @@
+﻿#include "UploadRing.h"
+
+HeapUploadMemory::HeapUploadMemory(uint64_t capacity)
+    : mStorage(new uint8_t[capacity + BASE_ALIGNMENT])
+    , mCapacity(capacity)
+{
+    uintptr_t base = (uintptr_t)mStorage.get();
+    mData = (uint8_t*)((base + BASE_ALIGNMENT - 1) & ~(uintptr_t)(BASE_ALIGNMENT - 1));
+}
+
+#ifdef _WIN32
+D3D12UploadMemory::~D3D12UploadMemory()
+{
+    Shutdown();
+}
+
+bool D3D12UploadMemory::Initialize(ID3D12Device* device, uint64_t capacity)
+{
+    Shutdown();
+
+    D3D12_HEAP_PROPERTIES heapProps = {};
+    heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+    D3D12_RESOURCE_DESC resourceDesc = {};
+    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    resourceDesc.Width = capacity;
+    resourceDesc.Height = 1;
+    resourceDesc.DepthOrArraySize = 1;
+    resourceDesc.MipLevels = 1;
+    resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+    resourceDesc.SampleDesc.Count = 1;
+    resourceDesc.SampleDesc.Quality = 0;
+    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    HRESULT hr = device->CreateCommittedResource(
+        &heapProps,
+        D3D12_HEAP_FLAG_NONE,
+        &resourceDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&mResource)
+    );
+    if (FAILED(hr))
+        return false;
+
+    // Upload-куча write-combined: из mData только пишем
+    if (FAILED(mResource->Map(0, nullptr, reinterpret_cast<void**>(&mData))))
+    {
+        mResource.Reset();
+        return false;
+    }
+
+    mCapacity = capacity;
+    return true;
+}
+
+void D3D12UploadMemory::Shutdown()
+{
+    if (mResource && mData)
+        mResource->Unmap(0, nullptr);
+    mResource.Reset();
+    mData = nullptr;
+    mCapacity = 0;
+}
+
+uint64_t D3D12UploadMemory::GpuBase() const
+{
+    return mResource ? mResource->GetGPUVirtualAddress() : 0;
+}
+#endif
+
+UploadRing::UploadRing(IUploadMemory* memory)
+{
+    Reset(memory);
+}
+
+void UploadRing::Reset(IUploadMemory* memory)
+{
+    mMemory = memory;
+    mCapacity = memory ? memory->Capacity() : 0;
+    mHead = 0;
+    mTail = 0;
+    mCommitted = 0;
+    mPending.clear();
+}
+
+UploadAllocation UploadRing::Allocate(uint64_t size, uint64_t alignment)
+{
+    UploadAllocation result;
+    if (size == 0 || size > mCapacity)
+        return result;
+
+    // Кольцо пусто - начинаем с нуля, иначе выделение больше остатка до конца не влезло бы никогда:
+    // освобождать нечего, а перенос в начало считает хвост занятым
+    if (mTail == mHead && mHead % mCapacity != 0)
+    {
+        mHead += mCapacity - mHead % mCapacity;
+        mTail = mHead;
+        mCommitted = mHead;
+    }
+
+    const uint64_t mask = alignment - 1;
+    uint64_t offset = mHead % mCapacity;
+    uint64_t aligned = (offset + mask) & ~mask;
+
+    // Не влезает до конца памяти: хвост пропускаем, начинаем с нуля
+    uint64_t start = mHead + (aligned - offset);
+    if (aligned + size > mCapacity)
+    {
+        start = mHead + (mCapacity - offset);
+        aligned = 0;
+    }
+
+    uint64_t newHead = start + size;
+    if (newHead - mTail > mCapacity)
+        return result;
+
+    mHead = newHead;
+
+    result.cpu = mMemory->CpuBase() + aligned;
+    result.gpu = mMemory->GpuBase() + aligned;
+    result.offset = aligned;
+    result.size = size;
+    return result;
+}
+
+void UploadRing::Commit(uint64_t fenceValue)
+{
+    if (mHead == mCommitted)
+        return;
+
+    mPending.push_back({ fenceValue, mHead });
+    mCommitted = mHead;
+}
+
+void UploadRing::Retire(uint64_t completedFenceValue)
+{
+    while (!mPending.empty() && mPending.front().fence <= completedFenceValue)
+    {
+        mTail = mPending.front().end;
+        mPending.pop_front();
+    }
+}
@@ -0,0 +1,120 @@
+﻿#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#ifdef _WIN32
+#include <d3d12.h>
+#include <wrl/client.h>
+#endif
+
+// ===== Память под кольцо загрузки =====
+// Один постоянно отображённый диапазон: CPU пишет, GPU читает по тому же смещению
+class IUploadMemory
+{
+public:
+    virtual ~IUploadMemory() = default;
+
+    virtual uint8_t* CpuBase() const = 0;
+    virtual uint64_t GpuBase() const = 0;
+    virtual uint64_t Capacity() const = 0;
+};
+
+// Обычная куча вместо GPU-ресурса: для тестов и замеров без видеокарты.
+// GpuBase - адрес самой памяти, чтобы выравнивание проверялось так же
+class HeapUploadMemory : public IUploadMemory
+{
+public:
+    explicit HeapUploadMemory(uint64_t capacity);
+
+    uint8_t* CpuBase() const override { return mData; }
+    uint64_t GpuBase() const override { return (uint64_t)(uintptr_t)mData; }
+    uint64_t Capacity() const override { return mCapacity; }
+
+private:
+    static constexpr uint64_t BASE_ALIGNMENT = 65536;
+
+    std::unique_ptr<uint8_t[]> mStorage;
+    uint8_t* mData = nullptr;
+    uint64_t mCapacity = 0;
+};
+
+#ifdef _WIN32
+// Буфер в UPLOAD куче, Map один раз на всё время жизни
+class D3D12UploadMemory : public IUploadMemory
+{
+public:
+    D3D12UploadMemory() = default;
+    ~D3D12UploadMemory();
+
+    bool Initialize(ID3D12Device* device, uint64_t capacity);
+    void Shutdown();
+
+    uint8_t* CpuBase() const override { return mData; }
+    uint64_t GpuBase() const override;
+    uint64_t Capacity() const override { return mCapacity; }
+
+    ID3D12Resource* Resource() const { return mResource.Get(); }
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Resource> mResource;
+    uint8_t* mData = nullptr;
+    uint64_t mCapacity = 0;
+};
+#endif
+
+struct UploadAllocation
+{
+    uint8_t* cpu = nullptr;
+    uint64_t gpu = 0;       // GpuBase() + offset
+    uint64_t offset = 0;    // смещение от начала памяти кольца (для CopyBufferRegion)
+    uint64_t size = 0;
+
+    explicit operator bool() const { return cpu != nullptr; }
+};
+
+// ===== Линейное кольцо загрузки =====
+// Выделения идут подряд, при нехватке места в конце - перенос в начало.
+// Commit(fence) помечает всё выделенное с прошлого Commit значением fence,
+// Retire(completed) освобождает всё, что помечено fence <= completed.
+// Сам ни с GPU, ни с очередью не общается: fence приходят снаружи.
+class UploadRing
+{
+public:
+    // Выравнивание CBV
+    static constexpr uint64_t CONSTANT_BUFFER_ALIGNMENT = 256;
+
+    explicit UploadRing(IUploadMemory* memory = nullptr);
+
+    void Reset(IUploadMemory* memory);
+
+    // alignment - степень двойки. Пустой результат, если места нет до Retire
+    UploadAllocation Allocate(uint64_t size, uint64_t alignment = 16);
+
+    void Commit(uint64_t fenceValue);
+    void Retire(uint64_t completedFenceValue);
+
+    bool HasPending() const { return !mPending.empty(); }
+    uint64_t OldestPendingFence() const { return mPending.empty() ? 0 : mPending.front().fence; }
+
+    uint64_t Capacity() const { return mCapacity; }
+    uint64_t UsedBytes() const { return mHead - mTail; }       // включая ещё не помеченное
+    uint64_t UncommittedBytes() const { return mHead - mCommitted; }
+    IUploadMemory* Memory() const { return mMemory; }
+
+private:
+    struct PendingRange
+    {
+        uint64_t fence;
+        uint64_t end;   // mHead на момент Commit
+    };
+
+    IUploadMemory* mMemory = nullptr;
+    uint64_t mCapacity = 0;
+
+    // Монотонные позиции; смещение в памяти = позиция % mCapacity
+    uint64_t mHead = 0;
+    uint64_t mTail = 0;
+    uint64_t mCommitted = 0;
+    std::deque<PendingRange> mPending;
+};
@@ -0,0 +1,188 @@
+﻿#include "UploadScheduler.h"
+
+using Microsoft::WRL::ComPtr;
+
+UploadScheduler::~UploadScheduler()
+{
+    Shutdown();
+}
+
+bool UploadScheduler::Initialize(ID3D12Device* device, GpuMemoryManager* gpuMemory, uint64_t stagingCapacity)
+{
+    Shutdown();
+    mDevice = device;
+    mGpuMemory = gpuMemory;
+
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+
+    if (FAILED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&mCopyQueue))))
+        return false;
+
+    if (!mFenceQueue.Initialize(device, mCopyQueue.Get()))
+        return false;
+
+    if (!mStagingMemory.Initialize(device, stagingCapacity))
+        return false;
+    mStaging.Reset(&mStagingMemory);
+
+    return true;
+}
+
+void UploadScheduler::Shutdown()
+{
+    if (mCopyQueue && mFenceQueue.Fence())
+        WaitIdle();
+
+    mCopyList.Reset();
+    mCurrentAllocator.Reset();
+    mRetiringAllocators.clear();
+    mStaging.Reset(nullptr);
+    mStagingMemory.Shutdown();
+    mFenceQueue.Shutdown();
+    mCopyQueue.Reset();
+    mDevice = nullptr;
+    mGpuMemory = nullptr;
+    mRecording = false;
+    mPendingCopies = 0;
+}
+
+bool UploadScheduler::BeginBatch()
+{
+    if (mRecording)
+        return true;
+
+    // Аллокатор завершённого пакета, иначе новый
+    if (!mRetiringAllocators.empty() &&
+        mRetiringAllocators.front().fence <= mFenceQueue.CompletedValue())
+    {
+        mCurrentAllocator = mRetiringAllocators.front().allocator;
+        mRetiringAllocators.pop_front();
+        mCurrentAllocator->Reset();
+    }
+    else
+    {
+        mCurrentAllocator.Reset();
+        if (FAILED(mDevice->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&mCurrentAllocator))))
+            return false;
+    }
+
+    if (!mCopyList)
+    {
+        if (FAILED(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY,
+            mCurrentAllocator.Get(), nullptr, IID_PPV_ARGS(&mCopyList))))
+            return false;
+    }
+    else
+    {
+        mCopyList->Reset(mCurrentAllocator.Get(), nullptr);
+    }
+
+    mRecording = true;
+    return true;
+}
+
+UploadAllocation UploadScheduler::AllocateStaging(uint64_t size)
+{
+    UploadAllocation alloc = mStaging.Allocate(size, 16);
+    if (alloc)
+        return alloc;
+
+    // Кольцо занято копиями текущего пакета - отправляем его
+    if (mStaging.UncommittedBytes() != 0)
+    {
+        Submit();
+        if (!BeginBatch())
+            return alloc;
+    }
+
+    while (!alloc && mStaging.HasPending())
+    {
+        mFenceQueue.WaitForValue(mStaging.OldestPendingFence());
+        Retire();
+        alloc = mStaging.Allocate(size, 16);
+    }
+    return alloc;
+}
+
+ComPtr<ID3D12Resource> UploadScheduler::QueueBuffer(
+    const void* initData,
+    uint64_t byteSize,
+    GpuAllocation& outAllocation)
+{
+    ComPtr<ID3D12Resource> buffer;
+    if (!mDevice || !mGpuMemory || byteSize == 0 || !BeginBatch())
+        return buffer;
+
+    if (FAILED(mGpuMemory->CreateBuffer(byteSize, D3D12_RESOURCE_STATE_COMMON, buffer, outAllocation)))
+        return nullptr;
+
+    // Большие буферы - кусками не больше половины кольца
+    const uint64_t maxChunk = mStaging.Capacity() / 2;
+    const uint8_t* src = static_cast<const uint8_t*>(initData);
+    uint64_t copied = 0;
+
+    while (copied < byteSize)
+    {
+        uint64_t chunk = (byteSize - copied < maxChunk) ? byteSize - copied : maxChunk;
+        UploadAllocation alloc = AllocateStaging(chunk);
+        if (!alloc)
+        {
+            // Уже записанные куски ссылаются на buffer: ждём их и только потом отдаём память
+            WaitIdle();
+            buffer.Reset();
+            mGpuMemory->Free(outAllocation);
+            return nullptr;
+        }
+
+        memcpy(alloc.cpu, src + copied, chunk);
+        mCopyList->CopyBufferRegion(buffer.Get(), copied,
+            mStagingMemory.Resource(), alloc.offset, chunk);
+
+        copied += chunk;
+        mPendingCopies++;
+    }
+
+    return buffer;
+}
+
+uint64_t UploadScheduler::Submit()
+{
+    if (!mRecording)
+        return mLastSubmitted;
+
+    mCopyList->Close();
+    ID3D12CommandList* lists[] = { mCopyList.Get() };
+    mCopyQueue->ExecuteCommandLists(1, lists);
+
+    uint64_t fence = mFenceQueue.Signal();
+    mStaging.Commit(fence);
+    mRetiringAllocators.push_back({ fence, mCurrentAllocator });
+    mCurrentAllocator.Reset();
+
+    mRecording = false;
+    mPendingCopies = 0;
+    mLastSubmitted = fence;
+    return fence;
+}
+
+void UploadScheduler::WaitOnGpu(ID3D12CommandQueue* queue, uint64_t fenceValue) const
+{
+    if (fenceValue != 0)
+        queue->Wait(mFenceQueue.Fence(), fenceValue);
+}
+
+void UploadScheduler::Retire()
+{
+    mStaging.Retire(mFenceQueue.CompletedValue());
+}
+
+void UploadScheduler::WaitIdle()
+{
+    Submit();
+    if (mLastSubmitted != 0)
+        mFenceQueue.WaitForValue(mLastSubmitted);
+    Retire();
+}
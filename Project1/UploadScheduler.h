@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <deque>
+#include "FrameRing.h"
+#include "GpuMemory.h"
+#include "UploadRing.h"
+
+// ===== Пакетная загрузка буферов через copy-очередь =====
+// QueueBuffer только записывает копирование; Submit отправляет все накопленные
+// копии одним ExecuteCommandLists. Графическая очередь ждёт fence на GPU (WaitOnGpu),
+// CPU не блокируется. Промежуточная память - своё кольцо, освобождается в Retire.
+//
+// Буферы создаются в COMMON: copy-очередь неявно переводит их в COPY_DEST,
+// после выполнения они снова COMMON и графическая очередь читает их без барьеров.
+class UploadScheduler
+{
+public:
+    UploadScheduler() = default;
+    ~UploadScheduler();
+
+    // Буферы размещаются в gpuMemory
+    bool Initialize(ID3D12Device* device, GpuMemoryManager* gpuMemory, uint64_t stagingCapacity);
+    void Shutdown();
+
+    // DEFAULT буфер с данными initData. Готов после того, как очередь дождётся Submit().
+    // outAllocation освобождается вызывающим через GpuMemoryManager::Free
+    Microsoft::WRL::ComPtr<ID3D12Resource> QueueBuffer(
+        const void* initData,
+        uint64_t byteSize,
+        GpuAllocation& outAllocation);
+
+    // Отправляет накопленные копии, возвращает fence последнего отправленного пакета
+    uint64_t Submit();
+
+    // queue не начнёт следующие команды, пока copy-очередь не дойдёт до fenceValue
+    void WaitOnGpu(ID3D12CommandQueue* queue, uint64_t fenceValue) const;
+
+    // Освобождает промежуточную память и аллокаторы завершённых пакетов
+    void Retire();
+
+    // Отправляет остаток и ждёт copy-очередь на CPU
+    void WaitIdle();
+
+    uint64_t LastSubmittedFence() const { return mLastSubmitted; }
+    uint64_t PendingCopyCount() const { return mPendingCopies; }
+
+private:
+    bool BeginBatch();
+    UploadAllocation AllocateStaging(uint64_t size);
+
+    struct RetiringAllocator
+    {
+        uint64_t fence;
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+    };
+
+    ID3D12Device* mDevice = nullptr;
+    GpuMemoryManager* mGpuMemory = nullptr;
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> mCopyQueue;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCopyList;
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mCurrentAllocator;
+    std::deque<RetiringAllocator> mRetiringAllocators;
+    D3D12FenceQueue mFenceQueue;
+
+    D3D12UploadMemory mStagingMemory;
+    UploadRing mStaging;
+
+    bool mRecording = false;
+    uint64_t mPendingCopies = 0;
+    uint64_t mLastSubmitted = 0;
+};
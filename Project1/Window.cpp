@@ -99,14 +99,15 @@ LRESULT CALLBACK Window::WindowProc(HWND hWnd, UINT message,
         // Начали изменять размер окна - пауза
         if (window && window->GetDirectXApp()) {
             window->GetDirectXApp()->StopTimer();
+            window->GetDirectXApp()->OnEnterSizeMove();
         }
         return 0;
 
     case WM_EXITSIZEMOVE:
-        // Закончили изменять размер окна
+        // Закончили изменять размер окна - swap chain пересоберётся на следующем кадре
         if (window && window->GetDirectXApp()) {
             window->GetDirectXApp()->StartTimer();
-            // TODO: Вызвать OnResize() для пересоздания swap chain
+            window->GetDirectXApp()->OnExitSizeMove();
         }
         return 0;
 
@@ -159,7 +160,13 @@ LRESULT CALLBACK Window::WindowProc(HWND hWnd, UINT message,
         if (window) {
             window->width = LOWORD(lParam);
             window->height = HIWORD(lParam);
-            // TODO: Обработка изменения размера окна
+
+            if (window->GetDirectXApp()) {
+                SizeEvent event = wParam == SIZE_MINIMIZED ? SizeEvent::Minimized
+                    : wParam == SIZE_MAXIMIZED ? SizeEvent::Maximized
+                    : SizeEvent::Restored;
+                window->GetDirectXApp()->OnSizeEvent(window->width, window->height, event);
+            }
         }
         break;
 
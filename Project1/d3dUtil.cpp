@@ -1,19 +1,27 @@
 ﻿#include "d3dUtil.h"
 #include "ThrowIfFailed.h"
+#include "ShaderCache.h"
+
+#include <cstring>
 
 namespace d3dUtil
 {
+    UINT DefaultShaderCompileFlags()
+    {
+#ifdef _DEBUG
+        return D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+        return 0;
+#endif
+    }
+
     Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
         const std::wstring& filename,
         const D3D_SHADER_MACRO* defines,
         const std::string& entrypoint,
-        const std::string& target)
+        const std::string& target,
+        UINT compileFlags)
     {
-        UINT compileFlags = 0;
-#ifdef _DEBUG
-        compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
         Microsoft::WRL::ComPtr<ID3DBlob> byteCode = nullptr;
         Microsoft::WRL::ComPtr<ID3DBlob> errors;
 
@@ -40,6 +48,41 @@ namespace d3dUtil
         return byteCode;
     }
 
+    Microsoft::WRL::ComPtr<ID3DBlob> CompileShaderCached(
+        ShaderCache& cache,
+        const std::string& filename,
+        const D3D_SHADER_MACRO* defines,
+        const std::string& entrypoint,
+        const std::string& target,
+        UINT compileFlags)
+    {
+        const std::wstring wideFilename(filename.begin(), filename.end());
+
+        std::vector<ShaderDefine> keyDefines;
+        for (const D3D_SHADER_MACRO* d = defines; d && d->Name; d++)
+            keyDefines.push_back({ d->Name, d->Definition ? d->Definition : "" });
+
+        uint64_t hash = 0;
+        if (!cache.MakeKey(filename, keyDefines, entrypoint, target, compileFlags, hash))
+            return CompileShader(wideFilename, defines, entrypoint, target, compileFlags);
+
+        std::vector<uint8_t> cached;
+        if (cache.Load(hash, cached))
+        {
+            Microsoft::WRL::ComPtr<ID3DBlob> blob;
+            ThrowIfFailed(D3DCreateBlob(cached.size(), &blob));
+            memcpy(blob->GetBufferPointer(), cached.data(), cached.size());
+            return blob;
+        }
+
+        Microsoft::WRL::ComPtr<ID3DBlob> byteCode =
+            CompileShader(wideFilename, defines, entrypoint, target, compileFlags);
+
+        // Кэш - только ускорение, ошибка записи не мешает запуску
+        cache.Store(hash, byteCode->GetBufferPointer(), byteCode->GetBufferSize());
+        return byteCode;
+    }
+
     UINT CalcConstantBufferByteSize(UINT byteSize)
     {
         // Constant buffers must be a multiple of 256 bytes.
@@ -5,13 +5,28 @@
 #include <string>
 #include <vector>
 
+class ShaderCache;
+
 namespace d3dUtil
 {
+    // Debug: отладочная информация без оптимизаций
+    UINT DefaultShaderCompileFlags();
+
     Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
         const std::wstring& filename,
         const D3D_SHADER_MACRO* defines,
         const std::string& entrypoint,
-        const std::string& target);
+        const std::string& target,
+        UINT compileFlags = DefaultShaderCompileFlags());
+
+    // Байткод из кэша (одно чтение файла); при промахе компилирует и сохраняет
+    Microsoft::WRL::ComPtr<ID3DBlob> CompileShaderCached(
+        ShaderCache& cache,
+        const std::string& filename,
+        const D3D_SHADER_MACRO* defines,
+        const std::string& entrypoint,
+        const std::string& target,
+        UINT compileFlags = DefaultShaderCompileFlags());
 
     UINT CalcConstantBufferByteSize(UINT byteSize);
 }
\ No newline at end of file
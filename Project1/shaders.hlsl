@@ -1,8 +1,24 @@
 cbuffer cbPerObject : register(b0)
 {
     float4x4 mWorldViewProj;
+    float4 mPosScale;
+    float4 mPosOffset;
+    float4x4 mViewProj;
 };
 
+// Корневая константа на вызов: первый экземпляр группы (SV_InstanceID начинается с нуля)
+cbuffer cbPerDraw : register(b1)
+{
+    uint gInstanceBase;
+};
+
+// Мировые матрицы экземпляров (InstanceBatcher.h), корневой SRV на весь кадр
+struct InstanceData
+{
+    float4x4 World;
+};
+StructuredBuffer<InstanceData> gInstances : register(t0);
+
 struct VSInput
 {
     float3 Pos : POSITION;
@@ -23,6 +39,70 @@ PSInput VS(VSInput vin)
     return vout;
 }
 
+// Мировая матрица экземпляра и проекция - общие для всех инстансных вариантов
+float4 InstancePosH(float3 pos, uint instanceID)
+{
+    float4 posW = mul(float4(pos, 1.0f), gInstances[gInstanceBase + instanceID].World);
+    return mul(posW, mViewProj);
+}
+
+PSInput VSInstanced(VSInput vin, uint instanceID : SV_InstanceID)
+{
+    PSInput vout;
+    vout.PosH = InstancePosH(vin.Pos, instanceID);
+    vout.Color = vin.Color;
+    return vout;
+}
+
+// Меш без цвета (OBJ): в буфере только позиции, цвет белый, как у пустого потока MeshStreams
+struct VSPositionInput
+{
+    float3 Pos : POSITION;
+};
+
+PSInput VSInstancedNoColor(VSPositionInput vin, uint instanceID : SV_InstanceID)
+{
+    PSInput vout;
+    vout.PosH = InstancePosH(vin.Pos, instanceID);
+    vout.Color = float4(1.0f, 1.0f, 1.0f, 1.0f);
+    return vout;
+}
+
+// Сжатые вершины (QuantizedVertex.h): позиция UNORM16 относительно габаритов меша.
+// Нормаль в формате есть, но освещения нет ни в одном варианте: цвет идёт как в VSInstanced
+struct VSQuantizedInput
+{
+    float4 Pos : POSITION;
+    float4 Color : COLOR;
+};
+
+struct VSQuantizedPositionInput
+{
+    float4 Pos : POSITION;
+};
+
+// mPosScale/mPosOffset - габариты меша из QuantizeMesh
+float3 DecodeQuantizedPosition(float4 q)
+{
+    return q.xyz * mPosScale.xyz + mPosOffset.xyz;
+}
+
+PSInput VSQuantized(VSQuantizedInput vin, uint instanceID : SV_InstanceID)
+{
+    PSInput vout;
+    vout.PosH = InstancePosH(DecodeQuantizedPosition(vin.Pos), instanceID);
+    vout.Color = vin.Color;
+    return vout;
+}
+
+PSInput VSQuantizedNoColor(VSQuantizedPositionInput vin, uint instanceID : SV_InstanceID)
+{
+    PSInput vout;
+    vout.PosH = InstancePosH(DecodeQuantizedPosition(vin.Pos), instanceID);
+    vout.Color = float4(1.0f, 1.0f, 1.0f, 1.0f);
+    return vout;
+}
+
 float4 PS(PSInput pin) : SV_TARGET
 {
     return pin.Color;
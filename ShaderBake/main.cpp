@@ -0,0 +1,65 @@
+﻿// Офлайн-компиляция шейдеров: все SHADER_PERMUTATIONS в кэш байткода (тот же формат, что читает BuildShaders)
+#include "ShaderCache.h"
+#include "d3dUtil.h"
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: ShaderBake <shader source dir> [cache dir]\n");
+        return 1;
+    }
+
+    const std::string sourceDir = argv[1];
+    const std::string cacheDir = (argc > 2) ? argv[2] : sourceDir + "/ShaderCache";
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Флаги и Release, и Debug сборки приложения
+    const UINT flagSets[] = { 0, D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION };
+
+    ShaderCache cache(cacheDir);
+    std::vector<uint64_t> liveKeys;
+    int failed = 0;
+
+    for (const ShaderPermutation& permutation : SHADER_PERMUTATIONS) {
+        const std::string sourcePath = sourceDir + "/" + permutation.file;
+
+        for (UINT flags : flagSets) {
+            uint64_t key = 0;
+            if (!cache.MakeKey(sourcePath, {}, permutation.entryPoint, permutation.target, flags, key)) {
+                printf("Failed to open %s\n", sourcePath.c_str());
+                return 1;
+            }
+            liveKeys.push_back(key);
+
+            try {
+                // Уже в кэше - пропускается, иначе компилируется и записывается
+                d3dUtil::CompileShaderCached(cache, sourcePath, nullptr,
+                    permutation.entryPoint, permutation.target, flags);
+            }
+            catch (const std::exception&) {
+                printf("Failed to compile %s %s (%s)\n",
+                    permutation.file, permutation.entryPoint, permutation.target);
+                failed++;
+            }
+        }
+    }
+
+    // Устаревшие ключи (исходник менялся) больше никогда не найдутся
+    size_t removed = cache.RemoveStale(liveKeys);
+
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    const ShaderCacheStats& stats = cache.GetStats();
+    printf("%s: %zu shaders, %u up to date, %u compiled, %zu stale removed (%.1f ms)\n",
+        cacheDir.c_str(), liveKeys.size(), stats.hits, stats.stores, removed, ms);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+﻿#include "UnitTest.h"
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Камера как в DirectXApp: LookAt * PerspectiveFov, пирамида в мировых координатах
+    Frustum MakeFrustum(const XMFLOAT3& eye, const XMFLOAT3& target, float fovY, float nearZ, float farZ)
+    {
+        const XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        const XMMATRIX proj = XMMatrixPerspectiveFovLH(fovY, 16.0f / 9.0f, nearZ, farZ);
+        XMFLOAT4X4 viewProj;
+        XMStoreFloat4x4(&viewProj, view * proj);
+        return Frustum::FromMatrix(viewProj);
+    }
+
+    int ClassifyBox(const Frustum& frustum, const XMFLOAT3& lo, const XMFLOAT3& hi)
+    {
+        const XMVECTOR l = XMLoadFloat3(&lo);
+        const XMVECTOR h = XMLoadFloat3(&hi);
+        return frustum.Classify(XMVectorScale(XMVectorAdd(l, h), 0.5f), XMVectorScale(XMVectorSubtract(h, l), 0.5f));
+    }
+
+    // Случайные коробки разного размера в кубе [-50; 50]
+    void RandomBoxes(size_t count, uint32_t seed, std::vector<XMFLOAT3>& boundsMin, std::vector<XMFLOAT3>& boundsMax)
+    {
+        auto next = [&]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / float(1 << 24); };
+        boundsMin.resize(count);
+        boundsMax.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const XMFLOAT3 center(next() * 100.0f - 50.0f, next() * 100.0f - 50.0f, next() * 100.0f - 50.0f);
+            const float size = next() < 0.9f ? next() * 2.0f : next() * 15.0f;
+            boundsMin[i] = XMFLOAT3(center.x - size, center.y - size * 0.5f, center.z - size);
+            boundsMax[i] = XMFLOAT3(center.x + size, center.y + size * 0.5f, center.z + size);
+        }
+    }
+}
+
+// Плоскости пирамиды: внутри, снаружи с каждой стороны, поперёк ближней плоскости; сфера так же
+TEST(FrustumClassifiesBoxesAndSpheres)
+{
+    const Frustum frustum = MakeFrustum(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 1), XM_PIDIV2, 1.0f, 100.0f);
+
+    CHECK(ClassifyBox(frustum, XMFLOAT3(-1, -1, 9), XMFLOAT3(1, 1, 11)) == 1);
+    CHECK(ClassifyBox(frustum, XMFLOAT3(-1, -1, -11), XMFLOAT3(1, 1, -9)) == -1);    // сзади
+    CHECK(ClassifyBox(frustum, XMFLOAT3(-1, -1, 101), XMFLOAT3(1, 1, 103)) == -1);   // за дальней
+    CHECK(ClassifyBox(frustum, XMFLOAT3(30, -1, 9), XMFLOAT3(32, 1, 11)) == -1);     // справа
+    CHECK(ClassifyBox(frustum, XMFLOAT3(-32, -1, 9), XMFLOAT3(-30, 1, 11)) == -1);   // слева
+    CHECK(ClassifyBox(frustum, XMFLOAT3(-1, 12, 9), XMFLOAT3(1, 14, 11)) == -1);     // сверху
+    CHECK(ClassifyBox(frustum, XMFLOAT3(-1, -14, 9), XMFLOAT3(1, -12, 11)) == -1);   // снизу
+    CHECK(ClassifyBox(frustum, XMFLOAT3(-1, -1, 0), XMFLOAT3(1, 1, 2)) == 0);        // поперёк ближней
+    CHECK(ClassifyBox(frustum, XMFLOAT3(16, -1, 9), XMFLOAT3(20, 1, 11)) == 0);      // поперёк правой
+
+    CHECK(!frustum.IsSphereOutside(XMVectorSet(0, 0, 10, 0), 1.0f));
+    CHECK(!frustum.IsSphereOutside(XMVectorSet(0, 0, -0.5f, 0), 2.0f));
+    CHECK(frustum.IsSphereOutside(XMVectorSet(0, 0, -5, 0), 2.0f));
+    CHECK(frustum.IsSphereOutside(XMVectorSet(0, 0, 110, 0), 5.0f));
+    CHECK(frustum.IsSphereOutside(XMVectorSet(30, 0, 10, 0), 1.0f));
+}
+
+// Дерево: каждый элемент ровно в одном листе, узел накрывает свои элементы, листья не больше maxLeafItems
+TEST(BvhBuildInvariants)
+{
+    std::vector<XMFLOAT3> boundsMin, boundsMax;
+    RandomBoxes(1000, 3, boundsMin, boundsMax);
+
+    for (uint32_t maxLeaf : { 1u, 2u, 7u })
+    {
+        Bvh bvh;
+        bvh.Build(boundsMin.data(), boundsMax.data(), boundsMin.size(), maxLeaf);
+        CHECK(bvh.ItemCount() == boundsMin.size());
+
+        std::vector<uint32_t> items = bvh.Items();
+        std::sort(items.begin(), items.end());
+        bool permutation = true;
+        for (size_t i = 0; i < items.size(); i++)
+            permutation = permutation && items[i] == i;
+        CHECK(permutation);
+
+        const std::vector<BvhNode>& nodes = bvh.Nodes();
+        bool encloses = true, childrenSplit = true, leavesSmall = true;
+        for (const BvhNode& node : nodes)
+        {
+            for (uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+            {
+                const uint32_t item = bvh.Items()[i];
+                encloses = encloses &&
+                    boundsMin[item].x >= node.center.x - node.extents.x - 1e-4f && boundsMax[item].x <= node.center.x + node.extents.x + 1e-4f &&
+                    boundsMin[item].y >= node.center.y - node.extents.y - 1e-4f && boundsMax[item].y <= node.center.y + node.extents.y + 1e-4f &&
+                    boundsMin[item].z >= node.center.z - node.extents.z - 1e-4f && boundsMax[item].z <= node.center.z + node.extents.z + 1e-4f;
+            }
+
+            if (node.leftChild != 0)
+            {
+                const BvhNode& l = nodes[node.leftChild];
+                const BvhNode& r = nodes[node.leftChild + 1];
+                childrenSplit = childrenSplit && l.firstItem == node.firstItem &&
+                    r.firstItem == l.firstItem + l.itemCount && l.itemCount + r.itemCount == node.itemCount;
+            }
+            else
+            {
+                leavesSmall = leavesSmall && node.itemCount <= maxLeaf;
+            }
+        }
+        CHECK(encloses);
+        CHECK(childrenSplit);
+        CHECK(leavesSmall);
+    }
+
+    // Пустое дерево и дерево из одного элемента
+    Bvh empty;
+    empty.Build(boundsMin.data(), boundsMax.data(), 0);
+    std::vector<uint32_t> visible;
+    CullStats stats;
+    empty.Cull(MakeFrustum(XMFLOAT3(0, 0, -100), XMFLOAT3(0, 0, 0), XM_PIDIV4, 0.1f, 1000.0f), visible, &stats);
+    CHECK(visible.empty() && stats.nodesTested == 0);
+
+    Bvh single;
+    single.Build(boundsMin.data(), boundsMax.data(), 1);
+    CHECK(single.Nodes().size() == 1 && single.Items().size() == 1);
+}
+
+// Отсечение деревом даёт ровно те элементы, что и проверка каждой коробки, и пропускает поддеревья
+TEST(BvhCullMatchesBruteForce)
+{
+    std::vector<XMFLOAT3> boundsMin, boundsMax;
+    RandomBoxes(3000, 11, boundsMin, boundsMax);
+
+    Bvh bvh;
+    bvh.Build(boundsMin.data(), boundsMax.data(), boundsMin.size());
+
+    const XMFLOAT3 eyes[] = { { 0, 0, -120 }, { 0, 0, 0 }, { 60, 30, 60 }, { -20, 5, 10 }, { 0, 200, 0 } };
+    const XMFLOAT3 targets[] = { { 0, 0, 0 }, { 1, 0.2f, 1 }, { 0, 0, 0 }, { -60, 0, 40 }, { 0.1f, 0, 0.1f } };
+    const float fovs[] = { XM_PIDIV4, XM_PIDIV2, 0.3f, XM_PIDIV4, 1.2f };
+
+    for (size_t v = 0; v < sizeof(fovs) / sizeof(fovs[0]); v++)
+    {
+        const Frustum frustum = MakeFrustum(eyes[v], targets[v], fovs[v], 0.5f, 150.0f);
+
+        std::vector<uint32_t> visible;
+        CullStats stats;
+        bvh.Cull(frustum, visible, &stats);
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < (uint32_t)boundsMin.size(); i++)
+        {
+            if (ClassifyBox(frustum, boundsMin[i], boundsMax[i]) >= 0)
+                expected.push_back(i);
+        }
+
+        std::sort(visible.begin(), visible.end());
+        CHECK(std::adjacent_find(visible.begin(), visible.end()) == visible.end());
+        CHECK(visible == expected);
+        CHECK(stats.itemsVisible == visible.size() && stats.itemsVisible + stats.itemsCulled == bvh.ItemCount());
+        CHECK(stats.itemsTested <= bvh.ItemCount());
+
+        // Поддеревья снаружи и целиком внутри не раскрываются
+        CHECK(stats.nodesTested * 2 < bvh.Nodes().size());
+
+        // Cull дописывает, а не заменяет
+        std::vector<uint32_t> appended = { 123456 };
+        bvh.Cull(frustum, appended, nullptr);
+        CHECK(appended.size() == visible.size() + 1 && appended[0] == 123456);
+    }
+}
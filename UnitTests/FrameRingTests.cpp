@@ -0,0 +1,132 @@
+﻿#include "UnitTest.h"
+#include "FrameRing.h"
+
+#include <vector>
+
+namespace
+{
+    // GPU без GPU: сигналы нумеруются подряд, завершение двигает тест (Complete) или
+    // ожидание CPU - WaitForValue сразу "доделывает" работу до нужного значения
+    class MockFenceQueue : public IFenceQueue
+    {
+    public:
+        uint64_t Signal() override { return ++mSignaled; }
+        uint64_t CompletedValue() const override { return mCompleted; }
+
+        void WaitForValue(uint64_t value) override
+        {
+            waits.push_back(value);
+            if (value > mCompleted)
+                mCompleted = value;
+        }
+
+        // GPU отстаёт от CPU на lag сигналов; завершённое значение не убывает
+        void CompleteWithLag(uint64_t lag)
+        {
+            if (mSignaled > lag && mSignaled - lag > mCompleted)
+                mCompleted = mSignaled - lag;
+        }
+
+        uint64_t Signaled() const { return mSignaled; }
+
+        std::vector<uint64_t> waits;
+
+    private:
+        uint64_t mSignaled = 0;
+        uint64_t mCompleted = 0;
+    };
+}
+
+// Слоты идут по кругу, fence слота - сигнал его кадра
+TEST(FrameRingCyclesSlots)
+{
+    MockFenceQueue queue;
+    FrameRing ring(queue, 3);
+    CHECK(ring.FrameCount() == 3);
+
+    for (uint32_t frame = 0; frame < 10; frame++)
+    {
+        CHECK(ring.BeginFrame() == frame % 3);
+        const uint64_t fence = ring.EndFrame();
+        CHECK(fence == frame + 1);
+        CHECK(ring.FrameFence(frame % 3) == fence);
+        queue.CompleteWithLag(0);
+    }
+    CHECK(ring.StallCount() == 0);
+    CHECK(queue.waits.empty());
+}
+
+// Пока GPU отстаёт меньше чем на FrameCount кадров, CPU не ждёт; на FrameCount - ждёт каждый кадр,
+// и ровно fence того кадра, что занимал слот
+TEST(FrameRingStallsOnlyWhenFullRingAhead)
+{
+    for (uint64_t lag = 0; lag <= 4; lag++)
+    {
+        MockFenceQueue queue;
+        FrameRing ring(queue, 3);
+
+        for (int frame = 0; frame < 30; frame++)
+        {
+            const uint32_t slot = ring.BeginFrame();
+            // Инвариант: к началу кадра прошлый кадр этого слота завершён
+            CHECK(queue.CompletedValue() >= ring.FrameFence(slot));
+            ring.EndFrame();
+            queue.CompleteWithLag(lag);
+        }
+
+        if (lag < 3)
+        {
+            CHECK(ring.StallCount() == 0);
+        }
+        else
+        {
+            // Первые три кадра слоты свободны
+            CHECK(ring.StallCount() == 27);
+            bool exact = queue.waits.size() == 27;
+            for (size_t i = 0; exact && i < queue.waits.size(); i++)
+                exact = queue.waits[i] == i + 1;
+            CHECK(exact);
+        }
+    }
+}
+
+// WaitIdle ждёт последний сигнал и не трогает очередь, если всё уже завершено
+TEST(FrameRingWaitIdle)
+{
+    MockFenceQueue queue;
+    FrameRing ring(queue, 2);
+
+    ring.WaitIdle();
+    CHECK(queue.waits.empty());
+
+    for (int frame = 0; frame < 2; frame++)
+    {
+        ring.BeginFrame();
+        ring.EndFrame();
+    }
+    ring.WaitIdle();
+    CHECK(queue.waits.size() == 1 && queue.waits[0] == queue.Signaled());
+    CHECK(queue.CompletedValue() == queue.Signaled());
+
+    ring.WaitIdle();
+    CHECK(queue.waits.size() == 1);
+
+    // После WaitIdle все слоты свободны - следующий кадр не ждёт
+    ring.BeginFrame();
+    CHECK(ring.StallCount() == 0);
+}
+
+// Ноль кадров в полёте - один слот: каждый кадр ждёт предыдущий
+TEST(FrameRingSingleSlot)
+{
+    MockFenceQueue queue;
+    FrameRing ring(queue, 0);
+    CHECK(ring.FrameCount() == 1);
+
+    for (int frame = 0; frame < 5; frame++)
+    {
+        CHECK(ring.BeginFrame() == 0);
+        ring.EndFrame();
+    }
+    CHECK(ring.StallCount() == 4);
+}
@@ -0,0 +1,186 @@
+﻿#include "UnitTest.h"
+#include "TestMeshes.h"
+#include "MeshCache.h"
+#include "MeshClusters.h"
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "MeshStreams.h"
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr uint64_t SOURCE_HASH = 0x1234;
+    constexpr uint64_t SOURCE_SIZE = 5678;
+
+    // Сфера с кластерами, мешлетами и LOD - тем же конвейером, что в BuildObj
+    struct CachedSphere
+    {
+        MeshStreams mesh;
+        std::vector<MeshCluster> clusters;
+        MeshletData meshlets;
+        std::vector<MeshLod> lods;
+
+        CachedSphere()
+        {
+            TestMesh sphere;
+            AppendSphere(sphere, 0.0f, 0.0f, 0.0f, 1.0f, 24, 12);
+            for (size_t i = 0; i < sphere.VertexCount(); i++)
+            {
+                const XMFLOAT3 p(sphere.positions[3 * i], sphere.positions[3 * i + 1], sphere.positions[3 * i + 2]);
+                mesh.positions.push_back(p);
+                mesh.normals.push_back(p);
+            }
+            mesh.indices = sphere.indices;
+
+            OptimizeMesh(mesh, &clusters);
+            BuildMeshlets(mesh.indices.data(), mesh.indices.size(), &mesh.positions[0].x, mesh.VertexCount(),
+                sizeof(XMFLOAT3), clusters.data(), clusters.size(), meshlets);
+            BuildLodChain(mesh.indices, mesh.indices.size(), &mesh.positions[0].x, mesh.VertexCount(), sizeof(XMFLOAT3),
+                MESH_LOD_RATIOS, sizeof(MESH_LOD_RATIOS) / sizeof(MESH_LOD_RATIOS[0]), lods);
+        }
+    };
+
+    std::vector<char> BuildCacheBytes(const std::string& path)
+    {
+        const CachedSphere sphere;
+        if (!WriteMeshCache(path, SOURCE_HASH, SOURCE_SIZE, sphere.mesh, sphere.clusters, sphere.meshlets, sphere.lods))
+            return {};
+
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Смещения секций по заголовку, в порядке MeshCache.h
+    struct CacheLayout
+    {
+        MeshCacheHeader header;
+        size_t indices, clusters, lods, meshlets, meshletVertices, meshletTriangles;
+
+        explicit CacheLayout(const std::vector<char>& bytes)
+        {
+            memcpy(&header, bytes.data(), sizeof(header));
+            indices = sizeof(MeshCacheHeader) + ((size_t)header.vertexCount + header.normalCount) * sizeof(XMFLOAT3);
+            clusters = indices + (size_t)header.indexCount * sizeof(uint32_t);
+            lods = clusters + (size_t)header.clusterCount * sizeof(MeshCluster);
+            meshlets = lods + (size_t)header.lodCount * sizeof(MeshLod);
+            meshletVertices = meshlets + (size_t)header.meshletCount * (sizeof(Meshlet) + sizeof(MeshletBounds));
+            meshletTriangles = meshletVertices + (size_t)header.meshletVertexCount * sizeof(uint32_t);
+        }
+    };
+
+    template<typename T>
+    void Patch(std::vector<char>& bytes, size_t offset, const T& value)
+    {
+        memcpy(bytes.data() + offset, &value, sizeof(T));
+    }
+
+    bool OpensAfterPatch(const std::vector<char>& original, const std::string& path,
+        const std::function<void(std::vector<char>&, const CacheLayout&)>& patch)
+    {
+        std::vector<char> bytes = original;
+        patch(bytes, CacheLayout(original));
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), (std::streamsize)bytes.size());
+
+        MeshCacheView view;
+        return view.Open(path, SOURCE_HASH, SOURCE_SIZE);
+    }
+}
+
+// Целый кэш открывается; любой диапазон или индекс за пределами своей секции - отказ,
+// а не чтение мимо файла в BuildObj
+TEST(MeshCacheRejectsOutOfRangeSections)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "UnitTestsSphere.meshcache").string();
+    const std::vector<char> original = BuildCacheBytes(path);
+    CHECK(!original.empty());
+    if (original.empty())
+        return;
+
+    const CacheLayout layout(original);
+    CHECK(layout.header.clusterCount > 1 && layout.header.meshletCount > 1 && layout.header.lodCount > 1);
+    CHECK(OpensAfterPatch(original, path, [](std::vector<char>&, const CacheLayout&) {}));
+
+    // Индекс вершины
+    CHECK(!OpensAfterPatch(original, path, [](std::vector<char>& b, const CacheLayout& l)
+        { Patch(b, l.indices + 4 * sizeof(uint32_t), l.header.vertexCount); }));
+
+    // LOD: конец за индексным буфером и переполнение first + count
+    CHECK(!OpensAfterPatch(original, path, [](std::vector<char>& b, const CacheLayout& l)
+        { Patch(b, l.lods + sizeof(MeshLod) + offsetof(MeshLod, indexCount), l.header.indexCount); }));
+    CHECK(!OpensAfterPatch(original, path, [](std::vector<char>& b, const CacheLayout& l)
+        { Patch(b, l.lods + sizeof(MeshLod) + offsetof(MeshLod, firstIndex), 0xFFFFFFF0u); }));
+
+    // Кластер: индексы и мешлеты
+    CHECK(!OpensAfterPatch(original, path, [](std::vector<char>& b, const CacheLayout& l)
+        { Patch(b, l.clusters + offsetof(MeshCluster, firstIndex), l.header.indexCount - 2); }));
+    CHECK(!OpensAfterPatch(original, path, [](std::vector<char>& b, const CacheLayout& l)
+        { Patch(b, l.clusters + offsetof(MeshCluster, meshletCount), l.header.meshletCount + 1); }));
+
+    // Мешлет: свои вершины, байты треугольников, диапазон индексов, локальный индекс
+    CHECK(!OpensAfterPatch(original, path, [](std::vector<char>& b, const CacheLayout& l)
+        { Patch(b, l.meshlets + offsetof(Meshlet, vertexOffset), l.header.meshletVertexCount); }));
+    CHECK(!OpensAfterPatch(original, path, [](std::vector<char>& b, const CacheLayout& l)
+        { Patch(b, l.meshlets + offsetof(Meshlet, triangleOffset), l.header.meshletTriangleBytes - 3); }));
+    CHECK(!OpensAfterPatch(original, path, [](std::vector<char>& b, const CacheLayout& l)
+        { Patch(b, l.meshlets + offsetof(Meshlet, firstIndex), l.header.indexCount); }));
+    CHECK(!OpensAfterPatch(original, path, [](std::vector<char>& b, const CacheLayout& l)
+        { Patch(b, l.meshletTriangles, (uint8_t)MESHLET_MAX_VERTICES); }));
+    CHECK(!OpensAfterPatch(original, path, [](std::vector<char>& b, const CacheLayout& l)
+        { Patch(b, l.meshletVertices, l.header.vertexCount); }));
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+// Кэш хранит потоки позиций и нормалей как есть, цвет не пишется; без нормалей - только позиции
+TEST(MeshCacheStoresStreams)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "UnitTestsStreams.meshcache").string();
+    CachedSphere sphere;
+    CHECK(WriteMeshCache(path, SOURCE_HASH, SOURCE_SIZE, sphere.mesh, sphere.clusters, sphere.meshlets, sphere.lods));
+
+    {
+        MeshCacheView view;
+        CHECK(view.Open(path, SOURCE_HASH, SOURCE_SIZE));
+        if (view.IsOpen())
+        {
+            const size_t count = sphere.mesh.VertexCount();
+            CHECK(view.Header().vertexCount == count && view.Header().normalCount == count);
+            CHECK(view.PositionByteSize() == count * sizeof(XMFLOAT3));
+            CHECK(memcmp(view.Positions(), sphere.mesh.positions.data(), view.PositionByteSize()) == 0);
+            CHECK(view.Normals() && memcmp(view.Normals(), sphere.mesh.normals.data(), view.PositionByteSize()) == 0);
+            CHECK(memcmp(view.Indices(), sphere.mesh.indices.data(), view.IndexByteSize()) == 0);
+        }
+    }
+
+    // Цвет в файл не попадает, нормали можно не хранить
+    sphere.mesh.colors.assign(sphere.mesh.VertexCount(), XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f));
+    sphere.mesh.normals.clear();
+    CHECK(WriteMeshCache(path, SOURCE_HASH, SOURCE_SIZE, sphere.mesh, sphere.clusters, sphere.meshlets, sphere.lods));
+    {
+        MeshCacheView view;
+        CHECK(view.Open(path, SOURCE_HASH, SOURCE_SIZE));
+        CHECK(view.IsOpen() && view.Header().normalCount == 0 && view.Normals() == nullptr);
+        CHECK(view.IsOpen() && memcmp(view.Indices(), sphere.mesh.indices.data(), view.IndexByteSize()) == 0);
+        CHECK(std::filesystem::file_size(path) == sizeof(MeshCacheHeader) + view.PositionByteSize() +
+            view.IndexByteSize() + sphere.clusters.size() * sizeof(MeshCluster) + sphere.lods.size() * sizeof(MeshLod) +
+            sphere.meshlets.meshlets.size() * (sizeof(Meshlet) + sizeof(MeshletBounds)) +
+            sphere.meshlets.vertices.size() * sizeof(uint32_t) + sphere.meshlets.triangles.size());
+    }
+
+    // Нормалей меньше, чем позиций, - не пишется
+    sphere.mesh.normals.assign(3, XMFLOAT3(0.0f, 1.0f, 0.0f));
+    CHECK(!WriteMeshCache(path + ".bad", SOURCE_HASH, SOURCE_SIZE, sphere.mesh, sphere.clusters, sphere.meshlets, sphere.lods));
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
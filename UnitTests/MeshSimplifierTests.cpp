@@ -0,0 +1,76 @@
+﻿#include "UnitTest.h"
+#include "TestMeshes.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Заявленная ошибка каждого LOD - расстояние до его поверхности, а не грубая оценка сверху:
+// от перебора MeasureSimplifyError она не отличается ни вверх, ни (заметно) вниз
+TEST(SimplifyErrorMatchesMeasuredDeviation)
+{
+    TestMesh mesh = BuildMixedScene();
+    const size_t baseIndexCount = mesh.indices.size();
+
+    std::vector<MeshLod> lods;
+    BuildLodChain(mesh.indices, baseIndexCount, mesh.positions.data(), mesh.VertexCount(), mesh.Stride(),
+        MESH_LOD_RATIOS, sizeof(MESH_LOD_RATIOS) / sizeof(MESH_LOD_RATIOS[0]), lods);
+    CHECK(lods.size() >= 3);
+
+    for (size_t i = 1; i < lods.size(); i++)
+    {
+        const float measured = MeasureSimplifyError(mesh.indices.data(), baseIndexCount,
+            mesh.indices.data() + lods[i].firstIndex, lods[i].indexCount,
+            mesh.positions.data(), mesh.VertexCount(), mesh.Stride());
+        printf("    LOD %zu: %u triangles, error %.5g, measured %.5g\n", i, lods[i].indexCount / 3, lods[i].error, measured);
+
+        CHECK(measured <= lods[i].error * 1.0001f + 1e-6f);
+        // Цепочка держит ошибку неубывающей - уровень может унаследовать ошибку предыдущего
+        CHECK(lods[i].error <= std::max(measured, lods[i - 1].error) * 1.0001f + 1e-6f);
+        CHECK(lods[i].error >= lods[i - 1].error);
+    }
+}
+
+TEST(SimplifyOutErrorEqualsMeasuredError)
+{
+    TestMesh mesh = BuildMixedScene();
+    const float ratios[] = { 0.6f, 0.3f, 0.15f, 0.05f };
+    for (float ratio : ratios)
+    {
+        std::vector<uint32_t> simplified;
+        float error = -1.0f;
+        SimplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.VertexCount(),
+            mesh.Stride(), (size_t)(mesh.indices.size() / 3 * ratio) * 3, FLT_MAX, simplified, &error);
+
+        const float measured = MeasureSimplifyError(mesh.indices.data(), mesh.indices.size(),
+            simplified.data(), simplified.size(), mesh.positions.data(), mesh.VertexCount(), mesh.Stride());
+        CHECK(error >= 0.0f);
+        CHECK(std::abs(error - measured) <= 1e-4f * (1.0f + measured));
+    }
+}
+
+// Чем дальше объект, тем грубее LOD. Уровень с той же ошибкой, что у следующего, пропускается
+// (грубее при той же точности), до остальных можно дойти - в том числе до LOD 1
+TEST(SelectLodReachesEveryLevel)
+{
+    TestMesh mesh = BuildMixedScene();
+    std::vector<MeshLod> lods;
+    BuildLodChain(mesh.indices, mesh.indices.size(), mesh.positions.data(), mesh.VertexCount(), mesh.Stride(),
+        MESH_LOD_RATIOS, sizeof(MESH_LOD_RATIOS) / sizeof(MESH_LOD_RATIOS[0]), lods);
+
+    const float pixelsPerUnit = 1000.0f;
+    const float maxPixelError = 1.0f;
+    std::vector<bool> reached(lods.size(), false);
+    uint32_t previous = 0;
+    for (float distance = 0.1f; distance < 1e6f; distance *= 1.1f)
+    {
+        const uint32_t lod = SelectLod(lods.data(), lods.size(), pixelsPerUnit, distance, maxPixelError);
+        CHECK(lod >= previous);
+        reached[lod] = true;
+        previous = lod;
+    }
+    CHECK(lods.size() >= 3 && lods[1].error < lods[2].error);
+    for (size_t i = 0; i < lods.size(); i++)
+        CHECK(reached[i] == (i + 1 == lods.size() || lods[i].error < lods[i + 1].error));
+}
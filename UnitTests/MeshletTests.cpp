@@ -0,0 +1,210 @@
+﻿#include "UnitTest.h"
+#include "TestMeshes.h"
+#include "MeshClusters.h"
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+using namespace DirectX;
+
+namespace
+{
+    XMVECTOR Position(const TestMesh& mesh, uint32_t v)
+    {
+        return XMVectorSet(mesh.positions[3 * v], mesh.positions[3 * v + 1], mesh.positions[3 * v + 2], 0.0f);
+    }
+
+    // Сцена, разбитая на кластеры и мешлеты так же, как в BuildObj
+    struct MeshletScene
+    {
+        TestMesh mesh;
+        std::vector<MeshCluster> clusters;
+        MeshletData meshlets;
+
+        MeshletScene()
+        {
+            mesh = BuildMixedScene();
+            AppendSphere(mesh, 0.0f, 3.0f, 0.0f, 0.5f, 48, 24);
+            BuildMeshClusters(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.VertexCount(),
+                mesh.Stride(), 256, clusters);
+            BuildMeshlets(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.VertexCount(),
+                mesh.Stride(), clusters.data(), clusters.size(), meshlets);
+        }
+    };
+}
+
+// Мешлеты собирают индексный буфер обратно без потерь, укладываются в лимиты и не пересекают кластеры
+TEST(MeshletsReproduceIndexBuffer)
+{
+    const MeshletScene scene;
+    const MeshletData& data = scene.meshlets;
+    CHECK(!data.meshlets.empty() && data.bounds.size() == data.meshlets.size());
+
+    bool exact = true, limits = true, aligned = true, contiguous = true, uniqueVertices = true;
+    uint32_t nextIndex = 0;
+    for (const Meshlet& m : data.meshlets)
+    {
+        limits = limits && m.vertexCount <= MESHLET_MAX_VERTICES && m.triangleCount <= MESHLET_MAX_TRIANGLES &&
+            m.triangleCount > 0 && m.vertexOffset + m.vertexCount <= data.vertices.size() &&
+            m.triangleOffset + m.triangleCount * 3 <= data.triangles.size();
+        aligned = aligned && m.triangleOffset % 4 == 0;
+        contiguous = contiguous && m.firstIndex == nextIndex;
+        nextIndex = m.firstIndex + m.triangleCount * 3;
+
+        const std::set<uint32_t> local(data.vertices.begin() + m.vertexOffset,
+            data.vertices.begin() + m.vertexOffset + m.vertexCount);
+        uniqueVertices = uniqueVertices && local.size() == m.vertexCount;
+
+        for (uint32_t k = 0; exact && k < m.triangleCount * 3; k++)
+        {
+            const uint8_t localIndex = data.triangles[m.triangleOffset + k];
+            exact = localIndex < m.vertexCount &&
+                data.vertices[m.vertexOffset + localIndex] == scene.mesh.indices[m.firstIndex + k];
+        }
+    }
+    CHECK(exact);
+    CHECK(limits);
+    CHECK(aligned);
+    CHECK(contiguous && nextIndex == scene.mesh.indices.size());
+    CHECK(uniqueVertices);
+
+    // Мешлеты кластера покрывают ровно его диапазон индексов
+    bool insideClusters = true;
+    uint32_t nextMeshlet = 0;
+    for (const MeshCluster& cluster : scene.clusters)
+    {
+        insideClusters = insideClusters && cluster.firstMeshlet == nextMeshlet && cluster.meshletCount > 0;
+        uint32_t index = cluster.firstIndex;
+        for (uint32_t i = cluster.firstMeshlet; i < cluster.firstMeshlet + cluster.meshletCount; i++)
+        {
+            insideClusters = insideClusters && data.meshlets[i].firstIndex == index;
+            index += data.meshlets[i].triangleCount * 3;
+        }
+        insideClusters = insideClusters && index == cluster.firstIndex + cluster.indexCount;
+        nextMeshlet = cluster.firstMeshlet + cluster.meshletCount;
+    }
+    CHECK(insideClusters && nextMeshlet == data.meshlets.size());
+
+    // Детерминированность и меньшие лимиты
+    MeshletData again;
+    std::vector<MeshCluster> clusters = scene.clusters;
+    BuildMeshlets(scene.mesh.indices.data(), scene.mesh.indices.size(), scene.mesh.positions.data(),
+        scene.mesh.VertexCount(), scene.mesh.Stride(), clusters.data(), clusters.size(), again);
+    CHECK(again.vertices == data.vertices && again.triangles == data.triangles);
+
+    MeshletData small;
+    BuildMeshlets(scene.mesh.indices.data(), scene.mesh.indices.size(), scene.mesh.positions.data(),
+        scene.mesh.VertexCount(), scene.mesh.Stride(), nullptr, 0, small, 16, 10);
+    bool smallLimits = true;
+    for (const Meshlet& m : small.meshlets)
+        smallLimits = smallLimits && m.vertexCount <= 16 && m.triangleCount <= 10;
+    CHECK(smallLimits && small.meshlets.size() > data.meshlets.size());
+}
+
+// Сфера мешлета накрывает все его вершины
+TEST(MeshletSpheresEnclose)
+{
+    const MeshletScene scene;
+    bool enclosed = true;
+    for (size_t i = 0; i < scene.meshlets.meshlets.size(); i++)
+    {
+        const Meshlet& m = scene.meshlets.meshlets[i];
+        const MeshletBounds& b = scene.meshlets.bounds[i];
+        for (uint32_t k = 0; k < m.vertexCount; k++)
+        {
+            const XMVECTOR p = Position(scene.mesh, scene.meshlets.vertices[m.vertexOffset + k]);
+            enclosed = enclosed && XMVectorGetX(XMVector3Length(XMVectorSubtract(p, XMLoadFloat3(&b.center)))) <= b.radius * 1.0001f + 1e-6f;
+        }
+    }
+    CHECK(enclosed);
+}
+
+// Конус консервативен: мешлет считается задним, только если из этой точки не видно ни одного его треугольника.
+// Лицевая сторона - по часовой стрелке, т.е. нормаль (b - a) x (c - a) смотрит на камеру
+TEST(MeshletConeCullingIsConservative)
+{
+    const MeshletScene scene;
+    const MeshletData& data = scene.meshlets;
+
+    uint32_t seed = 99;
+    auto next = [&]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / float(1 << 24); };
+
+    uint32_t culled = 0, wrong = 0;
+    for (int c = 0; c < 200; c++)
+    {
+        // Камеры вокруг сцены и вплотную к поверхностям
+        const float distance = c % 4 == 0 ? 1.1f + next() : 3.0f + next() * 10.0f;
+        XMVECTOR camera = XMVector3Normalize(XMVectorSet(next() - 0.5f, next() - 0.5f, next() - 0.5f, 0.0f));
+        camera = XMVectorScale(camera, distance);
+
+        for (size_t i = 0; i < data.meshlets.size(); i++)
+        {
+            const MeshletBounds& b = data.bounds[i];
+            if (b.coneCutoff >= 1.0f || !IsMeshletBackfacing(b, camera))
+                continue;
+            culled++;
+
+            const Meshlet& m = data.meshlets[i];
+            for (uint32_t t = 0; t < m.triangleCount; t++)
+            {
+                const uint32_t* tri = &scene.mesh.indices[m.firstIndex + t * 3];
+                const XMVECTOR a = Position(scene.mesh, tri[0]);
+                const XMVECTOR n = XMVector3Cross(XMVectorSubtract(Position(scene.mesh, tri[1]), a),
+                    XMVectorSubtract(Position(scene.mesh, tri[2]), a));
+                const float length = XMVectorGetX(XMVector3Length(n));
+                if (length <= 0.0f)
+                    continue;
+                // Камера перед плоскостью треугольника - он лицевой и должен был остаться
+                if (XMVectorGetX(XMVector3Dot(XMVectorSubtract(camera, a), n)) / length > 1e-5f)
+                    wrong++;
+            }
+        }
+    }
+    CHECK(culled > 0);
+    CHECK(wrong == 0);
+}
+
+// CullMeshlets: пирамида и конус по очереди, статистика накапливается, без отсечения граней - только пирамида
+TEST(CullMeshletsFrustumAndBackfaces)
+{
+    const MeshletScene scene;
+    const MeshletData& data = scene.meshlets;
+    const uint32_t count = (uint32_t)data.meshlets.size();
+
+    const XMFLOAT3 eye(0.0f, 0.5f, -6.0f);
+    const XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMVectorSet(0.0f, 0.5f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    XMFLOAT4X4 viewProj;
+    XMStoreFloat4x4(&viewProj, view * XMMatrixPerspectiveFovLH(0.5f, 1.0f, 0.1f, 100.0f));
+    const Frustum frustum = Frustum::FromMatrix(viewProj);
+    const XMVECTOR camera = XMLoadFloat3(&eye);
+
+    std::vector<uint32_t> visible;
+    MeshletCullStats stats;
+    CullMeshlets(data.bounds.data(), 0, count, frustum, camera, true, visible, &stats);
+    CHECK(stats.tested == count);
+    CHECK(stats.frustumCulled > 0 && stats.backfaceCulled > 0);
+    CHECK(visible.size() + stats.frustumCulled + stats.backfaceCulled == count);
+
+    bool consistent = true;
+    for (uint32_t i : visible)
+    {
+        consistent = consistent && !frustum.IsSphereOutside(XMLoadFloat3(&data.bounds[i].center), data.bounds[i].radius) &&
+            !(data.bounds[i].coneCutoff < 1.0f && IsMeshletBackfacing(data.bounds[i], camera));
+    }
+    CHECK(consistent);
+
+    // Без отсечения граней видно больше; вызовы по диапазонам (как по кластерам) дают то же и копят статистику
+    std::vector<uint32_t> noBackface;
+    MeshletCullStats noBackfaceStats;
+    CullMeshlets(data.bounds.data(), 0, count, frustum, camera, false, noBackface, &noBackfaceStats);
+    CHECK(noBackfaceStats.backfaceCulled == 0 && noBackface.size() == count - stats.frustumCulled);
+
+    std::vector<uint32_t> ranged;
+    MeshletCullStats rangedStats;
+    for (const MeshCluster& cluster : scene.clusters)
+        CullMeshlets(data.bounds.data(), cluster.firstMeshlet, cluster.meshletCount, frustum, camera, true, ranged, &rangedStats);
+    CHECK(ranged == visible);
+    CHECK(rangedStats.tested == stats.tested && rangedStats.backfaceCulled == stats.backfaceCulled);
+}
@@ -0,0 +1,246 @@
+﻿#include "UnitTest.h"
+#include "TestMeshes.h"
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    XMFLOAT4X4 MakeViewProj(const XMFLOAT3& eye, const XMFLOAT3& target)
+    {
+        const XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        const XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV4, 2.0f, 0.1f, 100.0f);
+        XMFLOAT4X4 viewProj;
+        XMStoreFloat4x4(&viewProj, view * proj);
+        return viewProj;
+    }
+
+    struct ScreenPoint
+    {
+        double x, y, z;
+    };
+
+    ScreenPoint Project(const XMFLOAT3& p, const XMFLOAT4X4& m, uint32_t width, uint32_t height)
+    {
+        const double cx = p.x * m.m[0][0] + p.y * m.m[1][0] + p.z * m.m[2][0] + m.m[3][0];
+        const double cy = p.x * m.m[0][1] + p.y * m.m[1][1] + p.z * m.m[2][1] + m.m[3][1];
+        const double cz = p.x * m.m[0][2] + p.y * m.m[1][2] + p.z * m.m[2][2] + m.m[3][2];
+        const double cw = p.x * m.m[0][3] + p.y * m.m[1][3] + p.z * m.m[2][3] + m.m[3][3];
+        return { (cx / cw * 0.5 + 0.5) * width, (0.5 - cy / cw * 0.5) * height, cz / cw };
+    }
+
+    // Эталон в double: для каждого центра пикселя - ближайшая глубина окклюдера (1 - пусто).
+    // z/w линейна в экранных координатах, так что барицентрики дают точную глубину.
+    // Все окклюдеры в тестах перед ближней плоскостью
+    std::vector<double> ReferenceDepth(const OccluderMesh& mesh, const XMFLOAT4X4& viewProj, uint32_t width, uint32_t height)
+    {
+        std::vector<double> depth((size_t)width * height, 1.0);
+        for (size_t t = 0; t < mesh.TriangleCount(); t++)
+        {
+            ScreenPoint v[3];
+            for (int k = 0; k < 3; k++)
+                v[k] = Project(mesh.positions[mesh.indices[t * 3 + k]], viewProj, width, height);
+
+            const double area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+            if (std::fabs(area) < 1e-12)
+                continue;
+
+            const int x0 = std::max(0, (int)std::floor(std::min({ v[0].x, v[1].x, v[2].x })));
+            const int x1 = std::min((int)width - 1, (int)std::ceil(std::max({ v[0].x, v[1].x, v[2].x })));
+            const int y0 = std::max(0, (int)std::floor(std::min({ v[0].y, v[1].y, v[2].y })));
+            const int y1 = std::min((int)height - 1, (int)std::ceil(std::max({ v[0].y, v[1].y, v[2].y })));
+            for (int y = y0; y <= y1; y++)
+            {
+                for (int x = x0; x <= x1; x++)
+                {
+                    const double px = x + 0.5, py = y + 0.5;
+                    const double w0 = ((v[1].x - px) * (v[2].y - py) - (v[2].x - px) * (v[1].y - py)) / area;
+                    const double w1 = ((v[2].x - px) * (v[0].y - py) - (v[0].x - px) * (v[2].y - py)) / area;
+                    const double w2 = 1.0 - w0 - w1;
+                    if (w0 < -1e-9 || w1 < -1e-9 || w2 < -1e-9)
+                        continue;
+                    double& d = depth[(size_t)y * width + x];
+                    d = std::min(d, w0 * v[0].z + w1 * v[1].z + w2 * v[2].z);
+                }
+            }
+        }
+        return depth;
+    }
+
+    // Коробка видна хоть в одном центре пикселя внутри её экранного прямоугольника:
+    // окклюдер там дальше её ближайшей точки (или его нет)
+    bool VisibleInReference(const std::vector<double>& depth, const XMFLOAT3& lo, const XMFLOAT3& hi,
+        const XMFLOAT4X4& viewProj, uint32_t width, uint32_t height)
+    {
+        double minX = 1e30, maxX = -1e30, minY = 1e30, maxY = -1e30, minZ = 1e30;
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const XMFLOAT3 p((corner & 1) ? hi.x : lo.x, (corner & 2) ? hi.y : lo.y, (corner & 4) ? hi.z : lo.z);
+            const ScreenPoint s = Project(p, viewProj, width, height);
+            minX = std::min(minX, s.x);
+            maxX = std::max(maxX, s.x);
+            minY = std::min(minY, s.y);
+            maxY = std::max(maxY, s.y);
+            minZ = std::min(minZ, s.z);
+        }
+
+        for (int y = std::max(0, (int)std::ceil(minY - 0.5)); y <= std::min((int)height - 1, (int)std::floor(maxY - 0.5)); y++)
+        {
+            for (int x = std::max(0, (int)std::ceil(minX - 0.5)); x <= std::min((int)width - 1, (int)std::floor(maxX - 0.5)); x++)
+            {
+                // Запас на float в растеризаторе
+                if (depth[(size_t)y * width + x] >= minZ - 1e-5)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    OccluderMesh BuildOccluders(uint32_t budget)
+    {
+        const TestMesh scene = BuildMixedScene();
+        OccluderMesh occluders;
+        SelectOccluders(scene.indices.data(), scene.indices.size(), scene.positions.data(), scene.VertexCount(),
+            scene.Stride(), budget, occluders);
+        return occluders;
+    }
+}
+
+// Простые случаи: за стеной закрыто, перед стеной и сбоку от неё - нет, угол за камерой - видно
+TEST(OcclusionBufferBasicCases)
+{
+    const OccluderMesh occluders = BuildOccluders(OCCLUDER_TRIANGLE_BUDGET);
+    const XMFLOAT4X4 viewProj = MakeViewProj(XMFLOAT3(0.0f, 0.0f, -6.0f), XMFLOAT3(0.0f, 0.0f, 1.0f));
+
+    OcclusionBuffer buffer;
+    buffer.Render(occluders, &viewProj, 1);
+    buffer.BuildHiZ();
+    CHECK(buffer.GetStats().trianglesRasterized > 0);
+
+    CHECK(buffer.IsOccluded(XMFLOAT3(-1.0f, -0.5f, 3.0f), XMFLOAT3(1.0f, 0.5f, 4.0f), viewProj));      // за стеной
+    CHECK(buffer.IsOccluded(XMFLOAT3(-0.2f, -0.2f, 1.2f), XMFLOAT3(0.2f, 0.2f, 1.5f), viewProj));      // за сферой
+    CHECK(!buffer.IsOccluded(XMFLOAT3(-0.5f, -0.5f, -3.0f), XMFLOAT3(0.5f, 0.5f, -2.0f), viewProj));   // перед сферой
+    CHECK(!buffer.IsOccluded(XMFLOAT3(1.5f, 0.8f, 3.0f), XMFLOAT3(2.5f, 1.5f, 4.0f), viewProj));       // выглядывает из-за края
+    CHECK(!buffer.IsOccluded(XMFLOAT3(-1.0f, 3.0f, 3.0f), XMFLOAT3(1.0f, 4.0f, 4.0f), viewProj));      // над стеной
+    CHECK(!buffer.IsOccluded(XMFLOAT3(-1.0f, -1.0f, -7.0f), XMFLOAT3(1.0f, 1.0f, 3.0f), viewProj));    // через камеру
+}
+
+// Консервативность: коробка, которую hi-Z считает закрытой, не видна ни в одном центре пикселя по эталону
+// в double. Случайные коробки и камеры, часть - впритык к стенам и сфере
+TEST(OcclusionHiZIsConservative)
+{
+    const OccluderMesh occluders = BuildOccluders(4096);
+
+    const XMFLOAT3 eyes[] = { { 0.0f, 0.0f, -6.0f }, { 1.5f, 0.7f, -5.0f }, { -4.0f, 0.3f, -4.0f }, { 3.0f, -0.5f, -2.5f } };
+    uint32_t seed = 2024;
+    auto next = [&]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / float(1 << 24); };
+
+    uint32_t tested = 0, occluded = 0, violations = 0;
+    for (const XMFLOAT3& eye : eyes)
+    {
+        const XMFLOAT4X4 viewProj = MakeViewProj(eye, XMFLOAT3(0.0f, 0.0f, 1.0f));
+        OcclusionBuffer buffer;
+        buffer.Render(occluders, &viewProj, 1);
+        buffer.BuildHiZ();
+        const std::vector<double> reference = ReferenceDepth(occluders, viewProj, buffer.Width(), buffer.Height());
+
+        for (int b = 0; b < 1500; b++)
+        {
+            const XMFLOAT3 center(next() * 6.0f - 3.0f, next() * 3.0f - 1.5f, next() * 5.0f - 0.5f);
+            const float size = b % 3 == 0 ? 0.01f + next() * 0.05f : 0.05f + next() * 0.6f;
+            const XMFLOAT3 lo(center.x - size, center.y - size * next(), center.z - size);
+            const XMFLOAT3 hi(center.x + size * next(), center.y + size, center.z + size * 0.3f);
+
+            tested++;
+            if (!buffer.IsOccluded(lo, hi, viewProj))
+                continue;
+            occluded++;
+            if (VisibleInReference(reference, lo, hi, viewProj, buffer.Width(), buffer.Height()))
+                violations++;
+        }
+    }
+
+    printf("    %u boxes, %u occluded, %u visible by reference\n", tested, occluded, violations);
+    CHECK(occluded > tested / 10);
+    CHECK(violations == 0);
+}
+
+// Пирамида: каждый тексель не ближе всех пикселей под ним; многопоточный рендер даёт тот же буфер
+TEST(OcclusionHiZPyramidAndThreads)
+{
+    const OccluderMesh occluders = BuildOccluders(OCCLUDER_TRIANGLE_BUDGET);
+    const XMFLOAT4X4 viewProj = MakeViewProj(XMFLOAT3(1.0f, 0.5f, -5.0f), XMFLOAT3(0.0f, 0.0f, 1.0f));
+
+    // Два экземпляра: второй сдвинут вправо и назад
+    XMFLOAT4X4 instances[2] = { viewProj, viewProj };
+    XMStoreFloat4x4(&instances[1], XMMatrixTranslation(3.0f, 0.0f, 4.0f) * XMLoadFloat4x4(&viewProj));
+
+    // Ширина не кратна 4 и нечётная высота
+    OcclusionBuffer single(190, 97), parallel(190, 97);
+    CHECK(single.Width() == 192 && single.Height() == 97);
+    single.Render(occluders, instances, 2, 1);
+    parallel.Render(occluders, instances, 2, 0);
+    single.BuildHiZ();
+    parallel.BuildHiZ();
+
+    const size_t pixels = (size_t)single.Width() * single.Height();
+    CHECK(memcmp(single.Level(0), parallel.Level(0), pixels * sizeof(float)) == 0);
+    CHECK(single.GetStats().trianglesRasterized == parallel.GetStats().trianglesRasterized);
+
+    // Размер уровня - ceil(размер / 2^level), как при построении
+    bool maxPyramid = true;
+    for (uint32_t level = 1; level < single.LevelCount(); level++)
+    {
+        const uint32_t levelWidth = (single.Width() + (1u << level) - 1) >> level;
+        for (uint32_t y = 0; y < single.Height(); y++)
+        {
+            for (uint32_t x = 0; x < single.Width(); x++)
+            {
+                maxPyramid = maxPyramid &&
+                    single.Level(level)[(size_t)(y >> level) * levelWidth + (x >> level)] >= single.Level(0)[(size_t)y * single.Width() + x];
+            }
+        }
+    }
+    CHECK(maxPyramid);
+    CHECK(single.LevelCount() > 1);
+}
+
+// Свои окклюдеры у каждого экземпляра (LOD, которым он рисуется): буфер - поточечный минимум
+// буферов, отрисованных по отдельности
+TEST(OcclusionPerInstanceOccluders)
+{
+    const OccluderMesh fine = BuildOccluders(OCCLUDER_TRIANGLE_BUDGET);
+    const OccluderMesh coarse = BuildOccluders(64);
+    CHECK(coarse.TriangleCount() < fine.TriangleCount());
+
+    const XMFLOAT4X4 viewProj = MakeViewProj(XMFLOAT3(1.0f, 0.5f, -5.0f), XMFLOAT3(0.0f, 0.0f, 1.0f));
+    XMFLOAT4X4 instances[2] = { viewProj, viewProj };
+    XMStoreFloat4x4(&instances[1], XMMatrixTranslation(-2.5f, 0.5f, 3.0f) * XMLoadFloat4x4(&viewProj));
+
+    OcclusionBuffer first, second, both;
+    first.Render(fine, &instances[0], 1);
+    second.Render(coarse, &instances[1], 1);
+    const OccluderMesh* meshes[2] = { &fine, &coarse };
+    both.Render(meshes, instances, 2);
+
+    bool minimum = true;
+    const size_t pixels = (size_t)both.Width() * both.Height();
+    for (size_t i = 0; i < pixels; i++)
+        minimum = minimum && both.Level(0)[i] == std::min(first.Level(0)[i], second.Level(0)[i]);
+    CHECK(minimum);
+    CHECK(both.GetStats().trianglesRasterized ==
+        first.GetStats().trianglesRasterized + second.GetStats().trianglesRasterized);
+
+    // Тот же меш у всех - как прежний Render
+    OcclusionBuffer shared;
+    const OccluderMesh* same[2] = { &fine, &fine };
+    shared.Render(same, instances, 2);
+    OcclusionBuffer single;
+    single.Render(fine, instances, 2);
+    CHECK(memcmp(shared.Level(0), single.Level(0), pixels * sizeof(float)) == 0);
+}
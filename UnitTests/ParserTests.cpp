@@ -0,0 +1,232 @@
+﻿#include "UnitTest.h"
+#include "Parser.h"
+#include "MeshStreams.h"
+#include "Vertex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace DirectX;
+
+namespace
+{
+    // OBJ во временном каталоге; удаляется в деструкторе
+    struct TempObj
+    {
+        std::string path;
+
+        TempObj(const char* name, const std::string& text)
+        {
+            path = (std::filesystem::temp_directory_path() / name).string();
+            std::ofstream(path, std::ios::binary) << text;
+        }
+
+        ~TempObj()
+        {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    };
+
+    // Сетка n x n с нормалями через одну вершину, гранями v//vn и v/vt/vn, квадами и
+    // отрицательными индексами; далёкая вершина без ссылок и грань с индексом вне файла
+    std::string BuildObjText(int n)
+    {
+        std::string text = "# test\nv 100 100 100\n";
+        for (int y = 0; y <= n; y++)
+        {
+            for (int x = 0; x <= n; x++)
+            {
+                text += "v " + std::to_string(x * 0.25f) + " " + std::to_string((x * y) % 7 * 0.1f) +
+                    " " + std::to_string(y * 0.5f) + "\n";
+                if ((x + y) % 2 == 0)
+                    text += "vn 0 1 0\nvn " + std::to_string(x * 0.1f) + " 0.5 0.25\n";
+            }
+        }
+
+        int normals = 0;
+        for (int y = 0; y <= n; y++)
+            for (int x = 0; x <= n; x++)
+                normals += ((x + y) % 2 == 0) ? 2 : 0;
+
+        auto position = [&](int x, int y) { return 2 + y * (n + 1) + x; };
+        for (int y = 0; y < n; y++)
+        {
+            for (int x = 0; x < n; x++)
+            {
+                const int a = position(x, y), b = position(x + 1, y), c = position(x + 1, y + 1), d = position(x, y + 1);
+                const int vn = 1 + (x * 7 + y) % normals;
+                if ((x + y) % 3 == 0)
+                    text += "f " + std::to_string(a) + "//" + std::to_string(vn) + " " + std::to_string(b) + "//" +
+                        std::to_string(vn) + " " + std::to_string(c) + "//" + std::to_string(vn) + " " +
+                        std::to_string(d) + "//" + std::to_string(vn) + "\n";
+                else if ((x + y) % 3 == 1)
+                    text += "f " + std::to_string(a) + "/1/" + std::to_string(vn) + " " + std::to_string(b) + " " +
+                        std::to_string(c) + "\nf " + std::to_string(a) + " " + std::to_string(c) + " " + std::to_string(d) + "\n";
+                else
+                    text += "f " + std::to_string(a - position(n, n) - 1) + " " + std::to_string(b - position(n, n) - 1) +
+                        " " + std::to_string(c - position(n, n) - 1) + "\n";
+            }
+        }
+        text += "f 1 2 999999\n";
+        return text;
+    }
+
+    // Куски потокового импорта, склеенные в список углов
+    struct StreamedCorners
+    {
+        std::vector<Vertex> corners;
+        size_t chunkCount = 0;
+        bool withinBudget = true;
+    };
+
+    bool LoadStreamedCorners(const std::string& path, const ObjStreamOptions& options, StreamedCorners& out)
+    {
+        return LoadOBJStreamed(path, options, [&](const ObjMeshChunk& chunk)
+            {
+                out.chunkCount++;
+                out.withinBudget = out.withinBudget &&
+                    chunk.vertexCount <= options.maxChunkVertices && chunk.indexCount <= options.maxChunkIndices;
+                for (size_t i = 0; i < chunk.indexCount; i++)
+                    out.corners.push_back(chunk.vertices[chunk.indices[i]]);
+                return true;
+            });
+    }
+
+    bool SameVertex(const Vertex& a, const Vertex& b)
+    {
+        return memcmp(&a.position, &b.position, sizeof(XMFLOAT3)) == 0 &&
+            memcmp(&a.normal, &b.normal, sizeof(XMFLOAT3)) == 0;
+    }
+}
+
+// Маленькие куски и редкий индекс строк: углы и их вершины побитово те же, что у LoadOBJ,
+// включая нормализацию по габаритам только тех позиций, на которые ссылаются грани
+TEST(StreamedObjMatchesLoadObj)
+{
+    TempObj obj("UnitTestsGrid.obj", BuildObjText(24));
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    CHECK(LoadOBJ(obj.path, vertices, indices));
+
+    for (size_t blockLines : { (size_t)1, (size_t)3, (size_t)1024 })
+    {
+        ObjStreamOptions options;
+        options.maxChunkVertices = 50;
+        options.maxChunkIndices = 60;
+        options.indexBlockLines = blockLines;
+
+        StreamedCorners streamed;
+        CHECK(LoadStreamedCorners(obj.path, options, streamed));
+        CHECK(streamed.withinBudget);
+        CHECK(streamed.chunkCount > 10);
+        CHECK(streamed.corners.size() == indices.size());
+
+        bool same = streamed.corners.size() == indices.size();
+        for (size_t i = 0; same && i < indices.size(); i++)
+            same = SameVertex(streamed.corners[i], vertices[indices[i]]);
+        CHECK(same);
+    }
+
+    // Далёкая вершина 1 не попала ни в одну грань и не сжала нормализацию: сетка сама занимает 5 по z
+    float minZ = vertices[0].position.z;
+    float maxZ = vertices[0].position.z;
+    for (const Vertex& v : vertices)
+    {
+        minZ = std::min(minZ, v.position.z);
+        maxZ = std::max(maxZ, v.position.z);
+    }
+    CHECK(std::fabs(maxZ - minZ - 5.0f) < 1e-4f);
+}
+
+// false из колбэка останавливает импорт; файл без граней - ошибка, как у LoadOBJ
+TEST(StreamedObjStopsAndRejectsEmpty)
+{
+    TempObj obj("UnitTestsSmallGrid.obj", BuildObjText(8));
+
+    ObjStreamOptions options;
+    options.maxChunkVertices = 16;
+    size_t calls = 0;
+    CHECK(LoadOBJStreamed(obj.path, options, [&](const ObjMeshChunk&) { return ++calls < 2; }));
+    CHECK(calls == 2);
+
+    TempObj empty("UnitTestsNoFaces.obj", "v 0 0 0\nv 1 0 0\nvn 0 1 0\n");
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    CHECK(!LoadOBJ(empty.path, vertices, indices));
+    CHECK(!LoadOBJStreamed(empty.path, options, [](const ObjMeshChunk&) { return true; }));
+}
+
+// Числа вне диапазона - как у sscanf: float насыщается до ±HUGE_VALF или теряется до ±0,
+// индекс за пределами int не переполняется и отбрасывает грань как вне границ
+TEST(ObjOutOfRangeNumbers)
+{
+    TempObj obj("UnitTestsOutOfRange.obj",
+        "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1e-60 -1e-60 0\n"
+        "vn 1e39 -1e39 1e-60\n"
+        "f 1//1 2//1 3//1\n"
+        "f 1//1 2//1 99999999999999999999999\n"
+        "f 1//1 2//1 -2147483649\n"
+        "f 4//1 2//1 3//1\n");
+
+    ObjLoadOptions options;
+    options.weldVertices = false;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    CHECK(LoadOBJ(obj.path, vertices, indices, options));
+    CHECK(indices.size() == 6 && vertices.size() == 6);
+    if (vertices.size() == 6)
+    {
+        // 1e-60 -> 0: четвёртая позиция совпадает с первой и после нормализации
+        CHECK(memcmp(&vertices[3].position, &vertices[0].position, sizeof(XMFLOAT3)) == 0);
+
+        const XMFLOAT3& n = vertices[0].normal;
+        CHECK(std::isinf(n.x) && n.x > 0.0f && std::isinf(n.y) && n.y < 0.0f && n.z == 0.0f);
+    }
+}
+
+// BuildObj и MeshBake грузят в потоки и собирают Vertex через ToVertices: результат тот же, что у LoadOBJ в Vertex
+TEST(ObjStreamsMatchVertexLoad)
+{
+    TempObj obj("UnitTestsStreamsGrid.obj", BuildObjText(12));
+
+    std::vector<Vertex> expected;
+    std::vector<uint32_t> expectedIndices;
+    CHECK(LoadOBJ(obj.path, expected, expectedIndices));
+
+    MeshStreams streams;
+    CHECK(LoadOBJ(obj.path, streams));
+    CHECK(streams.colors.empty());
+    CHECK(streams.indices == expectedIndices);
+
+    std::vector<Vertex> vertices;
+    streams.ToVertices(vertices);
+    bool same = vertices.size() == expected.size();
+    for (size_t i = 0; same && i < vertices.size(); i++)
+    {
+        same = SameVertex(vertices[i], expected[i]) &&
+            memcmp(&vertices[i].color, &expected[i].color, sizeof(XMFLOAT4)) == 0;
+    }
+    CHECK(same);
+
+    // Раскладка DirectXApp::BuildInputLayout: POSITION + COLOR, 28 байт, нормаль не пишется
+    const VertexElement elements[] = { { VertexAttribute::Position, 0 }, { VertexAttribute::Color, 12 } };
+    std::vector<uint8_t> interleaved(streams.VertexCount() * 28, 0xCD);
+    streams.Interleave(elements, 2, 28, interleaved.data());
+    bool packed = true;
+    for (size_t i = 0; packed && i < streams.VertexCount(); i++)
+    {
+        XMFLOAT3 position;
+        XMFLOAT4 color;
+        memcpy(&position, interleaved.data() + i * 28, sizeof(position));
+        memcpy(&color, interleaved.data() + i * 28 + 12, sizeof(color));
+        packed = memcmp(&position, &expected[i].position, sizeof(position)) == 0 &&
+            color.x == 1.0f && color.y == 1.0f && color.z == 1.0f && color.w == 1.0f;
+    }
+    CHECK(packed);
+}
@@ -0,0 +1,169 @@
+﻿#include "UnitTest.h"
+#include "PipelineCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace
+{
+    const uint8_t VS_BYTES[] = { 0x44, 0x58, 0x42, 0x43, 1, 2, 3, 4 };
+    const uint8_t PS_BYTES[] = { 0x44, 0x58, 0x42, 0x43, 5, 6, 7, 8 };
+
+    // Описание как у сплошного PSO в DirectXApp: POSITION + COLOR, один RT и глубина
+    PipelineDesc BaseDesc()
+    {
+        PipelineDesc desc;
+        desc.vs = MakeShaderRef(VS_BYTES, sizeof(VS_BYTES));
+        desc.ps = MakeShaderRef(PS_BYTES, sizeof(PS_BYTES));
+        desc.rootSignatureKey = 0xABCD;
+        desc.inputLayout.push_back({ "POSITION", 0, 6, 0, 0, false, 0 });
+        desc.inputLayout.push_back({ "COLOR", 0, 2, 0, 12, false, 0 });
+        desc.rtvFormats[0] = 28;
+        desc.dsvFormat = 45;
+        return desc;
+    }
+
+    std::string TempPath(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+}
+
+// Ключ зависит от содержимого, а не от адресов; нормализация не различает то, что не влияет на PSO
+TEST(PipelineKeyNormalization)
+{
+    const PipelineDesc base = BaseDesc();
+    const uint64_t key = HashPipelineDesc(base);
+
+    // Тот же байткод по другому адресу
+    const std::vector<uint8_t> vsCopy(VS_BYTES, VS_BYTES + sizeof(VS_BYTES));
+    PipelineDesc copy = base;
+    copy.vs = MakeShaderRef(vsCopy.data(), vsCopy.size());
+    CHECK(HashPipelineDesc(copy) == key);
+
+    // Регистр семантики, форматы за renderTargetCount, шаг вершинного элемента
+    PipelineDesc same = base;
+    same.inputLayout[0].semantic = "position";
+    same.rtvFormats[3] = 87;
+    same.inputLayout[1].stepRate = 5;
+    CHECK(HashPipelineDesc(same) == key);
+
+    // Всё, что меняет PSO, меняет ключ
+    auto differs = [&](void (*change)(PipelineDesc&))
+    {
+        PipelineDesc desc = base;
+        change(desc);
+        return HashPipelineDesc(desc) != key;
+    };
+    CHECK(differs([](PipelineDesc& d) { d.fill = FillMode::Wireframe; }));
+    CHECK(differs([](PipelineDesc& d) { d.cull = CullMode::None; }));
+    CHECK(differs([](PipelineDesc& d) { d.frontCounterClockwise = true; }));
+    CHECK(differs([](PipelineDesc& d) { d.depthBias = 1; }));
+    CHECK(differs([](PipelineDesc& d) { d.blend = BlendMode::Alpha; }));
+    CHECK(differs([](PipelineDesc& d) { d.depth = DepthMode::ReadOnly; }));
+    CHECK(differs([](PipelineDesc& d) { d.rootSignatureKey++; }));
+    CHECK(differs([](PipelineDesc& d) { d.inputLayout[1].offset = 16; }));
+    CHECK(differs([](PipelineDesc& d) { d.inputLayout[1].semantic = "NORMAL"; }));
+    CHECK(differs([](PipelineDesc& d) { d.inputLayout[1].perInstance = true; }));
+    CHECK(differs([](PipelineDesc& d) { d.inputLayout.pop_back(); }));
+    CHECK(differs([](PipelineDesc& d) { d.rtvFormats[0] = 87; }));
+    CHECK(differs([](PipelineDesc& d) { d.renderTargetCount = 2; }));
+    CHECK(differs([](PipelineDesc& d) { d.dsvFormat = 40; }));
+    CHECK(differs([](PipelineDesc& d) { d.sampleCount = 4; }));
+    CHECK(differs([](PipelineDesc& d) { d.ps = MakeShaderRef(VS_BYTES, sizeof(VS_BYTES)); }));
+
+    // Число RT больше допустимого - как MAX_RENDER_TARGETS, без чтения за массивом
+    PipelineDesc clamped = base;
+    clamped.renderTargetCount = 100;
+    PipelineDesc maxTargets = base;
+    maxTargets.renderTargetCount = PipelineDesc::MAX_RENDER_TARGETS;
+    CHECK(HashPipelineDesc(clamped) == HashPipelineDesc(maxTargets));
+}
+
+// Первый поиск ключа - новый объект со следующим индексом, повторный - тот же индекс
+TEST(PipelineCacheFindCreatesOnce)
+{
+    PipelineCache cache;
+    const PipelineLookup solid = cache.Find(BaseDesc());
+    CHECK(solid.isNew && solid.index == 0 && solid.blob == nullptr);
+
+    PipelineDesc wireDesc = BaseDesc();
+    wireDesc.fill = FillMode::Wireframe;
+    const PipelineLookup wire = cache.Find(wireDesc);
+    CHECK(wire.isNew && wire.index == 1);
+
+    const PipelineLookup again = cache.Find(BaseDesc());
+    CHECK(!again.isNew && again.index == 0);
+    CHECK(cache.PipelineCount() == 2);
+
+    const PipelineCacheStats& stats = cache.GetStats();
+    CHECK(stats.lookups == 3 && stats.hits == 1 && stats.misses == 2 && stats.blobHits == 0);
+    CHECK(!cache.IsDirty());
+}
+
+// Блобы переживают Save/Load и отдаются при первом поиске; чужое устройство и мусор - пустой кэш
+TEST(PipelineCacheBlobsRoundTrip)
+{
+    const std::string path = TempPath("UnitTestsPipelines.bin");
+    const uint64_t device = 0x1111;
+    const uint64_t solidKey = HashPipelineDesc(BaseDesc());
+    const uint8_t blobA[] = { 1, 2, 3, 4, 5 };
+    const uint8_t blobB[] = { 9, 8, 7 };
+
+    {
+        PipelineCache cache;
+        cache.StoreBlob(solidKey, blobA, sizeof(blobA));
+        cache.StoreBlob(42, blobB, sizeof(blobB));
+        CHECK(cache.IsDirty() && cache.BlobCount() == 2);
+        CHECK(cache.Save(path, device));
+        CHECK(!cache.IsDirty());
+
+        // Тот же блоб повторно не пачкает кэш
+        cache.StoreBlob(42, blobB, sizeof(blobB));
+        CHECK(!cache.IsDirty());
+    }
+
+    PipelineCache cache;
+    CHECK(cache.Load(path, device));
+    CHECK(cache.BlobCount() == 2 && !cache.IsDirty());
+
+    const PipelineLookup lookup = cache.Find(BaseDesc());
+    CHECK(lookup.isNew && lookup.blob != nullptr);
+    if (lookup.blob)
+        CHECK(*lookup.blob == std::vector<uint8_t>(blobA, blobA + sizeof(blobA)));
+    CHECK(cache.GetStats().blobHits == 1);
+
+    // Драйвер не принял блоб: он удаляется и больше не отдаётся
+    cache.RejectBlob(solidKey);
+    CHECK(cache.BlobCount() == 1 && cache.IsDirty() && cache.GetStats().blobRejected == 1);
+
+    // Другой адаптер или драйвер
+    PipelineCache other;
+    CHECK(!other.Load(path, device + 1));
+    CHECK(other.BlobCount() == 0);
+
+    // Обрезанный файл: целые записи до обрыва читаются, кэш помечен для перезаписи
+    std::vector<char> bytes;
+    {
+        std::ifstream file(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    const std::string truncatedPath = TempPath("UnitTestsPipelinesCut.bin");
+    std::ofstream(truncatedPath, std::ios::binary).write(bytes.data(), (std::streamsize)(bytes.size() - 1));
+
+    PipelineCache truncated;
+    CHECK(truncated.Load(truncatedPath, device));
+    CHECK(truncated.BlobCount() == 1 && truncated.IsDirty());
+
+    // Не кэш вовсе
+    std::ofstream(truncatedPath, std::ios::binary | std::ios::trunc) << "not a pipeline cache at all";
+    CHECK(!truncated.Load(truncatedPath, device));
+    CHECK(truncated.BlobCount() == 0);
+    CHECK(!truncated.Load(TempPath("UnitTestsPipelinesMissing.bin"), device));
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    std::filesystem::remove(truncatedPath, ec);
+}
@@ -0,0 +1,166 @@
+﻿#include "UnitTest.h"
+#include "TestMeshes.h"
+#include "QuantizedVertex.h"
+#include "MeshStreams.h"
+#include "Vertex.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    // Границы из QuantizedVertex.h; запас на округление float
+    constexpr float NORMAL_MAX_ANGLE = 1e-3f;
+    constexpr float COLOR_MAX_ERROR = 1.0f / 510.0f + 1e-6f;
+
+    float AngleBetween(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        const float dot = a.x * b.x + a.y * b.y + a.z * b.z;
+        return std::acos(std::min(std::max(dot, -1.0f), 1.0f));
+    }
+
+    // Смешанная сцена со случайными единичными нормалями и цветами
+    MeshStreams BuildStreams(uint32_t seed)
+    {
+        auto next = [&]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / float(1 << 24); };
+
+        const TestMesh scene = BuildMixedScene();
+        MeshStreams mesh;
+        mesh.indices = scene.indices;
+        for (size_t i = 0; i < scene.VertexCount(); i++)
+        {
+            mesh.positions.push_back(XMFLOAT3(scene.positions[3 * i], scene.positions[3 * i + 1], scene.positions[3 * i + 2]));
+
+            XMFLOAT3 n(next() * 2.0f - 1.0f, next() * 2.0f - 1.0f, next() * 2.0f - 1.0f);
+            const float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+            mesh.normals.push_back(length > 1e-3f ? XMFLOAT3(n.x / length, n.y / length, n.z / length) : XMFLOAT3(0.0f, 0.0f, -1.0f));
+            mesh.colors.push_back(XMFLOAT4(next(), next(), next(), next()));
+        }
+        return mesh;
+    }
+}
+
+// Позиция - не дальше половины шага по каждой оси, нормаль и цвет - в пределах, обещанных в заголовке
+TEST(QuantizedRoundTripWithinErrorBounds)
+{
+    const MeshStreams mesh = BuildStreams(7);
+    QuantizedMesh quantized;
+    CHECK(QuantizeMesh(mesh, true, quantized));
+    CHECK(quantized.stride == 16 && quantized.VertexCount() == mesh.VertexCount());
+    CHECK(quantized.indices == mesh.indices);
+
+    // Половина шага плюс округление float при декодировании (q * scale + offset, |pos| < 3)
+    const float rounding = 4.0f * FLT_EPSILON * 3.0f;
+    const float halfStep[3] =
+    {
+        quantized.positionScale.x / 65535.0f * 0.5f + rounding,
+        quantized.positionScale.y / 65535.0f * 0.5f + rounding,
+        quantized.positionScale.z / 65535.0f * 0.5f + rounding
+    };
+
+    float maxAngle = 0.0f;
+    float maxColor = 0.0f;
+    bool positionsOk = true;
+    for (size_t i = 0; i < mesh.VertexCount(); i++)
+    {
+        XMFLOAT3 p, n;
+        XMFLOAT4 c;
+        DecodeQuantizedVertex(quantized, i, p, n, c);
+
+        const XMFLOAT3& source = mesh.positions[i];
+        positionsOk = positionsOk &&
+            std::fabs(p.x - source.x) <= halfStep[0] &&
+            std::fabs(p.y - source.y) <= halfStep[1] &&
+            std::fabs(p.z - source.z) <= halfStep[2];
+
+        maxAngle = std::max(maxAngle, AngleBetween(n, mesh.normals[i]));
+
+        const XMFLOAT4& sc = mesh.colors[i];
+        maxColor = std::max({ maxColor, std::fabs(c.x - sc.x), std::fabs(c.y - sc.y),
+            std::fabs(c.z - sc.z), std::fabs(c.w - sc.w) });
+    }
+
+    CHECK(positionsOk);
+    CHECK(maxAngle <= NORMAL_MAX_ANGLE);
+    CHECK(maxColor <= COLOR_MAX_ERROR);
+    if (maxAngle > NORMAL_MAX_ANGLE || maxColor > COLOR_MAX_ERROR)
+        printf("    normal %.3g rad, color %.3g\n", maxAngle, maxColor);
+}
+
+// Оси, швы октаэдра (z = 0, x = 0, y = 0 в нижней полусфере) и нулевой вектор
+TEST(OctahedralEncodesAxesAndSeams)
+{
+    const float s = std::sqrt(0.5f);
+    const XMFLOAT3 normals[] =
+    {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+        { s, s, 0 }, { -s, s, 0 }, { s, -s, 0 }, { -s, -s, 0 },
+        { 0, s, -s }, { 0, -s, -s }, { s, 0, -s }, { -s, 0, -s },
+    };
+    for (const XMFLOAT3& n : normals)
+        CHECK(AngleBetween(DecodeOctahedral(EncodeOctahedral(n)), n) <= NORMAL_MAX_ANGLE);
+
+    const XMFLOAT3 up = DecodeOctahedral(EncodeOctahedral(XMFLOAT3(0.0f, 0.0f, 0.0f)));
+    CHECK(AngleBetween(up, XMFLOAT3(0.0f, 1.0f, 0.0f)) <= NORMAL_MAX_ANGLE);
+}
+
+// Без цвета - 12 байт и белый цвет; плоский меш (нулевая высота габаритов) не теряет координату
+TEST(QuantizedWithoutColorAndFlatMesh)
+{
+    std::vector<Vertex> vertices(3);
+    vertices[0].position = XMFLOAT3(-1.0f, 2.0f, 0.5f);
+    vertices[1].position = XMFLOAT3(3.0f, 2.0f, -0.25f);
+    vertices[2].position = XMFLOAT3(0.0f, 2.0f, 4.0f);
+    for (Vertex& v : vertices)
+    {
+        v.normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+        v.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    }
+
+    const MeshStreams mesh = MeshStreams::FromVertices(vertices.data(), vertices.size());
+    CHECK(mesh.colors.empty());
+
+    QuantizedMesh quantized;
+    CHECK(QuantizeMesh(mesh, false, quantized));
+    CHECK(quantized.stride == 12 && !quantized.hasColor);
+    CHECK(quantized.vertexData.size() == 3 * 12);
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        XMFLOAT3 p, n;
+        XMFLOAT4 c;
+        DecodeQuantizedVertex(quantized, i, p, n, c);
+        CHECK(p.y == 2.0f);
+        CHECK(std::fabs(p.x - vertices[i].position.x) <= 4.0f / 65535.0f);
+        CHECK(std::fabs(p.z - vertices[i].position.z) <= 4.25f / 65535.0f);
+        CHECK(AngleBetween(n, vertices[i].normal) <= NORMAL_MAX_ANGLE);
+        CHECK(c.x == 1.0f && c.y == 1.0f && c.z == 1.0f && c.w == 1.0f);
+    }
+
+    QuantizedMesh empty;
+    CHECK(!QuantizeMesh(MeshStreams(), true, empty));
+}
+
+// Перегрузка по указателям (вершины из кэша меша) даёт те же байты, что и по MeshStreams
+TEST(QuantizedFromRawStreamsMatchesMeshStreams)
+{
+    const MeshStreams mesh = BuildStreams(11);
+    for (bool withColor : { true, false })
+    {
+        QuantizedMesh expected, raw;
+        CHECK(QuantizeMesh(mesh, withColor, expected));
+        CHECK(QuantizeMesh(mesh.positions.data(), mesh.normals.data(), mesh.colors.data(), mesh.VertexCount(), withColor, raw));
+        CHECK(raw.vertexData == expected.vertexData && raw.stride == expected.stride && raw.indices.empty());
+    }
+
+    // nullptr вместо нормалей и цвета - как пустые потоки
+    MeshStreams bare;
+    bare.positions = mesh.positions;
+    QuantizedMesh expected, raw;
+    CHECK(QuantizeMesh(bare, true, expected));
+    CHECK(QuantizeMesh(bare.positions.data(), nullptr, nullptr, bare.VertexCount(), true, raw));
+    CHECK(raw.vertexData == expected.vertexData);
+}
@@ -0,0 +1,274 @@
+﻿#include "UnitTest.h"
+#include "RenderJobs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace
+{
+    // Запись без GPU: запоминает вызовы; Begin/End должны идти парой ровно один раз за Record
+    class MockRecorder : public ICommandRecorder
+    {
+    public:
+        void Begin() override
+        {
+            begins++;
+            open = true;
+            draws.clear();
+        }
+
+        void RecordDraw(const DrawItem& item) override
+        {
+            if (!open)
+                outside++;
+            draws.push_back(item.startIndex);
+        }
+
+        void End() override
+        {
+            ends++;
+            open = false;
+        }
+
+        uint32_t begins = 0;
+        uint32_t ends = 0;
+        uint32_t outside = 0;
+        bool open = false;
+        std::vector<uint32_t> draws;
+    };
+
+    // Заглушка с работой на вызов, как у записи в настоящий список: для замера без GPU
+    class BusyRecorder : public ICommandRecorder
+    {
+    public:
+        void Begin() override { draws = 0; }
+
+        void RecordDraw(const DrawItem& item) override
+        {
+            uint32_t h = item.startIndex ^ item.indexCount;
+            for (int i = 0; i < 200; i++)
+                h = h * 1664525u + 1013904223u;
+            checksum += h;
+            draws++;
+        }
+
+        void End() override {}
+
+        uint64_t checksum = 0;
+        size_t draws = 0;
+    };
+
+    std::vector<DrawItem> RandomDrawItems(size_t count, uint32_t seed)
+    {
+        auto next = [&]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+        std::vector<DrawItem> items(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            items[i].startIndex = (uint32_t)i;
+            items[i].indexCount = 3 * (1 + next() % 16384);
+            items[i].instanceCount = 1 + next() % 4;
+        }
+        return items;
+    }
+
+    // Диапазоны идут подряд с нуля до count, без пустых
+    bool CoversInOrder(const std::vector<DrawRange>& ranges, size_t count)
+    {
+        size_t expected = 0;
+        for (const DrawRange& range : ranges)
+        {
+            if (range.begin != expected || range.end <= range.begin)
+                return false;
+            expected = range.end;
+        }
+        return expected == count;
+    }
+}
+
+// Все элементы ровно в одном диапазоне, по порядку; частей не больше maxParts; пустой вход - без частей
+TEST(PartitionDrawItemsCoversAllItems)
+{
+    std::vector<DrawRange> ranges;
+    bool covered = true;
+    for (uint32_t seed = 1; seed <= 500; seed++)
+    {
+        const std::vector<DrawItem> items = RandomDrawItems(1 + seed % 300, seed);
+        const uint32_t maxParts = seed % 9;
+        PartitionDrawItems(items.data(), items.size(), maxParts, 1, ranges);
+        covered = covered && CoversInOrder(ranges, items.size()) && ranges.size() <= std::max(maxParts, 1u);
+    }
+    CHECK(covered);
+
+    PartitionDrawItems(nullptr, 0, 4, 1, ranges);
+    CHECK(ranges.empty());
+}
+
+// Каждый диапазон не короче minItems; если элементов меньше - один диапазон на всё
+TEST(PartitionDrawItemsRespectsMinItems)
+{
+    std::vector<DrawRange> ranges;
+    bool respected = true;
+    for (uint32_t seed = 1; seed <= 500; seed++)
+    {
+        const std::vector<DrawItem> items = RandomDrawItems(1 + seed % 200, seed);
+        const size_t minItems = 1 + seed % 40;
+        PartitionDrawItems(items.data(), items.size(), 8, minItems, ranges);
+        respected = respected && CoversInOrder(ranges, items.size());
+        for (const DrawRange& range : ranges)
+            respected = respected && (range.end - range.begin >= minItems || ranges.size() == 1);
+        if (items.size() < 2 * minItems)
+            respected = respected && ranges.size() == 1;
+    }
+    CHECK(respected);
+}
+
+// Цена части - не больше равной доли плюс один самый дорогой элемент; равные элементы делятся поровну
+TEST(PartitionDrawItemsBalancesCost)
+{
+    std::vector<DrawRange> ranges;
+    bool balanced = true;
+    for (uint32_t seed = 1; seed <= 200; seed++)
+    {
+        const std::vector<DrawItem> items = RandomDrawItems(64 + seed % 500, seed);
+        uint64_t total = 0, heaviest = 0;
+        for (const DrawItem& item : items)
+        {
+            total += DrawItemCost(item);
+            heaviest = std::max(heaviest, DrawItemCost(item));
+        }
+
+        const uint32_t parts = 2 + seed % 7;
+        PartitionDrawItems(items.data(), items.size(), parts, 1, ranges);
+        balanced = balanced && ranges.size() == parts;
+        for (const DrawRange& range : ranges)
+        {
+            uint64_t cost = 0;
+            for (size_t i = range.begin; i < range.end; i++)
+                cost += DrawItemCost(items[i]);
+            balanced = balanced && cost <= total / parts + heaviest;
+        }
+    }
+    CHECK(balanced);
+
+    std::vector<DrawItem> uniform;
+    SplitIntoDrawItems(3 * 16384 * 100, 3 * 16384, uniform);
+    PartitionDrawItems(uniform.data(), uniform.size(), 4, 1, ranges);
+    CHECK(ranges.size() == 4);
+    for (const DrawRange& range : ranges)
+        CHECK(range.end - range.begin == 25);
+}
+
+// Каждый вызов записан ровно один раз; склейка списков в порядке отправки - исходный порядок
+TEST(ParallelRecorderRecordsEveryDrawOnce)
+{
+    // Своя система на 4 потока: тест - её поток 0, как Draw у DirectXApp
+    JobSystem jobs(4);
+    ParallelRecorder recorder(jobs, 4);
+    CHECK(recorder.ThreadCount() == 4);
+
+    MockRecorder mocks[4];
+    ICommandRecorder* recorders[4] = { &mocks[0], &mocks[1], &mocks[2], &mocks[3] };
+
+    uint32_t seed = 15;
+    auto next = [&]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+    bool exact = true, paired = true;
+    uint32_t parallelFrames = 0;
+    for (int frame = 0; frame < 2000; frame++)
+    {
+        std::vector<DrawItem> items(next() % 200);
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            items[i].startIndex = (uint32_t)i;
+            items[i].indexCount = 3 * (1 + next() % 1000);
+        }
+
+        for (MockRecorder& mock : mocks)
+            mock = MockRecorder();
+        const uint32_t lists = recorder.Record(items.data(), items.size(), recorders, 4, 1 + next() % 32);
+        parallelFrames += lists > 1;
+
+        std::vector<uint32_t> joined;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            const bool used = i < lists;
+            paired = paired && mocks[i].begins == (used ? 1u : 0u) && mocks[i].ends == mocks[i].begins &&
+                mocks[i].outside == 0 && !mocks[i].open;
+            joined.insert(joined.end(), mocks[i].draws.begin(), mocks[i].draws.end());
+        }
+
+        exact = exact && lists >= 1 && lists <= 4 && joined.size() == items.size();
+        for (size_t i = 0; exact && i < joined.size(); i++)
+            exact = joined[i] == i;
+    }
+    CHECK(exact);
+    CHECK(paired);
+    CHECK(parallelFrames > 0);
+}
+
+// Списков не больше записывающих и потоков системы; пустой кадр - один пустой список
+TEST(ParallelRecorderLimitsLists)
+{
+    JobSystem jobs(2);
+    ParallelRecorder wide(jobs, 8);
+    CHECK(wide.ThreadCount() == 2);
+    ParallelRecorder all(jobs);
+    CHECK(all.ThreadCount() == 2);
+
+    MockRecorder mocks[3];
+    ICommandRecorder* recorders[3] = { &mocks[0], &mocks[1], &mocks[2] };
+    std::vector<DrawItem> items(100);
+    for (size_t i = 0; i < items.size(); i++)
+        items[i].startIndex = (uint32_t)i;
+
+    CHECK(wide.Record(items.data(), items.size(), recorders, 3) == 2);
+    CHECK(mocks[0].draws.size() + mocks[1].draws.size() == items.size() && mocks[2].begins == 0);
+
+    MockRecorder single;
+    ICommandRecorder* one = &single;
+    CHECK(wide.Record(items.data(), items.size(), &one, 1) == 1 && single.draws.size() == items.size());
+
+    MockRecorder empty;
+    ICommandRecorder* emptyRecorder = &empty;
+    CHECK(wide.Record(items.data(), 0, &emptyRecorder, 1) == 1);
+    CHECK(empty.begins == 1 && empty.ends == 1 && empty.draws.empty());
+    CHECK(wide.Record(items.data(), 0, nullptr, 0) == 0);
+}
+
+// Замер записи без GPU: те же элементы одним списком и по спискам на потоки системы
+TEST(ParallelRecorderBenchmark)
+{
+    JobSystem jobs(4);
+    const std::vector<DrawItem> items = RandomDrawItems(4096, 25);
+    BusyRecorder busy[4];
+    ICommandRecorder* recorders[4] = { &busy[0], &busy[1], &busy[2], &busy[3] };
+
+    const int frames = 200;
+    uint64_t reference = 0;
+    for (uint32_t threads : { 1u, 2u, 4u })
+    {
+        ParallelRecorder recorder(jobs, threads);
+        for (BusyRecorder& b : busy)
+            b.checksum = 0;
+
+        uint32_t lists = 0;
+        size_t recorded = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            lists = recorder.Record(items.data(), items.size(), recorders, 4);
+            for (uint32_t i = 0; i < lists; i++)
+                recorded += busy[i].draws;
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t checksum = 0;
+        for (const BusyRecorder& b : busy)
+            checksum += b.checksum;
+        if (threads == 1)
+            reference = checksum;
+        CHECK(checksum == reference && recorded == items.size() * frames && lists == threads);
+        printf("    %u threads: %zu draws in %u lists, %.3f ms/frame\n", threads, items.size(), lists, ms / frames);
+    }
+}
@@ -0,0 +1,108 @@
+﻿#include "UnitTest.h"
+#include "ResizeTracker.h"
+
+// Несколько WM_SIZE за кадр - одна пересборка под последний размер
+TEST(ResizeCoalescesEventsPerFrame)
+{
+    ResizeTracker tracker;
+    tracker.Reset(800, 600);
+
+    uint32_t width = 0, height = 0;
+    CHECK(!tracker.Consume(width, height));
+
+    tracker.OnSize(1024, 768, SizeEvent::Restored);
+    tracker.OnSize(1280, 720, SizeEvent::Restored);
+    tracker.OnSize(1920, 1080, SizeEvent::Maximized);
+    CHECK(tracker.Consume(width, height));
+    CHECK(width == 1920 && height == 1080);
+    CHECK(tracker.Width() == 1920 && tracker.Height() == 1080);
+
+    // Следующий кадр без событий ничего не пересобирает
+    CHECK(!tracker.Consume(width, height));
+    CHECK(tracker.EventCount() == 3 && tracker.RebuildCount() == 1);
+
+    // Размер, равный текущему, - без пересборки
+    tracker.OnSize(1920, 1080, SizeEvent::Restored);
+    CHECK(!tracker.Consume(width, height));
+    CHECK(tracker.RebuildCount() == 1);
+}
+
+// Пока тянут рамку, размер только запоминается; после отпускания - одна пересборка
+TEST(ResizeWaitsForSizeMoveToEnd)
+{
+    ResizeTracker tracker;
+    tracker.Reset(800, 600);
+    uint32_t width = 0, height = 0;
+
+    tracker.OnEnterSizeMove();
+    CHECK(tracker.IsSizing() && tracker.ShouldRender());
+    for (uint32_t step = 1; step <= 50; step++)
+    {
+        tracker.OnSize(800 + step * 4, 600 + step * 2, SizeEvent::Restored);
+        CHECK(!tracker.Consume(width, height));
+    }
+    tracker.OnExitSizeMove();
+
+    CHECK(tracker.Consume(width, height));
+    CHECK(width == 1000 && height == 700);
+    CHECK(tracker.EventCount() == 50 && tracker.RebuildCount() == 1);
+
+    // Перетаскивание окна без изменения размера и возврат рамки к исходному размеру
+    tracker.OnEnterSizeMove();
+    tracker.OnExitSizeMove();
+    CHECK(!tracker.Consume(width, height));
+
+    tracker.OnEnterSizeMove();
+    tracker.OnSize(1200, 900, SizeEvent::Restored);
+    tracker.OnSize(1000, 700, SizeEvent::Restored);
+    tracker.OnExitSizeMove();
+    CHECK(!tracker.Consume(width, height));
+    CHECK(tracker.RebuildCount() == 1);
+}
+
+// Свёрнутое окно не рисуется и не пересобирается; восстановление в тот же размер - без пересборки
+TEST(ResizeSkipsMinimized)
+{
+    ResizeTracker tracker;
+    tracker.Reset(800, 600);
+    uint32_t width = 0, height = 0;
+
+    tracker.OnSize(0, 0, SizeEvent::Minimized);
+    CHECK(tracker.IsMinimized() && !tracker.ShouldRender());
+    CHECK(!tracker.Consume(width, height));
+    CHECK(tracker.Width() == 800 && tracker.Height() == 600);
+
+    tracker.OnSize(800, 600, SizeEvent::Restored);
+    CHECK(!tracker.IsMinimized() && tracker.ShouldRender());
+    CHECK(!tracker.Consume(width, height));
+
+    // Отложенное до сворачивания изменение ждёт восстановления и заменяется его размером
+    tracker.OnSize(640, 480, SizeEvent::Restored);
+    tracker.OnSize(640, 480, SizeEvent::Minimized);
+    CHECK(!tracker.Consume(width, height));
+    tracker.OnSize(1024, 768, SizeEvent::Maximized);
+    CHECK(tracker.Consume(width, height));
+    CHECK(width == 1024 && height == 768);
+
+    // Нулевая сторона без SIZE_MINIMIZED - тоже свёрнуто
+    tracker.OnSize(1024, 0, SizeEvent::Restored);
+    CHECK(tracker.IsMinimized() && !tracker.Consume(width, height));
+    CHECK(tracker.RebuildCount() == 1);
+}
+
+// Reset - буферы созданы под этот размер (как после CreateSwapChain): отложенное изменение снимается
+TEST(ResizeResetDropsPending)
+{
+    ResizeTracker tracker;
+    tracker.Reset(800, 600);
+    tracker.OnEnterSizeMove();
+    tracker.OnSize(1024, 768, SizeEvent::Restored);
+    tracker.OnSize(0, 0, SizeEvent::Minimized);
+
+    tracker.Reset(1920, 1080);
+    CHECK(!tracker.IsSizing() && !tracker.IsMinimized());
+
+    uint32_t width = 0, height = 0;
+    CHECK(!tracker.Consume(width, height));
+    CHECK(tracker.Width() == 1920 && tracker.Height() == 1080);
+}
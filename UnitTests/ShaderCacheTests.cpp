@@ -0,0 +1,151 @@
+﻿#include "UnitTest.h"
+#include "ShaderCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    // Свой каталог кэша на тест; удаляется вместе с содержимым
+    struct TempCacheDir
+    {
+        std::string path;
+
+        explicit TempCacheDir(const char* name)
+        {
+            path = (std::filesystem::temp_directory_path() / name).string();
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+
+        ~TempCacheDir()
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+    };
+
+    ShaderKey BaseKey()
+    {
+        ShaderKey key;
+        key.sourceHash = 0x5EED;
+        key.defines = { { "INSTANCED", "1" }, { "MAX_LIGHTS", "4" } };
+        key.entryPoint = "VS";
+        key.target = "vs_5_0";
+        key.flags = 1;
+        return key;
+    }
+}
+
+// Порядок defines не важен; любое другое поле, включая границу имя/значение, меняет ключ
+TEST(ShaderKeyHashing)
+{
+    const uint64_t key = HashShaderKey(BaseKey());
+
+    ShaderKey reordered = BaseKey();
+    std::swap(reordered.defines[0], reordered.defines[1]);
+    CHECK(HashShaderKey(reordered) == key);
+
+    auto differs = [&](void (*change)(ShaderKey&))
+    {
+        ShaderKey k = BaseKey();
+        change(k);
+        return HashShaderKey(k) != key;
+    };
+    CHECK(differs([](ShaderKey& k) { k.sourceHash++; }));
+    CHECK(differs([](ShaderKey& k) { k.defines[1].value = "8"; }));
+    CHECK(differs([](ShaderKey& k) { k.defines.pop_back(); }));
+    CHECK(differs([](ShaderKey& k) { k.defines[0] = { "INSTANCED1", "" }; }));
+    CHECK(differs([](ShaderKey& k) { k.entryPoint = "VSInstanced"; }));
+    CHECK(differs([](ShaderKey& k) { k.target = "vs_5_1"; }));
+    CHECK(differs([](ShaderKey& k) { k.flags = 0; }));
+    CHECK(differs([](ShaderKey& k) { k.entryPoint = "VSvs_5_0"; k.target = ""; }));
+}
+
+// Байткод переживает Store/Load; чужой, подменённый или обрезанный файл - отказ, а не мусорный шейдер
+TEST(ShaderCacheStoreLoad)
+{
+    TempCacheDir dir("UnitTestsShaderCache");
+    ShaderCache cache(dir.path);
+    const uint64_t key = HashShaderKey(BaseKey());
+    const std::vector<uint8_t> byteCode = { 0x44, 0x58, 0x42, 0x43, 10, 20, 30, 40, 50 };
+
+    std::vector<uint8_t> loaded;
+    CHECK(!cache.Load(key, loaded));
+    CHECK(cache.GetStats().misses == 1);
+
+    CHECK(cache.Store(key, byteCode.data(), byteCode.size()));
+    CHECK(std::filesystem::exists(cache.PathFor(key)));
+    CHECK(!std::filesystem::exists(cache.PathFor(key) + ".tmp"));
+    CHECK(cache.Load(key, loaded) && loaded == byteCode);
+    CHECK(cache.GetStats().hits == 1 && cache.GetStats().stores == 1);
+
+    // Файл под чужим именем: ключ в заголовке не совпал
+    const uint64_t otherKey = key ^ 1;
+    std::filesystem::copy_file(cache.PathFor(key), cache.PathFor(otherKey));
+    CHECK(!cache.Load(otherKey, loaded));
+
+    // Обрезанный байткод и испорченная сигнатура
+    std::filesystem::resize_file(cache.PathFor(otherKey), sizeof(ShaderCacheHeader) + 3);
+    CHECK(!cache.Load(otherKey, loaded));
+    std::ofstream(cache.PathFor(otherKey), std::ios::binary | std::ios::trunc) << "garbage";
+    CHECK(!cache.Load(otherKey, loaded));
+    CHECK(cache.GetStats().rejected == 3);
+
+    // Перезапись новым байткодом
+    const std::vector<uint8_t> rebuilt = { 1, 2, 3 };
+    CHECK(cache.Store(key, rebuilt.data(), rebuilt.size()));
+    CHECK(cache.Load(key, loaded) && loaded == rebuilt);
+}
+
+// Ключ идёт от содержимого исходника: другой текст - другой ключ, хэш одного пути считается один раз
+TEST(ShaderCacheKeysFollowSource)
+{
+    TempCacheDir dir("UnitTestsShaderSource");
+    std::filesystem::create_directories(dir.path);
+    const std::string source = dir.path + "/shaders.hlsl";
+    std::ofstream(source, std::ios::binary) << "float4 VS() : SV_Position { return 0; }";
+
+    ShaderCache cache(dir.path);
+    uint64_t vs = 0, vsAgain = 0, ps = 0;
+    CHECK(cache.MakeKey(source, {}, "VS", "vs_5_0", 0, vs));
+    CHECK(cache.MakeKey(source, {}, "VS", "vs_5_0", 0, vsAgain));
+    CHECK(cache.MakeKey(source, {}, "PS", "ps_5_0", 0, ps));
+    CHECK(vs == vsAgain && vs != ps);
+
+    uint64_t missing;
+    CHECK(!cache.MakeKey(dir.path + "/missing.hlsl", {}, "VS", "vs_5_0", 0, missing));
+
+    // Правка исходника видна новому кэшу (следующему запуску); текущий держит свой хэш
+    std::ofstream(source, std::ios::binary | std::ios::trunc) << "float4 VS() : SV_Position { return 1; }";
+    uint64_t cached = 0, edited = 0;
+    CHECK(cache.MakeKey(source, {}, "VS", "vs_5_0", 0, cached));
+    ShaderCache nextRun(dir.path);
+    CHECK(nextRun.MakeKey(source, {}, "VS", "vs_5_0", 0, edited));
+    CHECK(cached == vs && edited != vs);
+}
+
+// RemoveStale удаляет только файлы кэша с неживыми ключами
+TEST(ShaderCacheRemovesStale)
+{
+    TempCacheDir dir("UnitTestsShaderStale");
+    ShaderCache cache(dir.path);
+    const uint8_t byteCode[] = { 1, 2, 3, 4 };
+    for (uint64_t key = 1; key <= 4; key++)
+        CHECK(cache.Store(key, byteCode, sizeof(byteCode)));
+
+    // Чужие файлы: не .cso, заглавные цифры, другая длина имени
+    const std::string foreign[] = { "readme.txt", "000000000000000A.cso", "0001.cso" };
+    for (const std::string& name : foreign)
+        std::ofstream(dir.path + "/" + name) << "keep";
+
+    CHECK(cache.RemoveStale({ 2, 4 }) == 2);
+    CHECK(!std::filesystem::exists(cache.PathFor(1)) && !std::filesystem::exists(cache.PathFor(3)));
+    CHECK(std::filesystem::exists(cache.PathFor(2)) && std::filesystem::exists(cache.PathFor(4)));
+    for (const std::string& name : foreign)
+        CHECK(std::filesystem::exists(dir.path + "/" + name));
+
+    ShaderCache missing(dir.path + "/none");
+    CHECK(missing.RemoveStale({}) == 0);
+}
@@ -0,0 +1,88 @@
+﻿#include "TestMeshes.h"
+
+#include <cmath>
+
+void AppendSphere(TestMesh& mesh, float cx, float cy, float cz, float radius, uint32_t segments, uint32_t rings)
+{
+    const uint32_t base = (uint32_t)mesh.VertexCount();
+    const float pi = 3.14159265358979f;
+
+    for (uint32_t r = 0; r <= rings; r++)
+    {
+        const float theta = pi * r / rings;
+        for (uint32_t s = 0; s <= segments; s++)
+        {
+            const float phi = 2.0f * pi * s / segments;
+            mesh.positions.push_back(cx + radius * sinf(theta) * cosf(phi));
+            mesh.positions.push_back(cy + radius * cosf(theta));
+            mesh.positions.push_back(cz + radius * sinf(theta) * sinf(phi));
+        }
+    }
+
+    for (uint32_t r = 0; r < rings; r++)
+    {
+        for (uint32_t s = 0; s < segments; s++)
+        {
+            const uint32_t a = base + r * (segments + 1) + s;
+            const uint32_t b = a + segments + 1;
+            // У полюсов один из треугольников квада вырожден - его не пишем
+            if (r != 0)
+                mesh.indices.insert(mesh.indices.end(), { a, a + 1, b });
+            if (r != rings - 1)
+                mesh.indices.insert(mesh.indices.end(), { a + 1, b + 1, b });
+        }
+    }
+}
+
+void AppendGrid(TestMesh& mesh, const float origin[3], const float u[3], const float v[3], uint32_t cellsU, uint32_t cellsV)
+{
+    const uint32_t base = (uint32_t)mesh.VertexCount();
+    for (uint32_t j = 0; j <= cellsV; j++)
+    {
+        for (uint32_t i = 0; i <= cellsU; i++)
+        {
+            for (int k = 0; k < 3; k++)
+                mesh.positions.push_back(origin[k] + u[k] * i / cellsU + v[k] * j / cellsV);
+        }
+    }
+
+    for (uint32_t j = 0; j < cellsV; j++)
+    {
+        for (uint32_t i = 0; i < cellsU; i++)
+        {
+            const uint32_t a = base + j * (cellsU + 1) + i;
+            const uint32_t c = a + cellsU + 1;
+            mesh.indices.insert(mesh.indices.end(), { a, c, a + 1, a + 1, c, c + 1 });
+        }
+    }
+}
+
+void AppendPentagon(TestMesh& mesh, float cx, float cy, float cz, float radius)
+{
+    const uint32_t base = (uint32_t)mesh.VertexCount();
+    mesh.positions.insert(mesh.positions.end(), { cx, cy, cz });
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        const float angle = 2.0f * 3.14159265358979f * i / 5;
+        mesh.positions.insert(mesh.positions.end(), { cx + radius * cosf(angle), cy + radius * sinf(angle), cz });
+    }
+    for (uint32_t i = 0; i < 5; i++)
+        mesh.indices.insert(mesh.indices.end(), { base, base + 1 + (i + 1) % 5, base + 1 + i });
+}
+
+TestMesh BuildMixedScene()
+{
+    TestMesh mesh;
+    AppendSphere(mesh, 0.0f, 0.0f, 0.0f, 1.0f, 64, 32);
+
+    const float backOrigin[3] = { -2.0f, -1.0f, 2.0f };
+    const float sideOrigin[3] = { -2.0f, -1.0f, -2.0f };
+    const float alongX[3] = { 4.0f, 0.0f, 0.0f };
+    const float alongY[3] = { 0.0f, 2.0f, 0.0f };
+    const float alongZ[3] = { 0.0f, 0.0f, 4.0f };
+    AppendGrid(mesh, backOrigin, alongX, alongY, 40, 20);
+    AppendGrid(mesh, sideOrigin, alongY, alongZ, 20, 40);
+
+    AppendPentagon(mesh, 2.5f, 0.0f, 0.0f, 0.3f);
+    return mesh;
+}
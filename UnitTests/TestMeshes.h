@@ -0,0 +1,29 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ===== Меши для тестов =====
+// Позиции - плотный массив xyz (stride 12), как их принимают MeshSimplifier, Meshlets и OcclusionBuffer
+struct TestMesh
+{
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+
+    size_t VertexCount() const { return positions.size() / 3; }
+    size_t Stride() const { return 3 * sizeof(float); }
+};
+
+// Дописывают геометрию в mesh, вершины не делятся с тем, что уже есть
+
+// UV-сфера; шов по долготе - продублированные вершины, как после разрыва текстуры
+void AppendSphere(TestMesh& mesh, float cx, float cy, float cz, float radius, uint32_t segments, uint32_t rings);
+
+// Прямоугольник cellsU x cellsV квадов: origin + u * i / cellsU + v * j / cellsV, нормаль - u x v
+void AppendGrid(TestMesh& mesh, const float origin[3], const float u[3], const float v[3], uint32_t cellsU, uint32_t cellsV);
+
+// Плоский правильный пятиугольник веером из центра - отдельная компонента с открытой границей
+void AppendPentagon(TestMesh& mesh, float cx, float cy, float cz, float radius);
+
+// Сфера радиуса 1 в центре, две стены 4 x 2 за ней и пятиугольник сбоку: ~5 единиц в поперечнике
+TestMesh BuildMixedScene();
@@ -0,0 +1,265 @@
+﻿#include "UnitTest.h"
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+
+namespace
+{
+    // Живые выделения: смещение -> размер; пересечения и выход за capacity - ошибка
+    bool DisjointInside(const std::map<uint64_t, uint64_t>& live, uint64_t capacity)
+    {
+        uint64_t end = 0;
+        for (const auto& [offset, size] : live)
+        {
+            if (offset < end || offset + size > capacity)
+                return false;
+            end = offset + size;
+        }
+        return true;
+    }
+
+    // Статистика сходится с моделью: занято - сумма живых, свободно - остальное
+    bool StatsMatch(const TlsfAllocator& tlsf, const std::map<uint64_t, uint64_t>& live)
+    {
+        uint64_t used = 0;
+        for (const auto& entry : live)
+            used += entry.second;
+
+        const TlsfAllocator::Stats stats = tlsf.GetStats();
+        return stats.usedBytes == used && stats.freeBytes == stats.capacity - used &&
+            stats.allocationCount == live.size() && stats.largestFreeBlock <= stats.freeBytes;
+    }
+}
+
+// Выделения подряд от нуля, весь объём до байта, отказ при нехватке и на нулевой размер
+TEST(TlsfAllocatesAndFails)
+{
+    TlsfAllocator tlsf(1024);
+    CHECK(tlsf.Allocate(0) == TlsfAllocator::INVALID_OFFSET);
+    CHECK(tlsf.Allocate(1025) == TlsfAllocator::INVALID_OFFSET);
+
+    const uint64_t a = tlsf.Allocate(100);
+    const uint64_t b = tlsf.Allocate(300);
+    const uint64_t c = tlsf.Allocate(624);
+    CHECK(a == 0 && b == 100 && c == 400);
+    CHECK(tlsf.UsedBytes() == 1024 && tlsf.AllocationCount() == 3);
+    CHECK(tlsf.Allocate(1) == TlsfAllocator::INVALID_OFFSET);
+
+    const TlsfAllocator::Stats stats = tlsf.GetStats();
+    CHECK(stats.freeBytes == 0 && stats.freeBlockCount == 0 && stats.Fragmentation() == 0.0f);
+
+    // Неизвестное смещение и повторное освобождение ничего не ломают
+    tlsf.Free(b);
+    tlsf.Free(b);
+    tlsf.Free(7);
+    CHECK(tlsf.UsedBytes() == 724 && tlsf.AllocationCount() == 2);
+    CHECK(tlsf.Allocate(300) == b);
+
+    TlsfAllocator empty;
+    CHECK(empty.Allocate(1) == TlsfAllocator::INVALID_OFFSET);
+}
+
+// Освобождённые соседи сливаются в один блок в любом порядке: после всех Free - снова весь объём
+TEST(TlsfCoalescesNeighbours)
+{
+    const uint64_t orders[][4] = { { 0, 1, 2, 3 }, { 3, 2, 1, 0 }, { 1, 3, 0, 2 }, { 2, 0, 3, 1 } };
+    for (const auto& order : orders)
+    {
+        TlsfAllocator tlsf(4096);
+        uint64_t offsets[4];
+        for (uint64_t& offset : offsets)
+            offset = tlsf.Allocate(1024);
+
+        tlsf.Free(offsets[order[0]]);
+        tlsf.Free(offsets[order[1]]);
+        tlsf.Free(offsets[order[2]]);
+        tlsf.Free(offsets[order[3]]);
+
+        const TlsfAllocator::Stats stats = tlsf.GetStats();
+        CHECK(tlsf.IsEmpty());
+        CHECK(stats.freeBlockCount == 1 && stats.largestFreeBlock == 4096);
+        CHECK(tlsf.Allocate(4096) == 0);
+    }
+
+    // Дырка между занятыми не сливается: фрагментация видна в статистике
+    TlsfAllocator tlsf(4096);
+    const uint64_t a = tlsf.Allocate(1024);
+    const uint64_t b = tlsf.Allocate(1024);
+    const uint64_t c = tlsf.Allocate(1024);
+    tlsf.Free(a);
+    tlsf.Free(c);
+    TlsfAllocator::Stats stats = tlsf.GetStats();
+    CHECK(stats.freeBlockCount == 2 && stats.largestFreeBlock == 2048);
+    CHECK(stats.Fragmentation() > 0.3f && stats.Fragmentation() < 0.4f);
+    CHECK(tlsf.Allocate(2049) == TlsfAllocator::INVALID_OFFSET);
+
+    // Освобождение середины склеивает все три куска
+    tlsf.Free(b);
+    stats = tlsf.GetStats();
+    CHECK(stats.freeBlockCount == 1 && stats.largestFreeBlock == 4096);
+}
+
+// Выравнивание: отступ слева остаётся свободным блоком и потом переиспользуется
+TEST(TlsfAlignsAndReusesPadding)
+{
+    TlsfAllocator tlsf(1 << 20);
+    const uint64_t small = tlsf.Allocate(100);
+    const uint64_t aligned = tlsf.Allocate(4096, 65536);
+    CHECK(small == 0 && aligned == 65536);
+
+    // Отступ - в меньшем классе, чем хвост кучи: good fit берёт его
+    const uint64_t padding = tlsf.Allocate(32768);
+    CHECK(padding == 100);
+
+    for (uint64_t alignment = 1; alignment <= 65536; alignment <<= 1)
+    {
+        const uint64_t offset = tlsf.Allocate(3, alignment);
+        CHECK(offset != TlsfAllocator::INVALID_OFFSET && offset % alignment == 0);
+    }
+
+    // Остаток точно по размеру запроса (тот же класс) и запрос, который влез бы без выравнивания, но не с ним
+    TlsfAllocator tight(4096);
+    tight.Allocate(1);
+    CHECK(tight.Allocate(4095, 1) == 1);
+    tight.Free(1);
+    CHECK(tight.Allocate(4095, 4096) == TlsfAllocator::INVALID_OFFSET);
+}
+
+// Размеры на границах классов: найденный блок всегда не меньше запроса
+TEST(TlsfSizeClassBoundaries)
+{
+    for (uint64_t size = 1; size <= 4096; size++)
+    {
+        TlsfAllocator tlsf(size * 3);
+        // Свободный блок ровно size и блок больше - в одном или соседних классах
+        const uint64_t a = tlsf.Allocate(size);
+        const uint64_t b = tlsf.Allocate(1);
+        tlsf.Free(a);
+
+        const uint64_t c = tlsf.Allocate(size);
+        CHECK(c != TlsfAllocator::INVALID_OFFSET);
+        CHECK(c == a || c >= b + 1);
+        tlsf.Free(c);
+        tlsf.Free(b);
+        CHECK(tlsf.GetStats().freeBlockCount == 1);
+    }
+
+    // Огромная ёмкость и размеры, близкие к 2^64, не переполняют отображение в классы
+    TlsfAllocator huge(~0ull - 1);
+    CHECK(huge.Allocate(1ull << 63) == 0);
+    CHECK(huge.Allocate(~0ull - 1) == TlsfAllocator::INVALID_OFFSET);
+    CHECK(huge.Allocate(16, 1ull << 63) == TlsfAllocator::INVALID_OFFSET);
+    CHECK(huge.Allocate(16, 1ull << 62) == 1ull << 63);
+}
+
+namespace
+{
+    // Отток как у GpuMemory: буферы от сотен байт до мегабайт, выравнивание 256 или 64К,
+    // чуть больше выделений, чем освобождений
+    struct ChurnRandom
+    {
+        uint32_t seed;
+
+        uint32_t Next() { seed = seed * 1664525u + 1013904223u; return seed >> 8; }
+        bool NextIsAllocate() { return Next() % 100 < 55; }
+        uint64_t NextSize() { return 1 + (uint64_t)Next() % (Next() % 8 == 0 ? (4u << 20) : (64u << 10)); }
+        uint64_t NextAlignment() { return Next() % 4 == 0 ? 65536 : 256; }
+    };
+}
+
+// Случайные выделения и освобождения против модели живых диапазонов
+TEST(TlsfChurnMatchesModel)
+{
+    const uint64_t capacity = 64ull << 20;
+    TlsfAllocator tlsf(capacity);
+    std::map<uint64_t, uint64_t> live;
+    std::vector<uint64_t> offsets;
+    ChurnRandom random{ 12345 };
+
+    bool consistent = true;
+    float maxFragmentation = 0.0f;
+    for (int op = 0; op < 50000; op++)
+    {
+        if (offsets.empty() || random.NextIsAllocate())
+        {
+            const uint64_t size = random.NextSize();
+            const uint64_t alignment = random.NextAlignment();
+            const uint64_t offset = tlsf.Allocate(size, alignment);
+            if (offset == TlsfAllocator::INVALID_OFFSET)
+                continue;
+            consistent = consistent && offset % alignment == 0 && live.count(offset) == 0;
+            live[offset] = size;
+            offsets.push_back(offset);
+        }
+        else
+        {
+            const size_t pick = random.Next() % offsets.size();
+            const uint64_t offset = offsets[pick];
+            offsets[pick] = offsets.back();
+            offsets.pop_back();
+            live.erase(offset);
+            tlsf.Free(offset);
+        }
+
+        if (op % 500 == 0)
+        {
+            consistent = consistent && DisjointInside(live, capacity) && StatsMatch(tlsf, live);
+            maxFragmentation = std::max(maxFragmentation, tlsf.GetStats().Fragmentation());
+        }
+    }
+
+    CHECK(consistent);
+    CHECK(DisjointInside(live, capacity) && StatsMatch(tlsf, live));
+    CHECK(maxFragmentation < 1.0f);
+
+    // Всё освобождено - снова один блок на всю ёмкость
+    for (uint64_t offset : offsets)
+        tlsf.Free(offset);
+    const TlsfAllocator::Stats stats = tlsf.GetStats();
+    CHECK(tlsf.IsEmpty() && stats.freeBlockCount == 1 && stats.largestFreeBlock == capacity);
+}
+
+// Замер оттока без модели: время Allocate/Free и доля отказов при заполненной куче
+TEST(TlsfChurnBenchmark)
+{
+    const uint64_t capacity = 256ull << 20;
+    TlsfAllocator tlsf(capacity);
+    std::vector<uint64_t> offsets;
+    offsets.reserve(1 << 16);
+    ChurnRandom random{ 777 };
+
+    const int operations = 1000000;
+    int allocations = 0;
+    int failures = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int op = 0; op < operations; op++)
+    {
+        if (offsets.empty() || random.NextIsAllocate())
+        {
+            const uint64_t size = random.NextSize();
+            const uint64_t offset = tlsf.Allocate(size, random.NextAlignment());
+            allocations++;
+            if (offset == TlsfAllocator::INVALID_OFFSET)
+                failures++;
+            else
+                offsets.push_back(offset);
+        }
+        else
+        {
+            const size_t pick = random.Next() % offsets.size();
+            tlsf.Free(offsets[pick]);
+            offsets[pick] = offsets.back();
+            offsets.pop_back();
+        }
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const TlsfAllocator::Stats stats = tlsf.GetStats();
+    CHECK(stats.allocationCount == offsets.size());
+    printf("    %d ops: %.1f ns/op, %.1f%% allocs failed, %u live, %.0f%% used, fragmentation %.2f\n",
+        operations, 1e6 * ms / operations, 100.0 * failures / std::max(allocations, 1), stats.allocationCount,
+        100.0 * stats.usedBytes / capacity, stats.Fragmentation());
+}
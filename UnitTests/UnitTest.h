@@ -0,0 +1,29 @@
+﻿#pragma once
+#include <cstdio>
+#include <vector>
+
+// ===== Тесты без фреймворка =====
+// TEST(Name) регистрирует функцию при статической инициализации, CHECK не прерывает тест:
+// провалы печатаются с файлом и строкой, UnitTests возвращает 2, если был хоть один
+
+struct UnitTest
+{
+    const char* name;
+    void (*run)();
+};
+
+std::vector<UnitTest>& UnitTestRegistry();
+void ReportCheckFailure(const char* file, int line, const char* expression);
+
+struct UnitTestRegistrar
+{
+    UnitTestRegistrar(const char* name, void (*run)()) { UnitTestRegistry().push_back({ name, run }); }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static UnitTestRegistrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(expression) \
+    do { if (!(expression)) ReportCheckFailure(__FILE__, __LINE__, #expression); } while (0)
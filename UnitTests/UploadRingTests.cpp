@@ -0,0 +1,176 @@
+﻿#include "UnitTest.h"
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <chrono>
+
+// Выделения выровнены, лежат внутри памяти и не пересекаются с ещё не освобождёнными
+TEST(UploadRingAlignsAndWraps)
+{
+    HeapUploadMemory memory(4096);
+    UploadRing ring(&memory);
+
+    UploadAllocation a = ring.Allocate(1000, 256);
+    UploadAllocation b = ring.Allocate(1000, 256);
+    CHECK(a && b);
+    CHECK(a.offset % 256 == 0 && b.offset % 256 == 0);
+    CHECK(b.offset >= a.offset + a.size);
+    CHECK(a.gpu == memory.GpuBase() + a.offset);
+    ring.Commit(1);
+
+    UploadAllocation c = ring.Allocate(1500, 256);
+    CHECK(c && c.offset + c.size <= 4096);
+    ring.Commit(2);
+
+    // До конца 4096 - 3584 байт не хватает, в начале занято кадром 1
+    CHECK(!ring.Allocate(1000, 256));
+
+    ring.Retire(1);
+    UploadAllocation d = ring.Allocate(1000, 256);
+    CHECK(d && d.offset == 0);
+    CHECK(d.offset + d.size <= c.offset);
+}
+
+TEST(UploadRingRetiresByFence)
+{
+    HeapUploadMemory memory(1024);
+    UploadRing ring(&memory);
+
+    for (uint64_t fence = 1; fence <= 4; fence++)
+    {
+        CHECK(ring.Allocate(256, 16));
+        ring.Commit(fence);
+    }
+    CHECK(!ring.Allocate(16, 16));
+    CHECK(ring.OldestPendingFence() == 1);
+
+    ring.Retire(2);
+    CHECK(ring.UsedBytes() == 512);
+    CHECK(ring.OldestPendingFence() == 3);
+
+    ring.Retire(4);
+    CHECK(!ring.HasPending());
+    CHECK(ring.UsedBytes() == 0);
+}
+
+// Пустое кольцо с головой не в нуле: любое выделение до Capacity проходит без Retire
+TEST(UploadRingEmptyRingAcceptsFullCapacity)
+{
+    HeapUploadMemory memory(4096);
+    UploadRing ring(&memory);
+
+    CHECK(ring.Allocate(3000, 256));
+    ring.Commit(1);
+    ring.Retire(1);
+    CHECK(!ring.HasPending() && ring.UsedBytes() == 0);
+
+    // Раньше: 4096 - 3072 до конца мало, перенос в начало считал хвост занятым - отказ навсегда
+    UploadAllocation whole = ring.Allocate(4096, 256);
+    CHECK(whole && whole.offset == 0);
+    ring.Commit(2);
+    ring.Retire(2);
+
+    for (uint64_t size : { 100ull, 2049ull, 4000ull, 4096ull })
+    {
+        CHECK(ring.Allocate(size, 256));
+        ring.Commit(3);
+        ring.Retire(3);
+    }
+}
+
+// Случайная нагрузка против модели: занятые диапазоны не пересекаются, пустое кольцо всегда выделяет
+TEST(UploadRingRandomChurn)
+{
+    HeapUploadMemory memory(1 << 16);
+    UploadRing ring(&memory);
+
+    struct Live { uint64_t fence, offset, size; };
+    std::vector<Live> live;
+    uint32_t seed = 12345;
+    auto next = [&]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+    uint64_t fence = 0, completed = 0;
+    for (int frame = 0; frame < 2000; frame++)
+    {
+        fence++;
+        const uint32_t count = next() % 8;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint64_t size = 1 + next() % 20000;
+            const bool empty = !ring.HasPending() && ring.UncommittedBytes() == 0;
+            UploadAllocation allocation = ring.Allocate(size, 256);
+            if (empty)
+                CHECK(allocation);
+            if (!allocation)
+                continue;
+
+            CHECK(allocation.offset % 256 == 0 && allocation.offset + size <= memory.Capacity());
+            for (const Live& other : live)
+                CHECK(allocation.offset + size <= other.offset || other.offset + other.size <= allocation.offset);
+            live.push_back({ fence, allocation.offset, size });
+        }
+        ring.Commit(fence);
+
+        // GPU отстаёт на 0-3 кадра
+        completed = std::max(completed, fence - std::min<uint64_t>(fence, next() % 4));
+        ring.Retire(completed);
+        std::vector<Live> kept;
+        for (const Live& l : live)
+        {
+            if (l.fence > completed)
+                kept.push_back(l);
+        }
+        live.swap(kept);
+    }
+}
+
+// Замер оттока без модели: кадры из Allocate / Commit / Retire, GPU отстаёт на 0-2 кадра.
+// Отказ обрабатывается как в AllocateUpload: ждём самый старый fence и повторяем
+TEST(UploadRingChurnBenchmark)
+{
+    const uint64_t capacity = 1ull << 20;
+    HeapUploadMemory memory(capacity);
+    UploadRing ring(&memory);
+    uint32_t seed = 777;
+    auto next = [&]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+    const int frames = 20000;
+    uint64_t fence = 0, completed = 0, peak = 0;
+    int allocations = 0, stalls = 0, lost = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        fence++;
+        // Константы по 256 байт и до четырёх крупных загрузок: кадр влезает в кольцо, три подряд - не всегда
+        const uint32_t constants = 16 + next() % 48;
+        const uint32_t count = constants + next() % 5;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint64_t size = (i < constants) ? 256 : 32768 + next() % 98304;
+            UploadAllocation allocation = ring.Allocate(size, UploadRing::CONSTANT_BUFFER_ALIGNMENT);
+            while (!allocation && ring.HasPending())
+            {
+                stalls++;
+                completed = std::max(completed, ring.OldestPendingFence());
+                ring.Retire(completed);
+                allocation = ring.Allocate(size, UploadRing::CONSTANT_BUFFER_ALIGNMENT);
+            }
+            allocations++;
+            if (!allocation)
+                lost++;
+            peak = std::max(peak, ring.UsedBytes());
+        }
+        ring.Commit(fence);
+
+        completed = std::max(completed, fence - std::min<uint64_t>(fence, next() % 3));
+        ring.Retire(completed);
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    CHECK(lost == 0);
+    ring.Retire(fence);
+    CHECK(!ring.HasPending() && ring.UsedBytes() == 0);
+    printf("    %d frames, %d allocs: %.1f ns/alloc, %d stalls (%.3f%%), peak %.0f%% used\n",
+        frames, allocations, 1e6 * ms / allocations, stalls, 100.0 * stalls / std::max(allocations, 1),
+        100.0 * peak / capacity);
+}
@@ -0,0 +1,47 @@
+﻿// Модульные тесты платформенно-независимых частей Project1 (консоль, без окна и GPU)
+#include "UnitTest.h"
+#include "JobSystem.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+
+static int sFailures = 0;
+
+std::vector<UnitTest>& UnitTestRegistry() {
+    static std::vector<UnitTest> tests;
+    return tests;
+}
+
+void ReportCheckFailure(const char* file, int line, const char* expression) {
+    printf("    %s:%d: CHECK(%s) failed\n", file, line, expression);
+    sFailures++;
+}
+
+int main(int argc, char** argv) {
+    // Аргумент - подстрока имени: запускаются только совпавшие тесты
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    // ParallelFor внутри проверяемого кода идёт заданиями, как в приложении
+    JobSystem jobs;
+
+    int failedTests = 0;
+    int run = 0;
+    for (const UnitTest& test : UnitTestRegistry()) {
+        if (filter && !strstr(test.name, filter))
+            continue;
+
+        const int failuresBefore = sFailures;
+        auto start = std::chrono::steady_clock::now();
+        test.run();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        const bool ok = sFailures == failuresBefore;
+        printf("%-48s %s (%.1f ms)\n", test.name, ok ? "ok" : "FAILED", ms);
+        failedTests += ok ? 0 : 1;
+        run++;
+    }
+
+    printf("%d tests, %d failed\n", run, failedTests);
+    return failedTests ? 2 : 0;
+}